@@ -0,0 +1,153 @@
+///////////////////////////////////////////////////////////////////////////////
+// allocationtracker.cpp
+// ============
+// count the heap allocations of the whole program for the frame profiler
+///////////////////////////////////////////////////////////////////////////////
+
+#include "AllocationTracker.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+// declaration of global variables
+namespace
+{
+	// constant initialized, so they are ready for the allocations
+	// made before main() starts
+	std::atomic<uint64_t> g_AllocationCount(0);
+	std::atomic<uint64_t> g_AllocatedBytes(0);
+
+	// count an allocation and get its memory from the C heap
+	void* TrackedAllocate(std::size_t size)
+	{
+		g_AllocationCount.fetch_add(1, std::memory_order_relaxed);
+		g_AllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+
+		return(std::malloc((size > 0) ? size : 1));
+	}
+
+	// count an over-aligned allocation and get its memory from
+	// the C heap
+	void* TrackedAllocateAligned(std::size_t size, std::size_t alignment)
+	{
+		g_AllocationCount.fetch_add(1, std::memory_order_relaxed);
+		g_AllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+
+		if (size == 0)
+		{
+			size = 1;
+		}
+#if defined(_WIN32)
+		return(_aligned_malloc(size, alignment));
+#else
+		void* memory = NULL;
+		if (posix_memalign(&memory, alignment, size) != 0)
+		{
+			return(NULL);
+		}
+		return(memory);
+#endif
+	}
+
+	// release the memory of an over-aligned allocation
+	void TrackedFreeAligned(void* memory)
+	{
+#if defined(_WIN32)
+		_aligned_free(memory);
+#else
+		std::free(memory);
+#endif
+	}
+}
+
+/***********************************************************
+ *  GetAllocationCount()
+ *
+ *  This method is used for getting the number of heap
+ *  allocations made so far, on every thread.  The difference
+ *  between two calls is the count of the code in between.
+ ***********************************************************/
+uint64_t AllocationTracker::GetAllocationCount()
+{
+	return(g_AllocationCount.load(std::memory_order_relaxed));
+}
+
+/***********************************************************
+ *  GetAllocatedBytes()
+ *
+ *  This method is used for getting the number of bytes that
+ *  the heap allocations made so far asked for.
+ ***********************************************************/
+uint64_t AllocationTracker::GetAllocatedBytes()
+{
+	return(g_AllocatedBytes.load(std::memory_order_relaxed));
+}
+
+// the replaced global allocation functions - the array forms
+// call these by default, so they are counted as well
+void* operator new(std::size_t size)
+{
+	void* memory = TrackedAllocate(size);
+	if (NULL == memory)
+	{
+		throw std::bad_alloc();
+	}
+
+	return(memory);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	return(TrackedAllocate(size));
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+	void* memory = TrackedAllocateAligned(size, (std::size_t)alignment);
+	if (NULL == memory)
+	{
+		throw std::bad_alloc();
+	}
+
+	return(memory);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return(TrackedAllocateAligned(size, (std::size_t)alignment));
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept
+{
+	TrackedFreeAligned(memory);
+}
+
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept
+{
+	TrackedFreeAligned(memory);
+}
+
+void operator delete(void* memory, std::align_val_t, const std::nothrow_t&) noexcept
+{
+	TrackedFreeAligned(memory);
+}
@@ -0,0 +1,33 @@
+///////////////////////////////////////////////////////////////////////////////
+// allocationtracker.h
+// ============
+// count the heap allocations of the whole program for the frame profiler
+//
+//  The global operator new and delete are replaced with versions that count
+//  every allocation before handing it to malloc, so the profiler can report
+//  how many allocations a frame made.  A steady frame is expected to make
+//  none - transient data goes into the frame arena and the lists that live
+//  across frames keep their capacity - and a report that shows allocations
+//  points at the code that still grows or copies a container every frame.
+//  The count covers every thread, since the worker threads share the same
+//  allocator and its locks with the render thread.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+
+/***********************************************************
+ *  AllocationTracker
+ *
+ *  This class contains the counters of the replaced global
+ *  allocation functions.
+ ***********************************************************/
+class AllocationTracker
+{
+public:
+	// the number of operator new calls since the program started
+	static uint64_t GetAllocationCount();
+	// the number of bytes those calls asked for
+	static uint64_t GetAllocatedBytes();
+};
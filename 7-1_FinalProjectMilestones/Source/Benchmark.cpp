@@ -0,0 +1,502 @@
+///////////////////////////////////////////////////////////////////////////////
+// benchmark.cpp
+// ============
+// deterministic offscreen benchmark runs along a scripted camera path
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace
+{
+	// statistics of one timing column
+	struct TIMING_STATS
+	{
+		double mean;
+		double min;
+		double p50;
+		double p95;
+		double p99;
+		double max;
+	};
+
+	/***********************************************************
+	 *  GetStats()
+	 *
+	 *  This function is used for computing the statistics of a
+	 *  timing column.  Percentiles use the nearest rank.
+	 ***********************************************************/
+	TIMING_STATS GetStats(const std::vector<double>& values)
+	{
+		TIMING_STATS stats = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+
+		if (values.empty())
+		{
+			return(stats);
+		}
+
+		std::vector<double> sorted = values;
+		std::sort(sorted.begin(), sorted.end());
+
+		double total = 0.0;
+		for (size_t i = 0; i < sorted.size(); i++)
+		{
+			total += sorted[i];
+		}
+
+		size_t last = sorted.size() - 1;
+		stats.mean = total / (double)sorted.size();
+		stats.min = sorted.front();
+		stats.p50 = sorted[(last * 50) / 100];
+		stats.p95 = sorted[(last * 95) / 100];
+		stats.p99 = sorted[(last * 99) / 100];
+		stats.max = sorted.back();
+
+		return(stats);
+	}
+
+	/***********************************************************
+	 *  WriteStats()
+	 *
+	 *  This function is used for writing the statistics of a
+	 *  timing column as a JSON object.
+	 ***********************************************************/
+	void WriteStats(std::ostream& out, const char* name, const TIMING_STATS& stats, bool bLast)
+	{
+		out << "  \"" << name << "\": { "
+			<< "\"mean\": " << stats.mean << ", "
+			<< "\"min\": " << stats.min << ", "
+			<< "\"p50\": " << stats.p50 << ", "
+			<< "\"p95\": " << stats.p95 << ", "
+			<< "\"p99\": " << stats.p99 << ", "
+			<< "\"max\": " << stats.max << " }"
+			<< (bLast ? "\n" : ",\n");
+	}
+
+	/***********************************************************
+	 *  JsonString()
+	 *
+	 *  This function is used for quoting a string for a JSON
+	 *  file, escaping the characters that need it.
+	 ***********************************************************/
+	std::string JsonString(const char* text)
+	{
+		std::string quoted = "\"";
+
+		for (const char* c = text; (NULL != c) && (*c != '\0'); c++)
+		{
+			if ((*c == '"') || (*c == '\\'))
+			{
+				quoted += '\\';
+				quoted += *c;
+			}
+			else if ((unsigned char)*c >= 0x20)
+			{
+				quoted += *c;
+			}
+		}
+		quoted += "\"";
+
+		return(quoted);
+	}
+}
+
+/***********************************************************
+ *  ParseArguments()
+ *
+ *  This method is used for reading the benchmark options of
+ *  the command line:
+ *
+ *      --benchmark [frames]      measured frames (600)
+ *      --warmup <frames>         unmeasured frames (60)
+ *      --resolution <W>x<H>      framebuffer size (1920x1080)
+ *      --camera-path <file>      keyframe file (default orbit)
+ *      --benchmark-output <path> results path (benchmark)
+ *
+ *  It returns false when --benchmark is not present.
+ ***********************************************************/
+bool Benchmark::ParseArguments(int argc, char* argv[], BENCHMARK_SETTINGS& settings)
+{
+	bool bBenchmark = false;
+
+	settings.width = 1920;
+	settings.height = 1080;
+	settings.frames = 600;
+	settings.warmupFrames = 60;
+	settings.frameStep = 1.0f / 60.0f;
+	settings.cameraPathFile.clear();
+	settings.orbitCenter = glm::vec3(0.0f, 4.0f, 0.0f);
+	settings.orbitRadius = 25.0f;
+	settings.outputBase = "benchmark";
+
+	for (int i = 1; i < argc; i++)
+	{
+		bool bHasValue = (i + 1 < argc) && (strncmp(argv[i + 1], "--", 2) != 0);
+
+		if (strcmp(argv[i], "--benchmark") == 0)
+		{
+			bBenchmark = true;
+			if (bHasValue == true)
+			{
+				settings.frames = std::max(1, atoi(argv[++i]));
+			}
+		}
+		else if ((strcmp(argv[i], "--warmup") == 0) && (bHasValue == true))
+		{
+			settings.warmupFrames = std::max(0, atoi(argv[++i]));
+		}
+		else if ((strcmp(argv[i], "--resolution") == 0) && (bHasValue == true))
+		{
+			int width = 0;
+			int height = 0;
+			const char* value = argv[++i];
+			const char* separator = strchr(value, 'x');
+			if (NULL != separator)
+			{
+				width = atoi(value);
+				height = atoi(separator + 1);
+			}
+			if ((width > 0) && (height > 0))
+			{
+				settings.width = width;
+				settings.height = height;
+			}
+			else
+			{
+				std::cout << "Invalid benchmark resolution: " << value << std::endl;
+			}
+		}
+		else if ((strcmp(argv[i], "--camera-path") == 0) && (bHasValue == true))
+		{
+			settings.cameraPathFile = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--benchmark-output") == 0) && (bHasValue == true))
+		{
+			settings.outputBase = argv[++i];
+		}
+	}
+
+	return(bBenchmark);
+}
+
+/***********************************************************
+ *  Benchmark()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+Benchmark::Benchmark(const BENCHMARK_SETTINGS& settings)
+{
+	m_settings = settings;
+	m_pViewManager = NULL;
+	m_framebuffer = 0;
+	m_colorBuffer = 0;
+	m_depthBuffer = 0;
+	for (int q = 0; q < QUERY_FRAMES; q++)
+	{
+		m_queries[q] = 0;
+		m_queryFrames[q] = -1;
+	}
+	m_bTimerQueries = false;
+	m_warmupDone = 0;
+	m_frameIndex = -1;
+	m_framesDone = 0;
+	m_cpuTimes.reserve(settings.frames);
+	m_gpuTimes.reserve(settings.frames);
+}
+
+/***********************************************************
+ *  ~Benchmark()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+Benchmark::~Benchmark()
+{
+	DestroyObjects();
+	m_pViewManager = NULL;
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for creating the offscreen
+ *  framebuffer and the timer queries, loading the camera
+ *  path, and taking the camera away from the user input.
+ ***********************************************************/
+bool Benchmark::Initialize(ViewManager* pViewManager)
+{
+	m_pViewManager = pViewManager;
+
+	if (m_settings.cameraPathFile.empty() == false)
+	{
+		if (m_cameraPath.LoadFile(m_settings.cameraPathFile.c_str()) == false)
+		{
+			return(false);
+		}
+	}
+	else
+	{
+		m_cameraPath.CreateOrbit(
+			(float)m_settings.frames * m_settings.frameStep,
+			m_settings.orbitCenter,
+			m_settings.orbitRadius);
+	}
+
+	glGenRenderbuffers(1, &m_colorBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_colorBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, m_settings.width, m_settings.height);
+	glGenRenderbuffers(1, &m_depthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, m_settings.width, m_settings.height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &m_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colorBuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depthBuffer);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Benchmark framebuffer is not complete: 0x" << std::hex << status << std::dec << std::endl;
+		return(false);
+	}
+
+	m_bTimerQueries = (GLEW_VERSION_3_3 || GLEW_ARB_timer_query) ? true : false;
+	if (m_bTimerQueries == true)
+	{
+		glGenQueries(QUERY_FRAMES, m_queries);
+	}
+
+	if (NULL != m_pViewManager)
+	{
+		m_pViewManager->SetInputEnabled(false);
+		m_pViewManager->SetViewportSize(m_settings.width, m_settings.height);
+	}
+
+	std::cout << "INFO: Benchmark " << m_settings.frames << " frames at "
+		<< m_settings.width << "x" << m_settings.height << std::endl;
+
+	return(true);
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for preparing the next frame - the
+ *  offscreen framebuffer is bound and the camera is placed
+ *  on the path.  Frames are only measured once the scene is
+ *  ready and the warm-up frames are done; until then the
+ *  camera stays at the start of the path.
+ ***********************************************************/
+void Benchmark::BeginFrame(bool bSceneReady)
+{
+	float pathTime = 0.0f;
+
+	m_frameIndex = -1;
+	if ((bSceneReady == true) && (m_warmupDone >= m_settings.warmupFrames))
+	{
+		m_frameIndex = m_framesDone;
+		pathTime = (float)m_frameIndex * m_settings.frameStep;
+	}
+	else if (bSceneReady == true)
+	{
+		m_warmupDone++;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glViewport(0, 0, m_settings.width, m_settings.height);
+
+	if (NULL != m_pViewManager)
+	{
+		CameraPath::CAMERA_KEY pose = m_cameraPath.Evaluate(pathTime);
+		m_pViewManager->SetCameraPose(pose.position, pose.front, pose.zoom);
+	}
+
+	if (m_frameIndex < 0)
+	{
+		return;
+	}
+
+	// the query slot is free again once the frame that used
+	// it is read back, which also keeps the CPU from running
+	// more than QUERY_FRAMES frames ahead of the GPU
+	int slot = m_frameIndex % QUERY_FRAMES;
+	if (m_bTimerQueries == true)
+	{
+		CollectQuery(slot);
+	}
+
+	m_frameStart = CLOCK::now();
+	if (m_bTimerQueries == true)
+	{
+		glBeginQuery(GL_TIME_ELAPSED, m_queries[slot]);
+		m_queryFrames[slot] = m_frameIndex;
+	}
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for recording the CPU time of the
+ *  measured frame and ending its GPU timer query.
+ ***********************************************************/
+void Benchmark::EndFrame()
+{
+	if (m_frameIndex < 0)
+	{
+		glFlush();
+		return;
+	}
+
+	if (m_bTimerQueries == true)
+	{
+		glEndQuery(GL_TIME_ELAPSED);
+	}
+	glFlush();
+
+	std::chrono::duration<double, std::milli> cpuTime = CLOCK::now() - m_frameStart;
+	m_cpuTimes.push_back(cpuTime.count());
+	m_gpuTimes.push_back(0.0);
+	m_framesDone++;
+}
+
+/***********************************************************
+ *  IsFinished()
+ *
+ *  This method is used for checking whether every measured
+ *  frame has been rendered.
+ ***********************************************************/
+bool Benchmark::IsFinished() const
+{
+	return(m_framesDone >= m_settings.frames);
+}
+
+/***********************************************************
+ *  CollectQuery()
+ *
+ *  This method is used for reading the GPU time of the frame
+ *  that issued a query slot, waiting for it if needed.
+ ***********************************************************/
+void Benchmark::CollectQuery(int slot)
+{
+	int frame = m_queryFrames[slot];
+
+	if (frame < 0)
+	{
+		return;
+	}
+
+	GLuint64 elapsedNs = 0;
+	glGetQueryObjectui64v(m_queries[slot], GL_QUERY_RESULT, &elapsedNs);
+	if (frame < (int)m_gpuTimes.size())
+	{
+		m_gpuTimes[frame] = (double)elapsedNs / 1000000.0;
+	}
+	m_queryFrames[slot] = -1;
+}
+
+/***********************************************************
+ *  WriteResults()
+ *
+ *  This method is used for writing the timings of every
+ *  measured frame to <output>.csv and their statistics to
+ *  <output>.json.
+ ***********************************************************/
+bool Benchmark::WriteResults()
+{
+	if (m_bTimerQueries == true)
+	{
+		for (int q = 0; q < QUERY_FRAMES; q++)
+		{
+			CollectQuery(q);
+		}
+	}
+
+	std::string csvFile = m_settings.outputBase + ".csv";
+	std::ofstream csv(csvFile, std::ios::trunc);
+	if (!csv)
+	{
+		std::cout << "Could not write benchmark results: " << csvFile << std::endl;
+		return(false);
+	}
+
+	csv << std::fixed << std::setprecision(4);
+	csv << "frame,cpu_ms,gpu_ms\n";
+	for (size_t i = 0; i < m_cpuTimes.size(); i++)
+	{
+		csv << i << "," << m_cpuTimes[i] << "," << m_gpuTimes[i] << "\n";
+	}
+	csv.close();
+
+	std::string jsonFile = m_settings.outputBase + ".json";
+	std::ofstream json(jsonFile, std::ios::trunc);
+	if (!json)
+	{
+		std::cout << "Could not write benchmark results: " << jsonFile << std::endl;
+		return(false);
+	}
+
+	json << std::fixed << std::setprecision(4);
+	json << "{\n";
+	json << "  \"renderer\": " << JsonString((const char*)glGetString(GL_RENDERER)) << ",\n";
+	json << "  \"vendor\": " << JsonString((const char*)glGetString(GL_VENDOR)) << ",\n";
+	json << "  \"version\": " << JsonString((const char*)glGetString(GL_VERSION)) << ",\n";
+	json << "  \"width\": " << m_settings.width << ",\n";
+	json << "  \"height\": " << m_settings.height << ",\n";
+	json << "  \"frames\": " << m_cpuTimes.size() << ",\n";
+	json << "  \"warmupFrames\": " << m_settings.warmupFrames << ",\n";
+	json << "  \"cameraPath\": " << JsonString(m_settings.cameraPathFile.empty() ? "orbit" : m_settings.cameraPathFile.c_str()) << ",\n";
+	json << "  \"gpuTimerQueries\": " << (m_bTimerQueries ? "true" : "false") << ",\n";
+	WriteStats(json, "cpuMs", GetStats(m_cpuTimes), false);
+	WriteStats(json, "gpuMs", GetStats(m_gpuTimes), true);
+	json << "}\n";
+	json.close();
+
+	TIMING_STATS gpuStats = GetStats(m_gpuTimes);
+	TIMING_STATS cpuStats = GetStats(m_cpuTimes);
+	std::cout << std::fixed << std::setprecision(3)
+		<< "INFO: Benchmark cpu p50 " << cpuStats.p50 << " ms p99 " << cpuStats.p99
+		<< " ms, gpu p50 " << gpuStats.p50 << " ms p99 " << gpuStats.p99 << " ms\n"
+		<< "INFO: Benchmark results written to " << csvFile << " and " << jsonFile << std::endl;
+
+	return(true);
+}
+
+/***********************************************************
+ *  DestroyObjects()
+ *
+ *  This method is used for releasing the framebuffer, its
+ *  attachments and the timer queries.
+ ***********************************************************/
+void Benchmark::DestroyObjects()
+{
+	if (m_framebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &m_framebuffer);
+		m_framebuffer = 0;
+	}
+	if (m_colorBuffer != 0)
+	{
+		glDeleteRenderbuffers(1, &m_colorBuffer);
+		m_colorBuffer = 0;
+	}
+	if (m_depthBuffer != 0)
+	{
+		glDeleteRenderbuffers(1, &m_depthBuffer);
+		m_depthBuffer = 0;
+	}
+	if (m_queries[0] != 0)
+	{
+		glDeleteQueries(QUERY_FRAMES, m_queries);
+		for (int q = 0; q < QUERY_FRAMES; q++)
+		{
+			m_queries[q] = 0;
+		}
+	}
+}
@@ -0,0 +1,117 @@
+///////////////////////////////////////////////////////////////////////////////
+// benchmark.h
+// ============
+// deterministic offscreen benchmark runs along a scripted camera path
+//
+//  In benchmark mode the window stays hidden and every frame is rendered into
+//  an offscreen framebuffer of a fixed size, without vsync.  The camera pose
+//  of a frame depends only on its frame number, so two runs draw exactly the
+//  same frames.  The CPU and GPU time of every measured frame is written to a
+//  CSV file, and their statistics to a JSON file next to it.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "CameraPath.h"
+#include "ViewManager.h"
+
+/***********************************************************
+ *  Benchmark
+ *
+ *  This class contains the offscreen framebuffer, the camera
+ *  path and the timings of one benchmark run.  The main loop
+ *  calls BeginFrame() before and EndFrame() after rendering
+ *  every frame, until IsFinished() returns true.
+ ***********************************************************/
+class Benchmark
+{
+public:
+	// the settings of a benchmark run
+	struct BENCHMARK_SETTINGS
+	{
+		// size of the offscreen framebuffer
+		int width;
+		int height;
+		// number of measured frames
+		int frames;
+		// frames rendered but not measured once the scene is ready
+		int warmupFrames;
+		// camera path time between two frames, in seconds
+		float frameStep;
+		// camera path file, the default orbit when empty
+		std::string cameraPathFile;
+		// the point and the radius of the default orbit
+		glm::vec3 orbitCenter;
+		float orbitRadius;
+		// path of the results without extension
+		std::string outputBase;
+	};
+
+	// read the benchmark options of the command line - returns
+	// false when the --benchmark option is not present
+	static bool ParseArguments(int argc, char* argv[], BENCHMARK_SETTINGS& settings);
+
+	// constructor
+	Benchmark(const BENCHMARK_SETTINGS& settings);
+	// destructor
+	~Benchmark();
+
+	// create the framebuffer and load the camera path - needs a
+	// current GL context
+	bool Initialize(ViewManager* pViewManager);
+
+	// prepare the next frame - the scene is not measured until
+	// it reports that it is ready
+	void BeginFrame(bool bSceneReady);
+	// record the timings of the frame
+	void EndFrame();
+	// true when every measured frame has been rendered
+	bool IsFinished() const;
+
+	// write the CSV and JSON result files
+	bool WriteResults();
+
+private:
+	typedef std::chrono::steady_clock CLOCK;
+
+	// number of frames whose GPU timer queries are in flight
+	static const int QUERY_FRAMES = 4;
+
+	BENCHMARK_SETTINGS m_settings;
+	ViewManager* m_pViewManager;
+	CameraPath m_cameraPath;
+
+	// offscreen framebuffer and its attachments
+	GLuint m_framebuffer;
+	GLuint m_colorBuffer;
+	GLuint m_depthBuffer;
+
+	// GPU timer query of every frame in flight
+	GLuint m_queries[QUERY_FRAMES];
+	// measured frame that issued each query, -1 when none
+	int m_queryFrames[QUERY_FRAMES];
+	bool m_bTimerQueries;
+
+	// warm-up frames rendered after the scene was ready
+	int m_warmupDone;
+	// index of the measured frame being rendered, -1 in warm-up
+	int m_frameIndex;
+	// number of measured frames rendered
+	int m_framesDone;
+	CLOCK::time_point m_frameStart;
+
+	// CPU and GPU time of every measured frame
+	std::vector<double> m_cpuTimes;
+	std::vector<double> m_gpuTimes;
+
+	// read the result of a query slot into its frame
+	void CollectQuery(int slot);
+	// release the GL objects
+	void DestroyObjects();
+};
@@ -0,0 +1,122 @@
+///////////////////////////////////////////////////////////////////////////////
+// boundingvolumes.cpp
+// ============
+// axis-aligned bounding boxes and view frustum tests
+///////////////////////////////////////////////////////////////////////////////
+
+#include "BoundingVolumes.h"
+
+/***********************************************************
+ *  TransformAABB()
+ *
+ *  This function is used for getting the bounds of a box
+ *  under a transformation.  The half size of the result is
+ *  the half size of the box through the absolute values of
+ *  the rotation and scale part of the matrix.
+ ***********************************************************/
+AABB TransformAABB(const AABB& box, const glm::mat4& matrix)
+{
+	glm::vec3 center = (box.min + box.max) * 0.5f;
+	glm::vec3 extent = (box.max - box.min) * 0.5f;
+
+	glm::vec3 worldCenter = glm::vec3(matrix * glm::vec4(center, 1.0f));
+	glm::vec3 worldExtent =
+		glm::abs(glm::vec3(matrix[0])) * extent.x +
+		glm::abs(glm::vec3(matrix[1])) * extent.y +
+		glm::abs(glm::vec3(matrix[2])) * extent.z;
+
+	AABB result;
+	result.min = worldCenter - worldExtent;
+	result.max = worldCenter + worldExtent;
+
+	return(result);
+}
+
+/***********************************************************
+ *  MergeAABB()
+ *
+ *  This function is used for getting the bounds that
+ *  contain both of the passed in boxes.
+ ***********************************************************/
+AABB MergeAABB(const AABB& a, const AABB& b)
+{
+	AABB result;
+	result.min = glm::min(a.min, b.min);
+	result.max = glm::max(a.max, b.max);
+
+	return(result);
+}
+
+/***********************************************************
+ *  SetViewProjection()
+ *
+ *  This method is used for building the frustum planes from
+ *  the rows of a projection * view matrix.  The planes are
+ *  normalized so the box tests compare real distances.
+ ***********************************************************/
+void Frustum::SetViewProjection(const glm::mat4& viewProjection)
+{
+	// glm matrices are column major, so build the rows first
+	glm::vec4 rows[4];
+	for (int r = 0; r < 4; r++)
+	{
+		rows[r] = glm::vec4(
+			viewProjection[0][r],
+			viewProjection[1][r],
+			viewProjection[2][r],
+			viewProjection[3][r]);
+	}
+
+	m_planes[0] = rows[3] + rows[0];	// left
+	m_planes[1] = rows[3] - rows[0];	// right
+	m_planes[2] = rows[3] + rows[1];	// bottom
+	m_planes[3] = rows[3] - rows[1];	// top
+	m_planes[4] = rows[3] + rows[2];	// near
+	m_planes[5] = rows[3] - rows[2];	// far
+
+	for (int p = 0; p < PLANE_COUNT; p++)
+	{
+		float length = glm::length(glm::vec3(m_planes[p]));
+		if (length > 0.0f)
+		{
+			m_planes[p] /= length;
+		}
+	}
+}
+
+/***********************************************************
+ *  TestAABB()
+ *
+ *  This method is used for testing a box against the planes
+ *  that are set in the plane mask.  Planes the box is
+ *  completely inside of are cleared from the mask.
+ ***********************************************************/
+CULL_RESULT Frustum::TestAABB(const AABB& box, unsigned int& planeMask) const
+{
+	glm::vec3 center = (box.min + box.max) * 0.5f;
+	glm::vec3 extent = (box.max - box.min) * 0.5f;
+
+	for (int p = 0; p < PLANE_COUNT; p++)
+	{
+		unsigned int planeBit = 1u << p;
+		if ((planeMask & planeBit) == 0)
+		{
+			continue;
+		}
+
+		glm::vec3 normal = glm::vec3(m_planes[p]);
+		float distance = glm::dot(normal, center) + m_planes[p].w;
+		float radius = glm::dot(glm::abs(normal), extent);
+
+		if (distance + radius < 0.0f)
+		{
+			return(CULL_OUTSIDE);
+		}
+		if (distance - radius >= 0.0f)
+		{
+			planeMask &= ~planeBit;
+		}
+	}
+
+	return((planeMask == 0) ? CULL_INSIDE : CULL_INTERSECT);
+}
@@ -0,0 +1,64 @@
+///////////////////////////////////////////////////////////////////////////////
+// boundingvolumes.h
+// ============
+// axis-aligned bounding boxes and view frustum tests
+//
+//  The six frustum planes are taken from the rows of the combined
+//  projection * view matrix, which works the same way for perspective and
+//  orthographic projections.  Boxes are tested with their center and half
+//  size, so a test is one dot product and one absolute dot product per plane.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+// an axis-aligned bounding box
+struct AABB
+{
+	glm::vec3 min;
+	glm::vec3 max;
+};
+
+// the result of testing a box against a frustum
+enum CULL_RESULT
+{
+	CULL_OUTSIDE,		// completely outside - not drawn
+	CULL_INTERSECT,		// partly inside
+	CULL_INSIDE			// completely inside - children need no test
+};
+
+// get the bounds of a transformed box
+AABB TransformAABB(const AABB& box, const glm::mat4& matrix);
+// get the bounds that contain both boxes
+AABB MergeAABB(const AABB& a, const AABB& b);
+
+/***********************************************************
+ *  Frustum
+ *
+ *  This class contains the six planes of a view frustum in
+ *  world space, with their normals pointing inwards.
+ ***********************************************************/
+class Frustum
+{
+public:
+	// the number of frustum planes
+	static const int PLANE_COUNT = 6;
+	// a plane mask with every plane set
+	static const unsigned int ALL_PLANES = (1u << PLANE_COUNT) - 1u;
+
+	// build the planes from a projection * view matrix
+	void SetViewProjection(const glm::mat4& viewProjection);
+
+	// test a box against the planes in the mask - the bits of
+	// the planes the box is completely inside are cleared, so
+	// the children of the box only test the remaining planes
+	CULL_RESULT TestAABB(const AABB& box, unsigned int& planeMask) const;
+
+	// the planes, in the order left, right, bottom, top, near, far
+	const glm::vec4* GetPlanes() const { return(m_planes); }
+
+private:
+	// plane normal in xyz and distance in w
+	glm::vec4 m_planes[PLANE_COUNT];
+};
@@ -0,0 +1,200 @@
+///////////////////////////////////////////////////////////////////////////////
+// camerapath.cpp
+// ============
+// scripted camera path made of timed keyframes
+///////////////////////////////////////////////////////////////////////////////
+
+#include "CameraPath.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace
+{
+	// number of keyframes of the default orbit
+	const int ORBIT_KEYS = 16;
+
+	/***********************************************************
+	 *  CatmullRom()
+	 *
+	 *  This function is used for interpolating between p1 and
+	 *  p2 with the neighbouring points p0 and p3.
+	 ***********************************************************/
+	glm::vec3 CatmullRom(
+		const glm::vec3& p0,
+		const glm::vec3& p1,
+		const glm::vec3& p2,
+		const glm::vec3& p3,
+		float t)
+	{
+		float t2 = t * t;
+		float t3 = t2 * t;
+
+		return(0.5f * ((2.0f * p1) +
+			(p2 - p0) * t +
+			(2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 +
+			(3.0f * p1 - p0 - 3.0f * p2 + p3) * t3));
+	}
+}
+
+/***********************************************************
+ *  LoadFile()
+ *
+ *  This method is used for loading the keyframes of a path
+ *  file.  The keyframes are sorted by time, so they can be
+ *  written in any order.
+ ***********************************************************/
+bool CameraPath::LoadFile(const char* filename)
+{
+	std::ifstream file(filename);
+	std::string line;
+	int lineNumber = 0;
+
+	if (!file)
+	{
+		std::cout << "Could not open camera path file: " << filename << std::endl;
+		return(false);
+	}
+
+	m_keys.clear();
+	while (std::getline(file, line))
+	{
+		lineNumber++;
+
+		size_t first = line.find_first_not_of(" \t\r");
+		if ((first == std::string::npos) || (line[first] == '#'))
+		{
+			continue;
+		}
+
+		CAMERA_KEY key;
+		std::istringstream values(line);
+		values >> key.time
+			>> key.position.x >> key.position.y >> key.position.z
+			>> key.front.x >> key.front.y >> key.front.z
+			>> key.zoom;
+		if ((!values) || (glm::length(key.front) < 1e-6f))
+		{
+			std::cout << "Invalid camera path keyframe at line " << lineNumber
+				<< " of " << filename << std::endl;
+			m_keys.clear();
+			return(false);
+		}
+
+		key.front = glm::normalize(key.front);
+		m_keys.push_back(key);
+	}
+
+	if (m_keys.empty())
+	{
+		std::cout << "Camera path file has no keyframes: " << filename << std::endl;
+		return(false);
+	}
+
+	std::stable_sort(m_keys.begin(), m_keys.end(),
+		[](const CAMERA_KEY& a, const CAMERA_KEY& b) { return(a.time < b.time); });
+
+	return(true);
+}
+
+/***********************************************************
+ *  CreateOrbit()
+ *
+ *  This method is used for building the default path, one
+ *  orbit around a point that rises and falls once on the
+ *  way around.  With the default center and radius it
+ *  starts at the default camera position.
+ ***********************************************************/
+void CameraPath::CreateOrbit(float duration, const glm::vec3& center, float radius)
+{
+	const float twoPi = 6.28318530718f;
+
+	m_keys.clear();
+	for (int i = 0; i <= ORBIT_KEYS; i++)
+	{
+		float fraction = (float)i / (float)ORBIT_KEYS;
+		float angle = fraction * twoPi;
+
+		CAMERA_KEY key;
+		key.time = fraction * duration;
+		key.position = center + glm::vec3(
+			radius * sinf(angle),
+			radius * (0.32f - 0.24f * sinf(angle * 0.5f)),
+			radius * cosf(angle));
+		key.front = glm::normalize(center - key.position);
+		key.zoom = 80.0f;
+		m_keys.push_back(key);
+	}
+}
+
+/***********************************************************
+ *  Evaluate()
+ *
+ *  This method is used for getting the camera pose at a
+ *  time along the path.  Times before the first or after
+ *  the last keyframe give that keyframe.
+ ***********************************************************/
+CameraPath::CAMERA_KEY CameraPath::Evaluate(float time) const
+{
+	CAMERA_KEY pose;
+
+	if (m_keys.empty())
+	{
+		pose.time = time;
+		pose.position = glm::vec3(0.0f, 12.0f, 25.0f);
+		pose.front = glm::normalize(glm::vec3(0.0f, -0.5f, -2.0f));
+		pose.zoom = 80.0f;
+		return(pose);
+	}
+	if (time <= m_keys.front().time)
+	{
+		return(m_keys.front());
+	}
+	if (time >= m_keys.back().time)
+	{
+		return(m_keys.back());
+	}
+
+	// find the segment that contains the time
+	size_t next = 1;
+	while (m_keys[next].time < time)
+	{
+		next++;
+	}
+	size_t previous = next - 1;
+
+	const CAMERA_KEY& k1 = m_keys[previous];
+	const CAMERA_KEY& k2 = m_keys[next];
+	const CAMERA_KEY& k0 = m_keys[(previous > 0) ? previous - 1 : previous];
+	const CAMERA_KEY& k3 = m_keys[(next + 1 < m_keys.size()) ? next + 1 : next];
+
+	float span = k2.time - k1.time;
+	float t = (span > 0.0f) ? (time - k1.time) / span : 0.0f;
+
+	pose.time = time;
+	pose.position = CatmullRom(k0.position, k1.position, k2.position, k3.position, t);
+	pose.front = glm::normalize(glm::mix(k1.front, k2.front, t));
+	pose.zoom = k1.zoom + (k2.zoom - k1.zoom) * t;
+
+	return(pose);
+}
+
+/***********************************************************
+ *  GetDuration()
+ *
+ *  This method is used for getting the time of the last
+ *  keyframe of the path.
+ ***********************************************************/
+float CameraPath::GetDuration() const
+{
+	if (m_keys.empty())
+	{
+		return(0.0f);
+	}
+
+	return(m_keys.back().time);
+}
@@ -0,0 +1,53 @@
+///////////////////////////////////////////////////////////////////////////////
+// camerapath.h
+// ============
+// scripted camera path made of timed keyframes
+//
+//  A path file is plain text with one keyframe per line:
+//
+//      time  posX posY posZ  frontX frontY frontZ  zoom
+//
+//  Blank lines and lines starting with '#' are skipped.  Positions are
+//  interpolated with a Catmull-Rom spline through the keyframes, the view
+//  direction and the zoom are interpolated linearly.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  CameraPath
+ *
+ *  This class contains the keyframes of a camera path and
+ *  evaluates the camera pose at any time along it.
+ ***********************************************************/
+class CameraPath
+{
+public:
+	// one keyframe of the path
+	struct CAMERA_KEY
+	{
+		float time;
+		glm::vec3 position;
+		glm::vec3 front;
+		float zoom;
+	};
+
+	// load the keyframes of a path file, sorted by time
+	bool LoadFile(const char* filename);
+	// build the default path - one orbit around a point
+	void CreateOrbit(float duration, const glm::vec3& center, float radius);
+
+	// the camera pose at a time, clamped to the ends of the path
+	CAMERA_KEY Evaluate(float time) const;
+
+	// the time of the last keyframe
+	float GetDuration() const;
+	bool IsEmpty() const { return(m_keys.empty()); }
+
+private:
+	std::vector<CAMERA_KEY> m_keys;
+};
@@ -0,0 +1,95 @@
+///////////////////////////////////////////////////////////////////////////////
+// drawqueue.cpp
+// ============
+// collect draw records and sort them by render state before submission
+///////////////////////////////////////////////////////////////////////////////
+
+#include "DrawQueue.h"
+
+#include <algorithm>
+
+namespace
+{
+	// each state field gets 16 bits of the sort key
+	const uint64_t g_KeyFieldMask = 0xFFFF;
+
+	// order records by their sort key only
+	bool CompareSortKeys(
+		const DrawQueue::DRAW_RECORD& left,
+		const DrawQueue::DRAW_RECORD& right)
+	{
+		return(left.sortKey < right.sortKey);
+	}
+}
+
+/***********************************************************
+ *  MakeSortKey()
+ *
+ *  This method is used for packing a render state into a
+ *  sort key.  The program is the most significant field,
+ *  followed by the texture binding, the material and the mesh.
+ ***********************************************************/
+uint64_t DrawQueue::MakeSortKey(
+	GLuint programID,
+	int textureBinding,
+	int materialIndex,
+	int mesh)
+{
+	uint64_t sortKey = 0;
+
+	sortKey |= ((uint64_t)programID & g_KeyFieldMask) << 48;
+	sortKey |= ((uint64_t)(textureBinding + 1) & g_KeyFieldMask) << 32;
+	sortKey |= ((uint64_t)(materialIndex + 1) & g_KeyFieldMask) << 16;
+	sortKey |= ((uint64_t)mesh & g_KeyFieldMask);
+
+	return(sortKey);
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing all of the queued
+ *  records.  The record storage is kept for the next pass.
+ ***********************************************************/
+void DrawQueue::Clear()
+{
+	m_records.clear();
+}
+
+/***********************************************************
+ *  Submit()
+ *
+ *  This method is used for adding a draw record with its
+ *  render state to the queue.
+ ***********************************************************/
+void DrawQueue::Submit(
+	GLuint programID,
+	int textureBinding,
+	int materialIndex,
+	int mesh,
+	int objectIndex)
+{
+	DRAW_RECORD record;
+
+	record.sortKey = MakeSortKey(programID, textureBinding, materialIndex, mesh);
+	record.programID = programID;
+	record.textureBinding = textureBinding;
+	record.materialIndex = materialIndex;
+	record.mesh = mesh;
+	record.objectIndex = objectIndex;
+
+	m_records.push_back(record);
+}
+
+/***********************************************************
+ *  Sort()
+ *
+ *  This method is used for ordering the queued records by
+ *  render state.  A stable sort keeps records with the same
+ *  state in submission order, so the result is the same on
+ *  every run.
+ ***********************************************************/
+void DrawQueue::Sort()
+{
+	std::stable_sort(m_records.begin(), m_records.end(), CompareSortKeys);
+}
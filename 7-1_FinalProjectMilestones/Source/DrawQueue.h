@@ -0,0 +1,71 @@
+///////////////////////////////////////////////////////////////////////////////
+// drawqueue.h
+// ============
+// collect draw records and sort them by render state before submission
+//
+//  Every record carries a 64-bit sort key built from the shader program, the
+//  bound texture, the material and the mesh, most expensive state first.  After
+//  sorting, records that share a state are next to each other, so the number
+//  of state changes follows the number of distinct states, not the number of
+//  drawn objects.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  DrawQueue
+ *
+ *  This class contains the draw records of one pass.  The
+ *  queue does not draw anything itself, the owner walks the
+ *  sorted records and submits them.
+ ***********************************************************/
+class DrawQueue
+{
+public:
+	// one queued draw and the render state it needs
+	struct DRAW_RECORD
+	{
+		uint64_t sortKey;
+		GLuint programID;
+		// the texture slot, or the texture array when arrays are used
+		int textureBinding;
+		int materialIndex;
+		int mesh;
+		// index of the drawn object in the owner's object list
+		int objectIndex;
+	};
+
+	// build the sort key of a render state - no texture and no
+	// material (-1) sort ahead of every real slot and material
+	static uint64_t MakeSortKey(
+		GLuint programID,
+		int textureBinding,
+		int materialIndex,
+		int mesh);
+
+	// remove all of the queued records
+	void Clear();
+	// add a draw record to the queue
+	void Submit(
+		GLuint programID,
+		int textureBinding,
+		int materialIndex,
+		int mesh,
+		int objectIndex);
+	// order the records by sort key, keeping the submission
+	// order of records that share a key
+	void Sort();
+
+	// the queued records, sorted after Sort() was called
+	const std::vector<DRAW_RECORD>& GetRecords() const { return(m_records); }
+	size_t Size() const { return(m_records.size()); }
+
+private:
+	std::vector<DRAW_RECORD> m_records;
+};
@@ -0,0 +1,233 @@
+///////////////////////////////////////////////////////////////////////////////
+// drawrecordring.cpp
+// ============
+// stream the per-draw shader values through a persistently mapped ring of
+// uniform buffer memory
+///////////////////////////////////////////////////////////////////////////////
+
+#include "DrawRecordRing.h"
+
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// the flags of the buffer storage and of its mapping
+	const GLbitfield g_MapFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	// how long one wait for a fence lasts before it is retried
+	const GLuint64 g_FenceTimeout = 1000000;	// 1ms in nanoseconds
+}
+
+/***********************************************************
+ *  DrawRecordRing()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+DrawRecordRing::DrawRecordRing()
+{
+	m_buffer = 0;
+	m_mappedRecords = NULL;
+	m_frameRecords = 0;
+	for (int f = 0; f < FRAME_COUNT; f++)
+	{
+		m_fences[f] = 0;
+	}
+	m_frame = 0;
+	m_boundWindow = -1;
+	m_stallCount = 0;
+}
+
+/***********************************************************
+ *  ~DrawRecordRing()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+DrawRecordRing::~DrawRecordRing()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  IsSupported()
+ *
+ *  This method is used for checking whether the context can
+ *  create immutable buffer storage that stays mapped while
+ *  the GPU reads it.
+ ***********************************************************/
+bool DrawRecordRing::IsSupported()
+{
+	return((GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage) ? true : false);
+}
+
+/***********************************************************
+ *  Reserve()
+ *
+ *  This method is used for growing the frame regions to
+ *  hold the passed in number of records.  The storage of a
+ *  persistent buffer cannot be resized, so a larger buffer
+ *  replaces it once the GPU is done with every region.  The
+ *  regions are whole windows, so every window offset is a
+ *  multiple of the window size.
+ ***********************************************************/
+bool DrawRecordRing::Reserve(int recordCount)
+{
+	if ((m_buffer != 0) && (recordCount <= m_frameRecords))
+	{
+		return(true);
+	}
+
+	int windowCount = (recordCount + TOTAL_DRAW_RECORDS - 1) / TOTAL_DRAW_RECORDS;
+	int frameRecords = ((windowCount > 0) ? windowCount : 1) * TOTAL_DRAW_RECORDS;
+
+	GLint offsetAlignment = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &offsetAlignment);
+	if ((offsetAlignment > 0) && ((sizeof(UBO_DRAW_BLOCK) % offsetAlignment) != 0))
+	{
+		std::cout << "The draw block size does not match the uniform buffer offset alignment" << std::endl;
+		return(false);
+	}
+
+	Destroy();
+
+	GLsizeiptr size = (GLsizeiptr)FRAME_COUNT * frameRecords * sizeof(UBO_DRAW_RECORD);
+
+	glGenBuffers(1, &m_buffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+	glBufferStorage(GL_UNIFORM_BUFFER, size, NULL, g_MapFlags);
+	m_mappedRecords = (UBO_DRAW_RECORD*)glMapBufferRange(GL_UNIFORM_BUFFER, 0, size, g_MapFlags);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	if (NULL == m_mappedRecords)
+	{
+		std::cout << "Could not map the draw record ring buffer" << std::endl;
+		Destroy();
+		return(false);
+	}
+
+	m_frameRecords = frameRecords;
+	m_frame = 0;
+	m_boundWindow = -1;
+
+	return(true);
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for moving on to the next frame
+ *  region and waiting until the draws of the frame that
+ *  last used it have finished on the GPU.
+ ***********************************************************/
+UBO_DRAW_RECORD* DrawRecordRing::BeginFrame()
+{
+	if (NULL == m_mappedRecords)
+	{
+		return(NULL);
+	}
+
+	m_frame = (m_frame + 1) % FRAME_COUNT;
+	m_boundWindow = -1;
+	WaitForRegion(m_frame);
+
+	return(m_mappedRecords + ((size_t)m_frame * m_frameRecords));
+}
+
+/***********************************************************
+ *  BindRecord()
+ *
+ *  This method is used for binding the window of the draw
+ *  block that holds a record of the current region.  The
+ *  records of a frame are drawn in order, so the window only
+ *  changes once every TOTAL_DRAW_RECORDS draws.
+ ***********************************************************/
+int DrawRecordRing::BindRecord(int record)
+{
+	int window = record / TOTAL_DRAW_RECORDS;
+
+	if (window != m_boundWindow)
+	{
+		size_t firstRecord = ((size_t)m_frame * m_frameRecords) + ((size_t)window * TOTAL_DRAW_RECORDS);
+		glBindBufferRange(GL_UNIFORM_BUFFER, DRAW_BLOCK_BINDING, m_buffer,
+			(GLintptr)(firstRecord * sizeof(UBO_DRAW_RECORD)), sizeof(UBO_DRAW_BLOCK));
+		m_boundWindow = window;
+	}
+
+	return(record - (window * TOTAL_DRAW_RECORDS));
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for fencing the draws that read the
+ *  current region, so that the region is not written again
+ *  before they have finished.
+ ***********************************************************/
+void DrawRecordRing::EndFrame()
+{
+	if (NULL == m_mappedRecords)
+	{
+		return;
+	}
+
+	m_fences[m_frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+/***********************************************************
+ *  WaitForRegion()
+ *
+ *  This method is used for waiting for the fence of a frame
+ *  region.  The first wait only polls, so a frame that has to
+ *  wait for the GPU is counted as a stall.
+ ***********************************************************/
+void DrawRecordRing::WaitForRegion(int frame)
+{
+	if (m_fences[frame] == 0)
+	{
+		return;
+	}
+
+	GLenum result = glClientWaitSync(m_fences[frame], 0, 0);
+	if (result == GL_TIMEOUT_EXPIRED)
+	{
+		m_stallCount++;
+		// flush once, so the fence is sure to be signaled
+		GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+		do
+		{
+			result = glClientWaitSync(m_fences[frame], flags, g_FenceTimeout);
+			flags = 0;
+		} while (result == GL_TIMEOUT_EXPIRED);
+	}
+
+	glDeleteSync(m_fences[frame]);
+	m_fences[frame] = 0;
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for waiting until the GPU is done
+ *  with every region and releasing the ring buffer.
+ ***********************************************************/
+void DrawRecordRing::Destroy()
+{
+	for (int f = 0; f < FRAME_COUNT; f++)
+	{
+		WaitForRegion(f);
+	}
+
+	if (m_buffer != 0)
+	{
+		if (NULL != m_mappedRecords)
+		{
+			glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+			glUnmapBuffer(GL_UNIFORM_BUFFER);
+			glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		}
+		glDeleteBuffers(1, &m_buffer);
+		m_buffer = 0;
+	}
+	m_mappedRecords = NULL;
+	m_frameRecords = 0;
+	m_boundWindow = -1;
+}
@@ -0,0 +1,79 @@
+///////////////////////////////////////////////////////////////////////////////
+// drawrecordring.h
+// ============
+// stream the per-draw shader values through a persistently mapped ring of
+// uniform buffer memory
+//
+//  The buffer is mapped once and stays mapped, with one region per frame in
+//  flight.  A frame writes the model matrix, color, UV scale, texture layer
+//  and material of every draw straight into its region, and each draw only
+//  sets the index of its record, instead of one glUniform call per value.
+//  A fence after the draws of a frame keeps the CPU from overwriting a region
+//  that the GPU still reads.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include "UniformBuffers.h"
+
+/***********************************************************
+ *  DrawRecordRing
+ *
+ *  This class contains the mapped ring buffer and the fence
+ *  of each frame region.  The shader reads the records as
+ *  the DrawBlock uniform block, which holds a window of
+ *  TOTAL_DRAW_RECORDS records of the current region.
+ ***********************************************************/
+class DrawRecordRing
+{
+public:
+	// number of frames the ring has regions for
+	static const int FRAME_COUNT = 3;
+
+	// constructor
+	DrawRecordRing();
+	// destructor
+	~DrawRecordRing();
+
+	// true when the context can create persistently mapped buffers
+	static bool IsSupported();
+
+	// make every frame region large enough for the passed in
+	// number of records - false when the buffer cannot be mapped
+	bool Reserve(int recordCount);
+
+	// wait until the GPU is done with the next frame region and
+	// get its records for writing
+	UBO_DRAW_RECORD* BeginFrame();
+	// bind the window of the draw block that holds a record of
+	// the current region - returns the index of the record in
+	// that window, for the drawIndex uniform
+	int BindRecord(int record);
+	// fence the draws that read the current region
+	void EndFrame();
+
+	// number of frames that had to wait for the GPU
+	int GetStallCount() const { return(m_stallCount); }
+
+	// unmap and release the ring buffer
+	void Destroy();
+
+private:
+	// the ring buffer and its persistent mapping
+	GLuint m_buffer;
+	UBO_DRAW_RECORD* m_mappedRecords;
+	// the records of one frame region, a multiple of the window size
+	int m_frameRecords;
+	// the fence of the last frame that used each region
+	GLsync m_fences[FRAME_COUNT];
+	// the region of the current frame
+	int m_frame;
+	// the window of the current region bound to the draw block
+	int m_boundWindow;
+	int m_stallCount;
+
+	// wait for the fence of a region and delete it
+	void WaitForRegion(int frame);
+};
@@ -0,0 +1,564 @@
+///////////////////////////////////////////////////////////////////////////////
+// dynamicresolution.cpp
+// ============
+// render the scene offscreen at a resolution that follows the GPU frame time,
+// and resolve it to the window with temporal anti-aliasing
+///////////////////////////////////////////////////////////////////////////////
+
+#include "DynamicResolution.h"
+#include "ProgramBuilder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// the texture units the resolve pass reads from, their
+	// bindings are restored afterwards
+	const int g_CurrentColorUnit = 0;
+	const int g_CurrentDepthUnit = 1;
+	const int g_HistoryColorUnit = 2;
+	const int g_ResolveUnitCount = 3;
+
+	// the weight of a new GPU frame time in the smoothed time
+	const double g_TimeSmoothing = 0.2;
+	// the scale aims this far below the frame time target, so
+	// small spikes do not miss it
+	const double g_TargetHeadroom = 0.9;
+	// frames between two scale changes, longer than the queries
+	// are in flight so a change is measured before the next one
+	const int g_AdjustFrames = 8;
+	// the largest and the smallest change of the scale
+	const float g_MaxScaleStep = 0.05f;
+	const float g_ScaleDeadband = 0.02f;
+
+	// number of jitter offsets before the sequence repeats, and
+	// so the frames a still view takes to converge
+	const int g_JitterCount = 8;
+
+	// the radical inverse of an index in a base, the sub-pixel
+	// offsets of the Halton sequence
+	float Halton(int index, int base)
+	{
+		float result = 0.0f;
+		float fraction = 1.0f / (float)base;
+
+		while (index > 0)
+		{
+			result += (float)(index % base) * fraction;
+			index /= base;
+			fraction /= (float)base;
+		}
+
+		return(result);
+	}
+}
+
+/***********************************************************
+ *  DynamicResolution()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+DynamicResolution::DynamicResolution()
+{
+	m_programID = 0;
+	m_currentColorLocation = -1;
+	m_currentDepthLocation = -1;
+	m_historyColorLocation = -1;
+	m_renderScaleLocation = -1;
+	m_renderTexelLocation = -1;
+	m_jitterLocation = -1;
+	m_reprojectionLocation = -1;
+	m_useHistoryLocation = -1;
+	m_vertexArray = 0;
+	m_sceneFramebuffer = 0;
+	m_sceneColor = 0;
+	m_sceneDepth = 0;
+	m_historyFramebuffers[0] = 0;
+	m_historyFramebuffers[1] = 0;
+	m_historyColors[0] = 0;
+	m_historyColors[1] = 0;
+	m_targetWidth = 0;
+	m_targetHeight = 0;
+	m_historyIndex = 0;
+	m_bHistoryValid = false;
+	for (int q = 0; q < QUERY_FRAMES; q++)
+	{
+		m_queries[q][0] = 0;
+		m_queries[q][1] = 0;
+		m_bQueryPending[q] = false;
+	}
+	m_querySlot = 0;
+	m_bTimerQueries = false;
+	m_targetFrameTime = 1000.0 / 60.0;
+	m_gpuFrameTime = 0.0;
+	m_framesSinceChange = 0;
+	m_scale = 1.0f;
+	m_minScale = 0.5f;
+	m_renderWidth = 0;
+	m_renderHeight = 0;
+	m_bTemporal = true;
+	m_jitterIndex = 0;
+	m_jitter = glm::vec2(0.0f);
+	m_previousViewProjection = glm::mat4(1.0f);
+	m_stillFrames = 0;
+	m_savedFramebuffer = 0;
+}
+
+/***********************************************************
+ *  ~DynamicResolution()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+DynamicResolution::~DynamicResolution()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for building the resolve program and
+ *  creating the timestamp queries.  Without timestamps the
+ *  frame is still resolved, at a fixed scale.
+ ***********************************************************/
+bool DynamicResolution::Initialize(const char* vertexShaderFile, const char* fragmentShaderFile)
+{
+	m_programID = ProgramBuilder::BuildProgram(vertexShaderFile, fragmentShaderFile);
+	if (m_programID == 0)
+	{
+		return(false);
+	}
+
+	m_currentColorLocation = glGetUniformLocation(m_programID, "currentColor");
+	m_currentDepthLocation = glGetUniformLocation(m_programID, "currentDepth");
+	m_historyColorLocation = glGetUniformLocation(m_programID, "historyColor");
+	m_renderScaleLocation = glGetUniformLocation(m_programID, "renderScale");
+	m_renderTexelLocation = glGetUniformLocation(m_programID, "renderTexel");
+	m_jitterLocation = glGetUniformLocation(m_programID, "jitter");
+	m_reprojectionLocation = glGetUniformLocation(m_programID, "reprojection");
+	m_useHistoryLocation = glGetUniformLocation(m_programID, "bUseHistory");
+
+	glGenVertexArrays(1, &m_vertexArray);
+
+	m_bTimerQueries = (GLEW_VERSION_3_3 || GLEW_ARB_timer_query) ? true : false;
+	if (m_bTimerQueries == true)
+	{
+		for (int q = 0; q < QUERY_FRAMES; q++)
+		{
+			glGenQueries(2, m_queries[q]);
+		}
+	}
+	else
+	{
+		std::cout << "Timestamp queries are not supported, rendering at a fixed resolution" << std::endl;
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  SetTargetFrameRate()
+ *
+ *  This method is used for setting the frame rate that the
+ *  resolution scale is chosen for.
+ ***********************************************************/
+void DynamicResolution::SetTargetFrameRate(double framesPerSecond)
+{
+	if (framesPerSecond > 0.0)
+	{
+		m_targetFrameTime = 1000.0 / framesPerSecond;
+	}
+}
+
+/***********************************************************
+ *  SetMinScale()
+ *
+ *  This method is used for setting the smallest resolution
+ *  scale, as a fraction of the window width and height.
+ ***********************************************************/
+void DynamicResolution::SetMinScale(float minScale)
+{
+	m_minScale = std::min(std::max(minScale, 0.25f), 1.0f);
+	m_scale = std::max(m_scale, m_minScale);
+}
+
+/***********************************************************
+ *  SetTemporalEnabled()
+ *
+ *  This method is used for turning the jitter and the
+ *  history blend on or off.
+ ***********************************************************/
+void DynamicResolution::SetTemporalEnabled(bool bEnabled)
+{
+	m_bTemporal = bEnabled;
+	m_bHistoryValid = false;
+}
+
+/***********************************************************
+ *  CreateTargets()
+ *
+ *  This method is used for creating the scene target and
+ *  the history targets for a window size.  The history is
+ *  kept at a higher precision than the window, so the small
+ *  steps of the blend do not band.
+ ***********************************************************/
+bool DynamicResolution::CreateTargets(int width, int height)
+{
+	DestroyTargets();
+	m_targetWidth = width;
+	m_targetHeight = height;
+
+	glGenTextures(1, &m_sceneColor);
+	glBindTexture(GL_TEXTURE_2D, m_sceneColor);
+	glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, width, height);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	glGenTextures(1, &m_sceneDepth);
+	glBindTexture(GL_TEXTURE_2D, m_sceneDepth);
+	glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT32F, width, height);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	glGenFramebuffers(1, &m_sceneFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_sceneFramebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_sceneColor, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_sceneDepth, 0);
+	bool bComplete = (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+
+	for (int i = 0; i < 2; i++)
+	{
+		glGenTextures(1, &m_historyColors[i]);
+		glBindTexture(GL_TEXTURE_2D, m_historyColors[i]);
+		glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA16F, width, height);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+		glGenFramebuffers(1, &m_historyFramebuffers[i]);
+		glBindFramebuffer(GL_FRAMEBUFFER, m_historyFramebuffers[i]);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_historyColors[i], 0);
+		bComplete = bComplete && (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)m_savedFramebuffer);
+
+	m_bHistoryValid = false;
+	if (bComplete == false)
+	{
+		std::cout << "Dynamic resolution framebuffer is incomplete" << std::endl;
+		DestroyTargets();
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  DestroyTargets()
+ *
+ *  This method is used for releasing the scene target and
+ *  the history targets.
+ ***********************************************************/
+void DynamicResolution::DestroyTargets()
+{
+	if (m_sceneFramebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &m_sceneFramebuffer);
+		m_sceneFramebuffer = 0;
+	}
+	if (m_sceneColor != 0)
+	{
+		glDeleteTextures(1, &m_sceneColor);
+		m_sceneColor = 0;
+	}
+	if (m_sceneDepth != 0)
+	{
+		glDeleteTextures(1, &m_sceneDepth);
+		m_sceneDepth = 0;
+	}
+	for (int i = 0; i < 2; i++)
+	{
+		if (m_historyFramebuffers[i] != 0)
+		{
+			glDeleteFramebuffers(1, &m_historyFramebuffers[i]);
+			m_historyFramebuffers[i] = 0;
+		}
+		if (m_historyColors[i] != 0)
+		{
+			glDeleteTextures(1, &m_historyColors[i]);
+			m_historyColors[i] = 0;
+		}
+	}
+	m_targetWidth = 0;
+	m_targetHeight = 0;
+	m_bHistoryValid = false;
+}
+
+/***********************************************************
+ *  UpdateScale()
+ *
+ *  This method is used for reading the timestamps of the
+ *  frames that finished on the GPU, without waiting for the
+ *  others, and moving the resolution scale in small steps
+ *  towards the one that fits the frame time target.  After
+ *  a change, the smoothed time is predicted for the new
+ *  pixel count so the next change does not overshoot.
+ ***********************************************************/
+void DynamicResolution::UpdateScale()
+{
+	if (m_bTimerQueries == false)
+	{
+		return;
+	}
+
+	for (int q = 0; q < QUERY_FRAMES; q++)
+	{
+		if (m_bQueryPending[q] == false)
+		{
+			continue;
+		}
+
+		GLint available = 0;
+		glGetQueryObjectiv(m_queries[q][1], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available == 0)
+		{
+			continue;
+		}
+
+		GLuint64 beginTime = 0;
+		GLuint64 endTime = 0;
+		glGetQueryObjectui64v(m_queries[q][0], GL_QUERY_RESULT, &beginTime);
+		glGetQueryObjectui64v(m_queries[q][1], GL_QUERY_RESULT, &endTime);
+		m_bQueryPending[q] = false;
+
+		double frameTime = (endTime > beginTime) ? (double)(endTime - beginTime) / 1.0e6 : 0.0;
+		if (m_gpuFrameTime <= 0.0)
+		{
+			m_gpuFrameTime = frameTime;
+		}
+		else
+		{
+			m_gpuFrameTime += (frameTime - m_gpuFrameTime) * g_TimeSmoothing;
+		}
+	}
+
+	m_framesSinceChange++;
+	if ((m_gpuFrameTime <= 0.0) || (m_framesSinceChange < g_AdjustFrames))
+	{
+		return;
+	}
+
+	float scale = m_scale * (float)std::sqrt(m_targetFrameTime * g_TargetHeadroom / m_gpuFrameTime);
+	scale = std::min(std::max(scale, m_scale - g_MaxScaleStep), m_scale + g_MaxScaleStep);
+	scale = std::min(std::max(scale, m_minScale), 1.0f);
+	if (std::fabs(scale - m_scale) < g_ScaleDeadband)
+	{
+		return;
+	}
+
+	m_gpuFrameTime *= (double)((scale * scale) / (m_scale * m_scale));
+	m_scale = scale;
+	m_framesSinceChange = 0;
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for choosing the resolution and the
+ *  jitter of the next frame, binding the scene target with
+ *  a viewport of that resolution and writing the timestamp
+ *  the frame time is measured from.  The targets follow
+ *  the size of the window.
+ ***********************************************************/
+void DynamicResolution::BeginFrame(int windowWidth, int windowHeight)
+{
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &m_savedFramebuffer);
+
+	if ((windowWidth != m_targetWidth) || (windowHeight != m_targetHeight) || (m_sceneFramebuffer == 0))
+	{
+		CreateTargets(windowWidth, windowHeight);
+	}
+
+	UpdateScale();
+	m_renderWidth = std::max(1, (int)((float)m_targetWidth * m_scale + 0.5f));
+	m_renderHeight = std::max(1, (int)((float)m_targetHeight * m_scale + 0.5f));
+
+	// the Halton points of bases 2 and 3 cover the pixel evenly
+	m_jitter = glm::vec2(0.0f);
+	if (m_bTemporal == true)
+	{
+		int index = (m_jitterIndex % g_JitterCount) + 1;
+		glm::vec2 offset(Halton(index, 2) - 0.5f, Halton(index, 3) - 0.5f);
+		m_jitter = offset * 2.0f / glm::vec2((float)m_renderWidth, (float)m_renderHeight);
+		m_jitterIndex++;
+	}
+
+	if (m_sceneFramebuffer != 0)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, m_sceneFramebuffer);
+		glViewport(0, 0, m_renderWidth, m_renderHeight);
+	}
+
+	if (m_bTimerQueries == true)
+	{
+		glQueryCounter(m_queries[m_querySlot][0], GL_TIMESTAMP);
+	}
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for resolving the frame into the
+ *  next history target, copying that to the framebuffer
+ *  that was bound before BeginFrame() and writing the last
+ *  timestamp of the frame.  The camera is the one the frame
+ *  was drawn with - its projection has no jitter, so the
+ *  history is reprojected between unjittered views.
+ ***********************************************************/
+void DynamicResolution::EndFrame(const UBO_CAMERA_BLOCK& camera)
+{
+	if (m_sceneFramebuffer == 0)
+	{
+		return;
+	}
+
+	glm::mat4 viewProjection = camera.projection * camera.view;
+	if (viewProjection == m_previousViewProjection)
+	{
+		m_stillFrames++;
+	}
+	else
+	{
+		m_stillFrames = 0;
+	}
+	glm::mat4 reprojection = m_previousViewProjection * glm::inverse(viewProjection);
+	bool bUseHistory = (m_bTemporal == true) && (m_bHistoryValid == true);
+
+	// the state the resolve pass replaces
+	GLint previousProgram = 0;
+	GLint previousTextures[g_ResolveUnitCount];
+	GLboolean bBlend = glIsEnabled(GL_BLEND);
+	GLboolean bDepthTest = glIsEnabled(GL_DEPTH_TEST);
+	glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
+	for (int unit = 0; unit < g_ResolveUnitCount; unit++)
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+		glGetIntegerv(GL_TEXTURE_BINDING_2D, &previousTextures[unit]);
+	}
+
+	int writeIndex = 1 - m_historyIndex;
+	glBindFramebuffer(GL_FRAMEBUFFER, m_historyFramebuffers[writeIndex]);
+	glViewport(0, 0, m_targetWidth, m_targetHeight);
+	glDisable(GL_BLEND);
+	glDisable(GL_DEPTH_TEST);
+
+	glActiveTexture(GL_TEXTURE0 + g_CurrentColorUnit);
+	glBindTexture(GL_TEXTURE_2D, m_sceneColor);
+	glActiveTexture(GL_TEXTURE0 + g_CurrentDepthUnit);
+	glBindTexture(GL_TEXTURE_2D, m_sceneDepth);
+	glActiveTexture(GL_TEXTURE0 + g_HistoryColorUnit);
+	glBindTexture(GL_TEXTURE_2D, m_historyColors[m_historyIndex]);
+
+	glUseProgram(m_programID);
+	glUniform1i(m_currentColorLocation, g_CurrentColorUnit);
+	glUniform1i(m_currentDepthLocation, g_CurrentDepthUnit);
+	glUniform1i(m_historyColorLocation, g_HistoryColorUnit);
+	glUniform2f(m_renderScaleLocation,
+		(float)m_renderWidth / (float)m_targetWidth,
+		(float)m_renderHeight / (float)m_targetHeight);
+	glUniform2f(m_renderTexelLocation, 1.0f / (float)m_targetWidth, 1.0f / (float)m_targetHeight);
+	glUniform2f(m_jitterLocation, m_jitter.x, m_jitter.y);
+	glUniformMatrix4fv(m_reprojectionLocation, 1, GL_FALSE, &reprojection[0][0]);
+	glUniform1i(m_useHistoryLocation, (bUseHistory == true) ? 1 : 0);
+
+	glBindVertexArray(m_vertexArray);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+
+	// the resolved frame is shown as it is
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_historyFramebuffers[writeIndex]);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, (GLuint)m_savedFramebuffer);
+	glBlitFramebuffer(
+		0, 0, m_targetWidth, m_targetHeight,
+		0, 0, m_targetWidth, m_targetHeight,
+		GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)m_savedFramebuffer);
+
+	if (m_bTimerQueries == true)
+	{
+		glQueryCounter(m_queries[m_querySlot][1], GL_TIMESTAMP);
+		m_bQueryPending[m_querySlot] = true;
+		m_querySlot = (m_querySlot + 1) % QUERY_FRAMES;
+	}
+
+	glUseProgram((GLuint)previousProgram);
+	for (int unit = g_ResolveUnitCount - 1; unit >= 0; unit--)
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+		glBindTexture(GL_TEXTURE_2D, (GLuint)previousTextures[unit]);
+	}
+	if (bBlend == GL_TRUE)
+	{
+		glEnable(GL_BLEND);
+	}
+	if (bDepthTest == GL_TRUE)
+	{
+		glEnable(GL_DEPTH_TEST);
+	}
+
+	m_historyIndex = writeIndex;
+	m_bHistoryValid = true;
+	m_previousViewProjection = viewProjection;
+}
+
+/***********************************************************
+ *  IsConverging()
+ *
+ *  This method is used for checking whether the history of
+ *  a still view has not seen every jitter offset yet.
+ ***********************************************************/
+bool DynamicResolution::IsConverging() const
+{
+	return((m_bTemporal == true) && (m_stillFrames < g_JitterCount));
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for releasing the targets, the
+ *  resolve program and the timestamp queries.
+ ***********************************************************/
+void DynamicResolution::Destroy()
+{
+	DestroyTargets();
+	if (m_vertexArray != 0)
+	{
+		glDeleteVertexArrays(1, &m_vertexArray);
+		m_vertexArray = 0;
+	}
+	if (m_programID != 0)
+	{
+		glDeleteProgram(m_programID);
+		m_programID = 0;
+	}
+	if (m_bTimerQueries == true)
+	{
+		for (int q = 0; q < QUERY_FRAMES; q++)
+		{
+			glDeleteQueries(2, m_queries[q]);
+			m_queries[q][0] = 0;
+			m_queries[q][1] = 0;
+			m_bQueryPending[q] = false;
+		}
+		m_bTimerQueries = false;
+	}
+}
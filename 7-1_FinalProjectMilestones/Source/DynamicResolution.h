@@ -0,0 +1,145 @@
+///////////////////////////////////////////////////////////////////////////////
+// dynamicresolution.h
+// ============
+// render the scene offscreen at a resolution that follows the GPU frame time,
+// and resolve it to the window with temporal anti-aliasing
+//
+//  The scene is drawn into the lower left part of an offscreen target the size
+//  of the window, so changing the resolution only changes the viewport and no
+//  texture is created again.  GPU timestamps around every frame are read back
+//  a few frames later without waiting, and the resolution scale is moved
+//  towards the one that fits the frame time target - the cost of a frame
+//  follows the number of pixels, so the scale follows the square root of the
+//  time ratio.
+//
+//  The resolve pass upscales the frame to the window.  With temporal anti-
+//  aliasing, the scene vertex shader shifts every frame by a sub-pixel offset
+//  that is kept apart from the camera projection, and the resolve blends the
+//  frame into a history at window resolution that is reprojected with the
+//  depth of the frame and the camera of the frame before.  The history is
+//  clamped to the colors around each pixel, so it can not keep colors that
+//  are no longer there.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "UniformBuffers.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  DynamicResolution
+ *
+ *  This class contains the offscreen scene target, the two
+ *  history targets, the resolve program and the timestamp
+ *  queries that the resolution scale is chosen from.  The
+ *  main loop calls BeginFrame() before and EndFrame() after
+ *  drawing the scene.
+ ***********************************************************/
+class DynamicResolution
+{
+public:
+	// constructor
+	DynamicResolution();
+	// destructor
+	~DynamicResolution();
+
+	// build the resolve program - needs a current GL context
+	bool Initialize(const char* vertexShaderFile, const char* fragmentShaderFile);
+
+	// set the GPU frame time to hold, in frames per second
+	void SetTargetFrameRate(double framesPerSecond);
+	// set the smallest resolution scale, 0.25 to 1
+	void SetMinScale(float minScale);
+	// turn the temporal anti-aliasing on or off, without it the
+	// frame is only upscaled
+	void SetTemporalEnabled(bool bEnabled);
+
+	// choose the resolution of the frame, and bind the scene
+	// target with its viewport - the window has this size
+	void BeginFrame(int windowWidth, int windowHeight);
+	// the offset to add to the projected x and y of the frame,
+	// in normalized device coordinates
+	const glm::vec2& GetJitter() const { return(m_jitter); }
+	// resolve the frame to the default framebuffer - the camera
+	// is the one the frame was drawn with
+	void EndFrame(const UBO_CAMERA_BLOCK& camera);
+
+	// true while the history still converges after the camera
+	// stopped, so a still view needs a few more frames
+	bool IsConverging() const;
+
+	// the resolution scale and the size of the last frame
+	float GetScale() const { return(m_scale); }
+	int GetRenderWidth() const { return(m_renderWidth); }
+	int GetRenderHeight() const { return(m_renderHeight); }
+
+	// release the targets, the program and the queries
+	void Destroy();
+
+private:
+	// number of frames whose timestamp queries are in flight
+	static const int QUERY_FRAMES = 4;
+
+	// the resolve program and its uniform locations
+	GLuint m_programID;
+	GLint m_currentColorLocation;
+	GLint m_currentDepthLocation;
+	GLint m_historyColorLocation;
+	GLint m_renderScaleLocation;
+	GLint m_renderTexelLocation;
+	GLint m_jitterLocation;
+	GLint m_reprojectionLocation;
+	GLint m_useHistoryLocation;
+	// the full screen triangle is generated from its vertex ids
+	GLuint m_vertexArray;
+
+	// the scene target and the history targets, all the size of
+	// the window
+	GLuint m_sceneFramebuffer;
+	GLuint m_sceneColor;
+	GLuint m_sceneDepth;
+	GLuint m_historyFramebuffers[2];
+	GLuint m_historyColors[2];
+	int m_targetWidth;
+	int m_targetHeight;
+	// the history written by the last frame, and whether it holds
+	// a frame at all
+	int m_historyIndex;
+	bool m_bHistoryValid;
+
+	// the first and the last timestamp of every frame in flight
+	GLuint m_queries[QUERY_FRAMES][2];
+	bool m_bQueryPending[QUERY_FRAMES];
+	int m_querySlot;
+	bool m_bTimerQueries;
+
+	// the frame time target and the smoothed GPU frame time, in
+	// milliseconds
+	double m_targetFrameTime;
+	double m_gpuFrameTime;
+	int m_framesSinceChange;
+	float m_scale;
+	float m_minScale;
+	int m_renderWidth;
+	int m_renderHeight;
+
+	bool m_bTemporal;
+	int m_jitterIndex;
+	glm::vec2 m_jitter;
+	// the unjittered view projection of the last frame
+	glm::mat4 m_previousViewProjection;
+	// number of frames drawn with the same camera
+	int m_stillFrames;
+
+	// the framebuffer replaced by BeginFrame()
+	GLint m_savedFramebuffer;
+
+	// create the targets for a window size
+	bool CreateTargets(int width, int height);
+	void DestroyTargets();
+	// read the finished timestamps and move the scale towards
+	// the frame time target
+	void UpdateScale();
+};
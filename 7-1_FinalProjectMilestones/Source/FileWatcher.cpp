@@ -0,0 +1,238 @@
+///////////////////////////////////////////////////////////////////////////////
+// filewatcher.cpp
+// ============
+// watch a set of files for changes on a background thread
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FileWatcher.h"
+
+#include <chrono>
+#include <filesystem>
+
+/***********************************************************
+ *  FileWatcher()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FileWatcher::FileWatcher()
+{
+	m_intervalMilliseconds = 250;
+	m_bStopping = false;
+}
+
+/***********************************************************
+ *  ~FileWatcher()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FileWatcher::~FileWatcher()
+{
+	Stop();
+}
+
+/***********************************************************
+ *  AddFile()
+ *
+ *  This method is used for adding a file to the watched
+ *  files.  Its current state is the one changes are compared
+ *  against, so the file is not reported right away.
+ ***********************************************************/
+void FileWatcher::AddFile(const std::string& filename)
+{
+	WATCHED_FILE file;
+	file.filename = filename;
+	file.writeTime = 0;
+	file.size = 0;
+	file.bChanging = false;
+	ReadFileStamp(filename, file.writeTime, file.size);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (size_t i = 0; i < m_files.size(); i++)
+	{
+		if (m_files[i].filename == filename)
+		{
+			return;
+		}
+	}
+	m_files.push_back(file);
+}
+
+/***********************************************************
+ *  Start()
+ *
+ *  This method is used for starting the polling thread.
+ ***********************************************************/
+void FileWatcher::Start(int intervalMilliseconds)
+{
+	if (m_thread.joinable())
+	{
+		return;
+	}
+
+	m_intervalMilliseconds = (intervalMilliseconds > 0) ? intervalMilliseconds : 250;
+	m_bStopping = false;
+	m_thread = std::thread(&FileWatcher::WatcherMain, this);
+}
+
+/***********************************************************
+ *  Stop()
+ *
+ *  This method is used for stopping the polling thread.  A
+ *  poll in progress finishes first.
+ ***********************************************************/
+void FileWatcher::Stop()
+{
+	if (m_thread.joinable() == false)
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_bStopping = true;
+	}
+	m_stopRequested.notify_all();
+	m_thread.join();
+}
+
+/***********************************************************
+ *  TakeChangedFiles()
+ *
+ *  This method is used for collecting the files that changed
+ *  since the last call, each one listed once.
+ ***********************************************************/
+bool FileWatcher::TakeChangedFiles(std::vector<std::string>& files)
+{
+	files.clear();
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	files.swap(m_changedFiles);
+
+	return(files.empty() == false);
+}
+
+/***********************************************************
+ *  HasChangedFiles()
+ *
+ *  This method is used for checking whether files changed
+ *  without taking them, so the caller can decide to draw a
+ *  frame that applies them.
+ ***********************************************************/
+bool FileWatcher::HasChangedFiles()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	return(m_changedFiles.empty() == false);
+}
+
+/***********************************************************
+ *  WatcherMain()
+ *
+ *  This method is used as the loop of the polling thread.
+ *  The file system is read without holding the lock, so
+ *  adding files and taking changes never waits on a slow
+ *  disk.
+ ***********************************************************/
+void FileWatcher::WatcherMain()
+{
+	// kept across the polls, so a poll without changes reuses
+	// their memory instead of allocating
+	std::vector<WATCHED_FILE> files;
+	std::vector<std::string> changed;
+
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_stopRequested.wait_for(lock,
+				std::chrono::milliseconds(m_intervalMilliseconds),
+				[this] { return(m_bStopping); });
+			if (m_bStopping == true)
+			{
+				return;
+			}
+			files = m_files;
+		}
+
+		// a changed file is reported one poll later, once its
+		// stamp stopped changing
+		changed.clear();
+		for (size_t i = 0; i < files.size(); i++)
+		{
+			WATCHED_FILE& file = files[i];
+			int64_t writeTime = 0;
+			uint64_t size = 0;
+
+			if (ReadFileStamp(file.filename, writeTime, size) == false)
+			{
+				continue;
+			}
+
+			if ((writeTime != file.writeTime) || (size != file.size))
+			{
+				file.writeTime = writeTime;
+				file.size = size;
+				file.bChanging = true;
+			}
+			else if (file.bChanging == true)
+			{
+				file.bChanging = false;
+				changed.push_back(file.filename);
+			}
+		}
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (size_t i = 0; i < files.size(); i++)
+		{
+			// files added during the poll keep their own entry
+			if ((i < m_files.size()) && (m_files[i].filename == files[i].filename))
+			{
+				m_files[i] = files[i];
+			}
+		}
+		for (size_t i = 0; i < changed.size(); i++)
+		{
+			bool bListed = false;
+			for (size_t c = 0; c < m_changedFiles.size(); c++)
+			{
+				if (m_changedFiles[c] == changed[i])
+				{
+					bListed = true;
+					break;
+				}
+			}
+			if (bListed == false)
+			{
+				m_changedFiles.push_back(changed[i]);
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  ReadFileStamp()
+ *
+ *  This method is used for reading the write time and size
+ *  of a file.  A file that is missing for a moment, while
+ *  it is being replaced, fails without an error message.
+ ***********************************************************/
+bool FileWatcher::ReadFileStamp(const std::string& filename, int64_t& writeTime, uint64_t& size)
+{
+	std::error_code error;
+
+	std::filesystem::file_time_type time = std::filesystem::last_write_time(filename, error);
+	if (error)
+	{
+		return(false);
+	}
+	uintmax_t fileSize = std::filesystem::file_size(filename, error);
+	if (error)
+	{
+		return(false);
+	}
+
+	writeTime = (int64_t)time.time_since_epoch().count();
+	size = (uint64_t)fileSize;
+
+	return(true);
+}
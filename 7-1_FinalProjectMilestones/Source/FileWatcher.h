@@ -0,0 +1,77 @@
+///////////////////////////////////////////////////////////////////////////////
+// filewatcher.h
+// ============
+// watch a set of files for changes on a background thread
+//
+//  A worker thread compares the write time and size of every watched file
+//  against the last values it saw, a few times per second.  A change is only
+//  reported once the file has stayed the same for one more poll, so a file
+//  that an editor or exporter is still writing is not picked up half done.
+//  The render thread collects the changed files between frames without ever
+//  touching the file system itself.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  FileWatcher
+ *
+ *  This class contains the watched files and the thread
+ *  that polls them.
+ ***********************************************************/
+class FileWatcher
+{
+public:
+	// constructor
+	FileWatcher();
+	// destructor
+	~FileWatcher();
+
+	// watch a file - files added twice are only watched once
+	void AddFile(const std::string& filename);
+	// start polling the files every interval milliseconds
+	void Start(int intervalMilliseconds);
+	// stop the polling thread
+	void Stop();
+
+	// move the files that changed since the last call into the
+	// list - returns false when none changed
+	bool TakeChangedFiles(std::vector<std::string>& files);
+	// true when files changed since the last TakeChangedFiles()
+	bool HasChangedFiles();
+
+private:
+	// a watched file and the last write time and size seen
+	struct WATCHED_FILE
+	{
+		std::string filename;
+		int64_t writeTime;
+		uint64_t size;
+		// set while a change waits for one stable poll
+		bool bChanging;
+	};
+
+	// the polling thread
+	std::thread m_thread;
+	// guards everything below
+	std::mutex m_mutex;
+	// signalled when the thread must stop
+	std::condition_variable m_stopRequested;
+	std::vector<WATCHED_FILE> m_files;
+	std::vector<std::string> m_changedFiles;
+	int m_intervalMilliseconds;
+	bool m_bStopping;
+
+	// the loop run by the polling thread
+	void WatcherMain();
+	// read the write time and size of a file, false when it can
+	// not be read right now
+	static bool ReadFileStamp(const std::string& filename, int64_t& writeTime, uint64_t& size);
+};
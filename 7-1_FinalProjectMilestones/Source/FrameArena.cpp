@@ -0,0 +1,147 @@
+///////////////////////////////////////////////////////////////////////////////
+// framearena.cpp
+// ============
+// a linear allocator for the transient data of one frame
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrameArena.h"
+
+#include <cstdint>
+
+// declaration of global variables
+namespace
+{
+	// the overflowed allocations a frame can make before the
+	// list of their blocks grows
+	const int g_OverflowReserve = 16;
+	// added to the block when it grows, so a scene that keeps
+	// growing a little does not replace it every frame
+	const size_t g_GrowthPercent = 50;
+}
+
+/***********************************************************
+ *  FrameArena()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FrameArena::FrameArena()
+{
+	m_block = NULL;
+	m_capacity = 0;
+	m_offset = 0;
+	m_frameBytes = 0;
+	m_peakBytes = 0;
+	m_overflowCount = 0;
+	m_overflowBlocks.reserve(g_OverflowReserve);
+}
+
+/***********************************************************
+ *  ~FrameArena()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FrameArena::~FrameArena()
+{
+	ReleaseOverflow();
+	delete[] m_block;
+	m_block = NULL;
+}
+
+/***********************************************************
+ *  Reserve()
+ *
+ *  This method is used for replacing the block with one of
+ *  at least the passed in size.  Every allocation made so
+ *  far is released.
+ ***********************************************************/
+void FrameArena::Reserve(size_t bytes)
+{
+	ReleaseOverflow();
+	m_offset = 0;
+	m_frameBytes = 0;
+
+	if (bytes <= m_capacity)
+	{
+		return;
+	}
+
+	delete[] m_block;
+	m_block = new unsigned char[bytes];
+	m_capacity = bytes;
+}
+
+/***********************************************************
+ *  Reset()
+ *
+ *  This method is used for releasing every allocation of
+ *  the last frame, at the start of a new one.  A frame that
+ *  overflowed the block is likely to be followed by frames
+ *  of the same size, so the block is replaced with one that
+ *  holds it and some headroom.
+ ***********************************************************/
+void FrameArena::Reset()
+{
+	if (m_overflowBlocks.empty() == false)
+	{
+		Reserve(m_peakBytes + (m_peakBytes * g_GrowthPercent) / 100);
+	}
+
+	m_offset = 0;
+	m_frameBytes = 0;
+}
+
+/***********************************************************
+ *  Allocate()
+ *
+ *  This method is used for getting aligned memory that stays
+ *  valid until the next reset.  An allocation that does not
+ *  fit the rest of the block gets its own heap block.
+ ***********************************************************/
+void* FrameArena::Allocate(size_t bytes, size_t alignment)
+{
+	if (bytes == 0)
+	{
+		bytes = 1;
+	}
+
+	// the padding is counted too, so the grown block fits the
+	// same allocations again
+	uintptr_t address = (uintptr_t)(m_block + m_offset);
+	size_t padding = (size_t)((alignment - (address & (alignment - 1))) & (alignment - 1));
+	m_frameBytes += bytes + padding;
+	if (m_frameBytes > m_peakBytes)
+	{
+		m_peakBytes = m_frameBytes;
+	}
+
+	if ((NULL != m_block) && (m_offset + padding + bytes <= m_capacity))
+	{
+		void* memory = m_block + m_offset + padding;
+		m_offset += padding + bytes;
+		return(memory);
+	}
+
+	unsigned char* overflowBlock = new unsigned char[bytes + alignment];
+	m_overflowBlocks.push_back(overflowBlock);
+	m_overflowCount++;
+
+	address = (uintptr_t)overflowBlock;
+	padding = (size_t)((alignment - (address & (alignment - 1))) & (alignment - 1));
+
+	return(overflowBlock + padding);
+}
+
+/***********************************************************
+ *  ReleaseOverflow()
+ *
+ *  This method is used for releasing the heap blocks of the
+ *  allocations that did not fit the block.
+ ***********************************************************/
+void FrameArena::ReleaseOverflow()
+{
+	for (size_t i = 0; i < m_overflowBlocks.size(); i++)
+	{
+		delete[] m_overflowBlocks[i];
+	}
+	m_overflowBlocks.clear();
+}
@@ -0,0 +1,74 @@
+///////////////////////////////////////////////////////////////////////////////
+// framearena.h
+// ============
+// a linear allocator for the transient data of one frame
+//
+//  Allocating is moving an offset through one block of memory, and the whole
+//  block is released at once when the next frame starts, so the per-frame
+//  lists of the scene update never touch the heap.  When a frame needs more
+//  than the block holds, the rest of its allocations come from the heap and
+//  the block is replaced with one that fits that frame at the next reset, so
+//  only the first frames after the scene grew allocate.  The memory is
+//  released without running destructors, so it only holds trivial types.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+/***********************************************************
+ *  FrameArena
+ *
+ *  This class contains the arena block, the heap blocks of
+ *  a frame that did not fit it, and the usage statistics.
+ ***********************************************************/
+class FrameArena
+{
+public:
+	// constructor
+	FrameArena();
+	// destructor
+	~FrameArena();
+
+	// make the block hold at least the passed in number of bytes,
+	// which releases everything allocated so far
+	void Reserve(size_t bytes);
+	// release every allocation of the last frame - grows the
+	// block when that frame did not fit it
+	void Reset();
+
+	// get memory for the rest of the frame - the alignment has to
+	// be a power of two
+	void* Allocate(size_t bytes, size_t alignment);
+	// get an uninitialized array for the rest of the frame
+	template<typename T>
+	T* AllocateArray(size_t count)
+	{
+		static_assert(std::is_trivially_destructible<T>::value, "the frame arena never runs destructors");
+		return((T*)Allocate(count * sizeof(T), alignof(T)));
+	}
+
+	// bytes allocated since the last reset
+	size_t GetUsedBytes() const { return(m_frameBytes); }
+	// the most bytes a frame has allocated
+	size_t GetPeakBytes() const { return(m_peakBytes); }
+	size_t GetCapacity() const { return(m_capacity); }
+	// number of allocations that did not fit the block
+	int GetOverflowCount() const { return(m_overflowCount); }
+
+private:
+	unsigned char* m_block;
+	size_t m_capacity;
+	// the offset of the next allocation in the block
+	size_t m_offset;
+	// the heap blocks of the allocations that did not fit
+	std::vector<unsigned char*> m_overflowBlocks;
+	size_t m_frameBytes;
+	size_t m_peakBytes;
+	int m_overflowCount;
+
+	// release the heap blocks of the overflowed allocations
+	void ReleaseOverflow();
+};
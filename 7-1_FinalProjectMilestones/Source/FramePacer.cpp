@@ -0,0 +1,138 @@
+///////////////////////////////////////////////////////////////////////////////
+// framepacer.cpp
+// ============
+// decide when the main loop draws a frame and how long it waits in between
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FramePacer.h"
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+// declaration of global variables
+namespace
+{
+	// the longest an idle loop sleeps in the event queue, in
+	// seconds - the watched files and the background texture
+	// loads are checked this often
+	const double g_IdleTimeout = 0.25;
+	// the scheduler may wake a sleep this late, so the last part
+	// of a frame interval is waited out by yielding
+	const double g_SleepMargin = 0.002;
+}
+
+/***********************************************************
+ *  FramePacer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FramePacer::FramePacer()
+{
+	m_frameInterval = 0.0;
+	m_lastFrameTime = 0.0;
+	m_bOnDemand = false;
+}
+
+/***********************************************************
+ *  SetSwapMode()
+ *
+ *  This method is used for setting how the buffer swap of
+ *  the current context waits for the display.  The adaptive
+ *  mode needs the swap control tear extension, without it
+ *  every vsync is waited for.
+ ***********************************************************/
+void FramePacer::SetSwapMode(SWAP_MODE swapMode)
+{
+	int interval = 1;
+
+	if (swapMode == SWAP_IMMEDIATE)
+	{
+		interval = 0;
+	}
+	else if (swapMode == SWAP_ADAPTIVE)
+	{
+		if ((glfwExtensionSupported("WGL_EXT_swap_control_tear") == GLFW_TRUE) ||
+			(glfwExtensionSupported("GLX_EXT_swap_control_tear") == GLFW_TRUE))
+		{
+			interval = -1;
+		}
+		else
+		{
+			std::cout << "Adaptive vsync is not supported, waiting for every vsync" << std::endl;
+		}
+	}
+
+	glfwSwapInterval(interval);
+}
+
+/***********************************************************
+ *  SetMaxFrameRate()
+ *
+ *  This method is used for capping the number of frames
+ *  drawn per second, 0 or less for no cap.
+ ***********************************************************/
+void FramePacer::SetMaxFrameRate(double framesPerSecond)
+{
+	m_frameInterval = (framesPerSecond > 0.0) ? (1.0 / framesPerSecond) : 0.0;
+}
+
+/***********************************************************
+ *  SetOnDemand()
+ *
+ *  This method is used for choosing between drawing every
+ *  loop iteration and only drawing the iterations in which
+ *  the camera or the scene changed.
+ ***********************************************************/
+void FramePacer::SetOnDemand(bool bOnDemand)
+{
+	m_bOnDemand = bOnDemand;
+}
+
+/***********************************************************
+ *  WaitForFrameSlot()
+ *
+ *  This method is used for sleeping until a frame interval
+ *  has passed since the last drawn frame.  The frames are
+ *  released on a fixed schedule, but a frame that is late
+ *  by more than an interval - a slow frame or the first one
+ *  after skipped frames - starts the schedule again instead
+ *  of rushing the next frames to catch up.
+ ***********************************************************/
+void FramePacer::WaitForFrameSlot()
+{
+	if (m_frameInterval <= 0.0)
+	{
+		return;
+	}
+
+	double targetTime = m_lastFrameTime + m_frameInterval;
+	double currentTime = glfwGetTime();
+	while (currentTime < targetTime)
+	{
+		double remaining = targetTime - currentTime;
+		if (remaining > g_SleepMargin)
+		{
+			std::this_thread::sleep_for(std::chrono::duration<double>(remaining - g_SleepMargin));
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+		currentTime = glfwGetTime();
+	}
+
+	m_lastFrameTime = (currentTime > targetTime + m_frameInterval) ? currentTime : targetTime;
+}
+
+/***********************************************************
+ *  WaitForEvents()
+ *
+ *  This method is used for sleeping in the event queue
+ *  after a skipped frame, instead of polling it at full
+ *  speed.  Any input or window event wakes it right away.
+ ***********************************************************/
+void FramePacer::WaitForEvents()
+{
+	glfwWaitEventsTimeout(g_IdleTimeout);
+}
@@ -0,0 +1,65 @@
+///////////////////////////////////////////////////////////////////////////////
+// framepacer.h
+// ============
+// decide when the main loop draws a frame and how long it waits in between
+//
+//  By default every loop iteration draws a frame and only the swap waits, for
+//  vsync when the driver does.  The swap mode can be set to wait for every
+//  vsync, for none, or adaptively - waiting unless the frame is already late.
+//  A frame rate cap sleeps out the rest of every frame interval after the
+//  swap, and the on demand mode skips the frames in which neither the camera
+//  nor the scene changed, sleeping in the event queue until something does.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// GLFW library
+#include "GLFW/glfw3.h"
+
+/***********************************************************
+ *  FramePacer
+ *
+ *  This class contains the frame rate cap and the on demand
+ *  setting of the main loop, and the time of the last frame
+ *  the cap is measured from.
+ ***********************************************************/
+class FramePacer
+{
+public:
+	// how the buffer swap waits for the display
+	enum SWAP_MODE
+	{
+		// swap right away, frames may tear
+		SWAP_IMMEDIATE,
+		// wait for every vsync
+		SWAP_VSYNC,
+		// wait for the vsync unless the frame missed it
+		SWAP_ADAPTIVE
+	};
+
+	// constructor
+	FramePacer();
+
+	// set the swap interval of the current context - adaptive
+	// falls back to vsync when the driver has no late swaps
+	static void SetSwapMode(SWAP_MODE swapMode);
+
+	// draw at most this many frames per second, 0 for no cap
+	void SetMaxFrameRate(double framesPerSecond);
+	// only draw the frames in which something changed
+	void SetOnDemand(bool bOnDemand);
+	bool IsOnDemand() const { return(m_bOnDemand); }
+
+	// sleep out the rest of the frame interval after a drawn frame
+	void WaitForFrameSlot();
+	// sleep until an event arrives after a skipped frame - the
+	// timeout keeps the background file and texture checks going
+	void WaitForEvents();
+
+private:
+	// the shortest time between two drawn frames, 0 for no cap
+	double m_frameInterval;
+	// the time the last drawn frame was released at
+	double m_lastFrameTime;
+	bool m_bOnDemand;
+};
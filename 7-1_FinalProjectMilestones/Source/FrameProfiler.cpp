@@ -0,0 +1,384 @@
+///////////////////////////////////////////////////////////////////////////////
+// frameprofiler.cpp
+// ============
+// measure the CPU and GPU time of every frame and report rolling statistics
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrameProfiler.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+/***********************************************************
+ *  FrameProfiler()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FrameProfiler::FrameProfiler()
+{
+	m_bEnabled = false;
+	m_bTimerQueries = false;
+	m_activePass = -1;
+	m_queryFrame = 0;
+	m_framesInWindow = 0;
+	m_totals = { 0, 0, 0, 0, 0 };
+	m_peakAllocations = 0;
+	m_bReportReady = false;
+	m_frameTimes.reserve(HISTORY_FRAMES);
+}
+
+/***********************************************************
+ *  ~FrameProfiler()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FrameProfiler::~FrameProfiler()
+{
+	m_scopes.clear();
+	m_passes.clear();
+}
+
+/***********************************************************
+ *  SetEnabled()
+ *
+ *  This method is used for turning the profiling on or off.
+ *  The timer query support is checked here, so it needs a
+ *  current GL context.
+ ***********************************************************/
+void FrameProfiler::SetEnabled(bool bEnabled)
+{
+	m_bEnabled = bEnabled;
+	m_bTimerQueries = (GLEW_VERSION_3_3 || GLEW_ARB_timer_query) ? true : false;
+}
+
+/***********************************************************
+ *  GetScopeHandle()
+ *
+ *  This method is used for getting the handle of a CPU
+ *  scope by name, adding the scope when it is new.
+ ***********************************************************/
+int FrameProfiler::GetScopeHandle(const char* name)
+{
+	for (size_t i = 0; i < m_scopes.size(); i++)
+	{
+		if (m_scopes[i].name == name)
+		{
+			return((int)i);
+		}
+	}
+
+	CPU_SCOPE scope;
+	scope.name = name;
+	scope.totalMs = 0.0;
+	m_scopes.push_back(scope);
+
+	return((int)m_scopes.size() - 1);
+}
+
+/***********************************************************
+ *  GetPassHandle()
+ *
+ *  This method is used for getting the handle of a GPU pass
+ *  by name, adding the pass when it is new.  The query
+ *  objects are created when the pass is first timed.
+ ***********************************************************/
+int FrameProfiler::GetPassHandle(const char* name)
+{
+	for (size_t i = 0; i < m_passes.size(); i++)
+	{
+		if (m_passes[i].name == name)
+		{
+			return((int)i);
+		}
+	}
+
+	GPU_PASS pass;
+	pass.name = name;
+	for (int q = 0; q < QUERY_FRAMES; q++)
+	{
+		pass.queries[q] = 0;
+		pass.bIssued[q] = false;
+	}
+	pass.totalMs = 0.0;
+	pass.samples = 0;
+	m_passes.push_back(pass);
+
+	return((int)m_passes.size() - 1);
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for marking the start of a frame.
+ *  The queries of the frame that used the same query set
+ *  are read back before the set is issued again.
+ ***********************************************************/
+void FrameProfiler::BeginFrame()
+{
+	if (m_bEnabled == false)
+	{
+		return;
+	}
+
+	m_frameStart = CLOCK::now();
+	m_queryFrame = (m_queryFrame + 1) % QUERY_FRAMES;
+	CollectQueries();
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for marking the end of a frame and
+ *  adding its time and counters to the rolling window.
+ ***********************************************************/
+void FrameProfiler::EndFrame(const FRAME_COUNTERS& counters)
+{
+	if (m_bEnabled == false)
+	{
+		return;
+	}
+
+	std::chrono::duration<double, std::milli> frameTime = CLOCK::now() - m_frameStart;
+	m_frameTimes.push_back(frameTime.count());
+
+	m_totals.drawCalls += counters.drawCalls;
+	m_totals.stateChanges += counters.stateChanges;
+	m_totals.uniformUploads += counters.uniformUploads;
+	m_totals.bufferUploads += counters.bufferUploads;
+	m_totals.heapAllocations += counters.heapAllocations;
+	m_peakAllocations = std::max(m_peakAllocations, counters.heapAllocations);
+	m_framesInWindow++;
+
+	if (m_framesInWindow >= HISTORY_FRAMES)
+	{
+		BuildReport();
+	}
+}
+
+/***********************************************************
+ *  BeginScope()
+ *
+ *  This method is used for starting the timer of a CPU
+ *  scope in the current frame.
+ ***********************************************************/
+void FrameProfiler::BeginScope(int handle)
+{
+	if ((m_bEnabled == false) || (handle < 0) || (handle >= (int)m_scopes.size()))
+	{
+		return;
+	}
+
+	m_scopes[handle].start = CLOCK::now();
+}
+
+/***********************************************************
+ *  EndScope()
+ *
+ *  This method is used for stopping the timer of a CPU
+ *  scope and adding its time to the window.
+ ***********************************************************/
+void FrameProfiler::EndScope(int handle)
+{
+	if ((m_bEnabled == false) || (handle < 0) || (handle >= (int)m_scopes.size()))
+	{
+		return;
+	}
+
+	std::chrono::duration<double, std::milli> scopeTime = CLOCK::now() - m_scopes[handle].start;
+	m_scopes[handle].totalMs += scopeTime.count();
+}
+
+/***********************************************************
+ *  BeginPass()
+ *
+ *  This method is used for starting the timer query of a
+ *  GPU pass.  Only one GL_TIME_ELAPSED query can be active,
+ *  so a pass that starts inside another is not timed.
+ ***********************************************************/
+void FrameProfiler::BeginPass(int handle)
+{
+	if ((m_bEnabled == false) || (m_bTimerQueries == false) ||
+		(handle < 0) || (handle >= (int)m_passes.size()) ||
+		(m_activePass >= 0))
+	{
+		return;
+	}
+
+	GPU_PASS& pass = m_passes[handle];
+	if (pass.queries[0] == 0)
+	{
+		glGenQueries(QUERY_FRAMES, pass.queries);
+	}
+
+	glBeginQuery(GL_TIME_ELAPSED, pass.queries[m_queryFrame]);
+	pass.bIssued[m_queryFrame] = true;
+	m_activePass = handle;
+}
+
+/***********************************************************
+ *  EndPass()
+ *
+ *  This method is used for stopping the timer query of the
+ *  active GPU pass.
+ ***********************************************************/
+void FrameProfiler::EndPass()
+{
+	if (m_activePass < 0)
+	{
+		return;
+	}
+
+	glEndQuery(GL_TIME_ELAPSED);
+	m_activePass = -1;
+}
+
+/***********************************************************
+ *  CollectQueries()
+ *
+ *  This method is used for reading the results of the
+ *  current query set.  They were issued QUERY_FRAMES - 1
+ *  frames ago; a result that is still not available is
+ *  dropped instead of waiting for the GPU.
+ ***********************************************************/
+void FrameProfiler::CollectQueries()
+{
+	for (size_t i = 0; i < m_passes.size(); i++)
+	{
+		GPU_PASS& pass = m_passes[i];
+
+		if (pass.bIssued[m_queryFrame] == false)
+		{
+			continue;
+		}
+		pass.bIssued[m_queryFrame] = false;
+
+		GLint available = 0;
+		glGetQueryObjectiv(pass.queries[m_queryFrame], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available == 0)
+		{
+			continue;
+		}
+
+		GLuint64 elapsedNs = 0;
+		glGetQueryObjectui64v(pass.queries[m_queryFrame], GL_QUERY_RESULT, &elapsedNs);
+		pass.totalMs += (double)elapsedNs / 1000000.0;
+		pass.samples++;
+	}
+}
+
+/***********************************************************
+ *  BuildReport()
+ *
+ *  This method is used for building the report of the
+ *  rolling window - the p50 and p99 frame times and the
+ *  averages of every scope, pass and counter - and then
+ *  starting a new window.
+ ***********************************************************/
+void FrameProfiler::BuildReport()
+{
+	std::vector<double> sorted = m_frameTimes;
+	std::sort(sorted.begin(), sorted.end());
+
+	double p50 = sorted[(sorted.size() - 1) / 2];
+	double p99 = sorted[((sorted.size() - 1) * 99) / 100];
+	double frames = (double)m_framesInWindow;
+
+	std::ostringstream report;
+	report << std::fixed << std::setprecision(2);
+	report << "PROFILE: " << m_framesInWindow << " frames, p50 " << p50
+		<< " ms, p99 " << p99 << " ms\n";
+
+	report << "  cpu:";
+	for (size_t i = 0; i < m_scopes.size(); i++)
+	{
+		report << " " << m_scopes[i].name << " " << (m_scopes[i].totalMs / frames) << " ms";
+		m_scopes[i].totalMs = 0.0;
+	}
+	report << "\n";
+
+	if (m_bTimerQueries == true)
+	{
+		report << "  gpu:";
+		for (size_t i = 0; i < m_passes.size(); i++)
+		{
+			double average = 0.0;
+			if (m_passes[i].samples > 0)
+			{
+				average = m_passes[i].totalMs / (double)m_passes[i].samples;
+			}
+			report << " " << m_passes[i].name << " " << average << " ms";
+			m_passes[i].totalMs = 0.0;
+			m_passes[i].samples = 0;
+		}
+		report << "\n";
+	}
+
+	report << std::setprecision(1);
+	report << "  per frame: " << (m_totals.drawCalls / frames) << " draws, "
+		<< (m_totals.stateChanges / frames) << " state changes, "
+		<< (m_totals.uniformUploads / frames) << " uniform uploads, "
+		<< (m_totals.bufferUploads / frames) << " buffer uploads, "
+		<< (m_totals.heapAllocations / frames) << " heap allocations (peak "
+		<< m_peakAllocations << ")\n";
+	m_report = report.str();
+
+	std::ostringstream summary;
+	summary << std::fixed << std::setprecision(2);
+	summary << "p50 " << p50 << " ms / p99 " << p99 << " ms / "
+		<< std::setprecision(0) << (m_totals.drawCalls / frames) << " draws";
+	m_summary = summary.str();
+
+	m_frameTimes.clear();
+	m_totals = { 0, 0, 0, 0, 0 };
+	m_peakAllocations = 0;
+	m_framesInWindow = 0;
+	m_bReportReady = true;
+}
+
+/***********************************************************
+ *  TakeReport()
+ *
+ *  This method is used for getting the latest report once.
+ *  It returns false when no new report was built since the
+ *  last call.
+ ***********************************************************/
+bool FrameProfiler::TakeReport(std::string& report)
+{
+	if (m_bReportReady == false)
+	{
+		return(false);
+	}
+
+	report = m_report;
+	m_bReportReady = false;
+
+	return(true);
+}
+
+/***********************************************************
+ *  DestroyQueries()
+ *
+ *  This method is used for releasing the query objects of
+ *  every GPU pass.
+ ***********************************************************/
+void FrameProfiler::DestroyQueries()
+{
+	if (m_activePass >= 0)
+	{
+		EndPass();
+	}
+
+	for (size_t i = 0; i < m_passes.size(); i++)
+	{
+		if (m_passes[i].queries[0] != 0)
+		{
+			glDeleteQueries(QUERY_FRAMES, m_passes[i].queries);
+		}
+		for (int q = 0; q < QUERY_FRAMES; q++)
+		{
+			m_passes[i].queries[q] = 0;
+			m_passes[i].bIssued[q] = false;
+		}
+	}
+}
@@ -0,0 +1,127 @@
+///////////////////////////////////////////////////////////////////////////////
+// frameprofiler.h
+// ============
+// measure the CPU and GPU time of every frame and report rolling statistics
+//
+//  CPU scopes are timed with a steady clock.  GPU passes are timed with
+//  GL_TIME_ELAPSED queries that are read back one frame later, so reading a
+//  result never waits for the GPU.  The frame times of a rolling window are
+//  reported as p50/p99 together with the averaged scopes, passes and counters.
+//  The heap allocations of a frame are counted as well, with the peak of the
+//  window, since a steady frame should not make any.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  FrameProfiler
+ *
+ *  This class contains the timing history of the last
+ *  frames.  Scopes and passes are registered by name once
+ *  and then started and stopped by handle on the hot path.
+ ***********************************************************/
+class FrameProfiler
+{
+public:
+	// the per-frame work counters reported with the timings
+	struct FRAME_COUNTERS
+	{
+		int drawCalls;
+		int stateChanges;
+		int uniformUploads;
+		int bufferUploads;
+		int heapAllocations;
+	};
+
+	// constructor
+	FrameProfiler();
+	// destructor
+	~FrameProfiler();
+
+	// turn on the profiling - while disabled, every method
+	// returns without doing any work
+	void SetEnabled(bool bEnabled);
+	bool IsEnabled() const { return(m_bEnabled); }
+
+	// get the handle of a CPU scope or a GPU pass by name
+	int GetScopeHandle(const char* name);
+	int GetPassHandle(const char* name);
+
+	// mark the start and the end of a frame
+	void BeginFrame();
+	void EndFrame(const FRAME_COUNTERS& counters);
+
+	// time a CPU scope of the current frame
+	void BeginScope(int handle);
+	void EndScope(int handle);
+
+	// time a GPU pass of the current frame - passes can not nest
+	void BeginPass(int handle);
+	void EndPass();
+
+	// true when a new report was built since the last call
+	bool TakeReport(std::string& report);
+	// one line summary of the latest report for a window title
+	const std::string& GetSummary() const { return(m_summary); }
+
+	// release the query objects - needs a current GL context
+	void DestroyQueries();
+
+private:
+	typedef std::chrono::steady_clock CLOCK;
+
+	// number of frames whose queries are in flight
+	static const int QUERY_FRAMES = 2;
+	// number of frames in the rolling window
+	static const int HISTORY_FRAMES = 240;
+
+	// a timed CPU scope and its accumulated time in the window
+	struct CPU_SCOPE
+	{
+		std::string name;
+		CLOCK::time_point start;
+		double totalMs;
+	};
+
+	// a timed GPU pass, its queries and accumulated time
+	struct GPU_PASS
+	{
+		std::string name;
+		GLuint queries[QUERY_FRAMES];
+		bool bIssued[QUERY_FRAMES];
+		double totalMs;
+		int samples;
+	};
+
+	bool m_bEnabled;
+	bool m_bTimerQueries;
+	std::vector<CPU_SCOPE> m_scopes;
+	std::vector<GPU_PASS> m_passes;
+	// the pass whose query is active, -1 when none
+	int m_activePass;
+	// the query set of the current frame
+	int m_queryFrame;
+
+	CLOCK::time_point m_frameStart;
+	// frame times of the rolling window
+	std::vector<double> m_frameTimes;
+	FRAME_COUNTERS m_totals;
+	// the most heap allocations of a frame in the window
+	int m_peakAllocations;
+	int m_framesInWindow;
+
+	std::string m_report;
+	std::string m_summary;
+	bool m_bReportReady;
+
+	// read the finished queries of the current query set
+	void CollectQueries();
+	// build the report of the window and start a new window
+	void BuildReport();
+};
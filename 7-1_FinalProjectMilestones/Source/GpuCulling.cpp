@@ -0,0 +1,291 @@
+///////////////////////////////////////////////////////////////////////////////
+// gpuculling.cpp
+// ============
+// GPU-driven frustum and occlusion culling that writes indirect draw commands
+///////////////////////////////////////////////////////////////////////////////
+
+#include "GpuCulling.h"
+#include "ProgramBuilder.h"
+
+#include <iostream>
+
+// the layout of the C++ images must match the std430 blocks
+static_assert(sizeof(GpuCulling::GPU_OBJECT) == 144, "GPU_OBJECT does not match the std430 layout");
+static_assert(sizeof(GpuCulling::DRAW_COMMAND) == 20, "DRAW_COMMAND does not match the indirect command layout");
+
+// declaration of global variables
+namespace
+{
+	// storage buffer bindings used by the culling shader
+	const GLuint g_ObjectBufferBinding = 0;
+	const GLuint g_CommandBufferBinding = 1;
+	const GLuint g_InstanceBufferBinding = 2;
+	const GLuint g_LodBufferBinding = 3;
+	// texture unit the depth pyramid is sampled from
+	const GLuint g_HiZTextureUnit = 0;
+}
+
+/***********************************************************
+ *  GpuCulling()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+GpuCulling::GpuCulling()
+{
+	m_programID = 0;
+	m_objectBuffer = 0;
+	m_commandBuffer = 0;
+	m_commandTemplate = 0;
+	m_lodBuffer = 0;
+	for (int i = 0; i < MAX_LOD_COUNT - 1; i++)
+	{
+		m_lodScreenSizes[i] = 0.0f;
+	}
+	m_lodHysteresis = 0.0f;
+	m_objectCount = 0;
+	m_commandCount = 0;
+	m_frustumPlanesLocation = -1;
+	m_objectCountLocation = -1;
+	m_useFrustumLocation = -1;
+	m_useOcclusionLocation = -1;
+	m_viewProjectionLocation = -1;
+	m_hiZBufferLocation = -1;
+	m_hiZSizeLocation = -1;
+	m_hiZLevelsLocation = -1;
+	m_useLodLocation = -1;
+	m_lodScaleLocation = -1;
+	m_lodScreenSizesLocation = -1;
+	m_lodHysteresisLocation = -1;
+}
+
+/***********************************************************
+ *  ~GpuCulling()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+GpuCulling::~GpuCulling()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  IsSupported()
+ *
+ *  This method is used for checking whether the context can
+ *  run the GPU culling pass - compute shaders and storage
+ *  buffers, indirect draws with a base instance, and
+ *  glMultiDrawElementsIndirect.
+ ***********************************************************/
+bool GpuCulling::IsSupported()
+{
+	if (GLEW_VERSION_4_3)
+	{
+		return(true);
+	}
+
+	return((GLEW_ARB_compute_shader && GLEW_ARB_shader_storage_buffer_object &&
+		GLEW_ARB_multi_draw_indirect && GLEW_ARB_base_instance) ? true : false);
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for building the compute program and
+ *  creating the buffers of the culling pass.
+ ***********************************************************/
+bool GpuCulling::Initialize(const char* shaderFile)
+{
+	if (IsSupported() == false)
+	{
+		return(false);
+	}
+
+	m_programID = ProgramBuilder::BuildComputeProgram(shaderFile);
+	if (m_programID == 0)
+	{
+		return(false);
+	}
+
+	m_frustumPlanesLocation = glGetUniformLocation(m_programID, "frustumPlanes");
+	m_objectCountLocation = glGetUniformLocation(m_programID, "objectCount");
+	m_useFrustumLocation = glGetUniformLocation(m_programID, "bUseFrustum");
+	m_useOcclusionLocation = glGetUniformLocation(m_programID, "bUseOcclusion");
+	m_viewProjectionLocation = glGetUniformLocation(m_programID, "viewProjection");
+	m_hiZBufferLocation = glGetUniformLocation(m_programID, "hiZBuffer");
+	m_hiZSizeLocation = glGetUniformLocation(m_programID, "hiZSize");
+	m_hiZLevelsLocation = glGetUniformLocation(m_programID, "hiZLevels");
+	m_useLodLocation = glGetUniformLocation(m_programID, "bUseLod");
+	m_lodScaleLocation = glGetUniformLocation(m_programID, "lodScale");
+	m_lodScreenSizesLocation = glGetUniformLocation(m_programID, "lodScreenSizes");
+	m_lodHysteresisLocation = glGetUniformLocation(m_programID, "lodHysteresis");
+
+	glGenBuffers(1, &m_objectBuffer);
+	glGenBuffers(1, &m_commandBuffer);
+	glGenBuffers(1, &m_commandTemplate);
+	glGenBuffers(1, &m_lodBuffer);
+
+	return(true);
+}
+
+/***********************************************************
+ *  SetLodThresholds()
+ *
+ *  This method is used for setting the screen sizes where
+ *  the objects switch between their detail levels.  An
+ *  object at level n moves to level n + 1 when it covers
+ *  less than screenSizes[n] * (1 - hysteresis) of the screen
+ *  height, and back when it covers more than
+ *  screenSizes[n] * (1 + hysteresis).
+ ***********************************************************/
+void GpuCulling::SetLodThresholds(const float* screenSizes, int thresholdCount, float hysteresis)
+{
+	for (int i = 0; i < MAX_LOD_COUNT - 1; i++)
+	{
+		// missing levels are never switched to
+		m_lodScreenSizes[i] = (i < thresholdCount) ? screenSizes[i] : 0.0f;
+	}
+	m_lodHysteresis = hysteresis;
+}
+
+/***********************************************************
+ *  SetObjects()
+ *
+ *  This method is used for replacing the culled objects and
+ *  the draw commands of their groups.
+ ***********************************************************/
+void GpuCulling::SetObjects(const std::vector<GPU_OBJECT>& objects, const std::vector<DRAW_COMMAND>& commands)
+{
+	if (m_programID == 0)
+	{
+		return;
+	}
+
+	m_objectCount = (int)objects.size();
+	m_commandCount = (int)commands.size();
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_objectBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, objects.size() * sizeof(GPU_OBJECT), objects.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	std::vector<DRAW_COMMAND> emptyCommands = commands;
+	for (size_t c = 0; c < emptyCommands.size(); c++)
+	{
+		emptyCommands[c].instanceCount = 0;
+	}
+
+	glBindBuffer(GL_COPY_READ_BUFFER, m_commandTemplate);
+	glBufferData(GL_COPY_READ_BUFFER, emptyCommands.size() * sizeof(DRAW_COMMAND), emptyCommands.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, emptyCommands.size() * sizeof(DRAW_COMMAND), emptyCommands.data(), GL_DYNAMIC_COPY);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+	// every object starts at the finest level
+	std::vector<GLuint> levels(objects.size(), 0);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_lodBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, levels.size() * sizeof(GLuint), levels.data(), GL_DYNAMIC_COPY);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+/***********************************************************
+ *  Cull()
+ *
+ *  This method is used for running the culling pass.  The
+ *  instance counts are reset from the command template, the
+ *  compute shader appends the visible objects, and a memory
+ *  barrier makes the results visible to the indirect draws
+ *  and to the instance attributes.  The program that was
+ *  current before is restored.
+ ***********************************************************/
+void GpuCulling::Cull(const CULL_VIEW& view, const HiZBuffer* pOcclusion, GLuint instanceBuffer)
+{
+	if ((m_programID == 0) || (m_objectCount == 0) || (m_commandCount == 0))
+	{
+		return;
+	}
+
+	GLint previousProgram = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
+
+	glBindBuffer(GL_COPY_READ_BUFFER, m_commandTemplate);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, m_commandBuffer);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, m_commandCount * sizeof(DRAW_COMMAND));
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	Frustum frustum;
+	frustum.SetViewProjection(view.viewProjection);
+
+	bool bUseOcclusion = (view.bUseFrustum == true) && (NULL != pOcclusion) && (pOcclusion->IsReady() == true);
+
+	glUseProgram(m_programID);
+	glUniformMatrix4fv(m_viewProjectionLocation, 1, GL_FALSE, &view.viewProjection[0][0]);
+	glUniform4fv(m_frustumPlanesLocation, Frustum::PLANE_COUNT, &frustum.GetPlanes()[0].x);
+	glUniform1ui(m_objectCountLocation, (GLuint)m_objectCount);
+	glUniform1i(m_useFrustumLocation, view.bUseFrustum ? 1 : 0);
+	glUniform1i(m_useLodLocation, view.bUseLod ? 1 : 0);
+	glUniform1f(m_lodScaleLocation, view.lodScale);
+	glUniform1fv(m_lodScreenSizesLocation, MAX_LOD_COUNT - 1, m_lodScreenSizes);
+	glUniform1f(m_lodHysteresisLocation, m_lodHysteresis);
+	glUniform1i(m_useOcclusionLocation, bUseOcclusion ? 1 : 0);
+	if (bUseOcclusion == true)
+	{
+		glUniform2i(m_hiZSizeLocation, pOcclusion->GetWidth(), pOcclusion->GetHeight());
+		glUniform1i(m_hiZLevelsLocation, pOcclusion->GetLevelCount());
+		glUniform1i(m_hiZBufferLocation, (GLint)g_HiZTextureUnit);
+		glActiveTexture(GL_TEXTURE0 + g_HiZTextureUnit);
+		glBindTexture(GL_TEXTURE_2D, pOcclusion->GetTexture());
+	}
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, g_ObjectBufferBinding, m_objectBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, g_CommandBufferBinding, m_commandBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, g_InstanceBufferBinding, instanceBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, g_LodBufferBinding, m_lodBuffer);
+
+	glDispatchCompute((GLuint)((m_objectCount + GROUP_SIZE - 1) / GROUP_SIZE), 1, 1);
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+
+	if (bUseOcclusion == true)
+	{
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+	glUseProgram((GLuint)previousProgram);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for releasing the compute program
+ *  and the buffers.
+ ***********************************************************/
+void GpuCulling::Destroy()
+{
+	if (m_programID != 0)
+	{
+		glDeleteProgram(m_programID);
+		m_programID = 0;
+	}
+	if (m_objectBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_objectBuffer);
+		m_objectBuffer = 0;
+	}
+	if (m_commandBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_commandBuffer);
+		m_commandBuffer = 0;
+	}
+	if (m_commandTemplate != 0)
+	{
+		glDeleteBuffers(1, &m_commandTemplate);
+		m_commandTemplate = 0;
+	}
+	if (m_lodBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_lodBuffer);
+		m_lodBuffer = 0;
+	}
+	m_objectCount = 0;
+	m_commandCount = 0;
+}
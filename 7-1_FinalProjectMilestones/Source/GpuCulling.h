@@ -0,0 +1,156 @@
+///////////////////////////////////////////////////////////////////////////////
+// gpuculling.h
+// ============
+// GPU-driven frustum and occlusion culling that writes indirect draw commands
+//
+//  The bounds, transformation and shader values of every drawn object live in
+//  a shader storage buffer.  Each frame a compute shader tests every object
+//  against the frustum planes and, when a depth pyramid of the occluders is
+//  available, against the occluders.  The visible objects are appended to the
+//  instance buffer region of their draw group and counted in the indirect
+//  draw command of the level of detail chosen for their screen size, so the
+//  CPU cost of a frame does not depend on the object count.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include "BoundingVolumes.h"
+#include "HiZBuffer.h"
+
+/***********************************************************
+ *  GpuCulling
+ *
+ *  This class contains the compute program and the buffers
+ *  of the GPU culling pass.  The owner describes the objects
+ *  and the draw groups, and then draws the groups with the
+ *  command buffer after Cull() returns.
+ ***********************************************************/
+class GpuCulling
+{
+public:
+	// std430 image of one culled object in the object buffer
+	struct GPU_OBJECT
+	{
+		glm::mat4 model;
+		glm::vec4 color;
+		// world bounds, w is unused
+		glm::vec4 boundsMin;
+		glm::vec4 boundsMax;
+		// UV scale in xy, texture layer in z, material index in w
+		glm::vec4 params;
+		// the first command of the draw group of the object
+		uint32_t drawGroup;
+		// OBJECT_FLAGS bits
+		uint32_t flags;
+		// number of detail levels, one command per level
+		uint32_t lodCount;
+		uint32_t padding;
+	};
+
+	// per-object flags, must match the culling shader
+	enum OBJECT_FLAGS
+	{
+		// drawn into the depth pyramid - never occlusion tested
+		OBJECT_OCCLUDER = 1
+	};
+
+	// the layout of a glMultiDrawElementsIndirect command
+	struct DRAW_COMMAND
+	{
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+
+	// the view an object list is culled for
+	struct CULL_VIEW
+	{
+		glm::mat4 viewProjection;
+		// projection[1][1], turns the bounds into screen sizes
+		float lodScale;
+		// cull against the frustum, otherwise keep every object
+		bool bUseFrustum;
+		// choose the detail level by screen size, otherwise
+		// every object is drawn at level 0
+		bool bUseLod;
+	};
+
+	// the most detail levels of one draw group
+	static const int MAX_LOD_COUNT = 4;
+
+	// constructor
+	GpuCulling();
+	// destructor
+	~GpuCulling();
+
+	// true when the context has compute shaders, storage
+	// buffers and indirect draws
+	static bool IsSupported();
+
+	// build the compute program - needs a current GL context
+	bool Initialize(const char* shaderFile);
+	bool IsInitialized() const { return(m_programID != 0); }
+
+	// replace the culled objects and the draw commands - the
+	// instanceCount of every command is reset by each Cull(),
+	// baseInstance is the first instance of the group
+	void SetObjects(const std::vector<GPU_OBJECT>& objects, const std::vector<DRAW_COMMAND>& commands);
+
+	// set the screen size below which each detail level
+	// switches to the next one, and the fraction of that size
+	// the screen size has to move past before the level changes
+	void SetLodThresholds(const float* screenSizes, int thresholdCount, float hysteresis);
+
+	// run the culling pass for a view, writing the visible
+	// instances into the passed in instance buffer - the
+	// occlusion test is skipped when pOcclusion is NULL or
+	// holds no pyramid yet
+	void Cull(const CULL_VIEW& view, const HiZBuffer* pOcclusion, GLuint instanceBuffer);
+
+	// the buffer to bind as GL_DRAW_INDIRECT_BUFFER
+	GLuint GetCommandBuffer() const { return(m_commandBuffer); }
+	int GetObjectCount() const { return(m_objectCount); }
+
+	// release the program and the buffers
+	void Destroy();
+
+private:
+	// threads per compute work group, must match the shader
+	static const int GROUP_SIZE = 64;
+
+	GLuint m_programID;
+	GLuint m_objectBuffer;
+	GLuint m_commandBuffer;
+	// the commands with zero instances, copied over the
+	// command buffer before every pass
+	GLuint m_commandTemplate;
+	// the detail level of every object in the last frame
+	GLuint m_lodBuffer;
+	// the level switching sizes and their hysteresis
+	float m_lodScreenSizes[MAX_LOD_COUNT - 1];
+	float m_lodHysteresis;
+	int m_objectCount;
+	int m_commandCount;
+
+	// uniform locations of the compute program
+	GLint m_frustumPlanesLocation;
+	GLint m_objectCountLocation;
+	GLint m_useFrustumLocation;
+	GLint m_useOcclusionLocation;
+	GLint m_viewProjectionLocation;
+	GLint m_hiZBufferLocation;
+	GLint m_hiZSizeLocation;
+	GLint m_hiZLevelsLocation;
+	GLint m_useLodLocation;
+	GLint m_lodScaleLocation;
+	GLint m_lodScreenSizesLocation;
+	GLint m_lodHysteresisLocation;
+};
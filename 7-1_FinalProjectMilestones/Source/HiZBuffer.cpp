@@ -0,0 +1,308 @@
+///////////////////////////////////////////////////////////////////////////////
+// hizbuffer.cpp
+// ============
+// hierarchical depth buffer for GPU occlusion culling
+///////////////////////////////////////////////////////////////////////////////
+
+#include "HiZBuffer.h"
+#include "ProgramBuilder.h"
+
+#include <algorithm>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// image units used by the pyramid shader
+	const GLuint g_SourceImageUnit = 0;
+	const GLuint g_TargetImageUnit = 1;
+	// texture unit the occluder depth is read from
+	const GLuint g_DepthTextureUnit = 0;
+}
+
+/***********************************************************
+ *  HiZBuffer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+HiZBuffer::HiZBuffer()
+{
+	m_programID = 0;
+	m_framebuffer = 0;
+	m_depthTexture = 0;
+	m_pyramidTexture = 0;
+	m_allocatedWidth = 0;
+	m_allocatedHeight = 0;
+	m_width = 0;
+	m_height = 0;
+	m_levelCount = 0;
+	m_bReady = false;
+	m_savedFramebuffer = 0;
+	m_savedViewport[0] = 0;
+	m_savedViewport[1] = 0;
+	m_savedViewport[2] = 0;
+	m_savedViewport[3] = 0;
+	m_depthTextureLocation = -1;
+	m_fromDepthLocation = -1;
+	m_sourceSizeLocation = -1;
+	m_targetSizeLocation = -1;
+}
+
+/***********************************************************
+ *  ~HiZBuffer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+HiZBuffer::~HiZBuffer()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for building the compute program
+ *  that reduces the occluder depth into the pyramid.  The
+ *  textures are created by the first occluder pass.
+ ***********************************************************/
+bool HiZBuffer::Initialize(const char* shaderFile)
+{
+	m_programID = ProgramBuilder::BuildComputeProgram(shaderFile);
+	if (m_programID == 0)
+	{
+		return(false);
+	}
+
+	m_depthTextureLocation = glGetUniformLocation(m_programID, "depthTexture");
+	m_fromDepthLocation = glGetUniformLocation(m_programID, "bFromDepth");
+	m_sourceSizeLocation = glGetUniformLocation(m_programID, "sourceSize");
+	m_targetSizeLocation = glGetUniformLocation(m_programID, "targetSize");
+
+	return(true);
+}
+
+/***********************************************************
+ *  Resize()
+ *
+ *  This method is used for creating the occluder depth
+ *  target and the full mip chain of the depth pyramid at
+ *  the allocated size.
+ ***********************************************************/
+bool HiZBuffer::Resize(int width, int height)
+{
+	DestroyTargets();
+
+	m_allocatedWidth = width;
+	m_allocatedHeight = height;
+	int levelCount = CountLevels(width, height);
+
+	glGenTextures(1, &m_depthTexture);
+	glBindTexture(GL_TEXTURE_2D, m_depthTexture);
+	glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT32F, m_allocatedWidth, m_allocatedHeight);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+
+	glGenTextures(1, &m_pyramidTexture);
+	glBindTexture(GL_TEXTURE_2D, m_pyramidTexture);
+	glTexStorage2D(GL_TEXTURE_2D, levelCount, GL_R32F, m_allocatedWidth, m_allocatedHeight);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	GLint previousFramebuffer = 0;
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+
+	glGenFramebuffers(1, &m_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_depthTexture, 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)previousFramebuffer);
+
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Occluder depth framebuffer is incomplete: " << status << std::endl;
+		DestroyTargets();
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  CountLevels()
+ *
+ *  This method is used for getting the number of levels of
+ *  a full mip chain for a size.
+ ***********************************************************/
+int HiZBuffer::CountLevels(int width, int height)
+{
+	int levelCount = 1;
+	while ((std::max(width, height) >> levelCount) > 0)
+	{
+		levelCount++;
+	}
+
+	return(levelCount);
+}
+
+/***********************************************************
+ *  BeginOccluderPass()
+ *
+ *  This method is used for binding the occluder depth target
+ *  and clearing it.  The drawn part follows the size of the
+ *  current viewport, so the occluders are drawn with the
+ *  same projection as the scene.  The textures are only
+ *  created again when the viewport outgrows them - a smaller
+ *  viewport draws into their lower left part.
+ ***********************************************************/
+void HiZBuffer::BeginOccluderPass()
+{
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &m_savedFramebuffer);
+	glGetIntegerv(GL_VIEWPORT, m_savedViewport);
+
+	int width = std::max(1, m_savedViewport[2] / 2);
+	int height = std::max(1, m_savedViewport[3] / 2);
+	if ((width > m_allocatedWidth) || (height > m_allocatedHeight) || (m_framebuffer == 0))
+	{
+		Resize(std::max(width, m_allocatedWidth), std::max(height, m_allocatedHeight));
+	}
+
+	// the pyramid of another size does not match this frame
+	if ((width != m_width) || (height != m_height))
+	{
+		m_width = width;
+		m_height = height;
+		m_levelCount = CountLevels(width, height);
+		m_bReady = false;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glViewport(0, 0, m_width, m_height);
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	glClear(GL_DEPTH_BUFFER_BIT);
+}
+
+/***********************************************************
+ *  EndOccluderPass()
+ *
+ *  This method is used for restoring the framebuffer, the
+ *  viewport and the color mask of the scene.
+ ***********************************************************/
+void HiZBuffer::EndOccluderPass()
+{
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+	glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)m_savedFramebuffer);
+	glViewport(m_savedViewport[0], m_savedViewport[1], m_savedViewport[2], m_savedViewport[3]);
+}
+
+/***********************************************************
+ *  BuildPyramid()
+ *
+ *  This method is used for copying the drawn part of the
+ *  occluder depth into the first pyramid level, and then
+ *  reducing every level into the next one with the farthest
+ *  depth of each block.
+ *  The program that was current before is restored.
+ ***********************************************************/
+void HiZBuffer::BuildPyramid()
+{
+	if ((m_programID == 0) || (m_pyramidTexture == 0))
+	{
+		return;
+	}
+
+	GLint previousProgram = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
+
+	glUseProgram(m_programID);
+	glActiveTexture(GL_TEXTURE0 + g_DepthTextureUnit);
+	glBindTexture(GL_TEXTURE_2D, m_depthTexture);
+	glUniform1i(m_depthTextureLocation, (GLint)g_DepthTextureUnit);
+
+	int sourceWidth = m_width;
+	int sourceHeight = m_height;
+	for (int level = 0; level < m_levelCount; level++)
+	{
+		int targetWidth = std::max(1, m_width >> level);
+		int targetHeight = std::max(1, m_height >> level);
+
+		glUniform1i(m_fromDepthLocation, (level == 0) ? 1 : 0);
+		glUniform2i(m_sourceSizeLocation, sourceWidth, sourceHeight);
+		glUniform2i(m_targetSizeLocation, targetWidth, targetHeight);
+
+		if (level > 0)
+		{
+			glBindImageTexture(g_SourceImageUnit, m_pyramidTexture, level - 1, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+		}
+		glBindImageTexture(g_TargetImageUnit, m_pyramidTexture, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+
+		glDispatchCompute(
+			(GLuint)((targetWidth + GROUP_SIZE - 1) / GROUP_SIZE),
+			(GLuint)((targetHeight + GROUP_SIZE - 1) / GROUP_SIZE),
+			1);
+		// the next level reads the one that was just written
+		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+		sourceWidth = targetWidth;
+		sourceHeight = targetHeight;
+	}
+
+	// the culling pass samples the pyramid as a texture
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glUseProgram((GLuint)previousProgram);
+
+	m_bReady = true;
+}
+
+/***********************************************************
+ *  DestroyTargets()
+ *
+ *  This method is used for releasing the textures and the
+ *  framebuffer of the current target size.
+ ***********************************************************/
+void HiZBuffer::DestroyTargets()
+{
+	if (m_framebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &m_framebuffer);
+		m_framebuffer = 0;
+	}
+	if (m_depthTexture != 0)
+	{
+		glDeleteTextures(1, &m_depthTexture);
+		m_depthTexture = 0;
+	}
+	if (m_pyramidTexture != 0)
+	{
+		glDeleteTextures(1, &m_pyramidTexture);
+		m_pyramidTexture = 0;
+	}
+	m_allocatedWidth = 0;
+	m_allocatedHeight = 0;
+	m_width = 0;
+	m_height = 0;
+	m_levelCount = 0;
+	m_bReady = false;
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for releasing the program and the
+ *  textures.
+ ***********************************************************/
+void HiZBuffer::Destroy()
+{
+	DestroyTargets();
+	if (m_programID != 0)
+	{
+		glDeleteProgram(m_programID);
+		m_programID = 0;
+	}
+}
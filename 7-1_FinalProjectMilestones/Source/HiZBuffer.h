@@ -0,0 +1,94 @@
+///////////////////////////////////////////////////////////////////////////////
+// hizbuffer.h
+// ============
+// hierarchical depth buffer for GPU occlusion culling
+//
+//  The large occluders of the scene are drawn depth only into a half size
+//  depth texture, which is then reduced into a mip chain where every texel
+//  holds the farthest depth of the texels it covers.  A box whose nearest
+//  depth is behind the farthest depth of the few texels covering it at the
+//  matching level is hidden behind the occluders and does not need to be drawn.
+//
+//  The textures are allocated for the largest viewport drawn so far, which is
+//  the full render target, and a smaller viewport - a lower dynamic resolution
+//  scale - is drawn into and reduced as the lower left part of every level.
+//  The scale steps then only change the part that is built and sampled.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+/***********************************************************
+ *  HiZBuffer
+ *
+ *  This class contains the occluder depth target, the depth
+ *  pyramid built from it and the compute program that builds
+ *  the pyramid.
+ ***********************************************************/
+class HiZBuffer
+{
+public:
+	// constructor
+	HiZBuffer();
+	// destructor
+	~HiZBuffer();
+
+	// build the pyramid program - needs a current GL context
+	bool Initialize(const char* shaderFile);
+
+	// bind the occluder depth target and draw into half the size
+	// of the current viewport - the framebuffer, viewport and
+	// color mask are restored by EndOccluderPass()
+	void BeginOccluderPass();
+	void EndOccluderPass();
+
+	// reduce the occluder depth into the depth pyramid
+	void BuildPyramid();
+
+	// the depth pyramid and the size of the part that was built,
+	// for the culling pass
+	GLuint GetTexture() const { return(m_pyramidTexture); }
+	int GetWidth() const { return(m_width); }
+	int GetHeight() const { return(m_height); }
+	int GetLevelCount() const { return(m_levelCount); }
+	// true once a pyramid was built
+	bool IsReady() const { return(m_bReady); }
+
+	// release the program and the textures
+	void Destroy();
+
+private:
+	// threads per compute work group side, must match the shader
+	static const int GROUP_SIZE = 8;
+
+	GLuint m_programID;
+	GLuint m_framebuffer;
+	GLuint m_depthTexture;
+	GLuint m_pyramidTexture;
+	// the allocated size of the textures
+	int m_allocatedWidth;
+	int m_allocatedHeight;
+	// the drawn part of the textures and its pyramid levels
+	int m_width;
+	int m_height;
+	int m_levelCount;
+	bool m_bReady;
+
+	// the state replaced by BeginOccluderPass()
+	GLint m_savedFramebuffer;
+	GLint m_savedViewport[4];
+
+	// uniform locations of the pyramid program
+	GLint m_depthTextureLocation;
+	GLint m_fromDepthLocation;
+	GLint m_sourceSizeLocation;
+	GLint m_targetSizeLocation;
+
+	// create the textures for a larger target size
+	bool Resize(int width, int height);
+	// the levels of a full mip chain for a size
+	static int CountLevels(int width, int height);
+	// release the textures and the framebuffer
+	void DestroyTargets();
+};
@@ -0,0 +1,551 @@
+///////////////////////////////////////////////////////////////////////////////
+// instancedmeshes.cpp
+// ============
+// generate the basic 3D shape meshes and draw many copies of each shape with
+// a single instanced draw call
+///////////////////////////////////////////////////////////////////////////////
+
+#include "InstancedMeshes.h"
+
+#include <cmath>
+#include <cstddef>
+
+// declaration of global variables
+namespace
+{
+	// number of floats per vertex - position, normal, texture coordinate
+	const int g_FloatsPerVertex = 8;
+
+	// per-instance attribute locations used by the vertex shader,
+	// the per-vertex ones are set up by the mesh arena
+	const GLuint g_InstanceModelLocation = 3;	// uses locations 3 to 6
+	const GLuint g_InstanceColorLocation = 7;
+	const GLuint g_InstanceUVScaleLocation = 8;
+	const GLuint g_InstanceTextureLayerLocation = 9;
+	const GLuint g_InstanceMaterialLocation = 10;
+
+	// tessellation of the curved shapes per level of detail
+	const int g_CylinderSlices[InstancedMeshes::LOD_COUNT] = { 36, 18, 10 };
+	const int g_SphereSectors[InstancedMeshes::LOD_COUNT] = { 36, 18, 12 };
+	const int g_SphereStacks[InstancedMeshes::LOD_COUNT] = { 18, 9, 6 };
+
+	const float g_PI = 3.14159265358979f;
+
+	// append a single vertex to a vertex list
+	void AddVertex(
+		std::vector<GLfloat>& vertices,
+		glm::vec3 position,
+		glm::vec3 normal,
+		glm::vec2 textureCoordinate)
+	{
+		vertices.push_back(position.x);
+		vertices.push_back(position.y);
+		vertices.push_back(position.z);
+		vertices.push_back(normal.x);
+		vertices.push_back(normal.y);
+		vertices.push_back(normal.z);
+		vertices.push_back(textureCoordinate.x);
+		vertices.push_back(textureCoordinate.y);
+	}
+
+	// append one flat quad, wound counter-clockwise around its normal
+	void AddQuad(
+		std::vector<GLfloat>& vertices,
+		std::vector<GLushort>& indices,
+		glm::vec3 center,
+		glm::vec3 uAxis,
+		glm::vec3 vAxis,
+		glm::vec3 normal)
+	{
+		GLushort first = (GLushort)(vertices.size() / g_FloatsPerVertex);
+
+		AddVertex(vertices, center - uAxis - vAxis, normal, glm::vec2(0.0f, 0.0f));
+		AddVertex(vertices, center + uAxis - vAxis, normal, glm::vec2(1.0f, 0.0f));
+		AddVertex(vertices, center + uAxis + vAxis, normal, glm::vec2(1.0f, 1.0f));
+		AddVertex(vertices, center - uAxis + vAxis, normal, glm::vec2(0.0f, 1.0f));
+
+		indices.push_back(first);
+		indices.push_back(first + 1);
+		indices.push_back(first + 2);
+		indices.push_back(first);
+		indices.push_back(first + 2);
+		indices.push_back(first + 3);
+	}
+}
+
+/***********************************************************
+ *  InstancedMeshes()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+InstancedMeshes::InstancedMeshes()
+{
+	m_planeMesh = -1;
+	m_boxMesh = -1;
+	for (int lod = 0; lod < LOD_COUNT; lod++)
+	{
+		m_cylinderMeshes[lod] = -1;
+		m_sphereMeshes[lod] = -1;
+	}
+	m_instanceBuffer = 0;
+	m_instanceCapacity = 0;
+}
+
+/***********************************************************
+ *  ~InstancedMeshes()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+InstancedMeshes::~InstancedMeshes()
+{
+	m_arena.Destroy();
+
+	if (m_instanceBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_instanceBuffer);
+		m_instanceBuffer = 0;
+	}
+}
+
+/***********************************************************
+ *  LoadPlaneMesh()
+ *
+ *  This method is used for generating a 2x2 plane on the
+ *  XZ axes, facing up.
+ ***********************************************************/
+void InstancedMeshes::LoadPlaneMesh()
+{
+	std::vector<GLfloat> vertices;
+	std::vector<GLushort> indices;
+
+	AddQuad(vertices, indices,
+		glm::vec3(0.0f, 0.0f, 0.0f),
+		glm::vec3(1.0f, 0.0f, 0.0f),
+		glm::vec3(0.0f, 0.0f, -1.0f),
+		glm::vec3(0.0f, 1.0f, 0.0f));
+
+	m_planeMesh = UploadMesh(vertices, indices);
+}
+
+/***********************************************************
+ *  LoadBoxMesh()
+ *
+ *  This method is used for generating a unit box centered
+ *  on the origin, with each face mapping the full texture.
+ ***********************************************************/
+void InstancedMeshes::LoadBoxMesh()
+{
+	std::vector<GLfloat> vertices;
+	std::vector<GLushort> indices;
+
+	// front and back faces
+	AddQuad(vertices, indices,
+		glm::vec3(0.0f, 0.0f, 0.5f), glm::vec3(0.5f, 0.0f, 0.0f),
+		glm::vec3(0.0f, 0.5f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+	AddQuad(vertices, indices,
+		glm::vec3(0.0f, 0.0f, -0.5f), glm::vec3(-0.5f, 0.0f, 0.0f),
+		glm::vec3(0.0f, 0.5f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f));
+	// right and left faces
+	AddQuad(vertices, indices,
+		glm::vec3(0.5f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -0.5f),
+		glm::vec3(0.0f, 0.5f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+	AddQuad(vertices, indices,
+		glm::vec3(-0.5f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 0.5f),
+		glm::vec3(0.0f, 0.5f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f));
+	// top and bottom faces
+	AddQuad(vertices, indices,
+		glm::vec3(0.0f, 0.5f, 0.0f), glm::vec3(0.5f, 0.0f, 0.0f),
+		glm::vec3(0.0f, 0.0f, -0.5f), glm::vec3(0.0f, 1.0f, 0.0f));
+	AddQuad(vertices, indices,
+		glm::vec3(0.0f, -0.5f, 0.0f), glm::vec3(0.5f, 0.0f, 0.0f),
+		glm::vec3(0.0f, 0.0f, 0.5f), glm::vec3(0.0f, -1.0f, 0.0f));
+
+	m_boxMesh = UploadMesh(vertices, indices);
+}
+
+/***********************************************************
+ *  LoadCylinderMesh()
+ *
+ *  This method is used for generating a unit radius
+ *  cylinder standing from y=0 to y=1, with both caps, at
+ *  every level of detail.
+ ***********************************************************/
+void InstancedMeshes::LoadCylinderMesh()
+{
+	for (int lod = 0; lod < LOD_COUNT; lod++)
+	{
+		const int slices = g_CylinderSlices[lod];
+		std::vector<GLfloat> vertices;
+		std::vector<GLushort> indices;
+
+		// sides - one extra column so the texture seam is not shared
+		for (int i = 0; i <= slices; i++)
+		{
+			float u = (float)i / (float)slices;
+			float angle = u * 2.0f * g_PI;
+			glm::vec3 normal(std::cos(angle), 0.0f, -std::sin(angle));
+
+			AddVertex(vertices, glm::vec3(normal.x, 0.0f, normal.z), normal, glm::vec2(u, 0.0f));
+			AddVertex(vertices, glm::vec3(normal.x, 1.0f, normal.z), normal, glm::vec2(u, 1.0f));
+		}
+		for (int i = 0; i < slices; i++)
+		{
+			GLushort bottom = (GLushort)(i * 2);
+
+			indices.push_back(bottom);
+			indices.push_back(bottom + 2);
+			indices.push_back(bottom + 3);
+			indices.push_back(bottom);
+			indices.push_back(bottom + 3);
+			indices.push_back(bottom + 1);
+		}
+
+		// top and bottom caps - a center vertex fanned out to a ring
+		for (int cap = 0; cap < 2; cap++)
+		{
+			float y = (cap == 0) ? 1.0f : 0.0f;
+			glm::vec3 normal(0.0f, (cap == 0) ? 1.0f : -1.0f, 0.0f);
+			GLushort center = (GLushort)(vertices.size() / g_FloatsPerVertex);
+
+			AddVertex(vertices, glm::vec3(0.0f, y, 0.0f), normal, glm::vec2(0.5f, 0.5f));
+			for (int i = 0; i <= slices; i++)
+			{
+				float angle = (float)i / (float)slices * 2.0f * g_PI;
+				float x = std::cos(angle);
+				float z = -std::sin(angle);
+
+				AddVertex(vertices, glm::vec3(x, y, z), normal,
+					glm::vec2(0.5f + (0.5f * x), 0.5f - (0.5f * z)));
+			}
+			for (int i = 0; i < slices; i++)
+			{
+				indices.push_back(center);
+				if (cap == 0)
+				{
+					indices.push_back(center + 1 + i);
+					indices.push_back(center + 2 + i);
+				}
+				else
+				{
+					indices.push_back(center + 2 + i);
+					indices.push_back(center + 1 + i);
+				}
+			}
+		}
+
+		m_cylinderMeshes[lod] = UploadMesh(vertices, indices);
+	}
+}
+
+/***********************************************************
+ *  LoadSphereMesh()
+ *
+ *  This method is used for generating a unit radius sphere
+ *  centered on the origin from stacks and sectors, at every
+ *  level of detail.
+ ***********************************************************/
+void InstancedMeshes::LoadSphereMesh()
+{
+	for (int lod = 0; lod < LOD_COUNT; lod++)
+	{
+		const int sectors = g_SphereSectors[lod];
+		const int stacks = g_SphereStacks[lod];
+		std::vector<GLfloat> vertices;
+		std::vector<GLushort> indices;
+
+		for (int stack = 0; stack <= stacks; stack++)
+		{
+			float v = (float)stack / (float)stacks;
+			// from the north pole down to the south pole
+			float phi = (g_PI / 2.0f) - (v * g_PI);
+			float ringRadius = std::cos(phi);
+			float y = std::sin(phi);
+
+			for (int sector = 0; sector <= sectors; sector++)
+			{
+				float u = (float)sector / (float)sectors;
+				float theta = u * 2.0f * g_PI;
+				glm::vec3 normal(ringRadius * std::cos(theta), y, -ringRadius * std::sin(theta));
+
+				AddVertex(vertices, normal, normal, glm::vec2(u, 1.0f - v));
+			}
+		}
+
+		for (int stack = 0; stack < stacks; stack++)
+		{
+			GLushort upper = (GLushort)(stack * (sectors + 1));
+			GLushort lower = (GLushort)(upper + sectors + 1);
+
+			for (int sector = 0; sector < sectors; sector++, upper++, lower++)
+			{
+				// the pole rows collapse to single triangles
+				if (stack != 0)
+				{
+					indices.push_back(upper);
+					indices.push_back(lower);
+					indices.push_back(upper + 1);
+				}
+				if (stack != (stacks - 1))
+				{
+					indices.push_back(upper + 1);
+					indices.push_back(lower);
+					indices.push_back(lower + 1);
+				}
+			}
+		}
+
+		m_sphereMeshes[lod] = UploadMesh(vertices, indices);
+	}
+}
+
+/***********************************************************
+ *  SetInstanceData()
+ *
+ *  This method is used for replacing the contents of the
+ *  shared instance buffer.  The buffer only grows, so
+ *  rewriting the same number of instances every frame does
+ *  not reallocate GPU memory.
+ ***********************************************************/
+void InstancedMeshes::SetInstanceData(const INSTANCE_DATA* instances, int instanceCount)
+{
+	if (m_instanceBuffer == 0)
+	{
+		glGenBuffers(1, &m_instanceBuffer);
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+	if (instanceCount > m_instanceCapacity)
+	{
+		glBufferData(GL_ARRAY_BUFFER, instanceCount * sizeof(INSTANCE_DATA), instances, GL_DYNAMIC_DRAW);
+		m_instanceCapacity = instanceCount;
+	}
+	else if (instanceCount > 0)
+	{
+		glBufferSubData(GL_ARRAY_BUFFER, 0, instanceCount * sizeof(INSTANCE_DATA), instances);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/***********************************************************
+ *  ReserveInstances()
+ *
+ *  This method is used for growing the shared instance
+ *  buffer without uploading any values, for instances that
+ *  are written on the GPU.
+ ***********************************************************/
+void InstancedMeshes::ReserveInstances(int instanceCount)
+{
+	if (m_instanceBuffer == 0)
+	{
+		glGenBuffers(1, &m_instanceBuffer);
+	}
+
+	if (instanceCount > m_instanceCapacity)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+		glBufferData(GL_ARRAY_BUFFER, instanceCount * sizeof(INSTANCE_DATA), NULL, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		m_instanceCapacity = instanceCount;
+	}
+}
+
+/***********************************************************
+ *  SetInstanceRange()
+ *
+ *  This method is used for overwriting a range of instances
+ *  inside the current size of the shared instance buffer,
+ *  leaving the other instances as they are.
+ ***********************************************************/
+void InstancedMeshes::SetInstanceRange(int firstInstance, const INSTANCE_DATA* instances, int instanceCount)
+{
+	if ((instanceCount <= 0) || (firstInstance < 0) || (firstInstance + instanceCount > m_instanceCapacity))
+	{
+		return;
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+	glBufferSubData(GL_ARRAY_BUFFER, firstInstance * sizeof(INSTANCE_DATA), instanceCount * sizeof(INSTANCE_DATA), instances);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/***********************************************************
+ *  Draw*MeshInstanced()
+ *
+ *  These methods are used for drawing a range of instances
+ *  from the shared instance buffer with one draw call.
+ ***********************************************************/
+void InstancedMeshes::DrawPlaneMeshInstanced(int firstInstance, int instanceCount)
+{
+	DrawMeshInstanced(m_planeMesh, firstInstance, instanceCount);
+}
+
+void InstancedMeshes::DrawBoxMeshInstanced(int firstInstance, int instanceCount)
+{
+	DrawMeshInstanced(m_boxMesh, firstInstance, instanceCount);
+}
+
+void InstancedMeshes::DrawCylinderMeshInstanced(int firstInstance, int instanceCount, int lod)
+{
+	DrawMeshInstanced(m_cylinderMeshes[lod], firstInstance, instanceCount);
+}
+
+void InstancedMeshes::DrawSphereMeshInstanced(int firstInstance, int instanceCount, int lod)
+{
+	DrawMeshInstanced(m_sphereMeshes[lod], firstInstance, instanceCount);
+}
+
+/***********************************************************
+ *  DrawIndirect()
+ *
+ *  This method is used for drawing with the commands of the
+ *  bound indirect buffer.  Every shape is in the same arena,
+ *  so one call covers commands of different shapes.  The
+ *  commands use baseInstance, so the instance attributes are
+ *  expected to point at the start of the instance buffer.
+ ***********************************************************/
+void InstancedMeshes::DrawIndirect(size_t commandOffset, int drawCount)
+{
+	if ((m_arena.GetVertexArray() == 0) || (drawCount <= 0))
+	{
+		return;
+	}
+
+	glBindVertexArray(m_arena.GetVertexArray());
+	glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_SHORT, (void*)commandOffset, drawCount, 0);
+}
+
+/***********************************************************
+ *  GetMeshRange()
+ *
+ *  This method is used for getting the arena range of a
+ *  mesh, which is empty for a mesh that is not loaded.
+ ***********************************************************/
+MeshArena::MESH_RANGE InstancedMeshes::GetMeshRange(int meshID) const
+{
+	if ((meshID < 0) || (meshID >= m_arena.GetMeshCount()))
+	{
+		MeshArena::MESH_RANGE empty = { 0, 0, 0 };
+		return(empty);
+	}
+
+	return(m_arena.GetMesh(meshID));
+}
+
+/***********************************************************
+ *  UploadMesh()
+ *
+ *  This method is used for adding generated vertex and
+ *  index data to the mesh arena.  The arena packs every
+ *  mesh again, so the instance buffer is attached to its
+ *  new vertex array afterwards.
+ ***********************************************************/
+int InstancedMeshes::UploadMesh(
+	const std::vector<GLfloat>& vertices,
+	const std::vector<GLushort>& indices)
+{
+	int meshID = m_arena.AddMesh(vertices, indices);
+
+	m_arena.Upload();
+	SetupInstanceAttributes();
+
+	return(meshID);
+}
+
+/***********************************************************
+ *  SetupInstanceAttributes()
+ *
+ *  This method is used for attaching the shared instance
+ *  buffer to the vertex array of the mesh arena.
+ ***********************************************************/
+void InstancedMeshes::SetupInstanceAttributes()
+{
+	if (m_instanceBuffer == 0)
+	{
+		glGenBuffers(1, &m_instanceBuffer);
+	}
+
+	glBindVertexArray(m_arena.GetVertexArray());
+
+	// per-instance attributes - advance once per drawn copy
+	for (GLuint column = 0; column < 4; column++)
+	{
+		glEnableVertexAttribArray(g_InstanceModelLocation + column);
+		glVertexAttribDivisor(g_InstanceModelLocation + column, 1);
+	}
+	glEnableVertexAttribArray(g_InstanceColorLocation);
+	glVertexAttribDivisor(g_InstanceColorLocation, 1);
+	glEnableVertexAttribArray(g_InstanceUVScaleLocation);
+	glVertexAttribDivisor(g_InstanceUVScaleLocation, 1);
+	glEnableVertexAttribArray(g_InstanceTextureLayerLocation);
+	glVertexAttribDivisor(g_InstanceTextureLayerLocation, 1);
+	glEnableVertexAttribArray(g_InstanceMaterialLocation);
+	glVertexAttribDivisor(g_InstanceMaterialLocation, 1);
+	SetInstanceAttributes(0);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/***********************************************************
+ *  SetInstanceAttributes()
+ *
+ *  This method is used for pointing the per-instance
+ *  attributes of the bound arena vertex array at the passed
+ *  in instance of the shared instance buffer.
+ ***********************************************************/
+void InstancedMeshes::SetInstanceAttributes(int firstInstance)
+{
+	const GLsizei stride = sizeof(INSTANCE_DATA);
+	size_t base = (size_t)firstInstance * sizeof(INSTANCE_DATA);
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+	for (GLuint column = 0; column < 4; column++)
+	{
+		glVertexAttribPointer(g_InstanceModelLocation + column, 4, GL_FLOAT, GL_FALSE, stride,
+			(void*)(base + offsetof(INSTANCE_DATA, model) + (sizeof(glm::vec4) * column)));
+	}
+	glVertexAttribPointer(g_InstanceColorLocation, 4, GL_FLOAT, GL_FALSE, stride,
+		(void*)(base + offsetof(INSTANCE_DATA, color)));
+	glVertexAttribPointer(g_InstanceUVScaleLocation, 2, GL_FLOAT, GL_FALSE, stride,
+		(void*)(base + offsetof(INSTANCE_DATA, UVscale)));
+	glVertexAttribPointer(g_InstanceTextureLayerLocation, 1, GL_FLOAT, GL_FALSE, stride,
+		(void*)(base + offsetof(INSTANCE_DATA, textureLayer)));
+	glVertexAttribPointer(g_InstanceMaterialLocation, 1, GL_FLOAT, GL_FALSE, stride,
+		(void*)(base + offsetof(INSTANCE_DATA, materialIndex)));
+}
+
+/***********************************************************
+ *  DrawMeshInstanced()
+ *
+ *  This method is used for drawing a range of instances of
+ *  a loaded mesh from its arena range.  OpenGL 4.2 can offset
+ *  into the instance buffer directly, older contexts
+ *  re-point the attributes.  The arena vertex array is left
+ *  bound, since the next shape draws from it as well.
+ ***********************************************************/
+void InstancedMeshes::DrawMeshInstanced(int meshID, int firstInstance, int instanceCount)
+{
+	MeshArena::MESH_RANGE range = GetMeshRange(meshID);
+	if ((range.indexCount == 0) || (instanceCount <= 0))
+	{
+		return;
+	}
+
+	void* indexOffset = (void*)((size_t)range.firstIndex * sizeof(GLushort));
+
+	glBindVertexArray(m_arena.GetVertexArray());
+
+	if (GLEW_VERSION_4_2)
+	{
+		glDrawElementsInstancedBaseVertexBaseInstance(
+			GL_TRIANGLES, range.indexCount, GL_UNSIGNED_SHORT, indexOffset,
+			instanceCount, range.baseVertex, firstInstance);
+	}
+	else
+	{
+		SetInstanceAttributes(firstInstance);
+		glDrawElementsInstancedBaseVertex(
+			GL_TRIANGLES, range.indexCount, GL_UNSIGNED_SHORT, indexOffset,
+			instanceCount, range.baseVertex);
+	}
+}
@@ -0,0 +1,126 @@
+///////////////////////////////////////////////////////////////////////////////
+// instancedmeshes.h
+// ============
+// generate the basic 3D shape meshes and draw many copies of each shape with
+// a single instanced draw call
+//
+//  The generated shapes follow the same conventions as ShapeMeshes - a 2x2
+//  plane on XZ, a unit box centered on the origin, a unit radius cylinder
+//  standing from y=0 to y=1 and a unit radius sphere - so that scene objects
+//  can be moved between the two without changing their transformations.
+//  The curved shapes are generated at several levels of detail, so objects
+//  that cover little of the screen can be drawn with fewer triangles.
+//  Every shape lives in one mesh arena, so all of them share a single vertex
+//  array and the draws of different shapes never switch buffers.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "MeshArena.h"
+
+#include <vector>
+
+/***********************************************************
+ *  InstancedMeshes
+ *
+ *  This class contains the code for loading the basic 3D
+ *  shape meshes together with a shared per-instance buffer
+ *  that holds the model matrix, color, texture UV scale and
+ *  material of every drawn copy.
+ ***********************************************************/
+class InstancedMeshes
+{
+public:
+	// constructor
+	InstancedMeshes();
+	// destructor
+	~InstancedMeshes();
+
+	// number of tessellations of the cylinder and the sphere,
+	// level 0 is the finest
+	static const int LOD_COUNT = 3;
+
+	// per-instance values read by the vertex shader
+	struct INSTANCE_DATA
+	{
+		glm::mat4 model;
+		glm::vec4 color;
+		glm::vec2 UVscale;
+		// layer of the object texture in its texture array
+		float textureLayer;
+		// index of the object material in the material block
+		float materialIndex;
+	};
+
+	// load the shape meshes into GPU memory
+	void LoadPlaneMesh();
+	void LoadBoxMesh();
+	void LoadCylinderMesh();
+	void LoadSphereMesh();
+
+	// replace the contents of the shared instance buffer
+	void SetInstanceData(const INSTANCE_DATA* instances, int instanceCount);
+	// grow the shared instance buffer so that it holds at least
+	// the passed in number of instances - the contents are
+	// undefined after the buffer grows
+	void ReserveInstances(int instanceCount);
+	// overwrite a range of instances that the buffer already holds
+	void SetInstanceRange(int firstInstance, const INSTANCE_DATA* instances, int instanceCount);
+	// the shared instance buffer, for writing instances on the GPU
+	GLuint GetInstanceBuffer() const { return(m_instanceBuffer); }
+
+	// the arena ranges of the shape meshes, for indirect draws -
+	// the range of a mesh that is not loaded is empty
+	MeshArena::MESH_RANGE GetPlaneRange() const { return(GetMeshRange(m_planeMesh)); }
+	MeshArena::MESH_RANGE GetBoxRange() const { return(GetMeshRange(m_boxMesh)); }
+	MeshArena::MESH_RANGE GetCylinderRange(int lod) const { return(GetMeshRange(m_cylinderMeshes[lod])); }
+	MeshArena::MESH_RANGE GetSphereRange(int lod) const { return(GetMeshRange(m_sphereMeshes[lod])); }
+
+	// draw a range of instances from the shared instance buffer
+	void DrawPlaneMeshInstanced(int firstInstance, int instanceCount);
+	void DrawBoxMeshInstanced(int firstInstance, int instanceCount);
+	void DrawCylinderMeshInstanced(int firstInstance, int instanceCount, int lod);
+	void DrawSphereMeshInstanced(int firstInstance, int instanceCount, int lod);
+
+	// draw any of the shapes with the commands of the bound
+	// GL_DRAW_INDIRECT_BUFFER, starting at a byte offset - the
+	// commands carry the first index and base vertex of their
+	// mesh range
+	void DrawIndirect(size_t commandOffset, int drawCount);
+
+	// the arena that holds the vertices and indices of every shape
+	const MeshArena& GetArena() const { return(m_arena); }
+
+private:
+	// the vertex and index buffers shared by every shape
+	MeshArena m_arena;
+
+	// the arena IDs of the loaded shape meshes, the curved ones
+	// per level of detail - -1 before the mesh is loaded
+	int m_planeMesh;
+	int m_boxMesh;
+	int m_cylinderMeshes[LOD_COUNT];
+	int m_sphereMeshes[LOD_COUNT];
+
+	// buffer holding the instance values of every drawn copy
+	GLuint m_instanceBuffer;
+	// number of instances the buffer can currently hold
+	int m_instanceCapacity;
+
+	// add generated vertex and index data to the arena and
+	// upload it again - returns the arena ID of the mesh
+	int UploadMesh(
+		const std::vector<GLfloat>& vertices,
+		const std::vector<GLushort>& indices);
+	// attach the shared instance buffer to the arena vertex array
+	void SetupInstanceAttributes();
+	// point the per-instance attributes at an instance
+	void SetInstanceAttributes(int firstInstance);
+	// the arena range of a mesh ID
+	MeshArena::MESH_RANGE GetMeshRange(int meshID) const;
+	// draw a range of instances of a loaded mesh
+	void DrawMeshInstanced(int meshID, int firstInstance, int instanceCount);
+};
@@ -0,0 +1,216 @@
+///////////////////////////////////////////////////////////////////////////////
+// jobsystem.cpp
+// ============
+// a work-stealing pool of worker threads for splitting the per-frame scene
+// work across the cores
+///////////////////////////////////////////////////////////////////////////////
+
+#include "JobSystem.h"
+
+#include <algorithm>
+
+/***********************************************************
+ *  JobSystem()
+ *
+ *  The constructor for the class - starts one worker per
+ *  requested thread besides the calling one.
+ ***********************************************************/
+JobSystem::JobSystem(int threadCount)
+{
+	if (threadCount <= 0)
+	{
+		threadCount = (int)std::thread::hardware_concurrency();
+	}
+	threadCount = std::max(threadCount, 1);
+
+	m_queuedJobs = 0;
+	m_bStopping = false;
+
+	for (int t = 0; t < threadCount; t++)
+	{
+		m_queues.push_back(std::unique_ptr<JOB_QUEUE>(new JOB_QUEUE()));
+		m_queues.back()->first = 0;
+		m_queues.back()->count = 0;
+	}
+	for (int t = 1; t < threadCount; t++)
+	{
+		m_workers.emplace_back(&JobSystem::WorkerMain, this, t);
+	}
+}
+
+/***********************************************************
+ *  ~JobSystem()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+JobSystem::~JobSystem()
+{
+	Shutdown();
+}
+
+/***********************************************************
+ *  ParallelFor()
+ *
+ *  This method is used for running the body of a loop over
+ *  a number of items on every thread.  The items are split
+ *  into a few chunks per thread and dealt out over the
+ *  queues, then the calling thread runs and steals chunks
+ *  until all of them have finished.  Small loops, and pools
+ *  without workers, run on the calling thread right away.
+ ***********************************************************/
+void JobSystem::ParallelFor(int count, int minChunk, const RANGE_FUNCTION& function)
+{
+	if (count <= 0)
+	{
+		return;
+	}
+
+	minChunk = std::max(minChunk, 1);
+	int chunkCount = std::min(GetThreadCount() * CHUNKS_PER_THREAD, (count + minChunk - 1) / minChunk);
+	if ((m_workers.empty() == true) || (chunkCount <= 1))
+	{
+		function(0, count, 0);
+		return;
+	}
+
+	std::atomic<int> remaining(chunkCount);
+	for (int c = 0; c < chunkCount; c++)
+	{
+		JOB job;
+		job.function = &function;
+		job.first = (int)(((long long)count * c) / chunkCount);
+		job.count = (int)(((long long)count * (c + 1)) / chunkCount) - job.first;
+		job.remaining = &remaining;
+
+		JOB_QUEUE& queue = *m_queues[c % m_queues.size()];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs[(queue.first + queue.count) % CHUNKS_PER_THREAD] = job;
+		queue.count++;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+		m_queuedJobs += chunkCount;
+	}
+	m_jobsQueued.notify_all();
+
+	// the calling thread works too, and only waits for the
+	// chunks that other threads are still running
+	while (remaining.load() > 0)
+	{
+		JOB job;
+		if (TakeJob(0, job) == true)
+		{
+			RunJob(job, 0);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+/***********************************************************
+ *  WorkerMain()
+ *
+ *  This method is used as the loop of every worker thread.
+ *  A worker runs jobs while any queue has one, and sleeps
+ *  until new jobs are queued otherwise.
+ ***********************************************************/
+void JobSystem::WorkerMain(int threadIndex)
+{
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_wakeMutex);
+			m_jobsQueued.wait(lock, [this] { return(m_bStopping || (m_queuedJobs.load() > 0)); });
+			if (m_bStopping == true)
+			{
+				return;
+			}
+		}
+
+		JOB job;
+		while (TakeJob(threadIndex, job) == true)
+		{
+			RunJob(job, threadIndex);
+		}
+	}
+}
+
+/***********************************************************
+ *  TakeJob()
+ *
+ *  This method is used for taking the next job of a thread.
+ *  The own queue is used from the back, where the jobs were
+ *  queued last, and the other queues are stolen from at the
+ *  front, starting with the next thread.
+ ***********************************************************/
+bool JobSystem::TakeJob(int threadIndex, JOB& job)
+{
+	int queueCount = (int)m_queues.size();
+
+	for (int i = 0; i < queueCount; i++)
+	{
+		int q = (threadIndex + i) % queueCount;
+		JOB_QUEUE& queue = *m_queues[q];
+
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.count == 0)
+		{
+			continue;
+		}
+
+		if (q == threadIndex)
+		{
+			job = queue.jobs[(queue.first + queue.count - 1) % CHUNKS_PER_THREAD];
+		}
+		else
+		{
+			job = queue.jobs[queue.first];
+			queue.first = (queue.first + 1) % CHUNKS_PER_THREAD;
+		}
+		queue.count--;
+		m_queuedJobs--;
+		return(true);
+	}
+
+	return(false);
+}
+
+/***********************************************************
+ *  RunJob()
+ *
+ *  This method is used for running one chunk of a loop and
+ *  counting it as finished.
+ ***********************************************************/
+void JobSystem::RunJob(const JOB& job, int threadIndex)
+{
+	(*job.function)(job.first, job.count, threadIndex);
+	job.remaining->fetch_sub(1);
+}
+
+/***********************************************************
+ *  Shutdown()
+ *
+ *  This method is used for stopping and joining the worker
+ *  threads.  Loops that are started afterwards run on the
+ *  calling thread.
+ ***********************************************************/
+void JobSystem::Shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+		m_bStopping = true;
+	}
+	m_jobsQueued.notify_all();
+
+	for (size_t i = 0; i < m_workers.size(); i++)
+	{
+		if (m_workers[i].joinable())
+		{
+			m_workers[i].join();
+		}
+	}
+	m_workers.clear();
+}
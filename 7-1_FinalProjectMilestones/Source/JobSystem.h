@@ -0,0 +1,103 @@
+///////////////////////////////////////////////////////////////////////////////
+// jobsystem.h
+// ============
+// a work-stealing pool of worker threads for splitting the per-frame scene
+// work across the cores
+//
+//  Every thread, the calling one included, owns a queue of jobs.  A parallel
+//  loop deals its chunks out over the queues, every thread runs the jobs of its
+//  own queue from the back and steals from the front of the other queues once
+//  its own is empty, so uneven chunks even out by themselves.  The caller
+//  takes part in the work and returns when every chunk has finished.  Jobs
+//  never touch OpenGL - they fill per-chunk lists that the render thread
+//  merges and submits.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  JobSystem
+ *
+ *  This class contains the worker threads and the job queue
+ *  of every thread.  Parallel loops are meant to be started
+ *  from one thread at a time, normally the render thread.
+ ***********************************************************/
+class JobSystem
+{
+public:
+	// the body of a parallel loop - handles the items from first
+	// to first + count, on the passed in thread index
+	typedef std::function<void(int first, int count, int threadIndex)> RANGE_FUNCTION;
+
+	// constructor - the number of threads includes the calling
+	// thread, 0 uses one thread per hardware thread
+	JobSystem(int threadCount);
+	// destructor
+	~JobSystem();
+
+	// number of threads that run jobs, the calling one included,
+	// for sizing per-thread data
+	int GetThreadCount() const { return((int)m_queues.size()); }
+
+	// run the body over count items, split into chunks of at
+	// least minChunk items - returns when every chunk has run
+	void ParallelFor(int count, int minChunk, const RANGE_FUNCTION& function);
+
+	// stop and join the worker threads
+	void Shutdown();
+
+private:
+	// chunks per thread in a parallel loop - more than one, so a
+	// thread that finishes early has chunks left to steal
+	static const int CHUNKS_PER_THREAD = 4;
+
+	// one chunk of a parallel loop
+	struct JOB
+	{
+		const RANGE_FUNCTION* function;
+		int first;
+		int count;
+		// chunks of the loop that have not finished yet
+		std::atomic<int>* remaining;
+	};
+
+	// the jobs owned by one thread, a ring that never allocates -
+	// the chunks of a loop are dealt out evenly, so a queue never
+	// holds more than the chunks of one thread
+	struct JOB_QUEUE
+	{
+		std::mutex mutex;
+		JOB jobs[CHUNKS_PER_THREAD];
+		// the oldest job and the number of queued jobs
+		int first;
+		int count;
+	};
+
+	// the queue of every thread, index 0 is the calling thread
+	std::vector<std::unique_ptr<JOB_QUEUE>> m_queues;
+	std::vector<std::thread> m_workers;
+	// guards the sleep of the workers and the stopping flag
+	std::mutex m_wakeMutex;
+	// signalled when jobs are queued or the workers must stop
+	std::condition_variable m_jobsQueued;
+	// jobs in all of the queues
+	std::atomic<int> m_queuedJobs;
+	// set when the workers must exit
+	bool m_bStopping;
+
+	// the loop run by every worker thread
+	void WorkerMain(int threadIndex);
+	// take a job from the back of the own queue, or steal one
+	// from the front of another - false when all are empty
+	bool TakeJob(int threadIndex, JOB& job);
+	// run a job and count it as finished
+	void RunJob(const JOB& job, int threadIndex);
+};
@@ -0,0 +1,294 @@
+///////////////////////////////////////////////////////////////////////////////
+// lightclusters.cpp
+// ============
+// clustered point lights for forward shading with many light sources
+///////////////////////////////////////////////////////////////////////////////
+
+#include "LightClusters.h"
+#include "ProgramBuilder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+// the layout of the C++ image must match the std430 block
+static_assert(sizeof(LightClusters::CLUSTER_LIGHT) == 64, "CLUSTER_LIGHT does not match the std430 layout");
+
+// declaration of global variables
+namespace
+{
+	// storage buffer bindings used by the binning shader
+	const GLuint g_LightBufferBinding = 0;
+	const GLuint g_ClusterBufferBinding = 1;
+	// RGBA32F texels of the light buffer texture per light
+	const int g_TexelsPerLight = 4;
+	// the nearest slice starts at least this far from the camera,
+	// so the exponential slices stay finite for projections whose
+	// near plane is at or behind the camera
+	const float g_MinSliceNear = 0.1f;
+}
+
+/***********************************************************
+ *  LightClusters()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+LightClusters::LightClusters()
+{
+	m_programID = 0;
+	m_lightBuffer = 0;
+	m_lightTexture = 0;
+	m_lightCount = 0;
+	m_lightCapacity = 0;
+	m_clusterBuffer = 0;
+	m_clusterTexture = 0;
+	m_binnedView = glm::mat4(0.0f);
+	m_binnedProjection = glm::mat4(0.0f);
+	m_binnedWidth = 0;
+	m_binnedHeight = 0;
+	m_bLightsDirty = true;
+	m_shaderParameters = glm::vec4(0.0f);
+	m_viewLocation = -1;
+	m_projectionLocation = -1;
+	m_inverseProjectionLocation = -1;
+	m_sliceNearLocation = -1;
+	m_sliceFarLocation = -1;
+	m_lightCountLocation = -1;
+}
+
+/***********************************************************
+ *  ~LightClusters()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+LightClusters::~LightClusters()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  IsSupported()
+ *
+ *  This method is used for checking whether the context can
+ *  run the binning pass - compute shaders and storage
+ *  buffers.  Buffer textures are part of every 3.3 context.
+ ***********************************************************/
+bool LightClusters::IsSupported()
+{
+	if (GLEW_VERSION_4_3)
+	{
+		return(true);
+	}
+
+	return((GLEW_ARB_compute_shader && GLEW_ARB_shader_storage_buffer_object) ? true : false);
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for building the binning program and
+ *  creating the cluster buffer, which has a fixed size.  The
+ *  light buffer grows with the lights passed to SetLights().
+ ***********************************************************/
+bool LightClusters::Initialize(const char* shaderFile)
+{
+	m_programID = ProgramBuilder::BuildComputeProgram(shaderFile);
+	if (m_programID == 0)
+	{
+		return(false);
+	}
+
+	m_viewLocation = glGetUniformLocation(m_programID, "view");
+	m_projectionLocation = glGetUniformLocation(m_programID, "projection");
+	m_inverseProjectionLocation = glGetUniformLocation(m_programID, "inverseProjection");
+	m_sliceNearLocation = glGetUniformLocation(m_programID, "sliceNear");
+	m_sliceFarLocation = glGetUniformLocation(m_programID, "sliceFar");
+	m_lightCountLocation = glGetUniformLocation(m_programID, "lightCount");
+
+	glGenBuffers(1, &m_lightBuffer);
+	glGenBuffers(1, &m_clusterBuffer);
+
+	// every cluster starts out without lights
+	std::vector<GLuint> entries((size_t)CLUSTER_COUNT * CLUSTER_STRIDE, 0);
+	glBindBuffer(GL_TEXTURE_BUFFER, m_clusterBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, entries.size() * sizeof(GLuint), entries.data(), GL_DYNAMIC_COPY);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	glGenTextures(1, &m_clusterTexture);
+	glBindTexture(GL_TEXTURE_BUFFER, m_clusterTexture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, m_clusterBuffer);
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+	return(true);
+}
+
+/***********************************************************
+ *  SetLights()
+ *
+ *  This method is used for replacing the lights.  The buffer
+ *  only grows, and its texture is attached again when it
+ *  does.  Returns false when the lights do not fit the
+ *  buffer texture size of the context.
+ ***********************************************************/
+bool LightClusters::SetLights(const CLUSTER_LIGHT* lights, int lightCount)
+{
+	if (m_programID == 0)
+	{
+		return(false);
+	}
+
+	GLint maxTexels = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+	if ((lightCount < 0) || ((long long)lightCount * g_TexelsPerLight > (long long)maxTexels))
+	{
+		std::cout << lightCount << " clustered lights do not fit a buffer texture of "
+			<< maxTexels << " texels" << std::endl;
+		m_lightCount = 0;
+		return(false);
+	}
+
+	glBindBuffer(GL_TEXTURE_BUFFER, m_lightBuffer);
+	if ((lightCount > m_lightCapacity) || (m_lightTexture == 0))
+	{
+		m_lightCapacity = std::max(lightCount, 1);
+		glBufferData(GL_TEXTURE_BUFFER, (GLsizeiptr)m_lightCapacity * sizeof(CLUSTER_LIGHT), NULL, GL_DYNAMIC_DRAW);
+
+		if (m_lightTexture == 0)
+		{
+			glGenTextures(1, &m_lightTexture);
+		}
+		glBindTexture(GL_TEXTURE_BUFFER, m_lightTexture);
+		glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_lightBuffer);
+		glBindTexture(GL_TEXTURE_BUFFER, 0);
+	}
+	if (lightCount > 0)
+	{
+		glBufferSubData(GL_TEXTURE_BUFFER, 0, (GLsizeiptr)lightCount * sizeof(CLUSTER_LIGHT), lights);
+	}
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	m_lightCount = lightCount;
+	m_bLightsDirty = true;
+
+	return(true);
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for binning the lights into the
+ *  clusters of a view.  The depth range of the slices comes
+ *  from the near and far planes of the projection, which
+ *  works the same way for perspective and orthographic
+ *  projections.  The program that was current before is
+ *  restored.
+ ***********************************************************/
+void LightClusters::Update(const glm::mat4& view, const glm::mat4& projection, int viewportWidth, int viewportHeight)
+{
+	if ((m_programID == 0) || (viewportWidth <= 0) || (viewportHeight <= 0))
+	{
+		return;
+	}
+
+	if ((m_bLightsDirty == false) && (view == m_binnedView) && (projection == m_binnedProjection) &&
+		(viewportWidth == m_binnedWidth) && (viewportHeight == m_binnedHeight))
+	{
+		return;
+	}
+
+	// the view depths of the near and the far plane
+	glm::mat4 inverseProjection = glm::inverse(projection);
+	glm::vec4 nearPoint = inverseProjection * glm::vec4(0.0f, 0.0f, -1.0f, 1.0f);
+	glm::vec4 farPoint = inverseProjection * glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+	float sliceNear = std::max(-nearPoint.z / nearPoint.w, g_MinSliceNear);
+	float sliceFar = std::max(-farPoint.z / farPoint.w, sliceNear * 2.0f);
+
+	// a fragment finds its slice from the log of its view depth
+	float logRange = std::log(sliceFar / sliceNear);
+	m_shaderParameters = glm::vec4(
+		(float)CLUSTER_COUNT_X / (float)viewportWidth,
+		(float)CLUSTER_COUNT_Y / (float)viewportHeight,
+		(float)CLUSTER_COUNT_Z / logRange,
+		-(float)CLUSTER_COUNT_Z * std::log(sliceNear) / logRange);
+
+	GLint previousProgram = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
+
+	glUseProgram(m_programID);
+	glUniformMatrix4fv(m_viewLocation, 1, GL_FALSE, &view[0][0]);
+	glUniformMatrix4fv(m_projectionLocation, 1, GL_FALSE, &projection[0][0]);
+	glUniformMatrix4fv(m_inverseProjectionLocation, 1, GL_FALSE, &inverseProjection[0][0]);
+	glUniform1f(m_sliceNearLocation, sliceNear);
+	glUniform1f(m_sliceFarLocation, sliceFar);
+	glUniform1i(m_lightCountLocation, m_lightCount);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, g_LightBufferBinding, m_lightBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, g_ClusterBufferBinding, m_clusterBuffer);
+	glDispatchCompute((GLuint)((CLUSTER_COUNT + GROUP_SIZE - 1) / GROUP_SIZE), 1, 1);
+
+	// the fragment shader reads the clusters as a buffer texture
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+	glUseProgram((GLuint)previousProgram);
+
+	m_binnedView = view;
+	m_binnedProjection = projection;
+	m_binnedWidth = viewportWidth;
+	m_binnedHeight = viewportHeight;
+	m_bLightsDirty = false;
+}
+
+/***********************************************************
+ *  BindTextures()
+ *
+ *  This method is used for binding the light and cluster
+ *  buffer textures to the texture units the scene shaders
+ *  read them from.  Texture unit 0 is active again
+ *  afterwards.
+ ***********************************************************/
+void LightClusters::BindTextures(int lightTextureUnit, int clusterTextureUnit) const
+{
+	glActiveTexture(GL_TEXTURE0 + lightTextureUnit);
+	glBindTexture(GL_TEXTURE_BUFFER, m_lightTexture);
+	glActiveTexture(GL_TEXTURE0 + clusterTextureUnit);
+	glBindTexture(GL_TEXTURE_BUFFER, m_clusterTexture);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for releasing the program, the
+ *  buffers and their textures.
+ ***********************************************************/
+void LightClusters::Destroy()
+{
+	if (m_lightTexture != 0)
+	{
+		glDeleteTextures(1, &m_lightTexture);
+		m_lightTexture = 0;
+	}
+	if (m_clusterTexture != 0)
+	{
+		glDeleteTextures(1, &m_clusterTexture);
+		m_clusterTexture = 0;
+	}
+	if (m_lightBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_lightBuffer);
+		m_lightBuffer = 0;
+	}
+	if (m_clusterBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_clusterBuffer);
+		m_clusterBuffer = 0;
+	}
+	if (m_programID != 0)
+	{
+		glDeleteProgram(m_programID);
+		m_programID = 0;
+	}
+	m_lightCount = 0;
+	m_lightCapacity = 0;
+	m_bLightsDirty = true;
+}
@@ -0,0 +1,117 @@
+///////////////////////////////////////////////////////////////////////////////
+// lightclusters.h
+// ============
+// clustered point lights for forward shading with many light sources
+//
+//  The view volume is split into a grid of clusters - screen tiles in x and
+//  y, and slices in depth that grow exponentially with the distance - and a
+//  compute pass tests every light with a limited radius against the view
+//  space bounds of every cluster.  Each cluster stores the number and the
+//  indices of the lights that touch it, so a fragment only shades the few
+//  lights of its own cluster no matter how many lights the scene has.  The
+//  fragment shader reads the lights and the clusters as buffer textures, so
+//  it still compiles on contexts without storage buffers.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  LightClusters
+ *
+ *  This class contains the light buffer, the cluster buffer
+ *  that the binning pass fills and the compute program of
+ *  that pass.
+ ***********************************************************/
+class LightClusters
+{
+public:
+	// the cluster grid, must match the shaders
+	static const int CLUSTER_COUNT_X = 16;
+	static const int CLUSTER_COUNT_Y = 9;
+	static const int CLUSTER_COUNT_Z = 24;
+	static const int CLUSTER_COUNT = CLUSTER_COUNT_X * CLUSTER_COUNT_Y * CLUSTER_COUNT_Z;
+	// entries per cluster - the light count followed by the
+	// indices of up to CLUSTER_STRIDE - 1 lights
+	static const int CLUSTER_STRIDE = 64;
+
+	// std430 image of the ClusterLight structure, four texels
+	// of the light buffer texture - the light fades out to
+	// nothing at its radius
+	struct CLUSTER_LIGHT
+	{
+		glm::vec3 position;
+		float radius;
+		glm::vec3 ambient;
+		float padding0;
+		glm::vec3 diffuse;
+		float padding1;
+		glm::vec3 specular;
+		float padding2;
+	};
+
+	// constructor
+	LightClusters();
+	// destructor
+	~LightClusters();
+
+	// true when the context can run the binning pass
+	static bool IsSupported();
+
+	// build the binning program and the cluster buffer - needs
+	// a current GL context
+	bool Initialize(const char* shaderFile);
+
+	// replace the lights - the clusters are binned again by the
+	// next Update()
+	bool SetLights(const CLUSTER_LIGHT* lights, int lightCount);
+
+	// bin the lights into the clusters of a view, skipped when
+	// neither the camera, the viewport nor the lights changed
+	void Update(const glm::mat4& view, const glm::mat4& projection, int viewportWidth, int viewportHeight);
+
+	// bind the light and cluster buffer textures for the scene
+	// shaders
+	void BindTextures(int lightTextureUnit, int clusterTextureUnit) const;
+
+	// the tiles per pixel in xy, and the scale and bias that
+	// turn the log of a view depth into a slice in zw
+	const glm::vec4& GetShaderParameters() const { return(m_shaderParameters); }
+	int GetLightCount() const { return(m_lightCount); }
+
+	// release the program, the buffers and the textures
+	void Destroy();
+
+private:
+	// threads per compute work group, must match the shader
+	static const int GROUP_SIZE = 128;
+
+	GLuint m_programID;
+	// the lights and their buffer texture
+	GLuint m_lightBuffer;
+	GLuint m_lightTexture;
+	int m_lightCount;
+	int m_lightCapacity;
+	// the cluster entries and their buffer texture
+	GLuint m_clusterBuffer;
+	GLuint m_clusterTexture;
+
+	// the view the clusters were binned for
+	glm::mat4 m_binnedView;
+	glm::mat4 m_binnedProjection;
+	int m_binnedWidth;
+	int m_binnedHeight;
+	// true when the lights changed since the last binning
+	bool m_bLightsDirty;
+	glm::vec4 m_shaderParameters;
+
+	// uniform locations of the binning program
+	GLint m_viewLocation;
+	GLint m_projectionLocation;
+	GLint m_inverseProjectionLocation;
+	GLint m_sliceNearLocation;
+	GLint m_sliceFarLocation;
+	GLint m_lightCountLocation;
+};
@@ -23,6 +23,20 @@
 #include "ViewManager.h"
 #include "ShapeMeshes.h"
 #include "ShaderManager.h"
+#include "UniformCache.h"
+#include "UniformBuffers.h"
+#include "TextureCache.h"
+#include "FrameProfiler.h"
+#include "AllocationTracker.h"
+#include "Benchmark.h"
+#include "TransformBatch.h"
+#include "SceneFile.h"
+#include "ProgramCache.h"
+#include "FramePacer.h"
+#include "DynamicResolution.h"
+
+#include <cstring>
+#include <string>
 
 // Namespace for declaring global variables
 namespace
@@ -30,6 +44,13 @@ namespace
 	// Macro for window title
 	const char* const WINDOW_TITLE = "Mike Montminy 7-1 Final Project CS330"; 
 
+	// the shader files of the scene program
+	const char* const VERTEX_SHADER_FILE = "shaders/vertexShader.glsl";
+	const char* const FRAGMENT_SHADER_FILE = "shaders/fragmentShader.glsl";
+	// the shader files of the dynamic resolution resolve pass
+	const char* const RESOLVE_VERTEX_SHADER_FILE = "shaders/resolveVertex.glsl";
+	const char* const RESOLVE_FRAGMENT_SHADER_FILE = "shaders/temporalResolve.glsl";
+
 	// Main GLFW window
 	GLFWwindow* g_Window = nullptr;
 
@@ -37,8 +58,21 @@ namespace
 	SceneManager* g_SceneManager = nullptr;
 	// shader manager object for dynamic interaction with the shader code
 	ShaderManager* g_ShaderManager = nullptr;
+	// cached uniform locations of the loaded shader program
+	UniformCache* g_UniformCache = nullptr;
+	// camera and light uniform buffers shared by the shader programs
+	UniformBuffers* g_UniformBuffers = nullptr;
 	// view manager object for managing the 3D view setup and projection to 2D
 	ViewManager* g_ViewManager = nullptr;
+	// frame profiler object for timing the CPU and GPU work of every frame
+	FrameProfiler* g_FrameProfiler = nullptr;
+	// benchmark run object, only created in benchmark mode
+	Benchmark* g_Benchmark = nullptr;
+	// frame pacer object for the frame rate cap and on demand drawing
+	FramePacer* g_FramePacer = nullptr;
+	// offscreen scene target and resolve pass, only created when
+	// the dynamic resolution is on
+	DynamicResolution* g_DynamicResolution = nullptr;
 }
 
 // Function declarations - all functions that are called manually
@@ -55,17 +89,261 @@ bool InitializeGLEW();
  ***********************************************************/
 int main(int argc, char* argv[])
 {
+	// build the compressed texture cache files and exit, without
+	// opening a window:  --build-texture-cache [directory] [--force]
+	if ((argc > 1) && (strcmp(argv[1], "--build-texture-cache") == 0))
+	{
+		const char* directory = "textures";
+		bool bForce = false;
+
+		for (int i = 2; i < argc; i++)
+		{
+			if (strcmp(argv[i], "--force") == 0)
+			{
+				bForce = true;
+			}
+			else
+			{
+				directory = argv[i];
+			}
+		}
+
+		if (TextureCache::BuildDirectory(directory, bForce) == false)
+		{
+			return(EXIT_FAILURE);
+		}
+		return(EXIT_SUCCESS);
+	}
+
+	// convert a text scene description into a binary scene file
+	// and exit:  --export-scene <text file> <scene file>
+	if ((argc > 1) && (strcmp(argv[1], "--export-scene") == 0))
+	{
+		if (argc < 4)
+		{
+			std::cout << "Usage: --export-scene <text file> <scene file>" << std::endl;
+			return(EXIT_FAILURE);
+		}
+
+		if (SceneFile::ExportText(argv[2], argv[3]) == false)
+		{
+			return(EXIT_FAILURE);
+		}
+		return(EXIT_SUCCESS);
+	}
+
+	// time the batch transform kernel against the five matrix
+	// product and exit:  --bench-transforms [objects] [iterations]
+	if ((argc > 1) && (strcmp(argv[1], "--bench-transforms") == 0))
+	{
+		int objectCount = (argc > 2) ? atoi(argv[2]) : 10000;
+		int iterations = (argc > 3) ? atoi(argv[3]) : 200;
+
+		if (TransformBatch::RunBenchmark(objectCount, iterations) == false)
+		{
+			return(EXIT_FAILURE);
+		}
+		return(EXIT_SUCCESS);
+	}
+
+	// print rolling frame timings to the console and the window
+	// title:  --profile
+	// replicate the scene prefabs into a grid of cells for stress
+	// testing:  --scene-grid <columns>x<rows>
+	// draw every object, also the ones out of view:  --no-culling
+	// cull and draw on the CPU even when compute shaders are
+	// supported:  --no-gpu-culling
+	// draw the objects hidden behind walls and table tops:
+	// --no-occlusion
+	// draw the curved shapes at full detail:  --no-lod
+	// draw one object at a time instead of instanced batches,
+	// streaming the draw values through a mapped ring buffer
+	// when it is supported:  --no-instancing
+	// detail level hysteresis, 0 to 0.9, default 0.15:
+	// --lod-hysteresis <fraction>
+	// threads sharing the scene update, 0 for one per core and 1
+	// for the main thread only:  --threads <count>
+	// load the scene from an exported scene file instead of the
+	// built in scene:  --scene <scene file>
+	// reload the shaders, textures and scene file when they are
+	// saved, without restarting:  --hot-reload
+	// spread clustered point lights over the scene grid for stress
+	// testing:  --ceiling-lights <count>
+	// skip the point lights with a radius and their light cluster
+	// pass:  --no-light-clusters
+	// draw everything with the generic scene program instead of
+	// its specialized variants:  --no-shader-variants
+	// build every program from source instead of loading and
+	// saving linked binaries:  --no-program-cache
+	// draw the depth of the scene before shading it, so every
+	// pixel is shaded once:  --depth-prepass
+	// draw the scene without shadow maps:  --no-shadows
+	// only draw a frame when the camera or the scene changed, and
+	// sleep in the event queue otherwise:  --on-demand
+	// draw at most this many frames per second:  --max-fps <rate>
+	// wait for every vsync, for none, or for the vsync unless the
+	// frame is late:  --vsync <on|off|adaptive>
+	// render the scene offscreen at a resolution that holds a
+	// frame rate, default 60, and resolve it to the window with
+	// temporal anti-aliasing:  --dynamic-resolution [rate]
+	// the smallest resolution scale, default 0.5:
+	// --min-resolution <fraction>
+	// only upscale the offscreen frame:  --no-taa
+	bool bProfile = false;
+	bool bCulling = true;
+	bool bGpuCulling = true;
+	bool bOcclusion = true;
+	bool bLod = true;
+	bool bInstancing = true;
+	float lodHysteresis = -1.0f;
+	int gridColumns = 1;
+	int gridRows = 1;
+	int threadCount = 0;
+	const char* sceneFile = NULL;
+	bool bHotReload = false;
+	int ceilingLightCount = 0;
+	bool bLightClusters = true;
+	bool bShaderVariants = true;
+	bool bProgramCache = true;
+	bool bDepthPrepass = false;
+	bool bShadows = true;
+	bool bOnDemand = false;
+	double maxFrameRate = 0.0;
+	const char* swapMode = NULL;
+	bool bDynamicResolution = false;
+	double targetFrameRate = 60.0;
+	float minResolution = 0.5f;
+	bool bTemporal = true;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--profile") == 0)
+		{
+			bProfile = true;
+		}
+		else if (strcmp(argv[i], "--no-culling") == 0)
+		{
+			bCulling = false;
+		}
+		else if (strcmp(argv[i], "--no-gpu-culling") == 0)
+		{
+			bGpuCulling = false;
+		}
+		else if (strcmp(argv[i], "--no-occlusion") == 0)
+		{
+			bOcclusion = false;
+		}
+		else if (strcmp(argv[i], "--no-lod") == 0)
+		{
+			bLod = false;
+		}
+		else if (strcmp(argv[i], "--no-instancing") == 0)
+		{
+			bInstancing = false;
+		}
+		else if ((strcmp(argv[i], "--lod-hysteresis") == 0) && (i + 1 < argc))
+		{
+			lodHysteresis = (float)atof(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--threads") == 0) && (i + 1 < argc))
+		{
+			threadCount = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--hot-reload") == 0)
+		{
+			bHotReload = true;
+		}
+		else if ((strcmp(argv[i], "--ceiling-lights") == 0) && (i + 1 < argc))
+		{
+			ceilingLightCount = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--no-light-clusters") == 0)
+		{
+			bLightClusters = false;
+		}
+		else if (strcmp(argv[i], "--no-shader-variants") == 0)
+		{
+			bShaderVariants = false;
+		}
+		else if (strcmp(argv[i], "--no-program-cache") == 0)
+		{
+			bProgramCache = false;
+		}
+		else if (strcmp(argv[i], "--depth-prepass") == 0)
+		{
+			bDepthPrepass = true;
+		}
+		else if (strcmp(argv[i], "--no-shadows") == 0)
+		{
+			bShadows = false;
+		}
+		else if (strcmp(argv[i], "--on-demand") == 0)
+		{
+			bOnDemand = true;
+		}
+		else if ((strcmp(argv[i], "--max-fps") == 0) && (i + 1 < argc))
+		{
+			maxFrameRate = atof(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--vsync") == 0) && (i + 1 < argc))
+		{
+			swapMode = argv[++i];
+		}
+		else if (strcmp(argv[i], "--dynamic-resolution") == 0)
+		{
+			bDynamicResolution = true;
+			if ((i + 1 < argc) && (atof(argv[i + 1]) > 0.0))
+			{
+				targetFrameRate = atof(argv[++i]);
+			}
+		}
+		else if ((strcmp(argv[i], "--min-resolution") == 0) && (i + 1 < argc))
+		{
+			minResolution = (float)atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--no-taa") == 0)
+		{
+			bTemporal = false;
+		}
+		else if ((strcmp(argv[i], "--scene") == 0) && (i + 1 < argc))
+		{
+			sceneFile = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--scene-grid") == 0) && (i + 1 < argc))
+		{
+			const char* value = argv[++i];
+			const char* separator = strchr(value, 'x');
+			gridColumns = atoi(value);
+			gridRows = (NULL != separator) ? atoi(separator + 1) : gridColumns;
+		}
+	}
+
+	// render offscreen along a camera path and write the frame
+	// timings:  --benchmark [frames], see Benchmark::ParseArguments()
+	Benchmark::BENCHMARK_SETTINGS benchmarkSettings;
+	bool bBenchmark = Benchmark::ParseArguments(argc, argv, benchmarkSettings);
+
 	// if GLFW fails initialization, then terminate the application
 	if (InitializeGLFW() == false)
 	{
 		return(EXIT_FAILURE);
 	}
 
+	// the benchmark window is never shown
+	if (bBenchmark == true)
+	{
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	}
+
 	// try to create a new shader manager object
 	g_ShaderManager = new ShaderManager();
+	// try to create a new uniform cache object
+	g_UniformCache = new UniformCache();
+	// try to create a new uniform buffers object
+	g_UniformBuffers = new UniformBuffers();
 	// try to create a new view manager object
 	g_ViewManager = new ViewManager(
-		g_ShaderManager);
+		g_ShaderManager,
+		g_UniformBuffers);
 
 	// try to create the main display window
 	g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
@@ -75,43 +353,272 @@ int main(int argc, char* argv[])
 	{
 		return(EXIT_FAILURE);
 	}
+	ProgramCache::SetEnabled(bProgramCache);
 
 	// load the shader code from the external GLSL files
 	g_ShaderManager->LoadShaders(
-		"shaders/vertexShader.glsl",
-		"shaders/fragmentShader.glsl");
+		VERTEX_SHADER_FILE,
+		FRAGMENT_SHADER_FILE);
 	g_ShaderManager->use();
 
+	// resolve the uniform locations of the loaded program once
+	GLint programID = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &programID);
+	g_UniformCache->LoadUniforms((GLuint)programID);
+
+	// create the shared camera and light buffers and connect the
+	// uniform blocks of the loaded program to them
+	g_UniformBuffers->CreateBuffers();
+	g_UniformBuffers->BindToProgram((GLuint)programID);
+
 	// try to create a new scene manager object and prepare the 3D scene
-	g_SceneManager = new SceneManager(g_ShaderManager);
+	g_SceneManager = new SceneManager(
+		g_ShaderManager,
+		g_UniformCache,
+		g_UniformBuffers);
+	g_SceneManager->SetSceneGrid(gridColumns, gridRows);
+	g_SceneManager->SetJobThreadCount(threadCount);
+	g_SceneManager->SetSceneFile(sceneFile);
+	g_SceneManager->SetCullingEnabled(bCulling);
+	g_SceneManager->SetGpuCullingEnabled(bGpuCulling);
+	g_SceneManager->SetOcclusionCullingEnabled(bOcclusion);
+	g_SceneManager->SetLightClustersEnabled(bLightClusters);
+	g_SceneManager->SetCeilingLightCount(ceilingLightCount);
+	g_SceneManager->SetShaderFiles(VERTEX_SHADER_FILE, FRAGMENT_SHADER_FILE);
+	g_SceneManager->SetShaderVariantsEnabled(bShaderVariants);
+	g_SceneManager->SetLodEnabled(bLod);
+	g_SceneManager->SetInstancingEnabled(bInstancing);
+	g_SceneManager->SetRenderMode(
+		(bDepthPrepass == true) ? SceneManager::RENDER_DEPTH_PREPASS : SceneManager::RENDER_FORWARD);
+	g_SceneManager->SetShadowsEnabled(bShadows);
+	if (lodHysteresis >= 0.0f)
+	{
+		g_SceneManager->SetLodHysteresis(lodHysteresis);
+	}
 	g_SceneManager->PrepareScene();
+	if (bHotReload == true)
+	{
+		g_SceneManager->EnableHotReload();
+	}
+
+	if (bBenchmark == true)
+	{
+		// the default orbit frames the whole scene grid
+		if ((gridColumns > 1) || (gridRows > 1))
+		{
+			g_SceneManager->GetSceneGridBounds(
+				benchmarkSettings.orbitCenter,
+				benchmarkSettings.orbitRadius);
+		}
+
+		// try to create a new benchmark object, rendering without
+		// waiting for vsync
+		g_Benchmark = new Benchmark(benchmarkSettings);
+		if (g_Benchmark->Initialize(g_ViewManager) == false)
+		{
+			return(EXIT_FAILURE);
+		}
+		glfwSwapInterval(0);
+	}
+
+	// try to create a new frame pacer object - the benchmark
+	// draws every frame as fast as it can
+	g_FramePacer = new FramePacer();
+	if (bBenchmark == false)
+	{
+		g_FramePacer->SetOnDemand(bOnDemand);
+		g_FramePacer->SetMaxFrameRate(maxFrameRate);
+		if (NULL != swapMode)
+		{
+			if (strcmp(swapMode, "off") == 0)
+			{
+				FramePacer::SetSwapMode(FramePacer::SWAP_IMMEDIATE);
+			}
+			else if (strcmp(swapMode, "adaptive") == 0)
+			{
+				FramePacer::SetSwapMode(FramePacer::SWAP_ADAPTIVE);
+			}
+			else
+			{
+				FramePacer::SetSwapMode(FramePacer::SWAP_VSYNC);
+			}
+		}
+	}
+
+	// try to create a new dynamic resolution object - the
+	// benchmark draws at its own fixed size
+	if ((bDynamicResolution == true) && (bBenchmark == false))
+	{
+		g_DynamicResolution = new DynamicResolution();
+		if (g_DynamicResolution->Initialize(RESOLVE_VERTEX_SHADER_FILE, RESOLVE_FRAGMENT_SHADER_FILE) == true)
+		{
+			g_DynamicResolution->SetTargetFrameRate(targetFrameRate);
+			g_DynamicResolution->SetMinScale(minResolution);
+			g_DynamicResolution->SetTemporalEnabled(bTemporal);
+		}
+		else
+		{
+			std::cout << "Could not build the resolve program, rendering at the window resolution" << std::endl;
+			delete g_DynamicResolution;
+			g_DynamicResolution = NULL;
+		}
+	}
+
+	// try to create a new frame profiler object - its timer
+	// queries can not run inside the benchmark's frame queries
+	g_FrameProfiler = new FrameProfiler();
+	g_FrameProfiler->SetEnabled((bProfile == true) && (bBenchmark == false));
+	const int prepareViewScope = g_FrameProfiler->GetScopeHandle("PrepareSceneView");
+	const int renderSceneScope = g_FrameProfiler->GetScopeHandle("RenderScene");
+	const int swapBuffersScope = g_FrameProfiler->GetScopeHandle("SwapBuffers");
+	const int clearPass = g_FrameProfiler->GetPassHandle("clear");
+	const int scenePass = g_FrameProfiler->GetPassHandle("scene");
 
 	// loop will keep running until the application is closed 
 	// or until an error has occurred
 	while (!glfwWindowShouldClose(g_Window))
 	{
+		if (NULL != g_Benchmark)
+		{
+			if (g_Benchmark->IsFinished() == true)
+			{
+				break;
+			}
+			g_Benchmark->BeginFrame(g_SceneManager->IsLoadingTextures() == false);
+		}
+
+		// in the on demand mode, a frame in which neither the view
+		// nor the scene changes would draw the shown frame again
+		if ((g_FramePacer->IsOnDemand() == true) &&
+			(g_ViewManager->IsViewChanging() == false) &&
+			(g_SceneManager->IsRedrawNeeded() == false) &&
+			((NULL == g_DynamicResolution) || (g_DynamicResolution->IsConverging() == false)))
+		{
+			g_FramePacer->WaitForEvents();
+			continue;
+		}
+
+		// the window frames are drawn at the framebuffer size, and
+		// not at all while the window is minimized
+		if (NULL == g_Benchmark)
+		{
+			int framebufferWidth = 0;
+			int framebufferHeight = 0;
+			g_ViewManager->GetFramebufferSize(framebufferWidth, framebufferHeight);
+			if ((framebufferWidth <= 0) || (framebufferHeight <= 0))
+			{
+				g_FramePacer->WaitForEvents();
+				continue;
+			}
+
+			if (NULL != g_DynamicResolution)
+			{
+				g_DynamicResolution->BeginFrame(framebufferWidth, framebufferHeight);
+				g_ViewManager->SetProjectionJitter(g_DynamicResolution->GetJitter());
+			}
+			else
+			{
+				glViewport(0, 0, framebufferWidth, framebufferHeight);
+			}
+		}
+
+		g_FrameProfiler->BeginFrame();
+		uint64_t frameAllocations = AllocationTracker::GetAllocationCount();
+		g_SceneManager->ResetFrameCounters();
+		g_UniformCache->ResetUploadCount();
+		g_UniformBuffers->ResetUploadCount();
+
 		// Enable z-depth
 		glEnable(GL_DEPTH_TEST);
 
 		// Clear the frame and z buffers
+		g_FrameProfiler->BeginPass(clearPass);
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		g_FrameProfiler->EndPass();
 
 		// convert from 3D object space to 2D view
+		g_FrameProfiler->BeginScope(prepareViewScope);
 		g_ViewManager->PrepareSceneView();
+		g_FrameProfiler->EndScope(prepareViewScope);
 
 		// refresh the 3D scene
+		g_FrameProfiler->BeginScope(renderSceneScope);
+		g_FrameProfiler->BeginPass(scenePass);
 		g_SceneManager->RenderScene();
+		g_FrameProfiler->EndPass();
+		g_FrameProfiler->EndScope(renderSceneScope);
 
+		// upscale the offscreen frame to the window
+		if (NULL != g_DynamicResolution)
+		{
+			g_DynamicResolution->EndFrame(g_UniformBuffers->GetCamera());
+		}
 
 		// Flips the the back buffer with the front buffer every frame.
-		glfwSwapBuffers(g_Window);
+		// The time spent here includes waiting for vsync.
+		// the benchmark frames stay in the offscreen framebuffer
+		if (NULL != g_Benchmark)
+		{
+			g_Benchmark->EndFrame();
+		}
+		else
+		{
+			g_FrameProfiler->BeginScope(swapBuffersScope);
+			glfwSwapBuffers(g_Window);
+			g_FrameProfiler->EndScope(swapBuffersScope);
+		}
 
-		// query the latest GLFW events
+		// hold the frame rate cap, then query the latest GLFW events
+		g_FramePacer->WaitForFrameSlot();
 		glfwPollEvents();
+
+		FrameProfiler::FRAME_COUNTERS counters;
+		counters.drawCalls = g_SceneManager->GetDrawCallCount();
+		counters.stateChanges = g_SceneManager->GetStateChangeCount();
+		counters.uniformUploads = g_UniformCache->GetUploadCount();
+		counters.bufferUploads = g_UniformBuffers->GetUploadCount();
+		counters.heapAllocations = (int)(AllocationTracker::GetAllocationCount() - frameAllocations);
+		g_FrameProfiler->EndFrame(counters);
+
+		std::string report;
+		if (g_FrameProfiler->TakeReport(report) == true)
+		{
+			std::cout << report << std::endl;
+			std::string title = std::string(WINDOW_TITLE) + " - " + g_FrameProfiler->GetSummary();
+			glfwSetWindowTitle(g_Window, title.c_str());
+		}
+	}
+
+	// write the benchmark results before the context goes away
+	int exitCode = EXIT_SUCCESS;
+	if (NULL != g_Benchmark)
+	{
+		if (g_Benchmark->WriteResults() == false)
+		{
+			exitCode = EXIT_FAILURE;
+		}
+		delete g_Benchmark;
+		g_Benchmark = NULL;
 	}
 
 	// clear the allocated manager objects from memory
+	if (NULL != g_DynamicResolution)
+	{
+		delete g_DynamicResolution;
+		g_DynamicResolution = NULL;
+	}
+	if (NULL != g_FramePacer)
+	{
+		delete g_FramePacer;
+		g_FramePacer = NULL;
+	}
+	if (NULL != g_FrameProfiler)
+	{
+		g_FrameProfiler->DestroyQueries();
+		delete g_FrameProfiler;
+		g_FrameProfiler = NULL;
+	}
 	if (NULL != g_SceneManager)
 	{
 		delete g_SceneManager;
@@ -122,14 +629,24 @@ int main(int argc, char* argv[])
 		delete g_ViewManager;
 		g_ViewManager = NULL;
 	}
+	if (NULL != g_UniformBuffers)
+	{
+		delete g_UniformBuffers;
+		g_UniformBuffers = NULL;
+	}
+	if (NULL != g_UniformCache)
+	{
+		delete g_UniformCache;
+		g_UniformCache = NULL;
+	}
 	if (NULL != g_ShaderManager)
 	{
 		delete g_ShaderManager;
 		g_ShaderManager = NULL;
 	}
 
-	// Terminates the program successfully
-	exit(EXIT_SUCCESS); 
+	// Terminates the program
+	exit(exitCode);
 }
 
 /***********************************************************
@@ -0,0 +1,155 @@
+///////////////////////////////////////////////////////////////////////////////
+// mappedfile.cpp
+// ============
+// read-only memory mapping of a whole file
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MappedFile.h"
+
+#include <iostream>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/***********************************************************
+ *  MappedFile()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+MappedFile::MappedFile()
+{
+	m_data = NULL;
+	m_size = 0;
+	m_fileHandle = NULL;
+	m_mappingHandle = NULL;
+}
+
+/***********************************************************
+ *  ~MappedFile()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+/***********************************************************
+ *  Open()
+ *
+ *  This method is used for mapping the whole of a file for
+ *  reading.  Empty files can not be mapped and fail to open.
+ ***********************************************************/
+bool MappedFile::Open(const char* filename)
+{
+	Close();
+
+	if (NULL == filename)
+	{
+		return(false);
+	}
+
+#if defined(_WIN32)
+	HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		std::cout << "Could not open file for mapping: " << filename << std::endl;
+		return(false);
+	}
+
+	LARGE_INTEGER size;
+	if ((GetFileSizeEx(file, &size) == FALSE) || (size.QuadPart <= 0))
+	{
+		std::cout << "Could not map empty file: " << filename << std::endl;
+		CloseHandle(file);
+		return(false);
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	void* view = (mapping != NULL) ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+	if (view == NULL)
+	{
+		std::cout << "Could not map file: " << filename << std::endl;
+		if (mapping != NULL)
+		{
+			CloseHandle(mapping);
+		}
+		CloseHandle(file);
+		return(false);
+	}
+
+	m_fileHandle = file;
+	m_mappingHandle = mapping;
+	m_data = (const unsigned char*)view;
+	m_size = (size_t)size.QuadPart;
+#else
+	int file = open(filename, O_RDONLY);
+	if (file < 0)
+	{
+		std::cout << "Could not open file for mapping: " << filename << std::endl;
+		return(false);
+	}
+
+	struct stat status;
+	if ((fstat(file, &status) != 0) || (status.st_size <= 0))
+	{
+		std::cout << "Could not map empty file: " << filename << std::endl;
+		close(file);
+		return(false);
+	}
+
+	void* view = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	// the mapping keeps its own reference to the file
+	close(file);
+	if (view == MAP_FAILED)
+	{
+		std::cout << "Could not map file: " << filename << std::endl;
+		return(false);
+	}
+
+	m_data = (const unsigned char*)view;
+	m_size = (size_t)status.st_size;
+#endif
+
+	return(true);
+}
+
+/***********************************************************
+ *  Close()
+ *
+ *  This method is used for unmapping the file.  Pointers
+ *  into the mapped bytes are no longer valid afterwards.
+ ***********************************************************/
+void MappedFile::Close()
+{
+	if (m_data == NULL)
+	{
+		return;
+	}
+
+#if defined(_WIN32)
+	UnmapViewOfFile(m_data);
+	CloseHandle((HANDLE)m_mappingHandle);
+	CloseHandle((HANDLE)m_fileHandle);
+#else
+	munmap((void*)m_data, m_size);
+#endif
+
+	m_data = NULL;
+	m_size = 0;
+	m_fileHandle = NULL;
+	m_mappingHandle = NULL;
+}
@@ -0,0 +1,46 @@
+///////////////////////////////////////////////////////////////////////////////
+// mappedfile.h
+// ============
+// read-only memory mapping of a whole file
+//
+//  The file is mapped with MapViewOfFile on Windows and mmap elsewhere, so
+//  its contents are paged in by the operating system as they are read and
+//  never copied into a separate buffer.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+
+/***********************************************************
+ *  MappedFile
+ *
+ *  This class contains one read-only view of a file.  The
+ *  view stays valid until the file is closed.
+ ***********************************************************/
+class MappedFile
+{
+public:
+	// constructor
+	MappedFile();
+	// destructor
+	~MappedFile();
+
+	// map the whole file, closing the previous one
+	bool Open(const char* filename);
+	// unmap the file
+	void Close();
+
+	bool IsOpen() const { return(m_data != NULL); }
+	// the mapped bytes, NULL when no file is open
+	const unsigned char* GetData() const { return(m_data); }
+	size_t GetSize() const { return(m_size); }
+
+private:
+	const unsigned char* m_data;
+	size_t m_size;
+	// the file and mapping handles on Windows, the descriptor
+	// in the first one elsewhere
+	void* m_fileHandle;
+	void* m_mappingHandle;
+};
@@ -0,0 +1,219 @@
+///////////////////////////////////////////////////////////////////////////////
+// mesharena.cpp
+// ============
+// pack the generated shape meshes into one vertex buffer, one index buffer
+// and one vertex array object
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshArena.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// declaration of global variables
+namespace
+{
+	// number of floats per staged vertex - position, normal,
+	// texture coordinate
+	const int g_FloatsPerVertex = 8;
+
+	// vertex attribute locations used by the vertex shader
+	const GLuint g_PositionLocation = 0;
+	const GLuint g_NormalLocation = 1;
+	const GLuint g_TextureLocation = 2;
+
+	// a quantized vertex - snorm16 position padded to four
+	// values, a 10:10:10:2 snorm normal and a unorm16 texture
+	// coordinate
+	struct PACKED_VERTEX
+	{
+		GLshort position[4];
+		GLuint normal;
+		GLushort textureCoordinate[2];
+	};
+
+	static_assert(sizeof(PACKED_VERTEX) == 16, "PACKED_VERTEX must stay 16 bytes");
+
+	// convert a -1 to 1 value into a signed normalized integer
+	int PackSnorm(float value, int maxValue)
+	{
+		float clamped = std::max(-1.0f, std::min(value, 1.0f));
+		return((int)std::lround(clamped * (float)maxValue));
+	}
+
+	// pack a unit normal into the GL_INT_2_10_10_10_REV layout
+	GLuint PackNormal(float x, float y, float z)
+	{
+		GLuint packed = ((GLuint)PackSnorm(x, 511) & 0x3FFu);
+		packed |= ((GLuint)PackSnorm(y, 511) & 0x3FFu) << 10;
+		packed |= ((GLuint)PackSnorm(z, 511) & 0x3FFu) << 20;
+		return(packed);
+	}
+}
+
+/***********************************************************
+ *  MeshArena()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+MeshArena::MeshArena()
+{
+	m_vao = 0;
+	m_vertexBuffer = 0;
+	m_indexBuffer = 0;
+	m_bQuantized = false;
+	m_vertexBytes = 0;
+}
+
+/***********************************************************
+ *  ~MeshArena()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+MeshArena::~MeshArena()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  AddMesh()
+ *
+ *  This method is used for appending a mesh to the staged
+ *  vertex and index data.  The indices stay relative to the
+ *  mesh, the base vertex places them in the shared buffer.
+ ***********************************************************/
+int MeshArena::AddMesh(const std::vector<GLfloat>& vertices, const std::vector<GLushort>& indices)
+{
+	MESH_RANGE range;
+	range.baseVertex = (GLint)(m_stagedVertices.size() / g_FloatsPerVertex);
+	range.firstIndex = (GLuint)m_stagedIndices.size();
+	range.indexCount = (GLuint)indices.size();
+
+	m_stagedVertices.insert(m_stagedVertices.end(), vertices.begin(), vertices.end());
+	m_stagedIndices.insert(m_stagedIndices.end(), indices.begin(), indices.end());
+	m_meshes.push_back(range);
+
+	return((int)m_meshes.size() - 1);
+}
+
+/***********************************************************
+ *  Upload()
+ *
+ *  This method is used for packing every staged mesh into
+ *  the shared vertex and index buffers and building the
+ *  vertex array that reads them.  The vertices are quantized
+ *  when all of them fit the normalized ranges, and are kept
+ *  as floats otherwise.
+ ***********************************************************/
+void MeshArena::Upload()
+{
+	Destroy();
+
+	size_t vertexCount = m_stagedVertices.size() / g_FloatsPerVertex;
+	if (vertexCount == 0)
+	{
+		return;
+	}
+
+	m_bQuantized = true;
+	for (size_t v = 0; (v < vertexCount) && (m_bQuantized == true); v++)
+	{
+		const GLfloat* vertex = &m_stagedVertices[v * g_FloatsPerVertex];
+		for (int i = 0; i < 3; i++)
+		{
+			if (std::fabs(vertex[i]) > 1.0f)
+			{
+				m_bQuantized = false;
+			}
+		}
+		for (int i = 6; i < 8; i++)
+		{
+			if ((vertex[i] < 0.0f) || (vertex[i] > 1.0f))
+			{
+				m_bQuantized = false;
+			}
+		}
+	}
+
+	glGenVertexArrays(1, &m_vao);
+	glBindVertexArray(m_vao);
+
+	glGenBuffers(1, &m_vertexBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+
+	if (m_bQuantized == true)
+	{
+		std::vector<PACKED_VERTEX> packed(vertexCount);
+		for (size_t v = 0; v < vertexCount; v++)
+		{
+			const GLfloat* vertex = &m_stagedVertices[v * g_FloatsPerVertex];
+
+			packed[v].position[0] = (GLshort)PackSnorm(vertex[0], 32767);
+			packed[v].position[1] = (GLshort)PackSnorm(vertex[1], 32767);
+			packed[v].position[2] = (GLshort)PackSnorm(vertex[2], 32767);
+			packed[v].position[3] = 0;
+			packed[v].normal = PackNormal(vertex[3], vertex[4], vertex[5]);
+			packed[v].textureCoordinate[0] = (GLushort)std::lround(vertex[6] * 65535.0f);
+			packed[v].textureCoordinate[1] = (GLushort)std::lround(vertex[7] * 65535.0f);
+		}
+
+		m_vertexBytes = packed.size() * sizeof(PACKED_VERTEX);
+		glBufferData(GL_ARRAY_BUFFER, m_vertexBytes, packed.data(), GL_STATIC_DRAW);
+
+		const GLsizei stride = sizeof(PACKED_VERTEX);
+		glVertexAttribPointer(g_PositionLocation, 3, GL_SHORT, GL_TRUE, stride,
+			(void*)offsetof(PACKED_VERTEX, position));
+		glVertexAttribPointer(g_NormalLocation, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride,
+			(void*)offsetof(PACKED_VERTEX, normal));
+		glVertexAttribPointer(g_TextureLocation, 2, GL_UNSIGNED_SHORT, GL_TRUE, stride,
+			(void*)offsetof(PACKED_VERTEX, textureCoordinate));
+	}
+	else
+	{
+		m_vertexBytes = m_stagedVertices.size() * sizeof(GLfloat);
+		glBufferData(GL_ARRAY_BUFFER, m_vertexBytes, m_stagedVertices.data(), GL_STATIC_DRAW);
+
+		const GLsizei stride = sizeof(GLfloat) * g_FloatsPerVertex;
+		glVertexAttribPointer(g_PositionLocation, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+		glVertexAttribPointer(g_NormalLocation, 3, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(GLfloat) * 3));
+		glVertexAttribPointer(g_TextureLocation, 2, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(GLfloat) * 6));
+	}
+	glEnableVertexAttribArray(g_PositionLocation);
+	glEnableVertexAttribArray(g_NormalLocation);
+	glEnableVertexAttribArray(g_TextureLocation);
+
+	glGenBuffers(1, &m_indexBuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_stagedIndices.size() * sizeof(GLushort), m_stagedIndices.data(), GL_STATIC_DRAW);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for releasing the GPU buffers and the
+ *  vertex array.  The staged meshes are kept, so Upload()
+ *  can build them again.
+ ***********************************************************/
+void MeshArena::Destroy()
+{
+	if (m_vao != 0)
+	{
+		glDeleteVertexArrays(1, &m_vao);
+		m_vao = 0;
+	}
+	if (m_vertexBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_vertexBuffer);
+		m_vertexBuffer = 0;
+	}
+	if (m_indexBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_indexBuffer);
+		m_indexBuffer = 0;
+	}
+	m_vertexBytes = 0;
+}
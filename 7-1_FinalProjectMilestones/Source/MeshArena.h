@@ -0,0 +1,83 @@
+///////////////////////////////////////////////////////////////////////////////
+// mesharena.h
+// ============
+// pack the generated shape meshes into one vertex buffer, one index buffer
+// and one vertex array object
+//
+//  Every mesh keeps its own 16-bit indices and is drawn with its base vertex
+//  and first index, so draws of different shapes never switch vertex arrays
+//  and one multi-draw can cover all of them.  When every position fits the
+//  unit cube and every texture coordinate the unit square, as they do for the
+//  basic shapes, the vertices are stored as 16 byte normalized integers
+//  instead of 32 bytes of floats.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <vector>
+
+/***********************************************************
+ *  MeshArena
+ *
+ *  This class contains the staged vertex and index data of
+ *  the added meshes and the GPU buffers they are packed into.
+ *  Meshes are only ever appended, and Upload() packs all of
+ *  them again.
+ ***********************************************************/
+class MeshArena
+{
+public:
+	// the part of the shared buffers that holds one mesh
+	struct MESH_RANGE
+	{
+		// added to every index of the mesh
+		GLint baseVertex;
+		// the first index in the shared index buffer
+		GLuint firstIndex;
+		GLuint indexCount;
+	};
+
+	// constructor
+	MeshArena();
+	// destructor
+	~MeshArena();
+
+	// stage a mesh of position, normal and texture coordinate
+	// floats - returns the ID of the mesh
+	int AddMesh(const std::vector<GLfloat>& vertices, const std::vector<GLushort>& indices);
+
+	// pack the staged meshes into the GPU buffers and build the
+	// vertex array - needs a current GL context
+	void Upload();
+
+	// the range of an added mesh
+	const MESH_RANGE& GetMesh(int meshID) const { return(m_meshes[meshID]); }
+	int GetMeshCount() const { return((int)m_meshes.size()); }
+
+	// the vertex array that draws every mesh
+	GLuint GetVertexArray() const { return(m_vao); }
+	// true when the vertices are stored as normalized integers
+	bool IsQuantized() const { return(m_bQuantized); }
+	// GPU memory of the vertex and index buffers in bytes
+	size_t GetVertexBytes() const { return(m_vertexBytes); }
+	size_t GetIndexBytes() const { return(m_stagedIndices.size() * sizeof(GLushort)); }
+
+	// release the GPU buffers, the staged meshes are kept
+	void Destroy();
+
+private:
+	std::vector<MESH_RANGE> m_meshes;
+	// position, normal and texture coordinate floats of every
+	// vertex, and the indices relative to each mesh
+	std::vector<GLfloat> m_stagedVertices;
+	std::vector<GLushort> m_stagedIndices;
+
+	GLuint m_vao;
+	GLuint m_vertexBuffer;
+	GLuint m_indexBuffer;
+	bool m_bQuantized;
+	size_t m_vertexBytes;
+};
@@ -0,0 +1,248 @@
+///////////////////////////////////////////////////////////////////////////////
+// programbuilder.cpp
+// ============
+// compile and link the shader programs that ShaderManager does not load
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ProgramBuilder.h"
+#include "ProgramCache.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+/***********************************************************
+ *  ReadShaderFile()
+ *
+ *  This method is used for reading the whole source of a
+ *  shader file into a string.
+ ***********************************************************/
+bool ProgramBuilder::ReadShaderFile(const char* filename, std::string& source)
+{
+	std::ifstream file(filename, std::ios::binary);
+
+	if (!file)
+	{
+		std::cout << "Could not open shader file: " << filename << std::endl;
+		return(false);
+	}
+
+	std::ostringstream contents;
+	contents << file.rdbuf();
+	source = contents.str();
+
+	return(true);
+}
+
+/***********************************************************
+ *  CompileShader()
+ *
+ *  This method is used for compiling one shader stage.  The
+ *  info log is printed with the passed in name when the
+ *  compile fails.
+ ***********************************************************/
+GLuint ProgramBuilder::CompileShader(GLenum stage, const std::string& source, const char* name)
+{
+	GLuint shaderID = glCreateShader(stage);
+	const GLchar* text = source.c_str();
+	GLint status = GL_FALSE;
+
+	glShaderSource(shaderID, 1, &text, NULL);
+	glCompileShader(shaderID);
+	glGetShaderiv(shaderID, GL_COMPILE_STATUS, &status);
+	if (status == GL_FALSE)
+	{
+		GLint logLength = 0;
+		glGetShaderiv(shaderID, GL_INFO_LOG_LENGTH, &logLength);
+		std::vector<GLchar> log((size_t)logLength + 1, '\0');
+		glGetShaderInfoLog(shaderID, logLength, NULL, log.data());
+		std::cout << "ERROR: Shader compile failed: " << name << "\n" << log.data() << std::endl;
+
+		glDeleteShader(shaderID);
+		return(0);
+	}
+
+	return(shaderID);
+}
+
+/***********************************************************
+ *  LinkProgram()
+ *
+ *  This method is used for linking the stages attached to a
+ *  program.  The info log is printed when the link fails.
+ ***********************************************************/
+bool ProgramBuilder::LinkProgram(GLuint programID, const char* name)
+{
+	GLint status = GL_FALSE;
+
+	glLinkProgram(programID);
+	glGetProgramiv(programID, GL_LINK_STATUS, &status);
+	if (status == GL_FALSE)
+	{
+		GLint logLength = 0;
+		glGetProgramiv(programID, GL_INFO_LOG_LENGTH, &logLength);
+		std::vector<GLchar> log((size_t)logLength + 1, '\0');
+		glGetProgramInfoLog(programID, logLength, NULL, log.data());
+		std::cout << "ERROR: Shader program link failed: " << name << "\n" << log.data() << std::endl;
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  BuildComputeProgram()
+ *
+ *  This method is used for building a compute program from
+ *  a shader file, or loading its cached binary.
+ ***********************************************************/
+GLuint ProgramBuilder::BuildComputeProgram(const char* filename)
+{
+	std::string source;
+
+	if (ReadShaderFile(filename, source) == false)
+	{
+		return(0);
+	}
+
+	uint64_t cacheKey = ProgramCache::GetKey(&source, 1);
+	GLuint programID = ProgramCache::LoadProgram(cacheKey);
+	if (programID != 0)
+	{
+		return(programID);
+	}
+
+	GLuint shaderID = CompileShader(GL_COMPUTE_SHADER, source, filename);
+	if (shaderID == 0)
+	{
+		return(0);
+	}
+
+	programID = glCreateProgram();
+	ProgramCache::PrepareProgram(programID);
+	glAttachShader(programID, shaderID);
+	bool bLinked = LinkProgram(programID, filename);
+	glDetachShader(programID, shaderID);
+	glDeleteShader(shaderID);
+
+	if (bLinked == false)
+	{
+		glDeleteProgram(programID);
+		return(0);
+	}
+	ProgramCache::StoreProgram(cacheKey, programID);
+
+	return(programID);
+}
+
+/***********************************************************
+ *  InsertDefines()
+ *
+ *  This method is used for inserting lines into a shader
+ *  source right after its #version line, which has to stay
+ *  the first statement.  Sources without one get the lines
+ *  at the start.
+ ***********************************************************/
+void ProgramBuilder::InsertDefines(std::string& source, const std::string& defines)
+{
+	if (defines.empty() == true)
+	{
+		return;
+	}
+
+	size_t position = 0;
+	size_t version = source.find("#version");
+	if (version != std::string::npos)
+	{
+		position = source.find('\n', version);
+		position = (position == std::string::npos) ? source.size() : position + 1;
+	}
+
+	std::string lines = defines;
+	if (lines.back() != '\n')
+	{
+		lines += '\n';
+	}
+	// a source whose #version line does not end in a newline
+	if ((position == source.size()) && (position > 0) && (source.back() != '\n'))
+	{
+		lines = "\n" + lines;
+	}
+	source.insert(position, lines);
+}
+
+/***********************************************************
+ *  BuildProgram()
+ *
+ *  This method is used for building a program from a vertex
+ *  and a fragment shader file.
+ ***********************************************************/
+GLuint ProgramBuilder::BuildProgram(const char* vertexFile, const char* fragmentFile)
+{
+	return(BuildProgram(vertexFile, fragmentFile, std::string()));
+}
+
+/***********************************************************
+ *  BuildProgram()
+ *
+ *  This method is used for building a program from a vertex
+ *  and a fragment shader file, with #define lines added to
+ *  the fragment shader for building one of its variants.
+ *  The cache key is taken after the lines are added, so
+ *  every variant has its own cached binary.
+ ***********************************************************/
+GLuint ProgramBuilder::BuildProgram(
+	const char* vertexFile,
+	const char* fragmentFile,
+	const std::string& fragmentDefines)
+{
+	std::string vertexSource;
+	std::string fragmentSource;
+
+	if ((ReadShaderFile(vertexFile, vertexSource) == false) ||
+		(ReadShaderFile(fragmentFile, fragmentSource) == false))
+	{
+		return(0);
+	}
+	InsertDefines(fragmentSource, fragmentDefines);
+
+	const std::string sources[2] = { vertexSource, fragmentSource };
+	uint64_t cacheKey = ProgramCache::GetKey(sources, 2);
+	GLuint programID = ProgramCache::LoadProgram(cacheKey);
+	if (programID != 0)
+	{
+		return(programID);
+	}
+
+	GLuint vertexID = CompileShader(GL_VERTEX_SHADER, vertexSource, vertexFile);
+	if (vertexID == 0)
+	{
+		return(0);
+	}
+	GLuint fragmentID = CompileShader(GL_FRAGMENT_SHADER, fragmentSource, fragmentFile);
+	if (fragmentID == 0)
+	{
+		glDeleteShader(vertexID);
+		return(0);
+	}
+
+	programID = glCreateProgram();
+	ProgramCache::PrepareProgram(programID);
+	glAttachShader(programID, vertexID);
+	glAttachShader(programID, fragmentID);
+	bool bLinked = LinkProgram(programID, fragmentFile);
+	glDetachShader(programID, vertexID);
+	glDetachShader(programID, fragmentID);
+	glDeleteShader(vertexID);
+	glDeleteShader(fragmentID);
+
+	if (bLinked == false)
+	{
+		glDeleteProgram(programID);
+		return(0);
+	}
+	ProgramCache::StoreProgram(cacheKey, programID);
+
+	return(programID);
+}
@@ -0,0 +1,58 @@
+///////////////////////////////////////////////////////////////////////////////
+// programbuilder.h
+// ============
+// compile and link the shader programs that ShaderManager does not load
+//
+//  ShaderManager only builds the vertex/fragment program of the scene.  The
+//  other programs - compute shaders for now - are built here from their GLSL
+//  files, and every compile or link error is printed with its info log.  The
+//  scene program can also be built here, to check edited shader files before
+//  ShaderManager loads them, and so can its variants, which insert #define
+//  lines after the #version line of the fragment shader.  Every program
+//  built here is taken from the program binary cache when its sources have
+//  not changed.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <string>
+
+/***********************************************************
+ *  ProgramBuilder
+ *
+ *  This class contains the code for reading shader files and
+ *  building shader programs from them.  It keeps no state,
+ *  so every method is static.
+ ***********************************************************/
+class ProgramBuilder
+{
+public:
+	// read a whole shader file - returns false if it can not
+	// be opened
+	static bool ReadShaderFile(const char* filename, std::string& source);
+
+	// compile one shader stage - returns 0 on failure
+	static GLuint CompileShader(GLenum stage, const std::string& source, const char* name);
+
+	// build a compute program from a shader file - returns 0
+	// on failure
+	static GLuint BuildComputeProgram(const char* filename);
+	// build a vertex/fragment program from its shader files -
+	// returns 0 on failure
+	static GLuint BuildProgram(const char* vertexFile, const char* fragmentFile);
+	// build a vertex/fragment program with #define lines added to
+	// the fragment shader - returns 0 on failure
+	static GLuint BuildProgram(
+		const char* vertexFile,
+		const char* fragmentFile,
+		const std::string& fragmentDefines);
+
+private:
+	// link the attached stages of a program - returns false on
+	// failure
+	static bool LinkProgram(GLuint programID, const char* name);
+	// insert lines after the #version line of a shader source
+	static void InsertDefines(std::string& source, const std::string& defines);
+};
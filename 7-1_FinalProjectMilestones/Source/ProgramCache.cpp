@@ -0,0 +1,329 @@
+///////////////////////////////////////////////////////////////////////////////
+// programcache.cpp
+// ============
+// linked program binaries kept on disk between runs
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ProgramCache.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+	// the directory of the cache files, next to the shaders
+	const char* g_CacheDirectory = "shadercache";
+	const char* g_CacheExtension = ".bin";
+	// "GLPB" read as a little endian value
+	const uint32_t g_CacheMagic = 0x42504C47;
+	// changes whenever the layout of the cache files does
+	const uint32_t g_CacheVersion = 1;
+	// 64 bit FNV-1a offset basis and prime
+	const uint64_t g_HashBasis = 0xCBF29CE484222325ull;
+	const uint64_t g_HashPrime = 0x00000100000001B3ull;
+
+	// the cache is used unless it was turned off
+	bool g_bCacheEnabled = true;
+
+	// the fields that start every cache file, followed by the
+	// driver name and the program binary
+	struct CACHE_HEADER
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t key;
+		uint32_t binaryFormat;
+		uint32_t binaryLength;
+		uint32_t driverNameLength;
+		uint32_t padding;
+	};
+
+	// add bytes to a running FNV-1a hash
+	uint64_t HashBytes(uint64_t hash, const void* data, size_t length)
+	{
+		const unsigned char* bytes = (const unsigned char*)data;
+
+		for (size_t i = 0; i < length; i++)
+		{
+			hash ^= bytes[i];
+			hash *= g_HashPrime;
+		}
+
+		return(hash);
+	}
+}
+
+/***********************************************************
+ *  SetEnabled()
+ *
+ *  This method is used for turning the cache on or off.
+ *  While it is off, no cache file is read or written.
+ ***********************************************************/
+void ProgramCache::SetEnabled(bool bEnabled)
+{
+	g_bCacheEnabled = bEnabled;
+}
+
+/***********************************************************
+ *  IsSupported()
+ *
+ *  This method is used for checking whether the cache is on
+ *  and the driver has at least one program binary format.
+ ***********************************************************/
+bool ProgramCache::IsSupported()
+{
+	if (g_bCacheEnabled == false)
+	{
+		return(false);
+	}
+	if (!GLEW_VERSION_4_1 && !GLEW_ARB_get_program_binary)
+	{
+		return(false);
+	}
+
+	GLint formatCount = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+
+	return(formatCount > 0);
+}
+
+/***********************************************************
+ *  GetDriverName()
+ *
+ *  This method is used for getting the vendor, renderer and
+ *  version strings of the driver, which together decide
+ *  whether a binary can be loaded.
+ ***********************************************************/
+std::string ProgramCache::GetDriverName()
+{
+	const GLenum names[3] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+	std::string driverName;
+
+	for (int i = 0; i < 3; i++)
+	{
+		const GLubyte* value = glGetString(names[i]);
+		if (NULL != value)
+		{
+			driverName += (const char*)value;
+		}
+		driverName += '\n';
+	}
+
+	return(driverName);
+}
+
+/***********************************************************
+ *  GetKey()
+ *
+ *  This method is used for hashing the stage sources of a
+ *  program together with the driver name.  The length of
+ *  every source is hashed too, so moving text from one stage
+ *  to the next changes the key.
+ ***********************************************************/
+uint64_t ProgramCache::GetKey(const std::string* sources, int sourceCount)
+{
+	uint64_t hash = g_HashBasis;
+
+	for (int i = 0; i < sourceCount; i++)
+	{
+		uint64_t length = (uint64_t)sources[i].size();
+		hash = HashBytes(hash, &length, sizeof(length));
+		hash = HashBytes(hash, sources[i].data(), sources[i].size());
+	}
+
+	std::string driverName = GetDriverName();
+	hash = HashBytes(hash, driverName.data(), driverName.size());
+
+	return(hash);
+}
+
+/***********************************************************
+ *  GetCachePath()
+ *
+ *  This method is used for getting the name of the cache
+ *  file of a program key.
+ ***********************************************************/
+std::string ProgramCache::GetCachePath(uint64_t key)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx", (unsigned long long)key);
+
+	std::filesystem::path cachePath(g_CacheDirectory);
+	cachePath /= std::string(name) + g_CacheExtension;
+
+	return(cachePath.string());
+}
+
+/***********************************************************
+ *  LoadProgram()
+ *
+ *  This method is used for creating a program from the
+ *  cache file of its key.  The file has to be for the same
+ *  key and driver, its size has to match the lengths in its
+ *  header, and the driver has to accept the binary - a
+ *  damaged or rejected file is removed so it is written
+ *  again after the source build.
+ ***********************************************************/
+GLuint ProgramCache::LoadProgram(uint64_t key)
+{
+	if (IsSupported() == false)
+	{
+		return(0);
+	}
+
+	std::string cachePath = GetCachePath(key);
+	std::ifstream file(cachePath, std::ios::binary);
+	if (!file)
+	{
+		return(0);
+	}
+
+	CACHE_HEADER header;
+	file.read((char*)&header, sizeof(header));
+	if ((!file) ||
+		(header.magic != g_CacheMagic) ||
+		(header.version != g_CacheVersion) ||
+		(header.key != key) ||
+		(header.binaryLength == 0))
+	{
+		return(0);
+	}
+
+	// the lengths come from the file, so a damaged file is
+	// caught before they are used to size anything
+	std::error_code error;
+	uintmax_t fileSize = std::filesystem::file_size(cachePath, error);
+	if ((error) ||
+		(fileSize != (uintmax_t)sizeof(CACHE_HEADER) + header.driverNameLength + header.binaryLength))
+	{
+		std::cout << "Cached program binary is damaged, building from source: " << cachePath << std::endl;
+		file.close();
+		std::filesystem::remove(cachePath, error);
+		return(0);
+	}
+
+	std::string driverName(header.driverNameLength, '\0');
+	file.read(&driverName[0], header.driverNameLength);
+	if ((!file) || (driverName != GetDriverName()))
+	{
+		return(0);
+	}
+
+	std::vector<char> binary(header.binaryLength);
+	file.read(binary.data(), header.binaryLength);
+	if (!file)
+	{
+		return(0);
+	}
+	file.close();
+
+	GLuint programID = glCreateProgram();
+	glProgramBinary(programID, (GLenum)header.binaryFormat, binary.data(), (GLsizei)binary.size());
+
+	GLint status = GL_FALSE;
+	glGetProgramiv(programID, GL_LINK_STATUS, &status);
+	if (status == GL_FALSE)
+	{
+		std::cout << "Cached program binary was rejected, building from source: " << cachePath << std::endl;
+		glDeleteProgram(programID);
+		std::filesystem::remove(cachePath, error);
+		return(0);
+	}
+
+	return(programID);
+}
+
+/***********************************************************
+ *  PrepareProgram()
+ *
+ *  This method is used for telling the driver to keep the
+ *  binary of a program, before the program is linked.
+ ***********************************************************/
+void ProgramCache::PrepareProgram(GLuint programID)
+{
+	if (IsSupported() == false)
+	{
+		return;
+	}
+
+	glProgramParameteri(programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+/***********************************************************
+ *  StoreProgram()
+ *
+ *  This method is used for writing the binary of a linked
+ *  program to the cache file of its key.  The file is
+ *  written under a temporary name and renamed when it is
+ *  complete, so a run that stops while writing leaves no
+ *  partial file behind.
+ ***********************************************************/
+bool ProgramCache::StoreProgram(uint64_t key, GLuint programID)
+{
+	if (IsSupported() == false)
+	{
+		return(false);
+	}
+
+	GLint binaryLength = 0;
+	glGetProgramiv(programID, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+	if (binaryLength <= 0)
+	{
+		return(false);
+	}
+
+	std::vector<char> binary((size_t)binaryLength);
+	GLenum binaryFormat = 0;
+	GLsizei writtenLength = 0;
+	glGetProgramBinary(programID, binaryLength, &writtenLength, &binaryFormat, binary.data());
+	if (writtenLength <= 0)
+	{
+		return(false);
+	}
+
+	std::error_code error;
+	std::filesystem::create_directories(g_CacheDirectory, error);
+
+	std::string driverName = GetDriverName();
+	CACHE_HEADER header;
+	header.magic = g_CacheMagic;
+	header.version = g_CacheVersion;
+	header.key = key;
+	header.binaryFormat = (uint32_t)binaryFormat;
+	header.binaryLength = (uint32_t)writtenLength;
+	header.driverNameLength = (uint32_t)driverName.size();
+	header.padding = 0;
+
+	std::string cachePath = GetCachePath(key);
+	std::string tempPath = cachePath + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file)
+		{
+			std::cout << "Could not write program cache: " << tempPath << std::endl;
+			return(false);
+		}
+
+		file.write((const char*)&header, sizeof(header));
+		file.write(driverName.data(), driverName.size());
+		file.write(binary.data(), writtenLength);
+		if (!file.good())
+		{
+			file.close();
+			std::filesystem::remove(tempPath, error);
+			return(false);
+		}
+	}
+
+	std::filesystem::rename(tempPath, cachePath, error);
+	if (error)
+	{
+		std::filesystem::remove(tempPath, error);
+		return(false);
+	}
+
+	return(true);
+}
@@ -0,0 +1,57 @@
+///////////////////////////////////////////////////////////////////////////////
+// programcache.h
+// ============
+// linked program binaries kept on disk between runs
+//
+//  Linking a program from GLSL source is the slowest part of startup, and the
+//  shader variants multiply it.  The driver can hand back the linked binary of
+//  a program, so the binary is written to a cache file named after the key of
+//  the program - a hash of its stage sources, the GL vendor, renderer and
+//  version - and the next run creates the program from that file instead.
+//  Binaries only work with the driver that made them; a file for another
+//  driver, a damaged file or a binary the driver rejects is ignored and the
+//  program is built from source again, which replaces the file.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <string>
+
+/***********************************************************
+ *  ProgramCache
+ *
+ *  This class contains the code for reading and writing the
+ *  program binary cache files.  ProgramBuilder goes through
+ *  it for every program it builds.
+ ***********************************************************/
+class ProgramCache
+{
+public:
+	// turn the cache on or off, it is on by default
+	static void SetEnabled(bool bEnabled);
+	// true when the cache is on and the driver can return
+	// program binaries
+	static bool IsSupported();
+
+	// get the key of a program from the sources of its stages,
+	// in the order they are attached, and the current driver
+	static uint64_t GetKey(const std::string* sources, int sourceCount);
+
+	// create a program from its cached binary - returns 0 when
+	// there is no usable binary
+	static GLuint LoadProgram(uint64_t key);
+	// ask the driver to keep the binary of a program that is
+	// about to be linked
+	static void PrepareProgram(GLuint programID);
+	// write the binary of a linked program to its cache file
+	static bool StoreProgram(uint64_t key, GLuint programID);
+
+private:
+	// get the cache file name of a program key
+	static std::string GetCachePath(uint64_t key);
+	// get the vendor, renderer and version of the driver
+	static std::string GetDriverName();
+};
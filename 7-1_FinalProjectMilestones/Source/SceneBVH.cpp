@@ -0,0 +1,217 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenebvh.cpp
+// ============
+// bounding volume hierarchy over the world bounds of the scene objects
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneBVH.h"
+
+#include <algorithm>
+
+/***********************************************************
+ *  Build()
+ *
+ *  This method is used for building the tree over a set of
+ *  items.  The previous tree is replaced.
+ ***********************************************************/
+void SceneBVH::Build(const std::vector<AABB>& bounds, const std::vector<int>& items)
+{
+	Clear();
+
+	if (items.empty())
+	{
+		return;
+	}
+
+	m_items = items;
+	// a binary tree with leaves of at least one item has fewer
+	// than twice as many nodes as items
+	m_nodes.reserve(items.size() * 2);
+	m_nodes.push_back(BVH_NODE());
+	BuildNode(0, 0, (int)m_items.size(), bounds);
+}
+
+/***********************************************************
+ *  BuildNode()
+ *
+ *  This method is used for building the subtree of a node.
+ *  The items are split at the median of their centers along
+ *  the axis where the centers are spread the most.
+ ***********************************************************/
+void SceneBVH::BuildNode(int node, int first, int count, const std::vector<AABB>& bounds)
+{
+	AABB nodeBounds = bounds[m_items[first]];
+	AABB centerBounds;
+	centerBounds.min = (nodeBounds.min + nodeBounds.max) * 0.5f;
+	centerBounds.max = centerBounds.min;
+
+	for (int i = first + 1; i < first + count; i++)
+	{
+		const AABB& box = bounds[m_items[i]];
+		glm::vec3 center = (box.min + box.max) * 0.5f;
+
+		nodeBounds = MergeAABB(nodeBounds, box);
+		centerBounds.min = glm::min(centerBounds.min, center);
+		centerBounds.max = glm::max(centerBounds.max, center);
+	}
+
+	m_nodes[node].bounds = nodeBounds;
+	m_nodes[node].firstChild = -1;
+	m_nodes[node].firstItem = first;
+	m_nodes[node].itemCount = count;
+
+	if (count <= LEAF_ITEMS)
+	{
+		return;
+	}
+
+	glm::vec3 spread = centerBounds.max - centerBounds.min;
+	int axis = 0;
+	if (spread.y > spread[axis])
+	{
+		axis = 1;
+	}
+	if (spread.z > spread[axis])
+	{
+		axis = 2;
+	}
+
+	// items that all share one center stay in a single leaf
+	if (spread[axis] <= 0.0f)
+	{
+		return;
+	}
+
+	int half = count / 2;
+	std::nth_element(
+		m_items.begin() + first,
+		m_items.begin() + first + half,
+		m_items.begin() + first + count,
+		[&bounds, axis](int a, int b)
+		{
+			return((bounds[a].min[axis] + bounds[a].max[axis]) <
+				(bounds[b].min[axis] + bounds[b].max[axis]));
+		});
+
+	int firstChild = (int)m_nodes.size();
+	m_nodes.push_back(BVH_NODE());
+	m_nodes.push_back(BVH_NODE());
+
+	m_nodes[node].firstChild = firstChild;
+	m_nodes[node].itemCount = 0;
+
+	BuildNode(firstChild, first, half, bounds);
+	BuildNode(firstChild + 1, first + half, count - half, bounds);
+}
+
+/***********************************************************
+ *  Refit()
+ *
+ *  This method is used for updating the node bounds after
+ *  the bounds of the items changed.  Children are always
+ *  stored after their parent, so one backwards pass is
+ *  enough.  The tree may get looser but stays correct.
+ ***********************************************************/
+void SceneBVH::Refit(const std::vector<AABB>& bounds)
+{
+	for (int n = (int)m_nodes.size() - 1; n >= 0; n--)
+	{
+		BVH_NODE& node = m_nodes[n];
+
+		if (node.firstChild >= 0)
+		{
+			node.bounds = MergeAABB(
+				m_nodes[node.firstChild].bounds,
+				m_nodes[node.firstChild + 1].bounds);
+			continue;
+		}
+
+		node.bounds = bounds[m_items[node.firstItem]];
+		for (int i = 1; i < node.itemCount; i++)
+		{
+			node.bounds = MergeAABB(node.bounds, bounds[m_items[node.firstItem + i]]);
+		}
+	}
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing every node and item.
+ ***********************************************************/
+void SceneBVH::Clear()
+{
+	m_nodes.clear();
+	m_items.clear();
+}
+
+/***********************************************************
+ *  QueryFrustum()
+ *
+ *  This method is used for marking the items that are at
+ *  least partly inside a frustum, testing the items of the
+ *  leaves against their own bounds.  The flags of the other
+ *  items are left as they are, so the caller clears them.
+ ***********************************************************/
+int SceneBVH::QueryFrustum(
+	const Frustum& frustum,
+	const std::vector<AABB>& bounds,
+	std::vector<uint8_t>& visible) const
+{
+	// a node and the planes its subtree still has to test
+	struct STACK_ENTRY
+	{
+		int node;
+		unsigned int planeMask;
+	};
+
+	int visibleCount = 0;
+
+	if (m_nodes.empty())
+	{
+		return(0);
+	}
+
+	// the tree depth stays far below this for median splits
+	STACK_ENTRY stack[64];
+	int stackSize = 0;
+	stack[stackSize++] = { 0, Frustum::ALL_PLANES };
+
+	while (stackSize > 0)
+	{
+		STACK_ENTRY entry = stack[--stackSize];
+		const BVH_NODE& node = m_nodes[entry.node];
+
+		unsigned int planeMask = entry.planeMask;
+		if (planeMask != 0)
+		{
+			if (frustum.TestAABB(node.bounds, planeMask) == CULL_OUTSIDE)
+			{
+				continue;
+			}
+		}
+
+		if (node.firstChild >= 0)
+		{
+			stack[stackSize++] = { node.firstChild, planeMask };
+			stack[stackSize++] = { node.firstChild + 1, planeMask };
+			continue;
+		}
+
+		for (int i = 0; i < node.itemCount; i++)
+		{
+			int item = m_items[node.firstItem + i];
+
+			// a leaf that intersects tests its items one by one
+			unsigned int itemMask = planeMask;
+			if ((itemMask == 0) ||
+				(frustum.TestAABB(bounds[item], itemMask) != CULL_OUTSIDE))
+			{
+				visible[item] = 1;
+				visibleCount++;
+			}
+		}
+	}
+
+	return(visibleCount);
+}
@@ -0,0 +1,65 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenebvh.h
+// ============
+// bounding volume hierarchy over the world bounds of the scene objects
+//
+//  The tree is built top down by splitting the items at the median of their
+//  centers along the longest axis, and is refitted bottom up when objects move
+//  without being rebuilt.  A frustum query skips whole subtrees that are
+//  outside, and accepts whole subtrees that are inside without testing them.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "BoundingVolumes.h"
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  SceneBVH
+ *
+ *  This class contains the hierarchy of a set of items, each
+ *  one the index of a box in the bounds list the tree was
+ *  built from.
+ ***********************************************************/
+class SceneBVH
+{
+public:
+	// build the tree over a set of items
+	void Build(const std::vector<AABB>& bounds, const std::vector<int>& items);
+	// update the node bounds after the item bounds changed
+	void Refit(const std::vector<AABB>& bounds);
+	// remove every node and item
+	void Clear();
+
+	// set the visible flag of every item whose bounds are at
+	// least partly inside the frustum - returns their number
+	int QueryFrustum(
+		const Frustum& frustum,
+		const std::vector<AABB>& bounds,
+		std::vector<uint8_t>& visible) const;
+
+	bool IsEmpty() const { return(m_nodes.empty()); }
+
+private:
+	// the most items kept in a leaf node
+	static const int LEAF_ITEMS = 4;
+
+	// a tree node - the children of an interior node are the
+	// two nodes at firstChild, a leaf holds itemCount items
+	// from firstItem in the item list
+	struct BVH_NODE
+	{
+		AABB bounds;
+		int firstChild;
+		int firstItem;
+		int itemCount;
+	};
+
+	std::vector<BVH_NODE> m_nodes;
+	std::vector<int> m_items;
+
+	// build the subtree of a node over a range of the items
+	void BuildNode(int node, int first, int count, const std::vector<AABB>& bounds);
+};
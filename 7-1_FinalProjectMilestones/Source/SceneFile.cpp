@@ -0,0 +1,541 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenefile.cpp
+// ============
+// binary scene description files that are read in place from a mapping
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneFile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+static_assert(sizeof(SceneFile::FILE_HEADER) == 64, "FILE_HEADER must stay 64 bytes");
+static_assert(sizeof(SceneFile::FILE_TEXTURE) == 8, "FILE_TEXTURE must stay 8 bytes");
+static_assert(sizeof(SceneFile::FILE_MATERIAL) == 48, "FILE_MATERIAL must stay 48 bytes");
+static_assert(sizeof(SceneFile::FILE_LIGHT) == 96, "FILE_LIGHT must stay 96 bytes");
+static_assert(sizeof(SceneFile::FILE_NODE) == 80, "FILE_NODE must stay 80 bytes");
+
+namespace
+{
+	// the first bytes of every scene file
+	const char g_FileMagic[4] = { 'S', 'C', 'N', 'B' };
+	// the alignment of every record array in the file
+	const size_t g_SectionAlignment = 16;
+
+	/***********************************************************
+	 *  AlignSection()
+	 *
+	 *  This function is used for rounding a file offset up to
+	 *  the start of the next record array.
+	 ***********************************************************/
+	size_t AlignSection(size_t offset)
+	{
+		return((offset + g_SectionAlignment - 1) & ~(g_SectionAlignment - 1));
+	}
+
+	/***********************************************************
+	 *  WriteSection()
+	 *
+	 *  This function is used for appending an array of records
+	 *  to the file image at the next aligned offset.
+	 ***********************************************************/
+	template <typename T>
+	SceneFile::FILE_SECTION WriteSection(
+		std::vector<unsigned char>& image,
+		const T* records,
+		size_t count,
+		size_t recordSize)
+	{
+		SceneFile::FILE_SECTION section;
+
+		image.resize(AlignSection(image.size()), 0);
+		section.offset = (uint32_t)image.size();
+		section.count = (uint32_t)count;
+
+		if (count > 0)
+		{
+			image.resize(image.size() + count * recordSize);
+			memcpy(image.data() + section.offset, records, count * recordSize);
+		}
+
+		return(section);
+	}
+
+	/***********************************************************
+	 *  AddString()
+	 *
+	 *  This function is used for appending a zero terminated
+	 *  string to the string table.  Returns its offset.
+	 ***********************************************************/
+	uint32_t AddString(std::string& strings, const std::string& value)
+	{
+		uint32_t offset = (uint32_t)strings.size();
+		strings.append(value);
+		strings.push_back('\0');
+		return(offset);
+	}
+
+	/***********************************************************
+	 *  FindName()
+	 *
+	 *  This function is used for resolving a name of the text
+	 *  description, where '-' means none.  Returns -1 for none
+	 *  and -2 for a name that was not defined.
+	 ***********************************************************/
+	int FindName(const std::unordered_map<std::string, int>& names, const std::string& name)
+	{
+		if (name == "-")
+		{
+			return(-1);
+		}
+
+		std::unordered_map<std::string, int>::const_iterator found = names.find(name);
+		if (found == names.end())
+		{
+			return(-2);
+		}
+		return(found->second);
+	}
+}
+
+/***********************************************************
+ *  SceneFile()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneFile::SceneFile()
+{
+	m_textures = NULL;
+	m_materials = NULL;
+	m_lights = NULL;
+	m_nodes = NULL;
+	m_strings = NULL;
+	m_textureCount = 0;
+	m_materialCount = 0;
+	m_lightCount = 0;
+	m_nodeCount = 0;
+	m_stringBytes = 0;
+}
+
+/***********************************************************
+ *  Open()
+ *
+ *  This method is used for mapping a scene file.  Only the
+ *  header and the indices between the records are checked,
+ *  the records themselves are used in place afterwards.
+ ***********************************************************/
+bool SceneFile::Open(const char* filename)
+{
+	Close();
+
+	if (m_file.Open(filename) == false)
+	{
+		return(false);
+	}
+
+	const FILE_HEADER* header = (const FILE_HEADER*)m_file.GetData();
+	if ((m_file.GetSize() < sizeof(FILE_HEADER)) ||
+		(memcmp(header->magic, g_FileMagic, sizeof(g_FileMagic)) != 0))
+	{
+		std::cout << "Not a scene file: " << filename << std::endl;
+		Close();
+		return(false);
+	}
+	if (header->version != FILE_VERSION)
+	{
+		std::cout << "Scene file version " << header->version << " is not supported: " << filename << std::endl;
+		Close();
+		return(false);
+	}
+	if ((header->fileSize != m_file.GetSize()) ||
+		(IsSectionValid(header->textures, sizeof(FILE_TEXTURE)) == false) ||
+		(IsSectionValid(header->materials, sizeof(FILE_MATERIAL)) == false) ||
+		(IsSectionValid(header->lights, sizeof(FILE_LIGHT)) == false) ||
+		(IsSectionValid(header->nodes, sizeof(FILE_NODE)) == false) ||
+		(IsSectionValid(header->strings, 1) == false))
+	{
+		std::cout << "Scene file is truncated or damaged: " << filename << std::endl;
+		Close();
+		return(false);
+	}
+
+	const unsigned char* data = m_file.GetData();
+	m_textures = (const FILE_TEXTURE*)(data + header->textures.offset);
+	m_materials = (const FILE_MATERIAL*)(data + header->materials.offset);
+	m_lights = (const FILE_LIGHT*)(data + header->lights.offset);
+	m_nodes = (const FILE_NODE*)(data + header->nodes.offset);
+	m_strings = (const char*)(data + header->strings.offset);
+	m_textureCount = (int)header->textures.count;
+	m_materialCount = (int)header->materials.count;
+	m_lightCount = (int)header->lights.count;
+	m_nodeCount = (int)header->nodes.count;
+	m_stringBytes = header->strings.count;
+
+	if (AreIndicesValid() == false)
+	{
+		std::cout << "Scene file has invalid references: " << filename << std::endl;
+		Close();
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  Close()
+ *
+ *  This method is used for unmapping the scene file.
+ ***********************************************************/
+void SceneFile::Close()
+{
+	m_file.Close();
+
+	m_textures = NULL;
+	m_materials = NULL;
+	m_lights = NULL;
+	m_nodes = NULL;
+	m_strings = NULL;
+	m_textureCount = 0;
+	m_materialCount = 0;
+	m_lightCount = 0;
+	m_nodeCount = 0;
+	m_stringBytes = 0;
+}
+
+/***********************************************************
+ *  GetString()
+ *
+ *  This method is used for getting a string of the string
+ *  table.  Offsets were checked when the file was opened.
+ ***********************************************************/
+const char* SceneFile::GetString(uint32_t offset) const
+{
+	if ((m_strings == NULL) || (offset >= m_stringBytes))
+	{
+		return("");
+	}
+
+	return(m_strings + offset);
+}
+
+/***********************************************************
+ *  IsSectionValid()
+ *
+ *  This method is used for checking that a record array
+ *  starts aligned and ends inside the mapped file.
+ ***********************************************************/
+bool SceneFile::IsSectionValid(const FILE_SECTION& section, size_t recordSize) const
+{
+	uint64_t end = (uint64_t)section.offset + (uint64_t)section.count * recordSize;
+
+	return(((section.offset % g_SectionAlignment) == 0) &&
+		(section.offset >= sizeof(FILE_HEADER)) &&
+		(end <= (uint64_t)m_file.GetSize()));
+}
+
+/***********************************************************
+ *  AreIndicesValid()
+ *
+ *  This method is used for checking the references between
+ *  the records, so using them never reads outside of the
+ *  arrays - the string table has to end with a terminator,
+ *  and every parent has to precede its children.
+ ***********************************************************/
+bool SceneFile::AreIndicesValid() const
+{
+	if ((m_stringBytes == 0) || (m_strings[m_stringBytes - 1] != '\0'))
+	{
+		return(false);
+	}
+
+	for (int i = 0; i < m_textureCount; i++)
+	{
+		if ((m_textures[i].tag >= m_stringBytes) || (m_textures[i].path >= m_stringBytes))
+		{
+			return(false);
+		}
+	}
+	for (int i = 0; i < m_materialCount; i++)
+	{
+		if (m_materials[i].tag >= m_stringBytes)
+		{
+			return(false);
+		}
+	}
+	for (int i = 0; i < m_lightCount; i++)
+	{
+		if ((m_lights[i].type > LIGHT_SPOT) || !(m_lights[i].radius >= 0.0f))
+		{
+			return(false);
+		}
+	}
+	for (int i = 0; i < m_nodeCount; i++)
+	{
+		const FILE_NODE& node = m_nodes[i];
+		if ((node.parent < -1) || (node.parent >= i) ||
+			(node.mesh > NODE_SPHERE) ||
+			(node.material < -1) || (node.material >= m_materialCount) ||
+			(node.texture < -1) || (node.texture >= m_textureCount))
+		{
+			return(false);
+		}
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  ExportText()
+ *
+ *  This method is used for converting a text scene
+ *  description into a scene file.  Textures, materials and
+ *  groups have to be defined before the lines that use them,
+ *  which also keeps every parent ahead of its children.
+ ***********************************************************/
+bool SceneFile::ExportText(const char* textFile, const char* sceneFile)
+{
+	std::ifstream file(textFile);
+	std::string line;
+	int lineNumber = 0;
+
+	if (!file)
+	{
+		std::cout << "Could not open scene description: " << textFile << std::endl;
+		return(false);
+	}
+
+	std::vector<FILE_TEXTURE> textures;
+	std::vector<FILE_MATERIAL> materials;
+	std::vector<FILE_LIGHT> lights;
+	std::vector<FILE_NODE> nodes;
+	std::string strings;
+	std::unordered_map<std::string, int> textureNames;
+	std::unordered_map<std::string, int> materialNames;
+	std::unordered_map<std::string, int> groupNames;
+
+	// offset 0 is the empty string
+	AddString(strings, "");
+
+	while (std::getline(file, line))
+	{
+		lineNumber++;
+
+		// files written on Windows keep the carriage return
+		if ((line.empty() == false) && (line.back() == '\r'))
+		{
+			line.pop_back();
+		}
+
+		size_t first = line.find_first_not_of(" \t\r");
+		if ((first == std::string::npos) || (line[first] == '#'))
+		{
+			continue;
+		}
+
+		std::istringstream values(line);
+		std::string keyword;
+		values >> keyword;
+
+		bool bValid = true;
+		if (keyword == "texture")
+		{
+			std::string tag;
+			std::string path;
+			values >> tag >> path;
+
+			FILE_TEXTURE texture;
+			texture.tag = AddString(strings, tag);
+			texture.path = AddString(strings, path);
+			bValid = !!values;
+			if (bValid == true)
+			{
+				textureNames[tag] = (int)textures.size();
+				textures.push_back(texture);
+			}
+		}
+		else if (keyword == "material")
+		{
+			std::string tag;
+			FILE_MATERIAL material;
+			values >> tag
+				>> material.ambientColor.x >> material.ambientColor.y >> material.ambientColor.z
+				>> material.ambientStrength
+				>> material.diffuseColor.x >> material.diffuseColor.y >> material.diffuseColor.z
+				>> material.specularColor.x >> material.specularColor.y >> material.specularColor.z
+				>> material.shininess;
+			bValid = !!values;
+			if (bValid == true)
+			{
+				material.tag = AddString(strings, tag);
+				materialNames[tag] = (int)materials.size();
+				materials.push_back(material);
+			}
+		}
+		else if ((keyword == "directional") || (keyword == "point") || (keyword == "spot"))
+		{
+			FILE_LIGHT light;
+			memset((void*)&light, 0, sizeof(light));
+			light.constant = 1.0f;
+
+			if (keyword == "directional")
+			{
+				light.type = LIGHT_DIRECTIONAL;
+				values >> light.direction.x >> light.direction.y >> light.direction.z;
+			}
+			else if (keyword == "point")
+			{
+				light.type = LIGHT_POINT;
+				values >> light.position.x >> light.position.y >> light.position.z;
+			}
+			else
+			{
+				float cutOffDegrees = 0.0f;
+				float outerCutOffDegrees = 0.0f;
+
+				light.type = LIGHT_SPOT;
+				values >> light.position.x >> light.position.y >> light.position.z
+					>> light.direction.x >> light.direction.y >> light.direction.z
+					>> cutOffDegrees >> outerCutOffDegrees;
+				light.cutOff = cosf(glm::radians(cutOffDegrees));
+				light.outerCutOff = cosf(glm::radians(outerCutOffDegrees));
+			}
+			values >> light.ambient.x >> light.ambient.y >> light.ambient.z
+				>> light.diffuse.x >> light.diffuse.y >> light.diffuse.z
+				>> light.specular.x >> light.specular.y >> light.specular.z;
+			if (light.type == LIGHT_SPOT)
+			{
+				values >> light.constant >> light.linear >> light.quadratic;
+			}
+
+			bValid = !!values;
+			// the radius of a point light is optional
+			if ((bValid == true) && (light.type == LIGHT_POINT))
+			{
+				float radius = 0.0f;
+				if (values >> radius)
+				{
+					light.radius = std::max(radius, 0.0f);
+				}
+			}
+			if (bValid == true)
+			{
+				lights.push_back(light);
+			}
+		}
+		else if (keyword == "group")
+		{
+			std::string name;
+			std::string parentName;
+			values >> name >> parentName;
+
+			FILE_NODE node;
+			memset((void*)&node, 0, sizeof(node));
+			node.scaleXYZ = glm::vec3(1.0f, 1.0f, 1.0f);
+			node.parent = FindName(groupNames, parentName);
+			node.mesh = NODE_GROUP;
+			node.material = -1;
+			node.color = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+			node.UVscale = glm::vec2(1.0f, 1.0f);
+			node.texture = -1;
+
+			bValid = (!!values) && (node.parent >= -1);
+			if (bValid == true)
+			{
+				groupNames[name] = (int)nodes.size();
+				nodes.push_back(node);
+			}
+		}
+		else if ((keyword == "plane") || (keyword == "box") || (keyword == "cylinder") || (keyword == "sphere"))
+		{
+			std::string parentName;
+			std::string materialName;
+			std::string textureName;
+
+			FILE_NODE node;
+			memset((void*)&node, 0, sizeof(node));
+			values >> parentName
+				>> node.scaleXYZ.x >> node.scaleXYZ.y >> node.scaleXYZ.z
+				>> node.rotationDegrees.x >> node.rotationDegrees.y >> node.rotationDegrees.z
+				>> node.positionXYZ.x >> node.positionXYZ.y >> node.positionXYZ.z
+				>> node.color.x >> node.color.y >> node.color.z >> node.color.w
+				>> materialName >> textureName
+				>> node.UVscale.x >> node.UVscale.y;
+
+			if (keyword == "plane")
+			{
+				node.mesh = NODE_PLANE;
+			}
+			else if (keyword == "box")
+			{
+				node.mesh = NODE_BOX;
+			}
+			else if (keyword == "cylinder")
+			{
+				node.mesh = NODE_CYLINDER;
+			}
+			else
+			{
+				node.mesh = NODE_SPHERE;
+			}
+			node.parent = FindName(groupNames, parentName);
+			node.material = FindName(materialNames, materialName);
+			node.texture = FindName(textureNames, textureName);
+
+			bValid = (!!values) && (node.parent >= -1) && (node.material >= -1) && (node.texture >= -1);
+			if (bValid == true)
+			{
+				nodes.push_back(node);
+			}
+		}
+		else
+		{
+			bValid = false;
+		}
+
+		if (bValid == false)
+		{
+			std::cout << "Invalid scene description line " << lineNumber
+				<< " of " << textFile << ": " << line << std::endl;
+			return(false);
+		}
+	}
+
+	// the header first, then the record arrays and the strings
+	std::vector<unsigned char> image(sizeof(FILE_HEADER), 0);
+	FILE_HEADER header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, g_FileMagic, sizeof(g_FileMagic));
+	header.version = FILE_VERSION;
+	header.textures = WriteSection(image, textures.data(), textures.size(), sizeof(FILE_TEXTURE));
+	header.materials = WriteSection(image, materials.data(), materials.size(), sizeof(FILE_MATERIAL));
+	header.lights = WriteSection(image, lights.data(), lights.size(), sizeof(FILE_LIGHT));
+	header.nodes = WriteSection(image, nodes.data(), nodes.size(), sizeof(FILE_NODE));
+	header.strings = WriteSection(image, strings.data(), strings.size(), 1);
+	header.fileSize = (uint32_t)image.size();
+	memcpy(image.data(), &header, sizeof(header));
+
+	std::ofstream output(sceneFile, std::ios::binary | std::ios::trunc);
+	if (!output)
+	{
+		std::cout << "Could not create scene file: " << sceneFile << std::endl;
+		return(false);
+	}
+	output.write((const char*)image.data(), (std::streamsize)image.size());
+	if (!output)
+	{
+		std::cout << "Could not write scene file: " << sceneFile << std::endl;
+		return(false);
+	}
+
+	std::cout << "Exported " << nodes.size() << " scene nodes, " << materials.size() << " materials, "
+		<< textures.size() << " textures and " << lights.size() << " lights to " << sceneFile << std::endl;
+
+	return(true);
+}
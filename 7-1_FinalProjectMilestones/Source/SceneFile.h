@@ -0,0 +1,202 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenefile.h
+// ============
+// binary scene description files that are read in place from a mapping
+//
+//  A scene file holds the textures, materials, lights and retained nodes of a
+//  scene as flat arrays of fixed size records, each one starting at a 16 byte
+//  aligned offset named in the file header.  The file is memory mapped and
+//  the records are used where they are, so opening a scene only checks the
+//  header and the indices, whatever the number of nodes.  Tags and paths are
+//  zero terminated strings in a string table, named by their offset in it.
+//  Records name each other by their index in the file - a node its parent,
+//  material and texture - so no tag has to be looked up per node.  Values are
+//  stored little endian, like on every platform the project builds for.
+//
+//  Scene files are written from a text description by ExportText(), where
+//  each line is one texture, material, light, group or drawn object:
+//
+//      texture <tag> <image file>
+//      material <tag> <ambient rgb> <ambient strength> <diffuse rgb>
+//               <specular rgb> <shininess>
+//      directional <direction xyz> <ambient rgb> <diffuse rgb> <specular rgb>
+//      point <position xyz> <ambient rgb> <diffuse rgb> <specular rgb>
+//            [radius]
+//      spot <position xyz> <direction xyz> <cutoff degrees> <outer cutoff
+//           degrees> <ambient rgb> <diffuse rgb> <specular rgb>
+//           <constant linear quadratic attenuation>
+//      group <name> <parent group>
+//      <plane|box|cylinder|sphere> <parent group> <scale xyz> <rotation xyz>
+//           <position xyz> <color rgba> <material> <texture> <UV scale>
+//
+//  A point light with a radius fades out to nothing at that distance and is
+//  shaded by the clustered light pass, one without a radius takes one of the
+//  few point light slots of the light block and lights the whole scene.
+//  A '-' stands for no parent group, material or texture.  Blank lines and
+//  lines starting with '#' are skipped.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MappedFile.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
+/***********************************************************
+ *  SceneFile
+ *
+ *  This class contains the mapping of an opened scene file
+ *  and the exporter that writes scene files.
+ ***********************************************************/
+class SceneFile
+{
+public:
+	// the version written into the header, files of any other
+	// version are rejected
+	static const uint32_t FILE_VERSION = 1;
+
+	// the drawn shape of a node, the same values as
+	// SceneManager::MESH_TYPE
+	enum NODE_MESH
+	{
+		NODE_GROUP,
+		NODE_PLANE,
+		NODE_BOX,
+		NODE_CYLINDER,
+		NODE_SPHERE
+	};
+
+	// the kind of a light record
+	enum LIGHT_TYPE
+	{
+		LIGHT_DIRECTIONAL,
+		LIGHT_POINT,
+		LIGHT_SPOT
+	};
+
+	// the offset from the start of the file and the number of
+	// records of one array
+	struct FILE_SECTION
+	{
+		uint32_t offset;
+		uint32_t count;
+	};
+
+	struct FILE_HEADER
+	{
+		// "SCNB"
+		char magic[4];
+		uint32_t version;
+		// the size of the whole file, to detect truncated files
+		uint32_t fileSize;
+		uint32_t padding;
+		FILE_SECTION textures;
+		FILE_SECTION materials;
+		FILE_SECTION lights;
+		FILE_SECTION nodes;
+		// the count of the string table is its size in bytes
+		FILE_SECTION strings;
+		uint32_t reserved[2];
+	};
+
+	struct FILE_TEXTURE
+	{
+		// string table offsets
+		uint32_t tag;
+		uint32_t path;
+	};
+
+	struct FILE_MATERIAL
+	{
+		glm::vec3 ambientColor;
+		float ambientStrength;
+		glm::vec3 diffuseColor;
+		float shininess;
+		glm::vec3 specularColor;
+		// string table offset
+		uint32_t tag;
+	};
+
+	struct FILE_LIGHT
+	{
+		glm::vec3 position;
+		uint32_t type;
+		glm::vec3 direction;
+		// cosines of the cone angles of a spot light
+		float cutOff;
+		glm::vec3 ambient;
+		float outerCutOff;
+		glm::vec3 diffuse;
+		float constant;
+		glm::vec3 specular;
+		float linear;
+		float quadratic;
+		// range of a clustered point light, 0 for a point light
+		// of the light block
+		float radius;
+		float padding[2];
+	};
+
+	struct FILE_NODE
+	{
+		glm::vec3 scaleXYZ;
+		// index of the parent node, or -1 for a root node - a
+		// parent always precedes its children
+		int32_t parent;
+		glm::vec3 rotationDegrees;
+		uint32_t mesh;
+		glm::vec3 positionXYZ;
+		// index of the material record, or -1
+		int32_t material;
+		glm::vec4 color;
+		glm::vec2 UVscale;
+		// index of the texture record, or -1
+		int32_t texture;
+		uint32_t padding;
+	};
+
+	// constructor
+	SceneFile();
+
+	// map a scene file and check its header and indices
+	bool Open(const char* filename);
+	// unmap the file, the record pointers are invalid afterwards
+	void Close();
+
+	// the record arrays, used in place from the mapping
+	int GetTextureCount() const { return(m_textureCount); }
+	const FILE_TEXTURE* GetTextures() const { return(m_textures); }
+	int GetMaterialCount() const { return(m_materialCount); }
+	const FILE_MATERIAL* GetMaterials() const { return(m_materials); }
+	int GetLightCount() const { return(m_lightCount); }
+	const FILE_LIGHT* GetLights() const { return(m_lights); }
+	int GetNodeCount() const { return(m_nodeCount); }
+	const FILE_NODE* GetNodes() const { return(m_nodes); }
+
+	// a string of the string table
+	const char* GetString(uint32_t offset) const;
+
+	// convert a text scene description into a scene file
+	static bool ExportText(const char* textFile, const char* sceneFile);
+
+private:
+	MappedFile m_file;
+	// the arrays inside the mapping, NULL when they are empty
+	const FILE_TEXTURE* m_textures;
+	const FILE_MATERIAL* m_materials;
+	const FILE_LIGHT* m_lights;
+	const FILE_NODE* m_nodes;
+	const char* m_strings;
+	int m_textureCount;
+	int m_materialCount;
+	int m_lightCount;
+	int m_nodeCount;
+	uint32_t m_stringBytes;
+
+	// check that an array lies aligned inside the file
+	bool IsSectionValid(const FILE_SECTION& section, size_t recordSize) const;
+	// check the references between the records
+	bool AreIndicesValid() const;
+};
@@ -23,6 +23,7 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "SceneManager.h"
+#include "ProgramBuilder.h"
 
 #ifndef STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
@@ -32,25 +33,211 @@
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/transform.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <utility>
+
 // declaration of global variables
 namespace
 {
 	const char* g_ModelName = "model";
 	const char* g_ColorValueName = "objectColor";
 	const char* g_TextureValueName = "objectTexture";
+	const char* g_TextureArrayName = "objectTextureArray";
+	const char* g_TextureLayerName = "textureLayer";
+	const char* g_UseTextureArrayName = "bUseTextureArray";
+	const char* g_UVScaleName = "UVscale";
 	const char* g_UseTextureName = "bUseTexture";
 	const char* g_UseLightingName = "bUseLighting";
+	const char* g_UseInstancingName = "bUseInstancing";
+	const char* g_UseMaterialIndexName = "bUseMaterialIndex";
+	const char* g_UseDrawRecordsName = "bUseDrawRecords";
+	const char* g_DrawIndexName = "drawIndex";
+	const char* g_MaterialDiffuseName = "material.diffuseColor";
+	const char* g_MaterialSpecularName = "material.specularColor";
+	const char* g_MaterialShininessName = "material.shininess";
+	const char* g_UseLightClustersName = "bUseLightClusters";
+	const char* g_ClusterLightsName = "clusterLights";
+	const char* g_ClusterEntriesName = "clusterEntries";
+	const char* g_ClusterParametersName = "clusterParameters";
+	const char* g_UseCascadeShadowsName = "bUseCascadeShadows";
+	const char* g_CascadeShadowMapName = "cascadeShadowMap";
+	const char* g_CascadeMatrixNames[ShadowMaps::CASCADE_COUNT] =
+		{ "cascadeMatrices[0]", "cascadeMatrices[1]", "cascadeMatrices[2]" };
+	const char* g_CascadeSplitsName = "cascadeSplits";
+	const char* g_PointShadowMapName = "pointShadowMap";
+	const char* g_PointShadowParametersName = "pointShadowParameters";
+	const char* g_PointShadowMaskName = "pointShadowMask";
+
+	// footprint of one scene grid cell - the size of the floor
+	const float SCENE_CELL_WIDTH = 50.0f;
+	const float SCENE_CELL_DEPTH = 30.0f;
+
+	// the compute shader of the GPU culling pass
+	const char* g_CullShaderFile = "shaders/cullCompute.glsl";
+	// the compute shader that builds the occluder depth pyramid
+	const char* g_HiZShaderFile = "shaders/hizBuild.glsl";
+	// planes and boxes with at least two sides this long are
+	// drawn as occluders - walls, floors and table tops
+	const float g_OccluderMinSize = 4.0f;
+
+	// the compute shader that bins the clustered point lights
+	const char* g_LightClusterShaderFile = "shaders/lightCluster.glsl";
+	// the height of the generated ceiling lights, and their radius
+	// as a multiple of the distance between them so the lights of
+	// neighbouring cells overlap
+	const float g_CeilingLightHeight = 14.0f;
+	const float g_CeilingLightRange = 1.5f;
+
+	// the depth only program the shadow casters are drawn with
+	const char* g_ShadowVertexShaderFile = "shaders/shadowVertex.glsl";
+	const char* g_ShadowFragmentShaderFile = "shaders/shadowFragment.glsl";
+
+	// the fraction of the screen height below which the curved
+	// meshes switch to their next coarser level of detail
+	const float g_LodScreenSizes[InstancedMeshes::LOD_COUNT - 1] = { 0.12f, 0.04f };
+	// the default fraction of those sizes for the hysteresis
+	const float g_DefaultLodHysteresis = 0.15f;
+
+	// the fewest items a job of the parallel scene loops handles,
+	// so small scenes are not split into more jobs than work
+	const int g_MinJobObjects = 256;
+	const int g_MinJobRuns = 16;
+	// the starting size of the frame arena in bytes, it grows to
+	// fit the largest frame
+	const size_t g_FrameArenaBytes = 1024 * 1024;
+
+	// how often the watched files are checked for changes, in
+	// milliseconds
+	const int g_HotReloadInterval = 250;
 }
 
+// the nodes of a scene file are cast straight to the mesh types
+static_assert((int)SceneFile::NODE_GROUP == (int)SceneManager::MESH_NONE, "scene file mesh values");
+static_assert((int)SceneFile::NODE_SPHERE == (int)SceneManager::MESH_SPHERE, "scene file mesh values");
+
 /***********************************************************
  *  SceneManager()
  *
  *  The constructor for the class
  ***********************************************************/
-SceneManager::SceneManager(ShaderManager *pShaderManager)
+SceneManager::SceneManager(
+	ShaderManager *pShaderManager,
+	UniformCache* pUniformCache,
+	UniformBuffers* pUniformBuffers)
 {
 	m_pShaderManager = pShaderManager;
+	m_pUniformCache = pUniformCache;
+	m_pUniformBuffers = pUniformBuffers;
 	m_basicMeshes = new ShapeMeshes();
+	m_instancedMeshes = new InstancedMeshes();
+	m_textureLoader = new TextureLoader();
+	m_textureStorage = new TextureStorage();
+	m_frameArena = new FrameArena();
+	m_frameArena->Reserve(g_FrameArenaBytes);
+	m_dirtyObjects = NULL;
+	m_dirtyMatrices = NULL;
+	m_sortRuns = NULL;
+	m_bSceneDirty = false;
+	m_gridColumns = 1;
+	m_gridRows = 1;
+	m_bBVHDirty = false;
+	m_bBoundsDirty = false;
+	m_cullViewProjection = glm::mat4(0.0f);
+	m_bVisibilityDirty = true;
+	m_bUseCulling = true;
+	m_bUseLod = true;
+	m_lodHysteresis = g_DefaultLodHysteresis;
+	m_lodViewProjection = glm::mat4(0.0f);
+	m_bInstancesDirty = false;
+	m_bDrawQueueDirty = false;
+	m_bUseInstancing = true;
+	m_drawRing = NULL;
+	m_jobSystem = NULL;
+	m_jobThreadCount = 0;
+	m_fileWatcher = NULL;
+	m_sceneFileNodes = 0;
+	m_gpuCulling = NULL;
+	m_bUseGpuCulling = true;
+	m_hiZBuffer = NULL;
+	m_bUseOcclusion = true;
+	m_lightClusters = NULL;
+	m_bUseLightClusters = true;
+	m_bClusterLightsDirty = false;
+	m_clusterLightUnit = -1;
+	m_clusterEntryUnit = -1;
+	m_bDrawLightClusters = false;
+	m_ceilingLightCount = 0;
+	m_shaderVariants = NULL;
+	m_bUseShaderVariants = true;
+	m_drawPrograms[0] = 0;
+	m_drawPrograms[1] = 0;
+	m_depthProgram = 0;
+	m_renderMode = RENDER_FORWARD;
+	m_bDrawingDepth = false;
+	m_shadowMaps = NULL;
+	m_bUseShadows = true;
+	m_shadowMeshes = NULL;
+	m_firstDynamicInstance = 0;
+	m_bShadowCastersDirty = false;
+	m_bDynamicCastersMoved = false;
+	m_bStaticShadowsBuilt = false;
+	m_shadowSceneMin = glm::vec3(0.0f);
+	m_shadowSceneMax = glm::vec3(0.0f);
+	m_bCascadesCached = false;
+	m_pointShadowCached = 0;
+	for (int i = 0; i < TOTAL_POINT_LIGHTS; i++)
+	{
+		m_pointShadowPositions[i] = glm::vec3(0.0f);
+	}
+	m_bCascadeShadows = false;
+	m_pointShadowMask = 0;
+	m_cascadeShadowUnit = -1;
+	m_pointShadowUnit = -1;
+	m_residentTextures = 0;
+	m_overflowTextureUnit = -1;
+	m_overflowTextureSlot = -1;
+	m_arrayTextureUnit = -1;
+	m_bUseTextureArrays = false;
+	m_bTextureArraysDirty = false;
+	m_drawCallCount = 0;
+	m_stateChangeCount = 0;
+	ResetRenderState();
+
+	// resolve the uniform names once - rendering only uses the handles
+	m_uniforms.model = m_pUniformCache->GetHandle(g_ModelName);
+	m_uniforms.objectColor = m_pUniformCache->GetHandle(g_ColorValueName);
+	m_uniforms.objectTexture = m_pUniformCache->GetHandle(g_TextureValueName);
+	m_uniforms.objectTextureArray = m_pUniformCache->GetHandle(g_TextureArrayName);
+	m_uniforms.textureLayer = m_pUniformCache->GetHandle(g_TextureLayerName);
+	m_uniforms.bUseTextureArray = m_pUniformCache->GetHandle(g_UseTextureArrayName);
+	m_uniforms.UVscale = m_pUniformCache->GetHandle(g_UVScaleName);
+	m_uniforms.bUseTexture = m_pUniformCache->GetHandle(g_UseTextureName);
+	m_uniforms.bUseLighting = m_pUniformCache->GetHandle(g_UseLightingName);
+	m_uniforms.bUseInstancing = m_pUniformCache->GetHandle(g_UseInstancingName);
+	m_uniforms.bUseMaterialIndex = m_pUniformCache->GetHandle(g_UseMaterialIndexName);
+	m_uniforms.bUseDrawRecords = m_pUniformCache->GetHandle(g_UseDrawRecordsName);
+	m_uniforms.drawIndex = m_pUniformCache->GetHandle(g_DrawIndexName);
+	m_uniforms.materialDiffuseColor = m_pUniformCache->GetHandle(g_MaterialDiffuseName);
+	m_uniforms.materialSpecularColor = m_pUniformCache->GetHandle(g_MaterialSpecularName);
+	m_uniforms.materialShininess = m_pUniformCache->GetHandle(g_MaterialShininessName);
+	m_uniforms.bUseLightClusters = m_pUniformCache->GetHandle(g_UseLightClustersName);
+	m_uniforms.clusterLights = m_pUniformCache->GetHandle(g_ClusterLightsName);
+	m_uniforms.clusterEntries = m_pUniformCache->GetHandle(g_ClusterEntriesName);
+	m_uniforms.clusterParameters = m_pUniformCache->GetHandle(g_ClusterParametersName);
+	m_uniforms.bUseCascadeShadows = m_pUniformCache->GetHandle(g_UseCascadeShadowsName);
+	m_uniforms.cascadeShadowMap = m_pUniformCache->GetHandle(g_CascadeShadowMapName);
+	for (int c = 0; c < ShadowMaps::CASCADE_COUNT; c++)
+	{
+		m_uniforms.cascadeMatrices[c] = m_pUniformCache->GetHandle(g_CascadeMatrixNames[c]);
+	}
+	m_uniforms.cascadeSplits = m_pUniformCache->GetHandle(g_CascadeSplitsName);
+	m_uniforms.pointShadowMap = m_pUniformCache->GetHandle(g_PointShadowMapName);
+	m_uniforms.pointShadowParameters = m_pUniformCache->GetHandle(g_PointShadowParametersName);
+	m_uniforms.pointShadowMask = m_pUniformCache->GetHandle(g_PointShadowMaskName);
 }
 
 /***********************************************************
@@ -61,8 +248,36 @@ SceneManager::SceneManager(ShaderManager *pShaderManager)
 SceneManager::~SceneManager()
 {
 	m_pShaderManager = NULL;
+	m_pUniformCache = NULL;
+	m_pUniformBuffers = NULL;
 	delete m_basicMeshes;
 	m_basicMeshes = NULL;
+	delete m_instancedMeshes;
+	m_instancedMeshes = NULL;
+	delete m_textureLoader;
+	m_textureLoader = NULL;
+	delete m_textureStorage;
+	m_textureStorage = NULL;
+	delete m_frameArena;
+	m_frameArena = NULL;
+	delete m_shaderVariants;
+	m_shaderVariants = NULL;
+	delete m_shadowMaps;
+	m_shadowMaps = NULL;
+	delete m_shadowMeshes;
+	m_shadowMeshes = NULL;
+	delete m_lightClusters;
+	m_lightClusters = NULL;
+	delete m_hiZBuffer;
+	m_hiZBuffer = NULL;
+	delete m_gpuCulling;
+	m_gpuCulling = NULL;
+	delete m_drawRing;
+	m_drawRing = NULL;
+	delete m_jobSystem;
+	m_jobSystem = NULL;
+	delete m_fileWatcher;
+	m_fileWatcher = NULL;
 }
 
 /***********************************************************
@@ -71,15 +286,34 @@ SceneManager::~SceneManager()
  *  This method is used for loading textures from image files,
  *  configuring the texture mapping parameters in OpenGL,
  *  generating the mipmaps, and loading the read texture into
- *  the next available texture slot in memory.
+ *  the next available texture slot in memory.  A current
+ *  compressed cache file of the image is loaded instead
+ *  when the driver supports it.
  ***********************************************************/
-bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
+bool SceneManager::CreateGLTexture(const char* filename, std::string_view tag)
 {
 	int width = 0;
 	int height = 0;
 	int colorChannels = 0;
 	GLuint textureID = 0;
 
+	// the cache holds the compressed mipmaps, so no decoding and
+	// no mipmap generation is needed
+	if ((TextureCache::IsSupported() == true) &&
+		(TextureCache::IsCacheCurrent(filename) == true))
+	{
+		TextureCache::COMPRESSED_TEXTURE compressed;
+		std::string cacheFile = TextureCache::GetCachePath(filename);
+
+		if (TextureCache::ReadFile(cacheFile.c_str(), compressed) == true)
+		{
+			textureID = TextureCache::CreateGLTexture(compressed, compressed.data.data());
+			std::cout << "Successfully loaded cached texture:" << cacheFile << ", width:" << compressed.width << ", height:" << compressed.height << std::endl;
+			RegisterGLTexture(textureID, filename, tag);
+			return true;
+		}
+	}
+
 	// indicate to always flip images vertically when loaded
 	stbi_set_flip_vertically_on_load(true);
 
@@ -96,28 +330,45 @@ bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
 	{
 		std::cout << "Successfully loaded image:" << filename << ", width:" << width << ", height:" << height << ", channels:" << colorChannels << std::endl;
 
-		glGenTextures(1, &textureID);
-		glBindTexture(GL_TEXTURE_2D, textureID);
-
-		// set the texture wrapping parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		// set texture filtering parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		GLenum internalFormat = GL_RGB8;
+		GLenum pixelFormat = GL_RGB;
 
 		// if the loaded image is in RGB format
 		if (colorChannels == 3)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
+		{
+			internalFormat = GL_RGB8;
+			pixelFormat = GL_RGB;
+		}
 		// if the loaded image is in RGBA format - it supports transparency
 		else if (colorChannels == 4)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
+		{
+			internalFormat = GL_RGBA8;
+			pixelFormat = GL_RGBA;
+		}
 		else
 		{
 			std::cout << "Not implemented to handle image with " << colorChannels << " channels" << std::endl;
+			stbi_image_free(image);
 			return false;
 		}
 
+		// allocate immutable storage for the whole mipmap chain
+		textureID = TextureStorage::CreateTexture2D(internalFormat, width, height,
+			TextureStorage::GetMipLevelCount(width, height));
+
+		// set the texture wrapping parameters
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		// set texture filtering parameters - minified textures blend
+		// between the generated mipmap levels
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		// rows of RGB images are not always four byte aligned
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, pixelFormat, GL_UNSIGNED_BYTE, image);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
 		// generate the texture mipmaps for mapping textures to lower resolutions
 		glGenerateMipmap(GL_TEXTURE_2D);
 
@@ -126,9 +377,7 @@ bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
 		glBindTexture(GL_TEXTURE_2D, 0); // Unbind the texture
 
 		// register the loaded texture and associate it with the special tag string
-		m_textureIDs[m_loadedTextures].ID = textureID;
-		m_textureIDs[m_loadedTextures].tag = tag;
-		m_loadedTextures++;
+		RegisterGLTexture(textureID, filename, tag);
 
 		return true;
 	}
@@ -139,15 +388,166 @@ bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
 	return false;
 }
 
+/***********************************************************
+ *  RegisterGLTexture()
+ *
+ *  This method is used for associating a created texture
+ *  with its tag.  A texture loaded again under the same tag
+ *  replaces the earlier one in the same texture slot.
+ ***********************************************************/
+void SceneManager::RegisterGLTexture(GLuint textureID, const char* filename, std::string_view tag)
+{
+	int textureSlot = m_textureTags.Intern(tag);
+	if (textureSlot < (int)m_textureIDs.size())
+	{
+		if ((NULL == m_textureLoader) ||
+			(m_textureIDs[textureSlot].ID != m_textureLoader->GetPlaceholderID()))
+		{
+			glDeleteTextures(1, &m_textureIDs[textureSlot].ID);
+		}
+	}
+	else
+	{
+		m_textureIDs.resize(textureSlot + 1);
+	}
+	m_textureIDs[textureSlot].ID = textureID;
+	m_textureIDs[textureSlot].tag = std::string(tag);
+	m_textureIDs[textureSlot].filename = filename;
+	m_bTextureArraysDirty = true;
+}
+
+/***********************************************************
+ *  LoadGLTextureAsync()
+ *
+ *  This method is used for queueing a texture image file to
+ *  be decoded on a worker thread.  The tag gets its texture
+ *  slot right away, and the slot shows a placeholder texture
+ *  until UpdateGLTextures() swaps in the loaded texture.
+ ***********************************************************/
+bool SceneManager::LoadGLTextureAsync(const char* filename, std::string_view tag)
+{
+	if ((NULL == filename) || (NULL == m_textureLoader))
+	{
+		return(false);
+	}
+
+	int textureSlot = m_textureTags.Intern(tag);
+	if (textureSlot >= (int)m_textureIDs.size())
+	{
+		// a texture loaded again under the same tag keeps showing the
+		// earlier texture until the new one is ready
+		m_textureIDs.resize(textureSlot + 1);
+		m_textureIDs[textureSlot].ID = m_textureLoader->GetPlaceholderID();
+		m_textureIDs[textureSlot].tag = std::string(tag);
+	}
+	m_textureIDs[textureSlot].filename = filename;
+
+	m_textureLoader->QueueTexture(filename, textureSlot);
+
+	return(true);
+}
+
+/***********************************************************
+ *  UpdateGLTextures()
+ *
+ *  This method is used for replacing the placeholders of the
+ *  texture slots whose images finished loading, and binding
+ *  the new textures to their texture units.
+ ***********************************************************/
+void SceneManager::UpdateGLTextures()
+{
+	// the number of textures uploaded per frame, to keep a burst
+	// of finished loads from stalling a single frame
+	const int maxUploadsPerFrame = 2;
+	std::vector<TextureLoader::LOADED_TEXTURE> loaded;
+
+	if ((NULL != m_textureLoader) && (m_textureLoader->IsIdle() == false))
+	{
+		m_textureLoader->UploadDecodedTextures(loaded, maxUploadsPerFrame);
+	}
+
+	for (size_t i = 0; i < loaded.size(); i++)
+	{
+		int textureSlot = loaded[i].textureSlot;
+		TEXTURE_INFO& texture = m_textureIDs[textureSlot];
+
+		if (texture.ID != m_textureLoader->GetPlaceholderID())
+		{
+			glDeleteTextures(1, &texture.ID);
+		}
+		texture.ID = loaded[i].textureID;
+
+		if (textureSlot < m_residentTextures)
+		{
+			glActiveTexture(GL_TEXTURE0 + textureSlot);
+			glBindTexture(GL_TEXTURE_2D, texture.ID);
+		}
+		else if (textureSlot == m_overflowTextureSlot)
+		{
+			// force the overflow unit to be bound again
+			m_overflowTextureSlot = -1;
+		}
+		m_bTextureArraysDirty = true;
+	}
+
+	// the arrays are built once every queued texture is loaded
+	if ((m_bTextureArraysDirty == true) &&
+		((NULL == m_textureLoader) || (m_textureLoader->IsIdle() == true)))
+	{
+		BuildTextureArrays();
+	}
+}
+
 /***********************************************************
  *  BindGLTextures()
  *
  *  This method is used for binding the loaded textures to
- *  OpenGL texture memory slots.  There are up to 16 slots.
+ *  OpenGL texture memory slots.  The last unit is reserved
+ *  for the texture arrays.  When there are more loaded
+ *  textures than the other units, the unit before it is kept
+ *  free and the remaining textures are bound to it on demand.
  ***********************************************************/
 void SceneManager::BindGLTextures()
 {
-	for (int i = 0; i < m_loadedTextures; i++)
+	GLint textureUnits = 0;
+	int loadedTextures = (int)m_textureIDs.size();
+
+	glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &textureUnits);
+
+	// a sampler2D and a sampler2DArray may never read the same
+	// unit, so the array sampler gets a unit of its own
+	m_arrayTextureUnit = textureUnits - 1;
+	textureUnits--;
+	if (NULL != m_pUniformCache)
+	{
+		m_pUniformCache->SetSampler2D(m_uniforms.objectTextureArray, m_arrayTextureUnit);
+	}
+	// and neither may the buffer samplers of the clustered lights,
+	// which are set with the clusters every frame
+	m_clusterLightUnit = textureUnits - 1;
+	m_clusterEntryUnit = textureUnits - 2;
+	textureUnits -= 2;
+	// and neither may the shadow samplers, which also compare
+	m_cascadeShadowUnit = textureUnits - 1;
+	m_pointShadowUnit = textureUnits - 2;
+	textureUnits -= 2;
+
+	if (loadedTextures <= textureUnits)
+	{
+		m_residentTextures = loadedTextures;
+		m_overflowTextureUnit = -1;
+	}
+	else
+	{
+		m_residentTextures = textureUnits - 1;
+		m_overflowTextureUnit = textureUnits - 1;
+		std::cout << loadedTextures << " textures loaded for " << textureUnits
+			<< " texture units, " << (loadedTextures - m_residentTextures)
+			<< " are bound on demand" << std::endl;
+	}
+	m_overflowTextureSlot = -1;
+
+	for (int i = 0; i < m_residentTextures; i++)
 	{
 		// bind textures on corresponding texture units
 		glActiveTexture(GL_TEXTURE0 + i);
@@ -163,10 +563,21 @@ void SceneManager::BindGLTextures()
  ***********************************************************/
 void SceneManager::DestroyGLTextures()
 {
-	for (int i = 0; i < m_loadedTextures; i++)
+	for (size_t i = 0; i < m_textureIDs.size(); i++)
 	{
-		glGenTextures(1, &m_textureIDs[i].ID);
+		// the placeholder belongs to the texture loader
+		if ((NULL != m_textureLoader) &&
+			(m_textureIDs[i].ID == m_textureLoader->GetPlaceholderID()))
+		{
+			continue;
+		}
+		glDeleteTextures(1, &m_textureIDs[i].ID);
 	}
+	m_textureIDs.clear();
+	m_textureTags.Clear();
+	m_residentTextures = 0;
+	m_overflowTextureUnit = -1;
+	m_overflowTextureSlot = -1;
 }
 
 /***********************************************************
@@ -175,24 +586,15 @@ void SceneManager::DestroyGLTextures()
  *  This method is used for getting an ID for the previously
  *  loaded texture bitmap associated with the passed in tag.
  ***********************************************************/
-int SceneManager::FindTextureID(std::string tag)
+int SceneManager::FindTextureID(std::string_view tag) const
 {
-	int textureID = -1;
-	int index = 0;
-	bool bFound = false;
-
-	while ((index < m_loadedTextures) && (bFound == false))
+	int textureSlot = m_textureTags.Find(tag);
+	if (textureSlot < 0)
 	{
-		if (m_textureIDs[index].tag.compare(tag) == 0)
-		{
-			textureID = m_textureIDs[index].ID;
-			bFound = true;
-		}
-		else
-			index++;
+		return(-1);
 	}
 
-	return(textureID);
+	return(m_textureIDs[textureSlot].ID);
 }
 
 /***********************************************************
@@ -201,178 +603,3047 @@ int SceneManager::FindTextureID(std::string tag)
  *  This method is used for getting a slot index for the previously
  *  loaded texture bitmap associated with the passed in tag.
  ***********************************************************/
-int SceneManager::FindTextureSlot(std::string tag)
+int SceneManager::FindTextureSlot(std::string_view tag) const
 {
-	int textureSlot = -1;
-	int index = 0;
-	bool bFound = false;
+	return(m_textureTags.Find(tag));
+}
+
+/***********************************************************
+ *  BindTextureSlot()
+ *
+ *  This method is used for getting the texture unit that
+ *  holds a texture slot.  A slot without a unit of its own
+ *  is bound to the overflow unit first.
+ ***********************************************************/
+int SceneManager::BindTextureSlot(int textureSlot)
+{
+	if ((textureSlot < 0) || (textureSlot >= (int)m_textureIDs.size()))
+	{
+		return(-1);
+	}
+
+	if ((textureSlot < m_residentTextures) || (m_overflowTextureUnit < 0))
+	{
+		return(textureSlot);
+	}
+
+	if (textureSlot != m_overflowTextureSlot)
+	{
+		glActiveTexture(GL_TEXTURE0 + m_overflowTextureUnit);
+		glBindTexture(GL_TEXTURE_2D, m_textureIDs[textureSlot].ID);
+		m_overflowTextureSlot = textureSlot;
+	}
+
+	return(m_overflowTextureUnit);
+}
+
+/***********************************************************
+ *  BuildTextureArrays()
+ *
+ *  This method is used for copying the loaded textures into
+ *  texture arrays.  When every texture fits in an array, the
+ *  textured objects sample the arrays by layer and objects
+ *  with different textures share instanced draw batches.
+ *  Otherwise the textures stay bound one per unit.
+ ***********************************************************/
+void SceneManager::BuildTextureArrays()
+{
+	std::vector<GLuint> textureIDs;
+	bool bUseTextureArrays = false;
+
+	m_bTextureArraysDirty = false;
+
+	for (size_t i = 0; i < m_textureIDs.size(); i++)
+	{
+		textureIDs.push_back(m_textureIDs[i].ID);
+	}
+
+	// the single textures are kept, they are the source of the
+	// arrays when a texture is loaded again
+	if ((NULL != m_textureStorage) && (m_arrayTextureUnit >= 0))
+	{
+		bUseTextureArrays = m_textureStorage->BuildArrays(textureIDs);
+	}
+
+	if (bUseTextureArrays != m_bUseTextureArrays)
+	{
+		// the sort order of the draws depends on the texture bindings
+		m_bDrawQueueDirty = true;
+	}
+	m_bUseTextureArrays = bUseTextureArrays;
+	m_bInstancesDirty = true;
+
+	if (NULL != m_pUniformCache)
+	{
+		m_pUniformCache->SetBool(m_uniforms.bUseTextureArray, m_bUseTextureArrays);
+	}
+	ResetRenderState();
+}
+
+/***********************************************************
+ *  GetTextureBinding()
+ *
+ *  This method is used for getting the texture binding that
+ *  a texture slot is drawn with - the texture array that
+ *  holds it when arrays are used, otherwise the slot itself.
+ ***********************************************************/
+int SceneManager::GetTextureBinding(int textureSlot) const
+{
+	if (textureSlot < 0)
+	{
+		return(-1);
+	}
+
+	if (m_bUseTextureArrays == true)
+	{
+		return(m_textureStorage->GetArrayIndex(textureSlot));
+	}
+
+	return(textureSlot);
+}
+
+/***********************************************************
+ *  AddObjectMaterial()
+ *
+ *  This method is used for adding a material to the defined
+ *  materials list.  A material with a tag that is already
+ *  defined replaces the earlier one.  Returns the material ID.
+ ***********************************************************/
+int SceneManager::AddObjectMaterial(const OBJECT_MATERIAL& material)
+{
+	int materialIndex = m_materialTags.Intern(material.tag);
+
+	if (materialIndex < (int)m_objectMaterials.size())
+	{
+		m_objectMaterials[materialIndex] = material;
+	}
+	else
+	{
+		m_objectMaterials.push_back(material);
+	}
+
+	return(materialIndex);
+}
+
+/***********************************************************
+ *  FindMaterial()
+ *
+ *  This method is used for getting a material from the previously
+ *  defined materials list that is associated with the passed in tag.
+ *  Returns false when the tag is not defined.
+ ***********************************************************/
+bool SceneManager::FindMaterial(std::string_view tag, OBJECT_MATERIAL& material) const
+{
+	int materialIndex = m_materialTags.Find(tag);
+	if (materialIndex < 0)
+	{
+		return(false);
+	}
+
+	material.diffuseColor = m_objectMaterials[materialIndex].diffuseColor;
+	material.specularColor = m_objectMaterials[materialIndex].specularColor;
+	material.shininess = m_objectMaterials[materialIndex].shininess;
+
+	return(true);
+}
+
+/***********************************************************
+ *  FindMaterialIndex()
+ *
+ *  This method is used for getting the index of a previously
+ *  defined material, or -1 when the tag is not defined.
+ ***********************************************************/
+int SceneManager::FindMaterialIndex(std::string_view tag) const
+{
+	return(m_materialTags.Find(tag));
+}
+
+/***********************************************************
+ *  SetTransformations()
+ *
+ *  This method is used for setting the transform buffer
+ *  using the passed in transformation values.
+ ***********************************************************/
+void SceneManager::SetTransformations(
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	// variables for this method
+	glm::mat4 modelView;
+
+	modelView = CalculateModelMatrix(
+		scaleXYZ,
+		XrotationDegrees,
+		YrotationDegrees,
+		ZrotationDegrees,
+		positionXYZ);
+
+	if (NULL != m_pUniformCache)
+	{
+		m_pUniformCache->SetMat4(m_uniforms.model, modelView);
+	}
+}
+
+/***********************************************************
+ *  CalculateModelMatrix()
+ *
+ *  This method is used for building the model matrix from
+ *  the passed in transformation values - translation *
+ *  rotationZ * rotationY * rotationX * scale, written out
+ *  directly instead of multiplying the five matrices.
+ ***********************************************************/
+glm::mat4 SceneManager::CalculateModelMatrix(
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	return(TransformBatch::ComposeMatrix(
+		scaleXYZ,
+		glm::vec3(XrotationDegrees, YrotationDegrees, ZrotationDegrees),
+		positionXYZ,
+		NULL));
+}
+
+/***********************************************************
+ *  SetShaderColor()
+ *
+ *  This method is used for setting the passed in color
+ *  into the shader for the next draw command
+ ***********************************************************/
+void SceneManager::SetShaderColor(
+	float redColorValue,
+	float greenColorValue,
+	float blueColorValue,
+	float alphaValue)
+{
+	// variables for this method
+	glm::vec4 currentColor;
+
+	currentColor.r = redColorValue;
+	currentColor.g = greenColorValue;
+	currentColor.b = blueColorValue;
+	currentColor.a = alphaValue;
+
+	if (NULL != m_pUniformCache)
+	{
+		m_pUniformCache->SetBool(m_uniforms.bUseTexture, false);
+		m_pUniformCache->SetVec4(m_uniforms.objectColor, currentColor);
+	}
+}
 
-	while ((index < m_loadedTextures) && (bFound == false))
+/***********************************************************
+ *  SetShaderTexture()
+ *
+ *  This method is used for setting the texture data
+ *  associated with the passed in ID into the shader.
+ ***********************************************************/
+void SceneManager::SetShaderTexture(
+	std::string_view textureTag)
+{
+	if (NULL != m_pUniformCache)
 	{
-		if (m_textureIDs[index].tag.compare(tag) == 0)
+		m_pUniformCache->SetBool(m_uniforms.bUseTexture, true);
+
+		int textureSlot = FindTextureSlot(textureTag);
+		if (m_bUseTextureArrays == true)
 		{
-			textureSlot = index;
-			bFound = true;
+			glActiveTexture(GL_TEXTURE0 + m_arrayTextureUnit);
+			glBindTexture(GL_TEXTURE_2D_ARRAY,
+				m_textureStorage->GetArrayID(m_textureStorage->GetArrayIndex(textureSlot)));
+			m_pUniformCache->SetFloat(m_uniforms.textureLayer, (float)m_textureStorage->GetLayer(textureSlot));
+			ResetRenderState();
 		}
 		else
-			index++;
+		{
+			int textureUnit = -1;
+			textureUnit = BindTextureSlot(textureSlot);
+			m_pUniformCache->SetSampler2D(m_uniforms.objectTexture, textureUnit);
+		}
+	}
+}
+
+/***********************************************************
+ *  SetTextureUVScale()
+ *
+ *  This method is used for setting the texture UV scale
+ *  values into the shader.
+ ***********************************************************/
+void SceneManager::SetTextureUVScale(float u, float v)
+{
+	if (NULL != m_pUniformCache)
+	{
+		m_pUniformCache->SetVec2(m_uniforms.UVscale, glm::vec2(u, v));
+	}
+}
+
+/***********************************************************
+ *  SetShaderMaterial()
+ *
+ *  This method is used for passing the material values
+ *  into the shader.
+ ***********************************************************/
+void SceneManager::SetShaderMaterial(
+	std::string_view materialTag)
+{
+	if (m_objectMaterials.size() > 0)
+	{
+		OBJECT_MATERIAL material;
+		bool bReturn = false;
+
+		bReturn = FindMaterial(materialTag, material);
+		if (bReturn == true)
+		{
+			SetShaderMaterial(material);
+		}
+		else
+		{
+			std::cout << "Material is not defined:" << materialTag << std::endl;
+		}
+	}
+}
+
+/***********************************************************
+ *  SetShaderMaterial()
+ *
+ *  This method is used for passing the values of an already
+ *  resolved material into the shader.
+ ***********************************************************/
+void SceneManager::SetShaderMaterial(
+	const OBJECT_MATERIAL& material)
+{
+	if (NULL != m_pUniformCache)
+	{
+		m_pUniformCache->SetVec3(m_uniforms.materialDiffuseColor, material.diffuseColor);
+		m_pUniformCache->SetVec3(m_uniforms.materialSpecularColor, material.specularColor);
+		m_pUniformCache->SetFloat(m_uniforms.materialShininess, material.shininess);
+	}
+}
+
+/***********************************************************
+ *  AddSceneGroup()
+ *
+ *  This method is used for adding a group node to the
+ *  retained scene.  Group nodes are never drawn, they only
+ *  carry a transformation that is applied to their children.
+ ***********************************************************/
+int SceneManager::AddSceneGroup(int parent)
+{
+	return(AddSceneObject(
+		parent,
+		MESH_NONE,
+		glm::vec3(1.0f, 1.0f, 1.0f),
+		glm::vec3(0.0f, 0.0f, 0.0f),
+		glm::vec3(0.0f, 0.0f, 0.0f),
+		glm::vec4(1.0f, 1.0f, 1.0f, 1.0f),
+		NULL, NULL,
+		glm::vec2(1.0f, 1.0f)));
+}
+
+/***********************************************************
+ *  AddSceneObject()
+ *
+ *  This method is used for adding a drawn node to the
+ *  retained scene.  The material and texture tags are
+ *  resolved here once so that rendering never has to
+ *  search for them.  Returns the index of the new node.
+ ***********************************************************/
+int SceneManager::AddSceneObject(
+	int parent,
+	MESH_TYPE mesh,
+	glm::vec3 scaleXYZ,
+	glm::vec3 rotationDegrees,
+	glm::vec3 positionXYZ,
+	glm::vec4 color,
+	const char* materialTag,
+	const char* textureTag,
+	glm::vec2 UVscale)
+{
+	int materialIndex = -1;
+	int textureSlot = -1;
+
+	if (NULL != materialTag)
+	{
+		materialIndex = FindMaterialIndex(materialTag);
+		if (materialIndex < 0)
+		{
+			std::cout << "Scene object uses undefined material:" << materialTag << std::endl;
+		}
+	}
+	if (NULL != textureTag)
+	{
+		textureSlot = FindTextureSlot(textureTag);
+		if (textureSlot < 0)
+		{
+			std::cout << "Scene object uses unloaded texture:" << textureTag << std::endl;
+		}
+	}
+
+	return(AddSceneNode(parent, mesh, scaleXYZ, rotationDegrees, positionXYZ,
+		color, materialIndex, textureSlot, UVscale));
+}
+
+/***********************************************************
+ *  AddSceneNode()
+ *
+ *  This method is used for adding a node to the retained
+ *  scene with the material index and texture slot given
+ *  directly, -1 for none.  Returns the index of the new node.
+ ***********************************************************/
+int SceneManager::AddSceneNode(
+	int parent,
+	MESH_TYPE mesh,
+	glm::vec3 scaleXYZ,
+	glm::vec3 rotationDegrees,
+	glm::vec3 positionXYZ,
+	glm::vec4 color,
+	int materialIndex,
+	int textureSlot,
+	glm::vec2 UVscale)
+{
+	SCENE_OBJECT object;
+
+	object.mesh = mesh;
+	// a parent must already exist so that one in-order pass
+	// is enough to update the whole scene
+	object.parent = (parent < (int)m_sceneObjects.size()) ? parent : -1;
+	object.scaleXYZ = scaleXYZ;
+	object.rotationDegrees = rotationDegrees;
+	object.positionXYZ = positionXYZ;
+	object.localMatrix = glm::mat4(1.0f);
+	object.worldMatrix = glm::mat4(1.0f);
+	object.bDirty = true;
+	object.bMoved = true;
+	object.color = color;
+	object.UVscale = UVscale;
+	object.materialIndex = materialIndex;
+	object.textureSlot = textureSlot;
+
+	m_sceneObjects.push_back(object);
+	m_bSceneDirty = true;
+	m_bInstancesDirty = true;
+	m_bDrawQueueDirty = true;
+	m_bBVHDirty = true;
+	InvalidateShadowCasters();
+
+	return((int)m_sceneObjects.size() - 1);
+}
+
+/***********************************************************
+ *  SetObjectTransform()
+ *
+ *  This method is used for changing the local transformation
+ *  of a retained scene node.  The node and its children are
+ *  rebuilt on the next call to RenderScene().
+ ***********************************************************/
+void SceneManager::SetObjectTransform(
+	int objectIndex,
+	glm::vec3 scaleXYZ,
+	glm::vec3 rotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	if ((objectIndex < 0) || (objectIndex >= (int)m_sceneObjects.size()))
+	{
+		return;
+	}
+
+	SCENE_OBJECT& object = m_sceneObjects[objectIndex];
+	object.scaleXYZ = scaleXYZ;
+	object.rotationDegrees = rotationDegrees;
+	object.positionXYZ = positionXYZ;
+	object.bDirty = true;
+	m_bSceneDirty = true;
+}
+
+/***********************************************************
+ *  UpdateSceneObjects()
+ *
+ *  This method is used for rebuilding the cached matrices of
+ *  any scene nodes that were changed since the last update.
+ *  The local matrices of the changed nodes are computed as
+ *  one batch first, split over the job threads.  Parents
+ *  always precede their children in the node list, so a
+ *  single pass then propagates the changes down the
+ *  hierarchy, and the bounds of the moved nodes are updated
+ *  on the job threads again.
+ ***********************************************************/
+void SceneManager::UpdateSceneObjects()
+{
+	if (m_bSceneDirty == false)
+	{
+		return;
+	}
+
+	if (m_objectBounds.size() != m_sceneObjects.size())
+	{
+		m_objectBounds.resize(m_sceneObjects.size());
+		m_objectVisible.resize(m_sceneObjects.size(), 1);
+		m_objectLods.resize(m_sceneObjects.size(), 0);
+	}
+
+	m_dirtyTransforms.Clear();
+	m_dirtyObjects = m_frameArena->AllocateArray<int>(m_sceneObjects.size());
+	int dirtyCount = 0;
+	for (size_t i = 0; i < m_sceneObjects.size(); i++)
+	{
+		const SCENE_OBJECT& object = m_sceneObjects[i];
+		if (object.bDirty == true)
+		{
+			m_dirtyTransforms.Add(object.scaleXYZ, object.rotationDegrees, object.positionXYZ);
+			m_dirtyObjects[dirtyCount++] = (int)i;
+		}
+	}
+
+	// the local matrices do not depend on each other, so every
+	// thread computes a range of them
+	m_dirtyMatrices = m_frameArena->AllocateArray<glm::mat4>(dirtyCount);
+	ParallelFor(dirtyCount, g_MinJobObjects,
+		[this](int first, int count, int threadIndex)
+		{
+			m_dirtyTransforms.Compute(first, count, m_dirtyMatrices, NULL);
+			for (int d = first; d < first + count; d++)
+			{
+				m_sceneObjects[m_dirtyObjects[d]].localMatrix = m_dirtyMatrices[d];
+			}
+		});
+
+	// the world matrices follow the hierarchy in node order
+	for (size_t i = 0; i < m_sceneObjects.size(); i++)
+	{
+		SCENE_OBJECT& object = m_sceneObjects[i];
+		bool bParentMoved = false;
+
+		if (object.parent >= 0)
+		{
+			bParentMoved = m_sceneObjects[object.parent].bMoved;
+		}
+
+		object.bMoved = object.bDirty || bParentMoved;
+		object.bDirty = false;
+
+		if (object.bMoved == true)
+		{
+			m_bInstancesDirty = true;
+
+			if (object.parent >= 0)
+			{
+				object.worldMatrix = m_sceneObjects[object.parent].worldMatrix * object.localMatrix;
+			}
+			else
+			{
+				object.worldMatrix = object.localMatrix;
+			}
+
+			if (object.mesh != MESH_NONE)
+			{
+				m_bBoundsDirty = true;
+
+				// a caster that moves after the cached shadow maps
+				// were drawn is drawn every frame from now on
+				if ((m_bStaticShadowsBuilt == true) && (i < m_objectDynamic.size()) && (m_objectDynamic[i] == 0))
+				{
+					m_objectDynamic[i] = 1;
+					m_bShadowCastersDirty = true;
+				}
+				m_bDynamicCastersMoved = true;
+			}
+		}
+	}
+
+	// and the bounds of the moved nodes only read their own
+	// world matrix
+	if (m_bBoundsDirty == true)
+	{
+		ParallelFor((int)m_sceneObjects.size(), g_MinJobObjects,
+			[this](int first, int count, int threadIndex)
+			{
+				for (int i = first; i < first + count; i++)
+				{
+					const SCENE_OBJECT& object = m_sceneObjects[i];
+					if ((object.bMoved == true) && (object.mesh != MESH_NONE))
+					{
+						m_objectBounds[i] = TransformAABB(GetMeshBounds(object.mesh), object.worldMatrix);
+					}
+				}
+			});
+	}
+
+	m_bSceneDirty = false;
+}
+
+/***********************************************************
+ *  SetSceneGrid()
+ *
+ *  This method is used for requesting a scene of columns x
+ *  rows copies of the prefab groups, for measuring how the
+ *  rendering scales with the number of objects.
+ ***********************************************************/
+void SceneManager::SetSceneGrid(int columns, int rows)
+{
+	m_gridColumns = (columns > 1) ? columns : 1;
+	m_gridRows = (rows > 1) ? rows : 1;
+}
+
+/***********************************************************
+ *  GetSceneGridBounds()
+ *
+ *  This method is used for getting the center of the area
+ *  the scene grid covers and the radius of a circle around
+ *  it, for placing a camera that sees the whole grid.
+ ***********************************************************/
+void SceneManager::GetSceneGridBounds(glm::vec3& center, float& radius) const
+{
+	float width = (float)m_gridColumns * SCENE_CELL_WIDTH;
+	float depth = (float)m_gridRows * SCENE_CELL_DEPTH;
+
+	center = glm::vec3(
+		(float)(m_gridColumns - 1) * SCENE_CELL_WIDTH * 0.5f,
+		4.0f,
+		(float)(m_gridRows - 1) * SCENE_CELL_DEPTH * 0.5f);
+	radius = 0.5f * glm::length(glm::vec2(width, depth));
+}
+
+/***********************************************************
+ *  LoadSceneFile()
+ *
+ *  This method is used for loading a whole scene from a
+ *  mapped scene file.  The records are read in place - the
+ *  textures and materials are registered first, and their
+ *  indices then map every node straight to its texture slot
+ *  and material index without looking up any tags.
+ ***********************************************************/
+bool SceneManager::LoadSceneFile(const char* filename)
+{
+	SceneFile sceneFile;
+
+	if (sceneFile.Open(filename) == false)
+	{
+		std::cout << "Using the built in scene instead of " << filename << std::endl;
+		return(false);
+	}
+
+	std::vector<int> textureSlots;
+	std::vector<int> materialIndices;
+	LoadSceneFileResources(sceneFile, textureSlots, materialIndices);
+	AddSceneFileNodes(sceneFile, textureSlots, materialIndices);
+
+	std::cout << "Loaded " << sceneFile.GetNodeCount() << " scene nodes from " << filename << std::endl;
+
+	return(true);
+}
+
+/***********************************************************
+ *  LoadSceneFileResources()
+ *
+ *  This method is used for registering the textures and
+ *  materials of a scene file and filling the light block
+ *  with its lights.  Textures whose tag is already loaded
+ *  from the same image file are kept as they are, so a
+ *  reloaded scene only decodes the images it did not use.
+ *  The texture slot and material index of every record are
+ *  returned for the nodes.
+ ***********************************************************/
+void SceneManager::LoadSceneFileResources(
+	const SceneFile& sceneFile,
+	std::vector<int>& textureSlots,
+	std::vector<int>& materialIndices)
+{
+	const SceneFile::FILE_TEXTURE* textures = sceneFile.GetTextures();
+	bool bNewTextures = false;
+	textureSlots.assign(sceneFile.GetTextureCount(), -1);
+	for (int i = 0; i < sceneFile.GetTextureCount(); i++)
+	{
+		const char* tag = sceneFile.GetString(textures[i].tag);
+		const char* filename = sceneFile.GetString(textures[i].path);
+
+		int textureSlot = FindTextureSlot(tag);
+		if ((textureSlot < 0) || (m_textureIDs[textureSlot].filename != filename))
+		{
+			bNewTextures = bNewTextures || (textureSlot < 0);
+			LoadGLTextureAsync(filename, tag);
+			textureSlot = FindTextureSlot(tag);
+		}
+		textureSlots[i] = textureSlot;
+	}
+	if (bNewTextures == true)
+	{
+		BindGLTextures();
+	}
+
+	const SceneFile::FILE_MATERIAL* materials = sceneFile.GetMaterials();
+	materialIndices.assign(sceneFile.GetMaterialCount(), -1);
+	for (int i = 0; i < sceneFile.GetMaterialCount(); i++)
+	{
+		OBJECT_MATERIAL material;
+		material.ambientColor = materials[i].ambientColor;
+		material.ambientStrength = materials[i].ambientStrength;
+		material.diffuseColor = materials[i].diffuseColor;
+		material.specularColor = materials[i].specularColor;
+		material.shininess = materials[i].shininess;
+		material.tag = sceneFile.GetString(materials[i].tag);
+		materialIndices[i] = AddObjectMaterial(material);
+	}
+
+	// the point lights without a radius fill the slots of the
+	// light block in file order, the directional and spot light
+	// have one slot each - the lights the file does not set are
+	// switched off.  The point lights with a radius are clustered.
+	m_pUniformCache->SetBool(m_uniforms.bUseLighting, true);
+	UBO_LIGHT_BLOCK& lightBlock = m_pUniformBuffers->GetLights();
+	lightBlock.directionalLight.bActive = false;
+	for (int i = 0; i < TOTAL_POINT_LIGHTS; i++)
+	{
+		lightBlock.pointLights[i].bActive = false;
+	}
+	lightBlock.spotLight.bActive = false;
+	m_clusterLights.clear();
+	m_bClusterLightsDirty = true;
+
+	const SceneFile::FILE_LIGHT* lights = sceneFile.GetLights();
+	int pointLightCount = 0;
+	for (int i = 0; i < sceneFile.GetLightCount(); i++)
+	{
+		const SceneFile::FILE_LIGHT& light = lights[i];
+		if (light.type == SceneFile::LIGHT_DIRECTIONAL)
+		{
+			lightBlock.directionalLight.direction = light.direction;
+			lightBlock.directionalLight.ambient = light.ambient;
+			lightBlock.directionalLight.diffuse = light.diffuse;
+			lightBlock.directionalLight.specular = light.specular;
+			lightBlock.directionalLight.bActive = true;
+		}
+		else if ((light.type == SceneFile::LIGHT_POINT) && (light.radius > 0.0f))
+		{
+			AddClusteredLight(light.position, light.radius, light.ambient, light.diffuse, light.specular);
+		}
+		else if (light.type == SceneFile::LIGHT_POINT)
+		{
+			if (pointLightCount >= TOTAL_POINT_LIGHTS)
+			{
+				std::cout << "Scene file has more than " << TOTAL_POINT_LIGHTS << " point lights without a radius" << std::endl;
+				continue;
+			}
+			UBO_POINT_LIGHT& pointLight = lightBlock.pointLights[pointLightCount++];
+			pointLight.position = light.position;
+			pointLight.ambient = light.ambient;
+			pointLight.diffuse = light.diffuse;
+			pointLight.specular = light.specular;
+			pointLight.bActive = true;
+		}
+		else
+		{
+			lightBlock.spotLight.position = light.position;
+			lightBlock.spotLight.direction = light.direction;
+			lightBlock.spotLight.cutOff = light.cutOff;
+			lightBlock.spotLight.outerCutOff = light.outerCutOff;
+			lightBlock.spotLight.constant = light.constant;
+			lightBlock.spotLight.linear = light.linear;
+			lightBlock.spotLight.quadratic = light.quadratic;
+			lightBlock.spotLight.ambient = light.ambient;
+			lightBlock.spotLight.diffuse = light.diffuse;
+			lightBlock.spotLight.specular = light.specular;
+			lightBlock.spotLight.bActive = true;
+		}
+	}
+	m_pUniformBuffers->UploadLights();
+}
+
+/***********************************************************
+ *  AddSceneFileNodes()
+ *
+ *  This method is used for adding the nodes of a scene file
+ *  to the retained scene.  The file checked that every
+ *  parent precedes its children, so the node indices of the
+ *  file only need the scene index of the first node added.
+ ***********************************************************/
+void SceneManager::AddSceneFileNodes(
+	const SceneFile& sceneFile,
+	const std::vector<int>& textureSlots,
+	const std::vector<int>& materialIndices)
+{
+	const SceneFile::FILE_NODE* nodes = sceneFile.GetNodes();
+	int firstNode = (int)m_sceneObjects.size();
+
+	m_sceneObjects.reserve(firstNode + sceneFile.GetNodeCount());
+	for (int i = 0; i < sceneFile.GetNodeCount(); i++)
+	{
+		const SceneFile::FILE_NODE& node = nodes[i];
+		AddSceneNode(
+			(node.parent >= 0) ? firstNode + node.parent : -1,
+			(MESH_TYPE)node.mesh,
+			node.scaleXYZ,
+			node.rotationDegrees,
+			node.positionXYZ,
+			node.color,
+			(node.material >= 0) ? materialIndices[node.material] : -1,
+			(node.texture >= 0) ? textureSlots[node.texture] : -1,
+			node.UVscale);
+	}
+	m_sceneFileNodes = sceneFile.GetNodeCount();
+}
+
+/***********************************************************
+ *  PatchSceneFileNodes()
+ *
+ *  This method is used for updating the retained nodes in
+ *  place from a changed scene file with the same hierarchy.
+ *  Only the nodes whose values differ are touched - moved
+ *  nodes are rebuilt and refitted, and the draws are only
+ *  sorted again when a material or texture changed.  Returns
+ *  the number of changed nodes, or -1 when the hierarchy or
+ *  the meshes differ and the scene has to be rebuilt.
+ ***********************************************************/
+int SceneManager::PatchSceneFileNodes(
+	const SceneFile& sceneFile,
+	const std::vector<int>& textureSlots,
+	const std::vector<int>& materialIndices)
+{
+	const SceneFile::FILE_NODE* nodes = sceneFile.GetNodes();
+	int nodeCount = sceneFile.GetNodeCount();
+
+	// the grid copies share nothing with the file nodes they were
+	// copied from, so a grid is always rebuilt
+	if ((nodeCount != m_sceneFileNodes) || (nodeCount != (int)m_sceneObjects.size()))
+	{
+		return(-1);
+	}
+	for (int i = 0; i < nodeCount; i++)
+	{
+		if ((nodes[i].parent != m_sceneObjects[i].parent) ||
+			((MESH_TYPE)nodes[i].mesh != m_sceneObjects[i].mesh))
+		{
+			return(-1);
+		}
+	}
+
+	int changedCount = 0;
+	for (int i = 0; i < nodeCount; i++)
+	{
+		const SceneFile::FILE_NODE& node = nodes[i];
+		SCENE_OBJECT& object = m_sceneObjects[i];
+		int materialIndex = (node.material >= 0) ? materialIndices[node.material] : -1;
+		int textureSlot = (node.texture >= 0) ? textureSlots[node.texture] : -1;
+		bool bChanged = false;
+
+		if ((node.scaleXYZ != object.scaleXYZ) ||
+			(node.rotationDegrees != object.rotationDegrees) ||
+			(node.positionXYZ != object.positionXYZ))
+		{
+			SetObjectTransform(i, node.scaleXYZ, node.rotationDegrees, node.positionXYZ);
+			bChanged = true;
+		}
+		if ((node.color != object.color) || (node.UVscale != object.UVscale))
+		{
+			object.color = node.color;
+			object.UVscale = node.UVscale;
+			m_bInstancesDirty = true;
+			bChanged = true;
+		}
+		if ((materialIndex != object.materialIndex) || (textureSlot != object.textureSlot))
+		{
+			object.materialIndex = materialIndex;
+			object.textureSlot = textureSlot;
+			m_bDrawQueueDirty = true;
+			bChanged = true;
+		}
+
+		if (bChanged == true)
+		{
+			changedCount++;
+		}
+	}
+
+	return(changedCount);
+}
+
+/***********************************************************
+ *  ReloadSceneFile()
+ *
+ *  This method is used for applying a changed scene file to
+ *  the running scene.  The resources are registered again,
+ *  which only loads new or changed textures, and the nodes
+ *  are patched in place when the hierarchy is the same, or
+ *  replaced as a whole otherwise.  A file that fails to open
+ *  leaves the scene as it is.
+ ***********************************************************/
+void SceneManager::ReloadSceneFile()
+{
+	SceneFile sceneFile;
+
+	if (sceneFile.Open(m_sceneFile.c_str()) == false)
+	{
+		std::cout << "Keeping the current scene" << std::endl;
+		return;
+	}
+
+	std::vector<int> textureSlots;
+	std::vector<int> materialIndices;
+	LoadSceneFileResources(sceneFile, textureSlots, materialIndices);
+	AddCeilingLights();
+	UploadSceneMaterials();
+
+	int changedCount = PatchSceneFileNodes(sceneFile, textureSlots, materialIndices);
+	if (changedCount > 0)
+	{
+		// the patched nodes are placed again, not moving
+		InvalidateShadowCasters();
+	}
+	if (changedCount >= 0)
+	{
+		std::cout << "Reloaded " << m_sceneFile << ", " << changedCount << " of "
+			<< sceneFile.GetNodeCount() << " scene nodes changed" << std::endl;
+		return;
+	}
+
+	// the casters and the cached maps point at the old nodes
+	m_sceneObjects.clear();
+	InvalidateShadowCasters();
+	AddSceneFileNodes(sceneFile, textureSlots, materialIndices);
+	ReplicateSceneGrid();
+	if (NULL != m_drawRing)
+	{
+		m_drawRing->Reserve((int)m_sceneObjects.size());
+	}
+	std::cout << "Reloaded " << m_sceneFile << ", rebuilt " << m_sceneObjects.size() << " scene nodes" << std::endl;
+}
+
+/***********************************************************
+ *  EnableHotReload()
+ *
+ *  This method is used for watching the files the running
+ *  scene was built from - the shaders of the scene program,
+ *  the loaded texture images and the scene file - so their
+ *  changes are applied without a restart.  The shaders are
+ *  the ones passed to SetShaderFiles().
+ ***********************************************************/
+void SceneManager::EnableHotReload()
+{
+	if (NULL == m_fileWatcher)
+	{
+		m_fileWatcher = new FileWatcher();
+	}
+
+	if ((m_vertexShaderFile.empty() == false) && (m_fragmentShaderFile.empty() == false))
+	{
+		m_fileWatcher->AddFile(m_vertexShaderFile);
+		m_fileWatcher->AddFile(m_fragmentShaderFile);
+	}
+	for (size_t i = 0; i < m_textureIDs.size(); i++)
+	{
+		if (m_textureIDs[i].filename.empty() == false)
+		{
+			m_fileWatcher->AddFile(m_textureIDs[i].filename);
+		}
+	}
+	if (m_sceneFile.empty() == false)
+	{
+		m_fileWatcher->AddFile(m_sceneFile);
+	}
+
+	m_fileWatcher->Start(g_HotReloadInterval);
+	std::cout << "Watching the scene files for changes" << std::endl;
+}
+
+/***********************************************************
+ *  ApplyFileChanges()
+ *
+ *  This method is used for applying the changes of the
+ *  watched files before the next frame is drawn.  Each
+ *  kind of file only rebuilds what depends on it - both
+ *  shaders change one program, a texture image reloads its
+ *  own slot in the background, and the scene file patches
+ *  the retained nodes.
+ ***********************************************************/
+void SceneManager::ApplyFileChanges()
+{
+	std::vector<std::string> changedFiles;
+
+	if ((NULL == m_fileWatcher) || (m_fileWatcher->TakeChangedFiles(changedFiles) == false))
+	{
+		return;
+	}
+
+	bool bShadersChanged = false;
+	bool bSceneChanged = false;
+	for (size_t i = 0; i < changedFiles.size(); i++)
+	{
+		const std::string& filename = changedFiles[i];
+
+		if ((filename == m_vertexShaderFile) || (filename == m_fragmentShaderFile))
+		{
+			bShadersChanged = true;
+		}
+		else if (filename == m_sceneFile)
+		{
+			bSceneChanged = true;
+		}
+		else
+		{
+			ReloadTexture(filename);
+		}
+	}
+
+	if (bShadersChanged == true)
+	{
+		ReloadShaders();
+	}
+	if (bSceneChanged == true)
+	{
+		ReloadSceneFile();
+		// a changed scene can use images that were not watched yet
+		for (size_t i = 0; i < m_textureIDs.size(); i++)
+		{
+			if (m_textureIDs[i].filename.empty() == false)
+			{
+				m_fileWatcher->AddFile(m_textureIDs[i].filename);
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  ReloadTexture()
+ *
+ *  This method is used for loading a changed texture image
+ *  again into every slot that uses it.  The image is decoded
+ *  in the background like at startup, and the slot keeps
+ *  showing the old texture until the new one is uploaded.
+ ***********************************************************/
+void SceneManager::ReloadTexture(const std::string& filename)
+{
+	for (size_t i = 0; i < m_textureIDs.size(); i++)
+	{
+		if (m_textureIDs[i].filename == filename)
+		{
+			std::cout << "Reloading texture " << filename << std::endl;
+			LoadGLTextureAsync(filename.c_str(), m_textureIDs[i].tag);
+		}
+	}
+}
+
+/***********************************************************
+ *  ReloadShaders()
+ *
+ *  This method is used for rebuilding the scene program
+ *  from its changed shader files.  The files are built once
+ *  on the side first, so an edit that does not compile
+ *  keeps the running program.  The new program then gets
+ *  its uniform locations, block bindings and the uniforms
+ *  that are only set once, and the old one is deleted.  The
+ *  shader variants are built again from the new files the
+ *  next time they are drawn.
+ ***********************************************************/
+bool SceneManager::ReloadShaders()
+{
+	GLuint testProgramID = ProgramBuilder::BuildProgram(
+		m_vertexShaderFile.c_str(),
+		m_fragmentShaderFile.c_str());
+	if (testProgramID == 0)
+	{
+		std::cout << "Keeping the current shader program" << std::endl;
+		return(false);
+	}
+	glDeleteProgram(testProgramID);
+
+	if (NULL != m_shaderVariants)
+	{
+		m_shaderVariants->Clear();
+	}
+	m_drawPrograms[0] = 0;
+	m_drawPrograms[1] = 0;
+	m_depthProgram = 0;
+
+	// the current program can be one of the variants
+	GLint oldProgramID = (GLint)m_pUniformCache->GetProgramID();
+
+	m_pShaderManager->LoadShaders(
+		m_vertexShaderFile.c_str(),
+		m_fragmentShaderFile.c_str());
+	m_pShaderManager->use();
+
+	GLint programID = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &programID);
+	if ((oldProgramID != 0) && (oldProgramID != programID) && (glIsProgram((GLuint)oldProgramID) == GL_TRUE))
+	{
+		glDeleteProgram((GLuint)oldProgramID);
+	}
+
+	m_pUniformCache->LoadUniforms((GLuint)programID);
+	m_pUniformBuffers->BindToProgram((GLuint)programID);
+
+	// the uniforms that are not set again every frame
+	m_pUniformCache->SetBool(m_uniforms.bUseLighting, true);
+	m_pUniformCache->SetBool(m_uniforms.bUseTextureArray, m_bUseTextureArrays);
+	if (m_arrayTextureUnit >= 0)
+	{
+		m_pUniformCache->SetSampler2D(m_uniforms.objectTextureArray, m_arrayTextureUnit);
+	}
+	ResetRenderState();
+
+	// the draw order is sorted by program first
+	m_bDrawQueueDirty = true;
+
+	std::cout << "Reloaded the shader program " << m_vertexShaderFile << ", " << m_fragmentShaderFile << std::endl;
+
+	return(true);
+}
+
+/***********************************************************
+ *  ReplicateSceneGrid()
+ *
+ *  This method is used for copying the prefab groups of the
+ *  scene - every root group node and all of its children -
+ *  into the other cells of the scene grid.  Each cell gets a
+ *  group node offset by the cell position, so the copies
+ *  keep their layout within the cell.  The room planes stay
+ *  in the first cell and one floor plane is added under the
+ *  whole grid.
+ ***********************************************************/
+void SceneManager::ReplicateSceneGrid()
+{
+	int cells = m_gridColumns * m_gridRows;
+
+	if (cells <= 1)
+	{
+		return;
+	}
+
+	// mark the nodes that belong to a prefab group, parents
+	// always precede their children
+	int sourceCount = (int)m_sceneObjects.size();
+	std::vector<bool> bPrefab(sourceCount, false);
+	int prefabCount = 0;
+	for (int i = 0; i < sourceCount; i++)
+	{
+		const SCENE_OBJECT& object = m_sceneObjects[i];
+		if (object.parent < 0)
+		{
+			bPrefab[i] = (object.mesh == MESH_NONE);
+		}
+		else
+		{
+			bPrefab[i] = bPrefab[object.parent];
+		}
+		if (bPrefab[i] == true)
+		{
+			prefabCount++;
+		}
+	}
+
+	m_sceneObjects.reserve(sourceCount + (size_t)(cells - 1) * (prefabCount + 1) + 1);
+
+	std::vector<int> copies(sourceCount, -1);
+	for (int row = 0; row < m_gridRows; row++)
+	{
+		for (int column = 0; column < m_gridColumns; column++)
+		{
+			// the first cell holds the original prefabs
+			if ((row == 0) && (column == 0))
+			{
+				continue;
+			}
+
+			int cellGroup = AddSceneGroup(-1);
+			SetObjectTransform(cellGroup,
+				glm::vec3(1.0f, 1.0f, 1.0f),
+				glm::vec3(0.0f, 0.0f, 0.0f),
+				glm::vec3((float)column * SCENE_CELL_WIDTH, 0.0f, (float)row * SCENE_CELL_DEPTH));
+
+			for (int i = 0; i < sourceCount; i++)
+			{
+				if (bPrefab[i] == false)
+				{
+					continue;
+				}
+
+				SCENE_OBJECT copy = m_sceneObjects[i];
+				copy.parent = (copy.parent < 0) ? cellGroup : copies[copy.parent];
+				copy.bDirty = true;
+				copy.bMoved = true;
+				m_sceneObjects.push_back(copy);
+				copies[i] = (int)m_sceneObjects.size() - 1;
+			}
+		}
+	}
+
+	// one floor under the whole grid, just below the floor of
+	// the first cell
+	AddSceneObject(-1, MESH_PLANE,
+		glm::vec3((float)m_gridColumns * SCENE_CELL_WIDTH * 0.5f, 1.0f, (float)m_gridRows * SCENE_CELL_DEPTH * 0.5f),
+		glm::vec3(0.0f, 0.0f, 0.0f),
+		glm::vec3((float)(m_gridColumns - 1) * SCENE_CELL_WIDTH * 0.5f, -0.01f, (float)(m_gridRows - 1) * SCENE_CELL_DEPTH * 0.5f),
+		glm::vec4(0.5f, 0.52f, 0.55f, 1.0f),
+		"stoneMAT", "floor", glm::vec2(2.0f * (float)m_gridColumns, 2.0f * (float)m_gridRows));
+
+	m_bSceneDirty = true;
+	m_bInstancesDirty = true;
+	m_bDrawQueueDirty = true;
+	m_bBVHDirty = true;
+
+	std::cout << "INFO: Scene grid " << m_gridColumns << "x" << m_gridRows << ": "
+		<< m_sceneObjects.size() << " scene nodes" << std::endl;
+}
+
+/***********************************************************
+ *  GetMeshBounds()
+ *
+ *  This method is used for getting the bounds of a basic
+ *  mesh before it is transformed - the 2x2 plane, the unit
+ *  box, the cylinder from y=0 to y=1 and the unit sphere.
+ ***********************************************************/
+AABB SceneManager::GetMeshBounds(MESH_TYPE mesh)
+{
+	AABB bounds;
+
+	switch (mesh)
+	{
+	case MESH_PLANE:
+		bounds.min = glm::vec3(-1.0f, 0.0f, -1.0f);
+		bounds.max = glm::vec3(1.0f, 0.0f, 1.0f);
+		break;
+	case MESH_BOX:
+		bounds.min = glm::vec3(-0.5f, -0.5f, -0.5f);
+		bounds.max = glm::vec3(0.5f, 0.5f, 0.5f);
+		break;
+	case MESH_CYLINDER:
+		bounds.min = glm::vec3(-1.0f, 0.0f, -1.0f);
+		bounds.max = glm::vec3(1.0f, 1.0f, 1.0f);
+		break;
+	case MESH_SPHERE:
+		bounds.min = glm::vec3(-1.0f, -1.0f, -1.0f);
+		bounds.max = glm::vec3(1.0f, 1.0f, 1.0f);
+		break;
+	default:
+		bounds.min = glm::vec3(0.0f, 0.0f, 0.0f);
+		bounds.max = glm::vec3(0.0f, 0.0f, 0.0f);
+		break;
+	}
+
+	return(bounds);
+}
+
+/***********************************************************
+ *  CullSceneObjects()
+ *
+ *  This method is used for finding the scene nodes that are
+ *  inside the view frustum of the camera.  The hierarchy is
+ *  rebuilt after nodes were added and refitted after nodes
+ *  moved, and the visibility is only computed again when
+ *  the camera or the scene changed.
+ ***********************************************************/
+void SceneManager::CullSceneObjects()
+{
+	bool bSceneChanged = false;
+
+	if (m_bBVHDirty == true)
+	{
+		std::vector<int> items;
+		items.reserve(m_sceneObjects.size());
+		for (size_t i = 0; i < m_sceneObjects.size(); i++)
+		{
+			if (m_sceneObjects[i].mesh != MESH_NONE)
+			{
+				items.push_back((int)i);
+			}
+		}
+
+		m_sceneBVH.Build(m_objectBounds, items);
+		m_bBVHDirty = false;
+		m_bBoundsDirty = false;
+		bSceneChanged = true;
+	}
+	else if (m_bBoundsDirty == true)
+	{
+		m_sceneBVH.Refit(m_objectBounds);
+		m_bBoundsDirty = false;
+		bSceneChanged = true;
+	}
+
+	// without culling every node keeps its visible flag set
+	if ((m_bUseCulling == false) || (NULL == m_pUniformBuffers))
+	{
+		return;
+	}
+
+	// the camera block holds the matrices of the current frame,
+	// for both the perspective and the orthographic projection
+	const UBO_CAMERA_BLOCK& camera = m_pUniformBuffers->GetCamera();
+	glm::mat4 viewProjection = camera.projection * camera.view;
+	if ((bSceneChanged == false) && (viewProjection == m_cullViewProjection))
+	{
+		return;
+	}
+
+	Frustum frustum;
+	frustum.SetViewProjection(viewProjection);
+	std::fill(m_objectVisible.begin(), m_objectVisible.end(), 0);
+	m_sceneBVH.QueryFrustum(frustum, m_objectBounds, m_objectVisible);
+
+	m_cullViewProjection = viewProjection;
+	m_bVisibilityDirty = true;
+}
+
+/***********************************************************
+ *  SetGpuCullingEnabled()
+ *
+ *  This method is used for allowing or forbidding the GPU
+ *  culling pass, for comparing it with the CPU path.  When
+ *  allowed, PrepareScene() still falls back to the CPU path
+ *  if the context cannot run it.
+ ***********************************************************/
+void SceneManager::SetGpuCullingEnabled(bool bEnabled)
+{
+	m_bUseGpuCulling = bEnabled;
+}
+
+/***********************************************************
+ *  SetOcclusionCullingEnabled()
+ *
+ *  This method is used for allowing or forbidding the
+ *  occlusion culling of the GPU path.  The CPU path only
+ *  culls against the view frustum.
+ ***********************************************************/
+void SceneManager::SetOcclusionCullingEnabled(bool bEnabled)
+{
+	m_bUseOcclusion = bEnabled;
+}
+
+/***********************************************************
+ *  SetLightClustersEnabled()
+ *
+ *  This method is used for allowing or forbidding the light
+ *  cluster pass.  Without it, the point lights with a radius
+ *  are not drawn.
+ ***********************************************************/
+void SceneManager::SetLightClustersEnabled(bool bEnabled)
+{
+	m_bUseLightClusters = bEnabled;
+}
+
+/***********************************************************
+ *  SetShaderFiles()
+ *
+ *  This method is used for setting the shader files that
+ *  the scene program was loaded from.  The shader variants
+ *  are built from them and hot reloading watches them.
+ ***********************************************************/
+void SceneManager::SetShaderFiles(const char* vertexShaderFile, const char* fragmentShaderFile)
+{
+	m_vertexShaderFile = (NULL != vertexShaderFile) ? vertexShaderFile : "";
+	m_fragmentShaderFile = (NULL != fragmentShaderFile) ? fragmentShaderFile : "";
+}
+
+/***********************************************************
+ *  SetShaderVariantsEnabled()
+ *
+ *  This method is used for choosing between the specialized
+ *  shader variants and drawing everything with the loaded
+ *  program, for comparing their cost.
+ ***********************************************************/
+void SceneManager::SetShaderVariantsEnabled(bool bEnabled)
+{
+	m_bUseShaderVariants = bEnabled;
+}
+
+/***********************************************************
+ *  SetCeilingLightCount()
+ *
+ *  This method is used for requesting a number of clustered
+ *  ceiling lights spread evenly over the scene grid, for
+ *  measuring how the shading scales with the light count.
+ ***********************************************************/
+void SceneManager::SetCeilingLightCount(int lightCount)
+{
+	m_ceilingLightCount = std::max(lightCount, 0);
+}
+
+/***********************************************************
+ *  SetRenderMode()
+ *
+ *  This method is used for choosing between drawing the
+ *  scene in one forward pass and putting a depth pre-pass
+ *  in front of it, for comparing their cost.
+ ***********************************************************/
+void SceneManager::SetRenderMode(RENDER_MODE renderMode)
+{
+	m_renderMode = renderMode;
+}
+
+/***********************************************************
+ *  SetShadowsEnabled()
+ *
+ *  This method is used for allowing or forbidding the
+ *  shadow maps, for comparing their cost.
+ ***********************************************************/
+void SceneManager::SetShadowsEnabled(bool bEnabled)
+{
+	m_bUseShadows = bEnabled;
+}
+
+/***********************************************************
+ *  SetInstancingEnabled()
+ *
+ *  This method is used for choosing between the instanced
+ *  batches and drawing one object at a time, for comparing
+ *  their cost.  The GPU culling pass always draws instanced,
+ *  so the per object path also culls on the CPU.
+ ***********************************************************/
+void SceneManager::SetInstancingEnabled(bool bEnabled)
+{
+	m_bUseInstancing = bEnabled;
+}
+
+/***********************************************************
+ *  SetSceneFile()
+ *
+ *  This method is used for choosing a scene file to load in
+ *  PrepareScene() instead of the scene defined in the code.
+ ***********************************************************/
+void SceneManager::SetSceneFile(const char* filename)
+{
+	m_sceneFile = (NULL != filename) ? filename : "";
+}
+
+/***********************************************************
+ *  SetJobThreadCount()
+ *
+ *  This method is used for setting the number of threads
+ *  that share the scene update.  The job system is created
+ *  by PrepareScene(), so a count set later has no effect.
+ ***********************************************************/
+void SceneManager::SetJobThreadCount(int threadCount)
+{
+	m_jobThreadCount = std::max(threadCount, 0);
+}
+
+/***********************************************************
+ *  SetCullingEnabled()
+ *
+ *  This method is used for turning the view frustum culling
+ *  on or off, for comparing the cost of drawing everything.
+ ***********************************************************/
+void SceneManager::SetCullingEnabled(bool bEnabled)
+{
+	m_bUseCulling = bEnabled;
+	// force the visibility to be computed again
+	m_cullViewProjection = glm::mat4(0.0f);
+	if (bEnabled == false)
+	{
+		std::fill(m_objectVisible.begin(), m_objectVisible.end(), 1);
+	}
+	m_bVisibilityDirty = true;
+}
+
+/***********************************************************
+ *  GetMeshLodCount()
+ *
+ *  This method is used for getting the number of detail
+ *  levels of a basic mesh.  Only the curved meshes have more
+ *  than one.
+ ***********************************************************/
+int SceneManager::GetMeshLodCount(MESH_TYPE mesh)
+{
+	if ((mesh == MESH_CYLINDER) || (mesh == MESH_SPHERE))
+	{
+		return(InstancedMeshes::LOD_COUNT);
+	}
+
+	return(1);
+}
+
+/***********************************************************
+ *  SelectMeshLod()
+ *
+ *  This method is used for choosing the detail level of a
+ *  box from the fraction of the screen height its bounding
+ *  sphere covers.  Starting from the last level, the box
+ *  only moves to another level once its size is past the
+ *  switching size by the hysteresis fraction, so objects
+ *  near a switching distance do not flicker between levels.
+ *  The culling shader makes the same choice on the GPU.
+ ***********************************************************/
+int SceneManager::SelectMeshLod(
+	const AABB& bounds,
+	const glm::mat4& viewProjection,
+	float lodScale,
+	int lastLod,
+	int lodCount) const
+{
+	glm::vec3 center = (bounds.min + bounds.max) * 0.5f;
+	float radius = glm::length(bounds.max - bounds.min) * 0.5f;
+	float w = (viewProjection * glm::vec4(center, 1.0f)).w;
+	float screenSize = radius * lodScale / std::max(w, 0.0001f);
+
+	int lod = std::min(lastLod, lodCount - 1);
+	while ((lod + 1 < lodCount) && (screenSize < g_LodScreenSizes[lod] * (1.0f - m_lodHysteresis)))
+	{
+		lod++;
+	}
+	while ((lod > 0) && (screenSize > g_LodScreenSizes[lod - 1] * (1.0f + m_lodHysteresis)))
+	{
+		lod--;
+	}
+
+	return(lod);
+}
+
+/***********************************************************
+ *  SelectObjectLods()
+ *
+ *  This method is used for choosing the detail level of the
+ *  visible curved scene nodes.  The levels are only chosen
+ *  again when the camera or the objects moved, and the
+ *  instance batches are rebuilt when any level changed.
+ ***********************************************************/
+void SceneManager::SelectObjectLods()
+{
+	if ((m_bUseLod == false) || (NULL == m_pUniformBuffers))
+	{
+		return;
+	}
+
+	const UBO_CAMERA_BLOCK& camera = m_pUniformBuffers->GetCamera();
+	glm::mat4 viewProjection = camera.projection * camera.view;
+	if ((m_bInstancesDirty == false) && (m_bVisibilityDirty == false) &&
+		(viewProjection == m_lodViewProjection))
+	{
+		return;
+	}
+
+	// every node only writes its own level, so the nodes are
+	// split over the job threads - the loop body reads the camera
+	// through the members, since a larger capture would not fit
+	// the small buffer of std::function and allocate every frame
+	std::atomic<bool> bChanged(false);
+	m_lodViewProjection = viewProjection;
+	ParallelFor((int)m_sceneObjects.size(), g_MinJobObjects,
+		[this, &bChanged](int first, int count, int threadIndex)
+		{
+			const glm::mat4& viewProjection = m_lodViewProjection;
+			float lodScale = m_pUniformBuffers->GetCamera().projection[1][1];
+			bool bRangeChanged = false;
+			for (int i = first; i < first + count; i++)
+			{
+				int lodCount = GetMeshLodCount(m_sceneObjects[i].mesh);
+				if ((lodCount <= 1) || (m_objectVisible[i] == 0))
+				{
+					continue;
+				}
+
+				int lod = SelectMeshLod(m_objectBounds[i], viewProjection, lodScale, m_objectLods[i], lodCount);
+				if (lod != m_objectLods[i])
+				{
+					m_objectLods[i] = (uint8_t)lod;
+					bRangeChanged = true;
+				}
+			}
+			if (bRangeChanged == true)
+			{
+				bChanged = true;
+			}
+		});
+
+	if (bChanged == true)
+	{
+		m_bVisibilityDirty = true;
+	}
+}
+
+/***********************************************************
+ *  SetLodEnabled()
+ *
+ *  This method is used for turning the screen size based
+ *  level of detail on or off.  When off, every object is
+ *  drawn with the finest meshes.
+ ***********************************************************/
+void SceneManager::SetLodEnabled(bool bEnabled)
+{
+	m_bUseLod = bEnabled;
+	std::fill(m_objectLods.begin(), m_objectLods.end(), 0);
+	m_lodViewProjection = glm::mat4(0.0f);
+	m_bVisibilityDirty = true;
+}
+
+/***********************************************************
+ *  SetLodHysteresis()
+ *
+ *  This method is used for setting the fraction of the
+ *  switching sizes that an object has to move past before
+ *  its detail level changes.
+ ***********************************************************/
+void SceneManager::SetLodHysteresis(float hysteresis)
+{
+	m_lodHysteresis = std::max(0.0f, std::min(hysteresis, 0.9f));
+	if (NULL != m_gpuCulling)
+	{
+		m_gpuCulling->SetLodThresholds(g_LodScreenSizes, InstancedMeshes::LOD_COUNT - 1, m_lodHysteresis);
+	}
+}
+
+/***********************************************************
+ *  DrawSceneMesh()
+ *
+ *  This method is used for drawing the basic mesh that is
+ *  assigned to a retained scene node.
+ ***********************************************************/
+void SceneManager::DrawSceneMesh(MESH_TYPE mesh)
+{
+	switch (mesh)
+	{
+	case MESH_PLANE:
+		m_basicMeshes->DrawPlaneMesh();
+		break;
+	case MESH_BOX:
+		m_basicMeshes->DrawBoxMesh();
+		break;
+	case MESH_CYLINDER:
+		m_basicMeshes->DrawCylinderMesh();
+		break;
+	case MESH_SPHERE:
+		m_basicMeshes->DrawSphereMesh();
+		break;
+	default:
+		break;
+	}
+}
+
+/***********************************************************
+ *  BuildDrawQueue()
+ *
+ *  This method is used for sorting the drawn scene objects
+ *  by render state, so that the records that share a mesh,
+ *  material and texture binding are next to each other.
+ *  The draws of one shader variant come first.  With
+ *  texture arrays, objects with different textures of
+ *  the same array share a binding.
+ ***********************************************************/
+void SceneManager::BuildDrawQueue()
+{
+	m_drawQueue.Clear();
+	for (size_t i = 0; i < m_sceneObjects.size(); i++)
+	{
+		const SCENE_OBJECT& object = m_sceneObjects[i];
+
+		// group nodes have nothing to draw
+		if (object.mesh == MESH_NONE)
+		{
+			continue;
+		}
+
+		int textureBinding = GetTextureBinding(object.textureSlot);
+		m_drawQueue.Submit(
+			GetDrawProgram(textureBinding),
+			textureBinding,
+			object.materialIndex,
+			(int)object.mesh,
+			(int)i);
+	}
+	m_drawQueue.Sort();
+
+	m_bDrawQueueDirty = false;
+	m_bInstancesDirty = true;
+}
+
+/***********************************************************
+ *  BuildRunInstances()
+ *
+ *  This method is used for building the draw batches and
+ *  instance values of a range of sort runs into a list.
+ *  Neighbouring visible records with the same sort key
+ *  become one instanced draw batch per detail level, with
+ *  the first instance counted from the start of the list.
+ ***********************************************************/
+void SceneManager::BuildRunInstances(size_t firstRun, size_t lastRun, INSTANCE_LIST& list) const
+{
+	const std::vector<DrawQueue::DRAW_RECORD>& records = m_drawQueue.GetRecords();
+
+	list.batches.clear();
+	list.instances.clear();
+
+	for (size_t run = firstRun; run < lastRun; run++)
+	{
+		size_t runStart = m_sortRuns[run];
+		size_t runEnd = m_sortRuns[run + 1];
+
+		// one batch per detail level of the run
+		int lodCount = GetMeshLodCount((MESH_TYPE)records[runStart].mesh);
+		for (int lod = 0; lod < lodCount; lod++)
+		{
+			bool bBatchStarted = false;
+			for (size_t r = runStart; r < runEnd; r++)
+			{
+				int objectIndex = records[r].objectIndex;
+				if ((m_objectVisible[objectIndex] == 0) || (m_objectLods[objectIndex] != lod))
+				{
+					continue;
+				}
+
+				if (bBatchStarted == false)
+				{
+					DRAW_BATCH batch;
+					batch.mesh = (MESH_TYPE)records[r].mesh;
+					batch.lod = lod;
+					batch.materialIndex = records[r].materialIndex;
+					batch.textureBinding = records[r].textureBinding;
+					batch.firstInstance = (int)list.instances.size();
+					batch.instanceCount = 0;
+					list.batches.push_back(batch);
+					bBatchStarted = true;
+				}
+				list.batches.back().instanceCount++;
+
+				const SCENE_OBJECT& object = m_sceneObjects[objectIndex];
+				InstancedMeshes::INSTANCE_DATA instance;
+
+				instance.model = object.worldMatrix;
+				instance.color = object.color;
+				instance.UVscale = object.UVscale;
+				instance.textureLayer = 0.0f;
+				if ((m_bUseTextureArrays == true) && (object.textureSlot >= 0))
+				{
+					instance.textureLayer = (float)m_textureStorage->GetLayer(object.textureSlot);
+				}
+				instance.materialIndex = (float)std::max(object.materialIndex, 0);
+				list.instances.push_back(instance);
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  UpdateInstanceData()
+ *
+ *  This method is used for copying the instance values of
+ *  the visible objects into the instance buffer, in the
+ *  order of the sorted draw queue.  The runs of equal sort
+ *  keys are split into chunks that the job threads build
+ *  into their own lists, which are then merged in chunk
+ *  order so the result matches a single pass.  Moving
+ *  objects or a moving camera only needs this refresh, the
+ *  sorted order stays the same.
+ ***********************************************************/
+void SceneManager::UpdateInstanceData()
+{
+	const std::vector<DrawQueue::DRAW_RECORD>& records = m_drawQueue.GetRecords();
+
+	// the start of every run of records with the same sort key,
+	// closed by the record count
+	m_sortRuns = m_frameArena->AllocateArray<size_t>(records.size() + 1);
+	int runCount = 0;
+	for (size_t r = 0; r < records.size(); r++)
+	{
+		if ((r == 0) || (records[r].sortKey != records[r - 1].sortKey))
+		{
+			m_sortRuns[runCount++] = r;
+		}
+	}
+	m_sortRuns[runCount] = records.size();
+
+	int threadCount = (m_jobSystem != NULL) ? m_jobSystem->GetThreadCount() : 1;
+	int chunkCount = std::max(1, std::min(threadCount * 4, runCount / g_MinJobRuns));
+	int runsPerChunk = (runCount + chunkCount - 1) / std::max(chunkCount, 1);
+
+	if ((int)m_instanceLists.size() < chunkCount)
+	{
+		m_instanceLists.resize(chunkCount);
+	}
+	ParallelFor(chunkCount, 1,
+		[this, runCount, runsPerChunk](int first, int count, int threadIndex)
+		{
+			for (int chunk = first; chunk < first + count; chunk++)
+			{
+				size_t firstRun = (size_t)std::min(chunk * runsPerChunk, runCount);
+				size_t lastRun = (size_t)std::min(firstRun + runsPerChunk, (size_t)runCount);
+				BuildRunInstances(firstRun, lastRun, m_instanceLists[chunk]);
+			}
+		});
+
+	// merge the lists, moving every batch past the instances of
+	// the lists before it - the merged values are only needed
+	// until they are uploaded, so they live in the frame arena
+	size_t totalInstances = 0;
+	for (int chunk = 0; chunk < chunkCount; chunk++)
+	{
+		totalInstances += m_instanceLists[chunk].instances.size();
+	}
+	InstancedMeshes::INSTANCE_DATA* instanceData =
+		m_frameArena->AllocateArray<InstancedMeshes::INSTANCE_DATA>(totalInstances);
+
+	int instanceCount = 0;
+	m_drawBatches.clear();
+	for (int chunk = 0; chunk < chunkCount; chunk++)
+	{
+		const INSTANCE_LIST& list = m_instanceLists[chunk];
+
+		for (size_t b = 0; b < list.batches.size(); b++)
+		{
+			DRAW_BATCH batch = list.batches[b];
+			batch.firstInstance += instanceCount;
+			m_drawBatches.push_back(batch);
+		}
+		std::copy(list.instances.begin(), list.instances.end(), instanceData + instanceCount);
+		instanceCount += (int)list.instances.size();
+	}
+
+	if (instanceCount > 0)
+	{
+		m_instancedMeshes->SetInstanceData(instanceData, instanceCount);
+	}
+	m_bInstancesDirty = false;
+	m_bVisibilityDirty = false;
+}
+
+/***********************************************************
+ *  ParallelFor()
+ *
+ *  This method is used for running a loop body over ranges
+ *  of the items on the job threads, or over all of them on
+ *  this thread when there is no job system.
+ ***********************************************************/
+void SceneManager::ParallelFor(int count, int minChunk, const JobSystem::RANGE_FUNCTION& function)
+{
+	if (count <= 0)
+	{
+		return;
+	}
+
+	if (m_jobSystem != NULL)
+	{
+		m_jobSystem->ParallelFor(count, minChunk, function);
+	}
+	else
+	{
+		function(0, count, 0);
+	}
+}
+
+/***********************************************************
+ *  ResetRenderState()
+ *
+ *  This method is used for forgetting the shader state of
+ *  the last draw, so that the next draw sets every value.
+ ***********************************************************/
+void SceneManager::ResetRenderState()
+{
+	m_renderState.programID = 0;
+	m_renderState.textureBinding = -1;
+	m_renderState.materialIndex = -1;
+	m_renderState.bUseTexture = -1;
+	m_renderState.bUseInstancing = -1;
+	m_renderState.bUseMaterialIndex = -1;
+	m_renderState.bUseDrawRecords = -1;
+}
+
+/***********************************************************
+ *  ApplyRenderState()
+ *
+ *  This method is used for setting the program, texture
+ *  binding and material of the next draw into the shader.
+ *  Values that are equal to the ones set by the previous draw
+ *  are skipped.  Draws without a material keep the last
+ *  material, as before.
+ ***********************************************************/
+void SceneManager::ApplyRenderState(int textureBinding, int materialIndex)
+{
+	UseDrawProgram(GetDrawProgram(textureBinding));
+
+	int bUseTexture = (textureBinding >= 0) ? 1 : 0;
+
+	if (bUseTexture != m_renderState.bUseTexture)
+	{
+		m_pUniformCache->SetBool(m_uniforms.bUseTexture, bUseTexture == 1);
+		m_renderState.bUseTexture = bUseTexture;
+		m_stateChangeCount++;
+	}
+
+	if ((textureBinding >= 0) && (textureBinding != m_renderState.textureBinding))
+	{
+		if (m_bUseTextureArrays == true)
+		{
+			// the array sampler always reads the same unit, only the
+			// bound array changes
+			glActiveTexture(GL_TEXTURE0 + m_arrayTextureUnit);
+			glBindTexture(GL_TEXTURE_2D_ARRAY, m_textureStorage->GetArrayID(textureBinding));
+		}
+		else
+		{
+			m_pUniformCache->SetSampler2D(m_uniforms.objectTexture, BindTextureSlot(textureBinding));
+		}
+		m_renderState.textureBinding = textureBinding;
+		m_stateChangeCount++;
+	}
+
+	if ((materialIndex >= 0) && (materialIndex != m_renderState.materialIndex))
+	{
+		SetShaderMaterial(m_objectMaterials[materialIndex]);
+		m_renderState.materialIndex = materialIndex;
+		m_stateChangeCount++;
+	}
+}
+
+/***********************************************************
+ *  DrawSceneMeshInstanced()
+ *
+ *  This method is used for drawing a range of instances of
+ *  the passed in basic mesh.
+ ***********************************************************/
+void SceneManager::DrawSceneMeshInstanced(MESH_TYPE mesh, int firstInstance, int instanceCount, int lod)
+{
+	switch (mesh)
+	{
+	case MESH_PLANE:
+		m_instancedMeshes->DrawPlaneMeshInstanced(firstInstance, instanceCount);
+		break;
+	case MESH_BOX:
+		m_instancedMeshes->DrawBoxMeshInstanced(firstInstance, instanceCount);
+		break;
+	case MESH_CYLINDER:
+		m_instancedMeshes->DrawCylinderMeshInstanced(firstInstance, instanceCount, lod);
+		break;
+	case MESH_SPHERE:
+		m_instancedMeshes->DrawSphereMeshInstanced(firstInstance, instanceCount, lod);
+		break;
+	default:
+		break;
+	}
+}
+
+/***********************************************************
+ *  UploadSceneMaterials()
+ *
+ *  This method is used for copying the defined materials
+ *  into the material block, where draws that take their
+ *  material from the instance buffer read them.  Returns
+ *  false when there are more materials than the block holds.
+ ***********************************************************/
+bool SceneManager::UploadSceneMaterials()
+{
+	if ((NULL == m_pUniformBuffers) || (m_objectMaterials.size() > TOTAL_MATERIALS))
+	{
+		return(false);
+	}
+
+	UBO_MATERIAL_BLOCK& block = m_pUniformBuffers->GetMaterials();
+	for (size_t i = 0; i < m_objectMaterials.size(); i++)
+	{
+		block.materials[i].diffuseColor = m_objectMaterials[i].diffuseColor;
+		block.materials[i].specularColor = m_objectMaterials[i].specularColor;
+		block.materials[i].shininess = m_objectMaterials[i].shininess;
+	}
+	m_pUniformBuffers->UploadMaterials();
+
+	return(true);
+}
+
+/***********************************************************
+ *  InitializeGpuCulling()
+ *
+ *  This method is used for creating the GPU culling pass.
+ *  The scene is drawn with the CPU culling path when the
+ *  context has no compute shaders, the program does not
+ *  build, or the materials do not fit the material block.
+ ***********************************************************/
+void SceneManager::InitializeGpuCulling()
+{
+	m_bUseGpuCulling = false;
+
+	if (GpuCulling::IsSupported() == false)
+	{
+		return;
+	}
+
+	if (UploadSceneMaterials() == false)
+	{
+		std::cout << "Too many materials for the material block, culling on the CPU" << std::endl;
+		return;
+	}
+
+	m_gpuCulling = new GpuCulling();
+	if (m_gpuCulling->Initialize(g_CullShaderFile) == false)
+	{
+		std::cout << "Could not build the culling program, culling on the CPU" << std::endl;
+		delete m_gpuCulling;
+		m_gpuCulling = NULL;
+		return;
+	}
+
+	m_gpuCulling->SetLodThresholds(g_LodScreenSizes, InstancedMeshes::LOD_COUNT - 1, m_lodHysteresis);
+	m_bUseGpuCulling = true;
+	m_bInstancesDirty = true;
+
+	if (m_bUseOcclusion == true)
+	{
+		m_hiZBuffer = new HiZBuffer();
+		if (m_hiZBuffer->Initialize(g_HiZShaderFile) == false)
+		{
+			std::cout << "Could not build the depth pyramid program, no occlusion culling" << std::endl;
+			delete m_hiZBuffer;
+			m_hiZBuffer = NULL;
+		}
+	}
+}
+
+/***********************************************************
+ *  InitializeDrawRing()
+ *
+ *  This method is used for creating the ring that the per
+ *  object path streams its draw values through.  The values
+ *  are set as uniforms when the context cannot map buffers
+ *  persistently, or the materials do not fit the material
+ *  block the records index.
+ ***********************************************************/
+void SceneManager::InitializeDrawRing()
+{
+	if (DrawRecordRing::IsSupported() == false)
+	{
+		return;
+	}
+
+	if (UploadSceneMaterials() == false)
+	{
+		std::cout << "Too many materials for the material block, draw values are set as uniforms" << std::endl;
+		return;
+	}
+
+	m_drawRing = new DrawRecordRing();
+	if (m_drawRing->Reserve((int)m_sceneObjects.size()) == false)
+	{
+		delete m_drawRing;
+		m_drawRing = NULL;
+	}
+}
+
+/***********************************************************
+ *  AddClusteredLight()
+ *
+ *  This method is used for adding a point light that fades
+ *  out to nothing at its radius.  Such lights are binned
+ *  into the view clusters, so a fragment only shades the
+ *  ones that reach it.
+ ***********************************************************/
+void SceneManager::AddClusteredLight(
+	glm::vec3 position,
+	float radius,
+	glm::vec3 ambient,
+	glm::vec3 diffuse,
+	glm::vec3 specular)
+{
+	if (radius <= 0.0f)
+	{
+		return;
+	}
+
+	LightClusters::CLUSTER_LIGHT light;
+	memset((void*)&light, 0, sizeof(light));
+	light.position = position;
+	light.radius = radius;
+	light.ambient = ambient;
+	light.diffuse = diffuse;
+	light.specular = specular;
+
+	m_clusterLights.push_back(light);
+	m_bClusterLightsDirty = true;
+}
+
+/***********************************************************
+ *  AddCeilingLights()
+ *
+ *  This method is used for spreading the requested ceiling
+ *  lights over the area of the scene grid, in rows that
+ *  keep the spacing about the same along X and Z.
+ ***********************************************************/
+void SceneManager::AddCeilingLights()
+{
+	if (m_ceilingLightCount <= 0)
+	{
+		return;
+	}
+
+	float width = (float)m_gridColumns * SCENE_CELL_WIDTH;
+	float depth = (float)m_gridRows * SCENE_CELL_DEPTH;
+	int columns = std::max(1, (int)std::ceil(std::sqrt((float)m_ceilingLightCount * width / depth)));
+	int rows = (m_ceilingLightCount + columns - 1) / columns;
+	float spacingX = width / (float)columns;
+	float spacingZ = depth / (float)rows;
+	float radius = g_CeilingLightRange * std::max(spacingX, spacingZ);
+
+	// the first grid cell is centered on the origin
+	glm::vec3 corner(-0.5f * SCENE_CELL_WIDTH, g_CeilingLightHeight, -0.5f * SCENE_CELL_DEPTH);
+	for (int i = 0; i < m_ceilingLightCount; i++)
+	{
+		glm::vec3 position = corner + glm::vec3(
+			((float)(i % columns) + 0.5f) * spacingX,
+			0.0f,
+			((float)(i / columns) + 0.5f) * spacingZ);
+
+		AddClusteredLight(
+			position,
+			radius,
+			glm::vec3(0.0f, 0.0f, 0.0f),
+			glm::vec3(0.3f, 0.3f, 0.27f),
+			glm::vec3(0.15f, 0.15f, 0.15f));
+	}
+}
+
+/***********************************************************
+ *  InitializeLightClusters()
+ *
+ *  This method is used for creating the light cluster pass.
+ *  The point lights with a radius are not drawn when the
+ *  context has no compute shaders or the program does not
+ *  build - the lights of the light block still are.
+ ***********************************************************/
+void SceneManager::InitializeLightClusters()
+{
+	if (LightClusters::IsSupported() == false)
+	{
+		if (m_clusterLights.empty() == false)
+		{
+			std::cout << "Light clusters need compute shaders, " << m_clusterLights.size()
+				<< " point lights with a radius are not drawn" << std::endl;
+		}
+		return;
+	}
+
+	m_lightClusters = new LightClusters();
+	if (m_lightClusters->Initialize(g_LightClusterShaderFile) == false)
+	{
+		std::cout << "Could not build the light cluster program, point lights with a radius are not drawn" << std::endl;
+		delete m_lightClusters;
+		m_lightClusters = NULL;
+		return;
+	}
+
+	m_bClusterLightsDirty = true;
+	if (m_clusterLights.empty() == false)
+	{
+		std::cout << "Clustering " << m_clusterLights.size() << " point lights" << std::endl;
+	}
+}
+
+/***********************************************************
+ *  UpdateLightClusters()
+ *
+ *  This method is used for uploading changed clustered
+ *  lights, binning them for the camera of the frame and
+ *  binding the light and cluster buffers.  The buffer
+ *  samplers always point at their own units, even when
+ *  the clusters are off, since the texture samplers of the
+ *  program may never share a unit with them.
+ ***********************************************************/
+void SceneManager::UpdateLightClusters()
+{
+	if ((NULL != m_lightClusters) && (m_bClusterLightsDirty == true))
+	{
+		m_lightClusters->SetLights(m_clusterLights.data(), (int)m_clusterLights.size());
+		m_bClusterLightsDirty = false;
+	}
+
+	m_bDrawLightClusters = (NULL != m_lightClusters) && (m_lightClusters->GetLightCount() > 0) &&
+		(m_clusterLightUnit >= 0) && (NULL != m_pUniformBuffers);
+	if (m_bDrawLightClusters == true)
+	{
+		// the clusters are cut from the viewport the scene is drawn to
+		GLint viewport[4] = { 0, 0, 0, 0 };
+		glGetIntegerv(GL_VIEWPORT, viewport);
+
+		const UBO_CAMERA_BLOCK& camera = m_pUniformBuffers->GetCamera();
+		m_lightClusters->Update(camera.view, camera.projection, viewport[2], viewport[3]);
+		m_lightClusters->BindTextures(m_clusterLightUnit, m_clusterEntryUnit);
+	}
+
+	SetLightClusterUniforms();
+}
+
+/***********************************************************
+ *  SetLightClusterUniforms()
+ *
+ *  This method is used for setting the light cluster
+ *  uniforms of this frame into the current program.
+ ***********************************************************/
+void SceneManager::SetLightClusterUniforms()
+{
+	if (m_clusterLightUnit >= 0)
+	{
+		m_pUniformCache->SetSampler2D(m_uniforms.clusterLights, m_clusterLightUnit);
+		m_pUniformCache->SetSampler2D(m_uniforms.clusterEntries, m_clusterEntryUnit);
+	}
+
+	m_pUniformCache->SetBool(m_uniforms.bUseLightClusters, m_bDrawLightClusters);
+	if (m_bDrawLightClusters == true)
+	{
+		m_pUniformCache->SetVec4(m_uniforms.clusterParameters, m_lightClusters->GetShaderParameters());
+	}
+}
+
+/***********************************************************
+ *  InitializeShaderVariants()
+ *
+ *  This method is used for creating the shader variant
+ *  cache and building the variants of the light setup the
+ *  scene starts with, so the first frame does not compile
+ *  them.  Without the shader files every draw uses the
+ *  loaded program.
+ ***********************************************************/
+void SceneManager::InitializeShaderVariants()
+{
+	if ((m_vertexShaderFile.empty() == true) || (m_fragmentShaderFile.empty() == true))
+	{
+		return;
+	}
+
+	m_shaderVariants = new ShaderVariants(m_pUniformCache, m_pUniformBuffers);
+	m_shaderVariants->SetShaderFiles(m_vertexShaderFile.c_str(), m_fragmentShaderFile.c_str());
+
+	UpdateDrawPrograms();
+	std::cout << "Built " << m_shaderVariants->GetProgramCount() << " shader variants" << std::endl;
+}
+
+/***********************************************************
+ *  UpdateDrawPrograms()
+ *
+ *  This method is used for choosing the programs of the
+ *  untextured and the textured draws for the lights that
+ *  are switched on.  A changed light setup picks other
+ *  variants, which are built the first time they are used,
+ *  and the draws are sorted again by their new program.
+ ***********************************************************/
+void SceneManager::UpdateDrawPrograms()
+{
+	GLuint programs[2] = { m_pUniformCache->GetProgramID(), m_pUniformCache->GetProgramID() };
+
+	if ((NULL != m_shaderVariants) && (NULL != m_pUniformBuffers))
+	{
+		// the scene program always draws lit
+		unsigned int key = ShaderVariants::GetLightKey(m_pUniformBuffers->GetLights()) |
+			ShaderVariants::VARIANT_LIGHTING;
+
+		GLuint untextured = m_shaderVariants->GetProgram(key);
+		GLuint textured = m_shaderVariants->GetProgram(key | ShaderVariants::VARIANT_TEXTURE);
+		if (untextured != 0)
+		{
+			programs[0] = untextured;
+		}
+		if (textured != 0)
+		{
+			programs[1] = textured;
+		}
+
+		// the depth pre-pass only needs the position, so it
+		// draws unlit without a texture
+		if (m_renderMode == RENDER_DEPTH_PREPASS)
+		{
+			m_depthProgram = m_shaderVariants->GetProgram(0);
+		}
+	}
+
+	if ((programs[0] != m_drawPrograms[0]) || (programs[1] != m_drawPrograms[1]))
+	{
+		m_drawPrograms[0] = programs[0];
+		m_drawPrograms[1] = programs[1];
+		m_bDrawQueueDirty = true;
+	}
+}
+
+/***********************************************************
+ *  GetDrawProgram()
+ *
+ *  This method is used for getting the program that a draw
+ *  with a texture binding uses, -1 for untextured draws.
+ *  Every draw of the depth pre-pass uses the depth program.
+ ***********************************************************/
+GLuint SceneManager::GetDrawProgram(int textureBinding) const
+{
+	GLuint programID = m_drawPrograms[(textureBinding >= 0) ? 1 : 0];
+	if (m_bDrawingDepth == true)
+	{
+		programID = m_depthProgram;
+	}
+
+	return((programID != 0) ? programID : m_pUniformCache->GetProgramID());
+}
+
+/***********************************************************
+ *  UseDrawProgram()
+ *
+ *  This method is used for making the program of the next
+ *  draw current.  A program that was made current by an
+ *  earlier pass has older values of the uniforms that are
+ *  set once per pass or frame, so they are set again, and
+ *  the values of the previous draw are forgotten.
+ ***********************************************************/
+void SceneManager::UseDrawProgram(GLuint programID)
+{
+	if (programID == m_renderState.programID)
+	{
+		return;
+	}
+
+	if (programID != m_pUniformCache->GetActiveProgramID())
+	{
+		m_pUniformCache->UseProgram(programID);
+
+		m_renderState.textureBinding = -1;
+		m_renderState.materialIndex = -1;
+		m_renderState.bUseTexture = -1;
+
+		m_pUniformCache->SetBool(m_uniforms.bUseLighting, m_bDrawingDepth == false);
+		m_pUniformCache->SetBool(m_uniforms.bUseTextureArray, m_bUseTextureArrays);
+		if (m_arrayTextureUnit >= 0)
+		{
+			m_pUniformCache->SetSampler2D(m_uniforms.objectTextureArray, m_arrayTextureUnit);
+		}
+		// the pass flags that were not set yet this frame are off
+		m_pUniformCache->SetBool(m_uniforms.bUseInstancing, m_renderState.bUseInstancing == 1);
+		m_pUniformCache->SetBool(m_uniforms.bUseMaterialIndex, m_renderState.bUseMaterialIndex == 1);
+		m_pUniformCache->SetBool(m_uniforms.bUseDrawRecords, m_renderState.bUseDrawRecords == 1);
+		SetLightClusterUniforms();
+		SetShadowUniforms();
+		m_stateChangeCount++;
+	}
+
+	m_renderState.programID = programID;
+}
+
+/***********************************************************
+ *  GetMeshRange()
+ *
+ *  This method is used for getting the mesh arena range of
+ *  a detail level of an instanced basic mesh.
+ ***********************************************************/
+MeshArena::MESH_RANGE SceneManager::GetMeshRange(MESH_TYPE mesh, int lod) const
+{
+	switch (mesh)
+	{
+	case MESH_PLANE:
+		return(m_instancedMeshes->GetPlaneRange());
+	case MESH_BOX:
+		return(m_instancedMeshes->GetBoxRange());
+	case MESH_CYLINDER:
+		return(m_instancedMeshes->GetCylinderRange(lod));
+	case MESH_SPHERE:
+		return(m_instancedMeshes->GetSphereRange(lod));
+	default:
+		break;
+	}
+
+	MeshArena::MESH_RANGE empty = { 0, 0, 0 };
+	return(empty);
+}
+
+/***********************************************************
+ *  IsOccluder()
+ *
+ *  This method is used for checking whether a drawn scene
+ *  node is a large flat or solid surface - a wall, a floor
+ *  or a table top - that is worth drawing into the depth
+ *  pyramid.  Thin and round objects hide too little.
+ ***********************************************************/
+bool SceneManager::IsOccluder(int objectIndex) const
+{
+	const SCENE_OBJECT& object = m_sceneObjects[objectIndex];
+
+	if ((object.mesh != MESH_PLANE) && (object.mesh != MESH_BOX))
+	{
+		return(false);
+	}
+
+	glm::vec3 size = m_objectBounds[objectIndex].max - m_objectBounds[objectIndex].min;
+	int largeSides = 0;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		if (size[axis] >= g_OccluderMinSize)
+		{
+			largeSides++;
+		}
+	}
+
+	return(largeSides >= 2);
+}
+
+/***********************************************************
+ *  BuildGpuObjects()
+ *
+ *  This method is used for describing every drawn object to
+ *  the GPU culling pass.  The objects are grouped by texture
+ *  binding and mesh, and every group owns one indirect draw
+ *  command and a range of the instance buffer that is large
+ *  enough for all of its objects to be visible.
+ ***********************************************************/
+void SceneManager::BuildGpuObjects()
+{
+	const std::vector<DrawQueue::DRAW_RECORD>& records = m_drawQueue.GetRecords();
+
+	// the groups in texture binding, then mesh order
+	std::map<std::pair<int, int>, int> groupIndices;
+	for (size_t r = 0; r < records.size(); r++)
+	{
+		groupIndices[std::make_pair(records[r].textureBinding, records[r].mesh)] = 0;
+	}
+
+	m_indirectGroups.clear();
+	for (std::map<std::pair<int, int>, int>::iterator it = groupIndices.begin(); it != groupIndices.end(); ++it)
+	{
+		INDIRECT_GROUP group;
+		group.textureBinding = it->first.first;
+		group.mesh = (MESH_TYPE)it->first.second;
+		group.objectCount = 0;
+		group.firstCommand = 0;
+		group.lodCount = GetMeshLodCount(group.mesh);
+		it->second = (int)m_indirectGroups.size();
+		m_indirectGroups.push_back(group);
+	}
+
+	std::vector<GpuCulling::GPU_OBJECT> objects(records.size());
+	for (size_t r = 0; r < records.size(); r++)
+	{
+		const SCENE_OBJECT& object = m_sceneObjects[records[r].objectIndex];
+		const AABB& bounds = m_objectBounds[records[r].objectIndex];
+		int groupIndex = groupIndices[std::make_pair(records[r].textureBinding, records[r].mesh)];
+		GpuCulling::GPU_OBJECT& gpuObject = objects[r];
+
+		gpuObject.model = object.worldMatrix;
+		gpuObject.color = object.color;
+		gpuObject.boundsMin = glm::vec4(bounds.min, 0.0f);
+		gpuObject.boundsMax = glm::vec4(bounds.max, 0.0f);
+		gpuObject.params = glm::vec4(object.UVscale, 0.0f, (float)std::max(object.materialIndex, 0));
+		if ((m_bUseTextureArrays == true) && (object.textureSlot >= 0))
+		{
+			gpuObject.params.z = (float)m_textureStorage->GetLayer(object.textureSlot);
+		}
+		gpuObject.drawGroup = (uint32_t)groupIndex;
+		gpuObject.flags = 0;
+		gpuObject.lodCount = (uint32_t)m_indirectGroups[groupIndex].lodCount;
+		gpuObject.padding = 0;
+
+		m_indirectGroups[groupIndex].objectCount++;
+	}
+
+	// every detail level of a group has room for all of its
+	// objects, as they may all pick the same level
+	std::vector<GpuCulling::DRAW_COMMAND> commands;
+	GLuint firstInstance = 0;
+	for (size_t g = 0; g < m_indirectGroups.size(); g++)
+	{
+		INDIRECT_GROUP& group = m_indirectGroups[g];
+
+		group.firstCommand = (int)commands.size();
+		for (int lod = 0; lod < group.lodCount; lod++)
+		{
+			MeshArena::MESH_RANGE range = GetMeshRange(group.mesh, lod);
+
+			GpuCulling::DRAW_COMMAND command;
+			command.count = range.indexCount;
+			command.instanceCount = 0;
+			command.firstIndex = range.firstIndex;
+			command.baseVertex = range.baseVertex;
+			command.baseInstance = firstInstance;
+			commands.push_back(command);
+			firstInstance += (GLuint)group.objectCount;
+		}
+	}
+
+	// the objects point at the first command of their group
+	for (size_t r = 0; r < objects.size(); r++)
+	{
+		objects[r].drawGroup = (uint32_t)m_indirectGroups[objects[r].drawGroup].firstCommand;
+	}
+
+	// the occluders follow the culled instances in the instance
+	// buffer, sorted by mesh so each mesh is one draw
+	std::vector<InstancedMeshes::INSTANCE_DATA> occluders;
+	m_occluderBatches.clear();
+	if (NULL != m_hiZBuffer)
+	{
+		for (int mesh = MESH_PLANE; mesh <= MESH_SPHERE; mesh++)
+		{
+			for (size_t r = 0; r < records.size(); r++)
+			{
+				int objectIndex = records[r].objectIndex;
+				if ((records[r].mesh != mesh) || (IsOccluder(objectIndex) == false))
+				{
+					continue;
+				}
+
+				if ((m_occluderBatches.empty() == true) || (m_occluderBatches.back().mesh != (MESH_TYPE)mesh))
+				{
+					DRAW_BATCH batch;
+					batch.mesh = (MESH_TYPE)mesh;
+					batch.lod = 0;
+					batch.materialIndex = -1;
+					batch.textureBinding = -1;
+					batch.firstInstance = (int)(firstInstance + occluders.size());
+					batch.instanceCount = 0;
+					m_occluderBatches.push_back(batch);
+				}
+				m_occluderBatches.back().instanceCount++;
+
+				InstancedMeshes::INSTANCE_DATA instance;
+				instance.model = m_sceneObjects[objectIndex].worldMatrix;
+				instance.color = m_sceneObjects[objectIndex].color;
+				instance.UVscale = glm::vec2(1.0f, 1.0f);
+				instance.textureLayer = 0.0f;
+				instance.materialIndex = 0.0f;
+				occluders.push_back(instance);
+
+				objects[r].flags |= GpuCulling::OBJECT_OCCLUDER;
+			}
+		}
+	}
+
+	m_instancedMeshes->ReserveInstances((int)(firstInstance + occluders.size()));
+	m_instancedMeshes->SetInstanceRange((int)firstInstance, occluders.data(), (int)occluders.size());
+	m_gpuCulling->SetObjects(objects, commands);
+	m_bInstancesDirty = false;
+}
+
+/***********************************************************
+ *  RenderOccluderDepth()
+ *
+ *  This method is used for drawing the occluders depth only
+ *  into the occluder target and building the depth pyramid
+ *  that the culling pass tests the other objects against.
+ ***********************************************************/
+void SceneManager::RenderOccluderDepth()
+{
+	m_hiZBuffer->BeginOccluderPass();
+
+	m_pUniformCache->SetBool(m_uniforms.bUseInstancing, true);
+	m_renderState.bUseInstancing = 1;
+	// only the depth is written, so skip the texture reads
+	ApplyRenderState(-1, -1);
+
+	for (size_t b = 0; b < m_occluderBatches.size(); b++)
+	{
+		const DRAW_BATCH& batch = m_occluderBatches[b];
+
+		DrawSceneMeshInstanced(batch.mesh, batch.firstInstance, batch.instanceCount, batch.lod);
+		m_drawCallCount++;
+	}
+
+	m_hiZBuffer->EndOccluderPass();
+	m_hiZBuffer->BuildPyramid();
+}
+
+/***********************************************************
+ *  RenderSceneIndirect()
+ *
+ *  This method is used for culling the retained scene on
+ *  the GPU and drawing it with the commands the culling pass
+ *  wrote.  The occluders are drawn into the depth pyramid
+ *  first, so objects hidden behind them are never shaded.
+ *  The object buffer is only rebuilt after objects were
+ *  added or moved - a moving camera costs one dispatch and
+ *  one multi-draw per texture binding, whatever the number
+ *  of objects.  The material of every object comes from the
+ *  material block.
+ ***********************************************************/
+void SceneManager::RenderSceneIndirect()
+{
+	if (m_bInstancesDirty == true)
+	{
+		BuildGpuObjects();
+	}
+
+	GpuCulling::CULL_VIEW view;
+	view.viewProjection = glm::mat4(1.0f);
+	view.lodScale = 1.0f;
+	view.bUseFrustum = m_bUseCulling;
+	view.bUseLod = m_bUseLod;
+	if (NULL != m_pUniformBuffers)
+	{
+		const UBO_CAMERA_BLOCK& camera = m_pUniformBuffers->GetCamera();
+		view.viewProjection = camera.projection * camera.view;
+		view.lodScale = camera.projection[1][1];
+	}
+
+	// hide the objects behind the occluders of this frame
+	bool bUseOcclusion = (m_bUseCulling == true) && (NULL != m_hiZBuffer) && (m_occluderBatches.empty() == false);
+	if (bUseOcclusion == true)
+	{
+		RenderOccluderDepth();
+	}
+
+	m_gpuCulling->Cull(
+		view,
+		(bUseOcclusion == true) ? m_hiZBuffer : NULL,
+		m_instancedMeshes->GetInstanceBuffer());
+
+	m_pUniformCache->SetBool(m_uniforms.bUseInstancing, true);
+	m_pUniformCache->SetBool(m_uniforms.bUseMaterialIndex, true);
+	m_renderState.bUseInstancing = 1;
+	m_renderState.bUseMaterialIndex = 1;
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_gpuCulling->GetCommandBuffer());
+	// the culled commands are drawn twice with the pre-pass
+	if (m_renderMode == RENDER_DEPTH_PREPASS)
+	{
+		BeginDepthPrepass();
+		DrawIndirectGroups();
+		BeginShadingPass();
+	}
+	DrawIndirectGroups();
+	if (m_renderMode == RENDER_DEPTH_PREPASS)
+	{
+		EndShadingPass();
+	}
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+	m_pUniformCache->SetBool(m_uniforms.bUseMaterialIndex, false);
+	m_pUniformCache->SetBool(m_uniforms.bUseInstancing, false);
+	m_renderState.bUseInstancing = 0;
+	m_renderState.bUseMaterialIndex = 0;
+}
+
+/***********************************************************
+ *  DrawIndirectGroups()
+ *
+ *  This method is used for drawing the commands that the
+ *  culling pass wrote, one multi-draw per texture binding.
+ *  The depth pre-pass reads no textures.
+ ***********************************************************/
+void SceneManager::DrawIndirectGroups()
+{
+	size_t g = 0;
+	while (g < m_indirectGroups.size())
+	{
+		const INDIRECT_GROUP& group = m_indirectGroups[g];
+
+		// the groups are sorted by texture binding and their
+		// commands are stored in order, and every mesh and detail
+		// level is in the same arena - so all the groups of one
+		// binding are a single multi-draw, and the depth pre-pass
+		// draws every group with one
+		int drawCount = 0;
+		size_t next = g;
+		while ((next < m_indirectGroups.size()) &&
+			((m_bDrawingDepth == true) || (m_indirectGroups[next].textureBinding == group.textureBinding)))
+		{
+			drawCount += m_indirectGroups[next].lodCount;
+			next++;
+		}
+
+		ApplyRenderState((m_bDrawingDepth == true) ? -1 : group.textureBinding, -1);
+		size_t commandOffset = (size_t)group.firstCommand * sizeof(GpuCulling::DRAW_COMMAND);
+		m_instancedMeshes->DrawIndirect(commandOffset, drawCount);
+		m_drawCallCount++;
+
+		g = next;
+	}
+}
+
+/***********************************************************
+ *  BeginDepthPrepass()
+ *
+ *  This method is used for starting the depth pre-pass.
+ *  Only the depth is written, and the draws are unlit and
+ *  untextured so their fragments cost next to nothing.
+ ***********************************************************/
+void SceneManager::BeginDepthPrepass()
+{
+	m_bDrawingDepth = true;
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	glDepthMask(GL_TRUE);
+	glDepthFunc(GL_LESS);
+	// the loaded program does the same when it has no variant
+	m_pUniformCache->SetBool(m_uniforms.bUseLighting, false);
+}
+
+/***********************************************************
+ *  BeginShadingPass()
+ *
+ *  This method is used for starting the shaded pass after
+ *  the depth pre-pass.  Only the fragments at the depth the
+ *  pre-pass wrote pass the test, so every pixel is shaded
+ *  once, and the depth buffer is already complete.  The
+ *  vertex shader declares its position invariant, so every
+ *  program computes the same depth.
+ ***********************************************************/
+void SceneManager::BeginShadingPass()
+{
+	m_bDrawingDepth = false;
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+	glDepthMask(GL_FALSE);
+	glDepthFunc(GL_EQUAL);
+	m_pUniformCache->SetBool(m_uniforms.bUseLighting, true);
+}
+
+/***********************************************************
+ *  EndShadingPass()
+ *
+ *  This method is used for restoring the default depth test
+ *  and depth writes after the shaded pass.
+ ***********************************************************/
+void SceneManager::EndShadingPass()
+{
+	glDepthMask(GL_TRUE);
+	glDepthFunc(GL_LESS);
+}
+
+/***********************************************************
+ *  InitializeShadows()
+ *
+ *  This method is used for creating the shadow maps and the
+ *  shapes the casters are drawn with.  The casters have an
+ *  instance buffer of their own, so the draw paths of the
+ *  scene keep theirs.  Without copies between textures or
+ *  when the caster program does not build, the scene is
+ *  drawn without shadows.
+ ***********************************************************/
+void SceneManager::InitializeShadows()
+{
+	if (ShadowMaps::IsSupported() == false)
+	{
+		std::cout << "Shadow maps need texture copies, the scene is drawn without shadows" << std::endl;
+		return;
+	}
+
+	m_shadowMaps = new ShadowMaps();
+	if (m_shadowMaps->Initialize(g_ShadowVertexShaderFile, g_ShadowFragmentShaderFile) == false)
+	{
+		std::cout << "Could not create the shadow maps, the scene is drawn without shadows" << std::endl;
+		delete m_shadowMaps;
+		m_shadowMaps = NULL;
+		return;
+	}
+
+	m_shadowMeshes = new InstancedMeshes();
+	m_shadowMeshes->LoadPlaneMesh();
+	m_shadowMeshes->LoadBoxMesh();
+	m_shadowMeshes->LoadCylinderMesh();
+	m_shadowMeshes->LoadSphereMesh();
+
+	m_bShadowCastersDirty = true;
+}
+
+/***********************************************************
+ *  BuildShadowCasters()
+ *
+ *  This method is used for sorting the drawn scene nodes
+ *  into the static casters, which are only drawn into the
+ *  cached maps, and the dynamic casters that moved after
+ *  them, which are drawn every frame.  Each list is one
+ *  batch per mesh at the finest detail level, and the
+ *  cached maps are drawn again for the new static casters.
+ ***********************************************************/
+void SceneManager::BuildShadowCasters()
+{
+	m_staticCasterBatches.clear();
+	m_dynamicCasterBatches.clear();
+	m_casterInstances.clear();
+	m_dynamicCasters.clear();
+	m_firstDynamicInstance = 0;
+	m_shadowSceneMin = glm::vec3(3.0e38f);
+	m_shadowSceneMax = glm::vec3(-3.0e38f);
+
+	size_t objectCount = std::min(m_sceneObjects.size(), m_objectBounds.size());
+	for (int dynamic = 0; dynamic <= 1; dynamic++)
+	{
+		std::vector<DRAW_BATCH>& batches = (dynamic == 0) ? m_staticCasterBatches : m_dynamicCasterBatches;
+		m_firstDynamicInstance = (dynamic == 1) ? (int)m_casterInstances.size() : 0;
+
+		for (int mesh = MESH_PLANE; mesh <= MESH_SPHERE; mesh++)
+		{
+			for (size_t i = 0; i < objectCount; i++)
+			{
+				const SCENE_OBJECT& object = m_sceneObjects[i];
+				if ((object.mesh != mesh) || (m_objectDynamic[i] != dynamic))
+				{
+					continue;
+				}
+
+				if ((batches.empty() == true) || (batches.back().mesh != (MESH_TYPE)mesh))
+				{
+					DRAW_BATCH batch;
+					batch.mesh = (MESH_TYPE)mesh;
+					batch.lod = 0;
+					batch.materialIndex = -1;
+					batch.textureBinding = -1;
+					batch.firstInstance = (int)m_casterInstances.size();
+					batch.instanceCount = 0;
+					batches.push_back(batch);
+				}
+				batches.back().instanceCount++;
+
+				InstancedMeshes::INSTANCE_DATA instance;
+				instance.model = object.worldMatrix;
+				instance.color = object.color;
+				instance.UVscale = glm::vec2(1.0f, 1.0f);
+				instance.textureLayer = 0.0f;
+				instance.materialIndex = 0.0f;
+				m_casterInstances.push_back(instance);
+
+				if (dynamic == 1)
+				{
+					m_dynamicCasters.push_back((int)i);
+				}
+				m_shadowSceneMin = glm::min(m_shadowSceneMin, m_objectBounds[i].min);
+				m_shadowSceneMax = glm::max(m_shadowSceneMax, m_objectBounds[i].max);
+			}
+		}
+	}
+
+	if (m_casterInstances.empty() == false)
+	{
+		m_shadowMeshes->ReserveInstances((int)m_casterInstances.size());
+		m_shadowMeshes->SetInstanceRange(0, m_casterInstances.data(), (int)m_casterInstances.size());
+		// every caster is closer to a light inside the scene than
+		// the diagonal of the scene
+		m_shadowMaps->SetPointRange(glm::length(m_shadowSceneMax - m_shadowSceneMin));
+	}
+
+	m_bCascadesCached = false;
+	m_pointShadowCached = 0;
+	m_bShadowCastersDirty = false;
+}
+
+/***********************************************************
+ *  UpdateDynamicCasters()
+ *
+ *  This method is used for copying the world matrices of
+ *  the dynamic casters into their instances, which follow
+ *  the static ones in the caster instance buffer.  A caster
+ *  that moves out of the caster bounds grows them.
+ ***********************************************************/
+void SceneManager::UpdateDynamicCasters()
+{
+	if (m_dynamicCasters.empty() == true)
+	{
+		return;
+	}
+
+	for (size_t d = 0; d < m_dynamicCasters.size(); d++)
+	{
+		int objectIndex = m_dynamicCasters[d];
+		m_casterInstances[m_firstDynamicInstance + d].model = m_sceneObjects[objectIndex].worldMatrix;
+		m_shadowSceneMin = glm::min(m_shadowSceneMin, m_objectBounds[objectIndex].min);
+		m_shadowSceneMax = glm::max(m_shadowSceneMax, m_objectBounds[objectIndex].max);
+	}
+
+	m_shadowMeshes->SetInstanceRange(
+		m_firstDynamicInstance,
+		&m_casterInstances[m_firstDynamicInstance],
+		(int)m_dynamicCasters.size());
+}
+
+/***********************************************************
+ *  InvalidateShadowCasters()
+ *
+ *  This method is used for dropping the caster lists and the
+ *  cached shadow maps after nodes were added, replaced or
+ *  placed again.  Every node starts out as a static caster
+ *  again, and the casters are sorted and the cached maps are
+ *  drawn again by the next UpdateShadows().
+ ***********************************************************/
+void SceneManager::InvalidateShadowCasters()
+{
+	m_objectDynamic.clear();
+	m_bShadowCastersDirty = true;
+	// keeps the first placement of the nodes from counting as a
+	// move of a cached caster
+	m_bStaticShadowsBuilt = false;
+	m_bCascadesCached = false;
+	m_pointShadowCached = 0;
+}
+
+/***********************************************************
+ *  DrawShadowCasters()
+ *
+ *  This method is used for drawing a list of caster batches
+ *  with the caster shapes.
+ ***********************************************************/
+void SceneManager::DrawShadowCasters(const std::vector<DRAW_BATCH>& batches)
+{
+	for (size_t b = 0; b < batches.size(); b++)
+	{
+		const DRAW_BATCH& batch = batches[b];
+
+		switch (batch.mesh)
+		{
+		case MESH_PLANE:
+			m_shadowMeshes->DrawPlaneMeshInstanced(batch.firstInstance, batch.instanceCount);
+			break;
+		case MESH_BOX:
+			m_shadowMeshes->DrawBoxMeshInstanced(batch.firstInstance, batch.instanceCount);
+			break;
+		case MESH_CYLINDER:
+			m_shadowMeshes->DrawCylinderMeshInstanced(batch.firstInstance, batch.instanceCount, batch.lod);
+			break;
+		case MESH_SPHERE:
+			m_shadowMeshes->DrawSphereMeshInstanced(batch.firstInstance, batch.instanceCount, batch.lod);
+			break;
+		default:
+			break;
+		}
+		m_drawCallCount++;
 	}
-
-	return(textureSlot);
 }
 
 /***********************************************************
- *  FindMaterial()
+ *  DrawShadowLayer()
  *
- *  This method is used for getting a material from the previously
- *  defined materials list that is associated with the passed in tag.
+ *  This method is used for bringing one layer of the shadow
+ *  maps up to date.  The static casters are only drawn into
+ *  the cached layer when its view projection or the static
+ *  casters changed, and the sampled layer is only replaced
+ *  when the cached layer or a dynamic caster changed - a
+ *  still scene under still lights draws nothing at all.
  ***********************************************************/
-bool SceneManager::FindMaterial(std::string tag, OBJECT_MATERIAL& material)
+void SceneManager::DrawShadowLayer(
+	ShadowMaps::SHADOW_TARGET target,
+	int layer,
+	const glm::mat4& viewProjection,
+	bool bRedrawStatic,
+	bool bRedrawDynamic)
 {
-	if (m_objectMaterials.size() == 0)
+	if (bRedrawStatic == true)
 	{
-		return(false);
+		m_shadowMaps->BeginLayer(target, true, layer, viewProjection);
+		DrawShadowCasters(m_staticCasterBatches);
 	}
 
-	int index = 0;
-	bool bFound = false;
-	while ((index < m_objectMaterials.size()) && (bFound == false))
+	if ((bRedrawStatic == true) || (bRedrawDynamic == true))
 	{
-		if (m_objectMaterials[index].tag.compare(tag) == 0)
-		{
-			bFound = true;
-			material.diffuseColor = m_objectMaterials[index].diffuseColor;
-			material.specularColor = m_objectMaterials[index].specularColor;
-			material.shininess = m_objectMaterials[index].shininess;
-		}
-		else
+		m_shadowMaps->CopyCachedLayer(target, layer);
+		if (m_dynamicCasterBatches.empty() == false)
 		{
-			index++;
+			m_shadowMaps->BeginLayer(target, false, layer, viewProjection);
+			DrawShadowCasters(m_dynamicCasterBatches);
 		}
 	}
-
-	return(true);
 }
 
 /***********************************************************
- *  SetTransformations()
+ *  UpdateShadows()
  *
- *  This method is used for setting the transform buffer
- *  using the passed in transformation values.
+ *  This method is used for drawing the shadow maps of the
+ *  active directional light and point lights of the light
+ *  block for this frame, and binding them for the scene
+ *  shaders.  The cascades follow the camera in whole grid
+ *  steps, so their cached layers are only drawn again when
+ *  the camera crosses a step, and the cube faces of a point
+ *  light only when the light moves.
  ***********************************************************/
-void SceneManager::SetTransformations(
-	glm::vec3 scaleXYZ,
-	float XrotationDegrees,
-	float YrotationDegrees,
-	float ZrotationDegrees,
-	glm::vec3 positionXYZ)
+void SceneManager::UpdateShadows()
 {
-	// variables for this method
-	glm::mat4 modelView;
-	glm::mat4 scale;
-	glm::mat4 rotationX;
-	glm::mat4 rotationY;
-	glm::mat4 rotationZ;
-	glm::mat4 translation;
+	m_bCascadeShadows = false;
+	m_pointShadowMask = 0;
+	if ((NULL == m_shadowMaps) || (NULL == m_pUniformBuffers))
+	{
+		return;
+	}
 
-	// set the scale value in the transform buffer
-	scale = glm::scale(scaleXYZ);
-	// set the rotation values in the transform buffer
-	rotationX = glm::rotate(glm::radians(XrotationDegrees), glm::vec3(1.0f, 0.0f, 0.0f));
-	rotationY = glm::rotate(glm::radians(YrotationDegrees), glm::vec3(0.0f, 1.0f, 0.0f));
-	rotationZ = glm::rotate(glm::radians(ZrotationDegrees), glm::vec3(0.0f, 0.0f, 1.0f));
-	// set the translation value in the transform buffer
-	translation = glm::translate(positionXYZ);
+	if (m_objectDynamic.size() != m_sceneObjects.size())
+	{
+		m_objectDynamic.resize(m_sceneObjects.size(), 0);
+		m_bShadowCastersDirty = true;
+	}
 
-	modelView = translation * rotationZ * rotationY * rotationX * scale;
+	bool bDynamicMoved = m_bDynamicCastersMoved;
+	if (m_bShadowCastersDirty == true)
+	{
+		BuildShadowCasters();
+	}
+	else if (bDynamicMoved == true)
+	{
+		UpdateDynamicCasters();
+	}
+	m_bDynamicCastersMoved = false;
 
-	if (NULL != m_pShaderManager)
+	if (m_casterInstances.empty() == true)
 	{
-		m_pShaderManager->setMat4Value(g_ModelName, modelView);
+		return;
 	}
-}
 
-/***********************************************************
- *  SetShaderColor()
- *
- *  This method is used for setting the passed in color
- *  into the shader for the next draw command
- ***********************************************************/
-void SceneManager::SetShaderColor(
-	float redColorValue,
-	float greenColorValue,
-	float blueColorValue,
-	float alphaValue)
-{
-	// variables for this method
-	glm::vec4 currentColor;
+	const UBO_LIGHT_BLOCK& lights = m_pUniformBuffers->GetLights();
+	const UBO_CAMERA_BLOCK& camera = m_pUniformBuffers->GetCamera();
 
-	currentColor.r = redColorValue;
-	currentColor.g = greenColorValue;
-	currentColor.b = blueColorValue;
-	currentColor.a = alphaValue;
+	m_shadowMaps->BeginPass();
 
-	if (NULL != m_pShaderManager)
+	if (lights.directionalLight.bActive != 0)
 	{
-		m_pShaderManager->setIntValue(g_UseTextureName, false);
-		m_pShaderManager->setVec4Value(g_ColorValueName, currentColor);
+		int changedCascades = m_shadowMaps->UpdateCascades(
+			lights.directionalLight.direction,
+			camera.view,
+			camera.projection,
+			m_shadowSceneMin,
+			m_shadowSceneMax);
+		if (m_bCascadesCached == false)
+		{
+			changedCascades = (1 << ShadowMaps::CASCADE_COUNT) - 1;
+		}
+
+		for (int c = 0; c < ShadowMaps::CASCADE_COUNT; c++)
+		{
+			DrawShadowLayer(ShadowMaps::TARGET_CASCADE, c, m_shadowMaps->GetCascadeMatrix(c),
+				(changedCascades & (1 << c)) != 0, bDynamicMoved);
+		}
+		m_bCascadesCached = true;
+		m_bCascadeShadows = true;
 	}
-}
 
-/***********************************************************
- *  SetShaderTexture()
- *
- *  This method is used for setting the texture data
- *  associated with the passed in ID into the shader.
- ***********************************************************/
-void SceneManager::SetShaderTexture(
-	std::string textureTag)
-{
-	if (NULL != m_pShaderManager)
+	for (int i = 0; i < TOTAL_POINT_LIGHTS; i++)
 	{
-		m_pShaderManager->setIntValue(g_UseTextureName, true);
+		const UBO_POINT_LIGHT& light = lights.pointLights[i];
+		if (light.bActive == 0)
+		{
+			continue;
+		}
 
-		int textureID = -1;
-		textureID = FindTextureSlot(textureTag);
-		m_pShaderManager->setSampler2DValue(g_TextureValueName, textureID);
+		bool bRedrawStatic = ((m_pointShadowCached & (1 << i)) == 0) || (light.position != m_pointShadowPositions[i]);
+		for (int face = 0; face < ShadowMaps::CUBE_FACES; face++)
+		{
+			DrawShadowLayer(ShadowMaps::TARGET_POINT, i * ShadowMaps::CUBE_FACES + face,
+				m_shadowMaps->GetFaceMatrix(light.position, face), bRedrawStatic, bDynamicMoved);
+		}
+		m_pointShadowPositions[i] = light.position;
+		m_pointShadowCached |= 1 << i;
+		m_pointShadowMask |= 1 << i;
 	}
-}
 
-/***********************************************************
- *  SetTextureUVScale()
- *
- *  This method is used for setting the texture UV scale
- *  values into the shader.
- ***********************************************************/
-void SceneManager::SetTextureUVScale(float u, float v)
-{
-	if (NULL != m_pShaderManager)
+	m_shadowMaps->EndPass();
+	m_bStaticShadowsBuilt = true;
+
+	if (m_cascadeShadowUnit >= 0)
 	{
-		m_pShaderManager->setVec2Value("UVscale", glm::vec2(u, v));
+		m_shadowMaps->BindTextures(m_cascadeShadowUnit, m_pointShadowUnit);
 	}
 }
 
 /***********************************************************
- *  SetShaderMaterial()
+ *  SetShadowUniforms()
  *
- *  This method is used for passing the material values
- *  into the shader.
+ *  This method is used for setting the shadow uniforms of
+ *  this frame into the current program.  The shadow
+ *  samplers always point at their own units, even without
+ *  shadows, since the texture samplers of the program may
+ *  never share a unit with them.
  ***********************************************************/
-void SceneManager::SetShaderMaterial(
-	std::string materialTag)
+void SceneManager::SetShadowUniforms()
 {
-	if (m_objectMaterials.size() > 0)
+	if (m_cascadeShadowUnit >= 0)
 	{
-		OBJECT_MATERIAL material;
-		bool bReturn = false;
+		m_pUniformCache->SetSampler2D(m_uniforms.cascadeShadowMap, m_cascadeShadowUnit);
+		m_pUniformCache->SetSampler2D(m_uniforms.pointShadowMap, m_pointShadowUnit);
+	}
 
-		bReturn = FindMaterial(materialTag, material);
-		if (bReturn == true)
+	m_pUniformCache->SetBool(m_uniforms.bUseCascadeShadows, m_bCascadeShadows);
+	m_pUniformCache->SetInt(m_uniforms.pointShadowMask, m_pointShadowMask);
+	if (m_bCascadeShadows == true)
+	{
+		for (int c = 0; c < ShadowMaps::CASCADE_COUNT; c++)
 		{
-			m_pShaderManager->setVec3Value("material.diffuseColor", material.diffuseColor);
-			m_pShaderManager->setVec3Value("material.specularColor", material.specularColor);
-			m_pShaderManager->setFloatValue("material.shininess", material.shininess);
+			m_pUniformCache->SetMat4(m_uniforms.cascadeMatrices[c], m_shadowMaps->GetCascadeMatrix(c));
 		}
+		m_pUniformCache->SetVec4(m_uniforms.cascadeSplits, m_shadowMaps->GetCascadeSplits());
+	}
+	if (m_pointShadowMask != 0)
+	{
+		m_pUniformCache->SetVec2(m_uniforms.pointShadowParameters, m_shadowMaps->GetPointParameters());
 	}
 }
 
@@ -399,7 +3670,7 @@ void SceneManager::DefineObjectMaterials()
 	stoneMAT.shininess = 5.0;
 	stoneMAT.tag = "stoneMAT";
 
-	m_objectMaterials.push_back(stoneMAT);
+	AddObjectMaterial(stoneMAT);
 
 	OBJECT_MATERIAL metalMAT;
 	metalMAT.ambientColor = glm::vec3(0.1f, 0.1f, 0.1f);
@@ -409,7 +3680,7 @@ void SceneManager::DefineObjectMaterials()
 	metalMAT.shininess = 15.0;
 	metalMAT.tag = "metalMAT";
 
-	m_objectMaterials.push_back(metalMAT);
+	AddObjectMaterial(metalMAT);
 
 	OBJECT_MATERIAL woodMaterial;
 	woodMaterial.ambientColor = glm::vec3(0.3f, 0.25f, 0.1f);   
@@ -419,7 +3690,7 @@ void SceneManager::DefineObjectMaterials()
 	woodMaterial.shininess = 5.0f;
 	woodMaterial.tag = "woodMAT";
 
-	m_objectMaterials.push_back(woodMaterial);
+	AddObjectMaterial(woodMaterial);
 
 	OBJECT_MATERIAL rubberMaterial;
 	rubberMaterial.ambientColor = glm::vec3(0.05f, 0.05f, 0.05f); 
@@ -429,7 +3700,7 @@ void SceneManager::DefineObjectMaterials()
 	rubberMaterial.shininess = 1.0f;
 	rubberMaterial.tag = "rubberMAT";
 
-	m_objectMaterials.push_back(rubberMaterial);
+	AddObjectMaterial(rubberMaterial);
 }
 
 
@@ -440,26 +3711,35 @@ void SceneManager::SetupSceneLights()
 	// the 3D scene with custom lighting, if no light sources have
 	// been added then the display window will be black - to use the 
 	// default OpenGL lighting then comment out the following line
-    m_pShaderManager->setBoolValue(g_UseLightingName, true);
+    m_pUniformCache->SetBool(m_uniforms.bUseLighting, true);
 
 	/*** STUDENTS - add the code BELOW for setting up light sources ***/
-	/*** Up to four light sources can be defined. Refer to the code ***/
-	/*** in the OpenGL Sample for help                              ***/
+	/*** The light block holds one directional light, up to five    ***/
+	/*** point lights and one spot light that light the whole       ***/
+	/*** scene.  Any number of point lights with a radius can be    ***/
+	/*** added with AddClusteredLight(). Refer to the code in the   ***/
+	/*** OpenGL Sample for help                                     ***/
 
 
+	// the lights are written into the shared light block and
+	// uploaded with a single buffer update - any light that is
+	// not set here stays inactive
+	UBO_LIGHT_BLOCK& lights = m_pUniformBuffers->GetLights();
+
 	// point light 1
-	m_pShaderManager->setVec3Value("pointLights[0].position", 16.0f, 25.0f, 1.5f);
-	m_pShaderManager->setVec3Value("pointLights[0].ambient", 0.35f, 0.35f, 0.35f);
-	m_pShaderManager->setVec3Value("pointLights[0].diffuse", 0.7f, 0.7f, 0.8f);
-	m_pShaderManager->setVec3Value("pointLights[0].specular", 0.5f, 0.5f, 0.6f);
-	m_pShaderManager->setBoolValue("pointLights[0].bActive", true);
+	lights.pointLights[0].position = glm::vec3(16.0f, 25.0f, 1.5f);
+	lights.pointLights[0].ambient = glm::vec3(0.35f, 0.35f, 0.35f);
+	lights.pointLights[0].diffuse = glm::vec3(0.7f, 0.7f, 0.8f);
+	lights.pointLights[0].specular = glm::vec3(0.5f, 0.5f, 0.6f);
+	lights.pointLights[0].bActive = true;
 	// point light 2
-	m_pShaderManager->setVec3Value("pointLights[1].position", -14.0f, 25.0f, -10.0f);
-	m_pShaderManager->setVec3Value("pointLights[1].ambient", 0.35f, 0.35f, 0.35f);
-	m_pShaderManager->setVec3Value("pointLights[1].diffuse", 0.7f, 0.7f, 0.8f);
-	m_pShaderManager->setVec3Value("pointLights[1].specular", 0.5f, 0.5f, 0.6f);
-	m_pShaderManager->setBoolValue("pointLights[1].bActive", true);
+	lights.pointLights[1].position = glm::vec3(-14.0f, 25.0f, -10.0f);
+	lights.pointLights[1].ambient = glm::vec3(0.35f, 0.35f, 0.35f);
+	lights.pointLights[1].diffuse = glm::vec3(0.7f, 0.7f, 0.8f);
+	lights.pointLights[1].specular = glm::vec3(0.5f, 0.5f, 0.6f);
+	lights.pointLights[1].bActive = true;
 
+	m_pUniformBuffers->UploadLights();
 }
 
 
@@ -467,26 +3747,28 @@ void SceneManager::SetupSceneLights()
 void SceneManager::LoadSceneTextures()
 {
 	bool bReturn = false;
+	// the images are decoded on worker threads while the scene
+	// starts rendering, each texture appears once it is uploaded
 	// LOADS FLOOR TEXTURE
-	bReturn = CreateGLTexture("textures/asphalt-floor.png", "floor");
+	bReturn = LoadGLTextureAsync("textures/asphalt-floor.png", "floor");
 
 	// LOADS ATLAS STONE TEXTURES
-	bReturn = CreateGLTexture("textures/concrete-stones.png", "atlas-stone");
+	bReturn = LoadGLTextureAsync("textures/concrete-stones.png", "atlas-stone");
 
 	// LOADS FAR WALL TEXTURE
-	bReturn = CreateGLTexture("textures/concrete-walls.png", "walls");
+	bReturn = LoadGLTextureAsync("textures/concrete-walls.png", "walls");
 
 	// LOADS LIFTING BENCH TEXTURE
-	bReturn = CreateGLTexture("textures/rubber-bench.png", "bench");
+	bReturn = LoadGLTextureAsync("textures/rubber-bench.png", "bench");
 
 	// LOADS METAL TEXTURE
-	bReturn = CreateGLTexture("textures/metal-beams.png", "metal");
+	bReturn = LoadGLTextureAsync("textures/metal-beams.png", "metal");
 
 	// LOADS WOOD TEXTURE
-	bReturn = CreateGLTexture("textures/wood-base.png", "wood");
+	bReturn = LoadGLTextureAsync("textures/wood-base.png", "wood");
 
 	// LOADS DUMBBELL TEXTURE
-	bReturn = CreateGLTexture("textures/dumbbells.png", "dbell");
+	bReturn = LoadGLTextureAsync("textures/dumbbells.png", "dbell");
 
 
 	// Binds textures to the available slots
@@ -503,11 +3785,31 @@ void SceneManager::LoadSceneTextures()
  ***********************************************************/
 void SceneManager::PrepareScene()
 {
-	LoadSceneTextures();
-	// define the materials for objects in the scene
-	DefineObjectMaterials();
-	// add and define the light sources for the scene
-	SetupSceneLights();
+	// the worker threads for the scene update, the calling
+	// thread counts as one of them
+	if ((m_jobSystem == NULL) && (m_jobThreadCount != 1))
+	{
+		m_jobSystem = new JobSystem(m_jobThreadCount);
+		std::cout << "Scene update uses " << m_jobSystem->GetThreadCount() << " threads" << std::endl;
+	}
+
+	// a scene file replaces the four definitions below as a whole,
+	// they are only used when no file is set or it fails to open
+	if ((m_sceneFile.empty() == true) || (LoadSceneFile(m_sceneFile.c_str()) == false))
+	{
+		LoadSceneTextures();
+		// define the materials for objects in the scene
+		DefineObjectMaterials();
+		// add and define the light sources for the scene
+		SetupSceneLights();
+		// build the retained scene objects once - the tags used by
+		// the objects are resolved against the loaded textures and
+		// the defined materials above
+		DefineSceneObjects();
+	}
+	// copy the prefabs when a larger scene grid is requested
+	ReplicateSceneGrid();
+	AddCeilingLights();
 
 	// only one instance of a particular mesh needs to be
 	// loaded in memory no matter how many times it is drawn
@@ -517,853 +3819,902 @@ void SceneManager::PrepareScene()
 	m_basicMeshes->LoadBoxMesh();
 	m_basicMeshes->LoadCylinderMesh();
 	m_basicMeshes->LoadSphereMesh();
-}
 
-/***********************************************************
- *  RenderScene()
- *
- *  This method is used for rendering the 3D scene by 
- *  transforming and drawing the basic 3D shapes
- ***********************************************************/
-void SceneManager::RenderScene()
-{
-	// declare the variables for the transformations
-	glm::vec3 scaleXYZ;
-	float XrotationDegrees = 0.0f;
-	float YrotationDegrees = 0.0f;
-	float ZrotationDegrees = 0.0f;
-	glm::vec3 positionXYZ;
+	// the instanced copies of the same shapes used for
+	// drawing whole batches of objects at once
+	m_instancedMeshes->LoadPlaneMesh();
+	m_instancedMeshes->LoadBoxMesh();
+	m_instancedMeshes->LoadCylinderMesh();
+	m_instancedMeshes->LoadSphereMesh();
 
-	/*** Set needed transformations before drawing the basic mesh.  ***/
-	/*** This same ordering of code should be used for transforming ***/
-	/*** and drawing all the basic 3D shapes.						***/
-	/******************************************************************/
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(25.0f, 1.0f, 15.0f);
+	// cull and draw on the GPU when the context supports it
+	if ((m_bUseGpuCulling == true) && (m_bUseInstancing == true))
+	{
+		InitializeGpuCulling();
+	}
+	else
+	{
+		m_bUseGpuCulling = false;
+	}
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+	// stream the draw values of the per object path
+	if (m_bUseInstancing == false)
+	{
+		InitializeDrawRing();
+	}
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(0.0f, 0.0f, 0.0f);
+	// the per object path streams its draw values once per frame,
+	// so it can not draw the scene twice
+	if ((m_renderMode == RENDER_DEPTH_PREPASS) && (m_bUseInstancing == false))
+	{
+		std::cout << "The depth pre-pass needs instancing, drawing the scene in one pass" << std::endl;
+		m_renderMode = RENDER_FORWARD;
+	}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// bin the point lights with a radius into view clusters
+	if (m_bUseLightClusters == true)
+	{
+		InitializeLightClusters();
+	}
+	else if (m_clusterLights.empty() == false)
+	{
+		std::cout << "Light clusters are off, " << m_clusterLights.size()
+			<< " point lights with a radius are not drawn" << std::endl;
+	}
 
-    SetShaderColor(0.5, 0.52, 0.55, 1);
-	SetShaderMaterial("stoneMAT");
-	SetTextureUVScale(2.0f, 2.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderTexture("floor"); // SETS SHAPE TEXTURE
+	// the shadows of the directional light and the light block
+	if (m_bUseShadows == true)
+	{
+		InitializeShadows();
+	}
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawPlaneMesh();
-	/****************************************************************/
+	// compile the fixed texture and light setups of the scene
+	if (m_bUseShaderVariants == true)
+	{
+		InitializeShaderVariants();
+	}
+}
 
-	/*** Set needed transformations before drawing the basic mesh.  ***/
-	/*** This same ordering of code should be used for transforming ***/
-	/*** and drawing all the basic 3D shapes.						***/
+/***********************************************************
+ *  DefineSceneObjects()
+ *
+ *  This method is used for defining the objects that make up
+ *  the 3D scene.  Each object is added to the retained scene
+ *  once, and RenderScene() only redraws the stored records.
+ ***********************************************************/
+void SceneManager::DefineSceneObjects()
+{
+	/*** Objects are added with their parent group, mesh shape,  ***/
+	/*** scale, rotation, position, color, material, texture and ***/
+	/*** texture UV scale.  Objects without a texture are drawn  ***/
+	/*** with their color only.                                  ***/
 	/******************************************************************/
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(25.0f, 1.0f, 15.0f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 90.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(0.0f, 15.0f, -15.0f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	// set the color values into the shader
-	SetShaderColor(0.6, 0.62, 0.65, 1);
-	SetShaderMaterial("stoneMAT");
-	SetTextureUVScale(3.0f, 3.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderTexture("walls"); // SETS SHAPE TEXTURE
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawPlaneMesh();
-	/****************************************************************/
-
 
+	// FLOOR PLANE
+	AddSceneObject(-1, MESH_PLANE,
+		glm::vec3(25.0f, 1.0f, 15.0f),	// SCALE
+		glm::vec3(0.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(0.0f, 0.0f, 0.0f),	// POSITION
+		glm::vec4(0.5f, 0.52f, 0.55f, 1.0f),
+		"stoneMAT", "floor", glm::vec2(2.0f, 2.0f));
+
+	// BACK WALL PLANE
+	AddSceneObject(-1, MESH_PLANE,
+		glm::vec3(25.0f, 1.0f, 15.0f),	// SCALE
+		glm::vec3(90.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(0.0f, 15.0f, -15.0f),	// POSITION
+		glm::vec4(0.6f, 0.62f, 0.65f, 1.0f),
+		"stoneMAT", "walls", glm::vec2(3.0f, 3.0f));
 
 	// ATLAS STONE TABLES
+	int closeTable = AddSceneGroup(-1);
+	int farTable = AddSceneGroup(-1);
 
-	// CLOSE TABLE SHAPES 
+	// CLOSE TABLE SHAPES
 
 	// CLOSE TABLE WOOD BASE
-	SetTransformations(
-		glm::vec3(4.35f, 0.5f, 4.35f), // SCALE
-		0.0f, 0.0f, 0.0f,              // ROTAION
-		glm::vec3(16.0f, 8.0f, 6.0f)   // POSITION
-	);
-	SetShaderColor(1.0f, 0.894f, 0.769f, 1.0f); // Sets Bisque Color
-	SetShaderMaterial("woodMAT");
-	SetTextureUVScale(5.0f, 77.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderTexture("wood"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawBoxMesh();
+	AddSceneObject(closeTable, MESH_BOX,
+		glm::vec3(4.35f, 0.5f, 4.35f),	// SCALE
+		glm::vec3(0.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(16.0f, 8.0f, 6.0f),	// POSITION
+		glm::vec4(1.0f, 0.894f, 0.769f, 1.0f),
+		"woodMAT", "wood", glm::vec2(5.0f, 77.0f));
 
 	// CLOSE TABLE METAL BASE
-	SetTransformations(
-		glm::vec3(4.35f, 0.5f, 4.35f), // SCALE
-		0.0f, 0.0f, 0.0f,              // ROTAION
-		glm::vec3(16.0f, 7.5f, 6.0f)   // POSITION
-	);
-	SetShaderColor(0.15f, 0.15f, 0.15f, 1.0f); // Sets Steel Color
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("metal");
-	m_basicMeshes->DrawBoxMesh();
+	AddSceneObject(closeTable, MESH_BOX,
+		glm::vec3(4.35f, 0.5f, 4.35f),	// SCALE
+		glm::vec3(0.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(16.0f, 7.5f, 6.0f),	// POSITION
+		glm::vec4(0.15f, 0.15f, 0.15f, 1.0f),
+		"metalMAT", "metal", glm::vec2(5.0f, 77.0f));
 
 	// LEG
-	SetTransformations(
-		glm::vec3(0.5f, 0.5f, 7.5f),     // SCALE
-		90.0f, 0.0f, 0.0f,               // ROTAION
-		glm::vec3(16.5f, 3.95f, 4.15f)   // POSITION
-	);
-	SetShaderColor(0.15f, 0.15f, 0.15f, 1.0f); // Sets Steel Color
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("metal");
-	m_basicMeshes->DrawBoxMesh();
+	AddSceneObject(closeTable, MESH_BOX,
+		glm::vec3(0.5f, 0.5f, 7.5f),	// SCALE
+		glm::vec3(90.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(16.5f, 3.95f, 4.15f),	// POSITION
+		glm::vec4(0.15f, 0.15f, 0.15f, 1.0f),
+		"metalMAT", "metal", glm::vec2(5.0f, 77.0f));
 
 	// LEG
-	SetTransformations(
-		glm::vec3(0.5f, 0.5f, 7.5f),    // SCALE
-		90.0f, 0.0f, 0.0f,              // ROTAION
-		glm::vec3(16.5f, 3.95f, 7.9f)   // POSITION
-	);
-	SetShaderColor(0.15f, 0.15f, 0.15f, 1.0f); // Sets Steel Color
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("metal");
-	m_basicMeshes->DrawBoxMesh();
+	AddSceneObject(closeTable, MESH_BOX,
+		glm::vec3(0.5f, 0.5f, 7.5f),	// SCALE
+		glm::vec3(90.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(16.5f, 3.95f, 7.9f),	// POSITION
+		glm::vec4(0.15f, 0.15f, 0.15f, 1.0f),
+		"metalMAT", "metal", glm::vec2(5.0f, 77.0f));
 
 	// BASE
-	SetTransformations(
-		glm::vec3(0.5f, 0.5f, 4.5f),     // SCALE
-		0.0f, 90.0f, 0.0f,               // ROTAION
-		glm::vec3(16.25f, 0.25f, 7.9f)   // POSITION
-	);
-	SetShaderColor(0.15f, 0.15f, 0.15f, 1.0f); // Sets Steel Color
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("metal");
-	m_basicMeshes->DrawBoxMesh();
+	AddSceneObject(closeTable, MESH_BOX,
+		glm::vec3(0.5f, 0.5f, 4.5f),	// SCALE
+		glm::vec3(0.0f, 90.0f, 0.0f),	// ROTATION
+		glm::vec3(16.25f, 0.25f, 7.9f),	// POSITION
+		glm::vec4(0.15f, 0.15f, 0.15f, 1.0f),
+		"metalMAT", "metal", glm::vec2(5.0f, 77.0f));
 
 	// BASE
-	SetTransformations(
-		glm::vec3(0.5f, 0.5f, 4.5f),     // SCALE
-		0.0f, 90.0f, 0.0f,               // ROTAION
-		glm::vec3(16.25f, 0.25f, 4.125f) // POSITION
-	);
-	SetShaderColor(0.15f, 0.15f, 0.15f, 1.0f); // Sets Steel Color
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("metal");
-	m_basicMeshes->DrawBoxMesh();
+	AddSceneObject(closeTable, MESH_BOX,
+		glm::vec3(0.5f, 0.5f, 4.5f),	// SCALE
+		glm::vec3(0.0f, 90.0f, 0.0f),	// ROTATION
+		glm::vec3(16.25f, 0.25f, 4.125f),	// POSITION
+		glm::vec4(0.15f, 0.15f, 0.15f, 1.0f),
+		"metalMAT", "metal", glm::vec2(5.0f, 77.0f));
 
 	// BASE REAR CROSS SUPPORT
-	SetTransformations(
-		glm::vec3(0.5f, 0.5f, 4.5f),    // SCALE
-		0.0f, 0.0f, 90.0f,              // ROTAION
-		glm::vec3(18.25f, 0.25f, 6.0f)  // POSITION
-	);
-	SetShaderColor(0.15f, 0.15f, 0.15f, 1.0f); // Sets Steel Color
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("metal");
-	m_basicMeshes->DrawBoxMesh();
-	
+	AddSceneObject(closeTable, MESH_BOX,
+		glm::vec3(0.5f, 0.5f, 4.5f),	// SCALE
+		glm::vec3(0.0f, 0.0f, 90.0f),	// ROTATION
+		glm::vec3(18.25f, 0.25f, 6.0f),	// POSITION
+		glm::vec4(0.15f, 0.15f, 0.15f, 1.0f),
+		"metalMAT", "metal", glm::vec2(5.0f, 77.0f));
+
 	// STONE "HOLE"
-	SetTransformations(
-		glm::vec3(1.0f, 0.1f, 1.0), // SCALE
-		0.0f, 0.0f, 0.0f,			// ROTATION
-		glm::vec3(16.0f, 7.155f, -3.0f) // POSITION
-	);
-	SetShaderColor(0.15f, 0.15f, 0.15f, 1.0f);
-	m_basicMeshes->DrawCylinderMesh();
+	AddSceneObject(farTable, MESH_CYLINDER,
+		glm::vec3(1.0f, 0.1f, 1.0f),	// SCALE
+		glm::vec3(0.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(16.0f, 7.155f, -3.0f),	// POSITION
+		glm::vec4(0.15f, 0.15f, 0.15f, 1.0f),
+		"metalMAT", NULL, glm::vec2(5.0f, 77.0f));
 
 
 	// FAR TABLE SHAPES
 
 	// FAR TABLE WOOD BASE
-	SetTransformations(
-		glm::vec3(4.35f, 0.5f, 4.35f), // SCALE
-		0.0f, 0.0f, 0.0f,              // ROTAION
-		glm::vec3(16.0f, 7.0f, -3.0f)  // POSITION
-	);
-	SetShaderColor(1.0f, 0.894f, 0.769f, 1.0f); // Sets Bisque Color
-	SetShaderMaterial("woodMAT");
-	SetTextureUVScale(5.0f, 77.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderTexture("wood"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawBoxMesh();
+	AddSceneObject(farTable, MESH_BOX,
+		glm::vec3(4.35f, 0.5f, 4.35f),	// SCALE
+		glm::vec3(0.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(16.0f, 7.0f, -3.0f),	// POSITION
+		glm::vec4(1.0f, 0.894f, 0.769f, 1.0f),
+		"woodMAT", "wood", glm::vec2(5.0f, 77.0f));
 
 	// FAR TABLE METAL BASE
-	SetTransformations(
-		glm::vec3(4.35f, 0.5f, 4.35f), // SCALE
-		0.0f, 0.0f, 0.0f,              // ROTAION
-		glm::vec3(16.0f, 6.5f, -3.0f)  // POSITION
-	);
-	SetShaderColor(0.15f, 0.15f, 0.15f, 1.0f); // Sets Steel Color
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("metal");
-	m_basicMeshes->DrawBoxMesh();
+	AddSceneObject(farTable, MESH_BOX,
+		glm::vec3(4.35f, 0.5f, 4.35f),	// SCALE
+		glm::vec3(0.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(16.0f, 6.5f, -3.0f),	// POSITION
+		glm::vec4(0.15f, 0.15f, 0.15f, 1.0f),
+		"metalMAT", "metal", glm::vec2(5.0f, 77.0f));
 
 	// LEG
-	SetTransformations(
-		glm::vec3(0.5f, 0.5f, 6.5f), // SCALE
-		90.0f, 0.0f, 0.0f,              // ROTAION
-		glm::vec3(16.5f, 3.125f, -4.925f)   // POSITION
-	);
-	SetShaderColor(0.15f, 0.15f, 0.15f, 1.0f); // Sets Steel Color
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("metal");
-	m_basicMeshes->DrawBoxMesh();
+	AddSceneObject(farTable, MESH_BOX,
+		glm::vec3(0.5f, 0.5f, 6.5f),	// SCALE
+		glm::vec3(90.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(16.5f, 3.125f, -4.925f),	// POSITION
+		glm::vec4(0.15f, 0.15f, 0.15f, 1.0f),
+		"metalMAT", "metal", glm::vec2(5.0f, 77.0f));
 
 	// LEG
-	SetTransformations(
-		glm::vec3(0.5f, 0.5f, 6.5f), // SCALE
-		90.0f, 0.0f, 0.0f,              // ROTAION
-		glm::vec3(16.5f, 3.125f, -1.075f)   // POSITION
-	);
-	SetShaderColor(0.15f, 0.15f, 0.15f, 1.0f); // Sets Steel Color
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("metal");
-	m_basicMeshes->DrawBoxMesh();
+	AddSceneObject(farTable, MESH_BOX,
+		glm::vec3(0.5f, 0.5f, 6.5f),	// SCALE
+		glm::vec3(90.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(16.5f, 3.125f, -1.075f),	// POSITION
+		glm::vec4(0.15f, 0.15f, 0.15f, 1.0f),
+		"metalMAT", "metal", glm::vec2(5.0f, 77.0f));
 
 	// BASE
-	SetTransformations(
-		glm::vec3(0.5f, 0.5f, 4.5f),     // SCALE
-		0.0f, 90.0f, 0.0f,               // ROTAION
-		glm::vec3(16.25f, 0.25f, -4.925f)   // POSITION
-	);
-	SetShaderColor(0.15f, 0.15f, 0.15f, 1.0f); // Sets Steel Color
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("metal");
-	m_basicMeshes->DrawBoxMesh();
+	AddSceneObject(farTable, MESH_BOX,
+		glm::vec3(0.5f, 0.5f, 4.5f),	// SCALE
+		glm::vec3(0.0f, 90.0f, 0.0f),	// ROTATION
+		glm::vec3(16.25f, 0.25f, -4.925f),	// POSITION
+		glm::vec4(0.15f, 0.15f, 0.15f, 1.0f),
+		"metalMAT", "metal", glm::vec2(5.0f, 77.0f));
 
 	// BASE
-	SetTransformations(
-		glm::vec3(0.5f, 0.5f, 4.5f),     // SCALE
-		0.0f, 90.0f, 0.0f,               // ROTAION
-		glm::vec3(16.25f, 0.25f, -1.075f) // POSITION
-	);
-	SetShaderColor(0.15f, 0.15f, 0.15f, 1.0f); // Sets Steel Color
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("metal");
-	m_basicMeshes->DrawBoxMesh();
+	AddSceneObject(farTable, MESH_BOX,
+		glm::vec3(0.5f, 0.5f, 4.5f),	// SCALE
+		glm::vec3(0.0f, 90.0f, 0.0f),	// ROTATION
+		glm::vec3(16.25f, 0.25f, -1.075f),	// POSITION
+		glm::vec4(0.15f, 0.15f, 0.15f, 1.0f),
+		"metalMAT", "metal", glm::vec2(5.0f, 77.0f));
 
 	// BASE REAR CROSS SUPPORT
-	SetTransformations(
-		glm::vec3(0.5f, 0.5f, 4.5f),    // SCALE
-		0.0f, 0.0f, 90.0f,              // ROTAION
-		glm::vec3(18.25f, 0.25f, -3.0f)  // POSITION
-	);
-	SetShaderColor(0.15f, 0.15f, 0.15f, 1.0f); // Sets Steel Color
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("metal");
-	m_basicMeshes->DrawBoxMesh();
+	AddSceneObject(farTable, MESH_BOX,
+		glm::vec3(0.5f, 0.5f, 4.5f),	// SCALE
+		glm::vec3(0.0f, 0.0f, 90.0f),	// ROTATION
+		glm::vec3(18.25f, 0.25f, -3.0f),	// POSITION
+		glm::vec4(0.15f, 0.15f, 0.15f, 1.0f),
+		"metalMAT", "metal", glm::vec2(5.0f, 77.0f));
 
 	// STONE "HOLE"
-	SetTransformations(
-		glm::vec3(1.0f, 0.1f, 1.0), // SCALE
-		0.0f, 0.0f, 0.0f,			// ROTATION
-		glm::vec3(16.0f, 8.155f, 6.0f) // POSITION
-	);
-	SetShaderColor(0.15f, 0.15f, 0.15f, 1.0f);
-	m_basicMeshes->DrawCylinderMesh();
-
-	
+	AddSceneObject(closeTable, MESH_CYLINDER,
+		glm::vec3(1.0f, 0.1f, 1.0f),	// SCALE
+		glm::vec3(0.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(16.0f, 8.155f, 6.0f),	// POSITION
+		glm::vec4(0.15f, 0.15f, 0.15f, 1.0f),
+		"metalMAT", NULL, glm::vec2(5.0f, 77.0f));
+
+
 	// ATLAS STONES
+	int atlasStones = AddSceneGroup(-1);
 
 	// FAR STONE
-	SetTransformations(
-		glm::vec3(2.25f, 2.25f, 2.25f), // SCALE
-		0.0f, 0.0f, 0.0f,				// ROTATION
-		glm::vec3(10.0f, 2.35f, -3.0f)	// POSITION
-	);
-	SetShaderColor(0.725f, 0.725f, 0.655f, 1.0f); // Sets Concrete Color
-	SetTextureUVScale(2.0f, 2.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("stoneMAT");
-	SetShaderTexture("atlas-stone"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawSphereMesh();
+	AddSceneObject(atlasStones, MESH_SPHERE,
+		glm::vec3(2.25f, 2.25f, 2.25f),	// SCALE
+		glm::vec3(0.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(10.0f, 2.35f, -3.0f),	// POSITION
+		glm::vec4(0.725f, 0.725f, 0.655f, 1.0f),
+		"stoneMAT", "atlas-stone", glm::vec2(2.0f, 2.0f));
 
 	// CLOSE STONE
-	SetTransformations(
-		glm::vec3(1.75f, 1.75f, 1.75f), // SCALE
-		0.0f, 0.0f, 0.0f,				// ROTATION
-		glm::vec3(10.0f, 1.95f, 6.0f)	// POSITION
-	);
-	SetShaderColor(0.725f, 0.725f, 0.655f, 1.0f); // Sets Concrete Color
-	SetTextureUVScale(2.0f, 2.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("stoneMAT");
-	SetShaderTexture("atlas-stone"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawSphereMesh();
+	AddSceneObject(atlasStones, MESH_SPHERE,
+		glm::vec3(1.75f, 1.75f, 1.75f),	// SCALE
+		glm::vec3(0.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(10.0f, 1.95f, 6.0f),	// POSITION
+		glm::vec4(0.725f, 0.725f, 0.655f, 1.0f),
+		"stoneMAT", "atlas-stone", glm::vec2(2.0f, 2.0f));
 
 
 	// LIFTING BENCHES
 
 	// LEFT SIDE BENCH
+	int leftBench = AddSceneGroup(-1);
 
 	// "SEAT" PLATFORM
-	SetTransformations(
-		glm::vec3(0.5f, 2.5f, 10.75f),    // SCALE
-		0.0f, 0.0f, 90.0f,              // ROTAION
-		glm::vec3(-15.25f, 3.025f, 3.0f)  // POSITION
-	);
-	SetShaderColor(0.15f, 0.15f, 0.15f, 1.0f); // Sets Dark Grey Color
-	SetTextureUVScale(0.75f, 0.75f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("rubberMAT");
-	SetShaderTexture("bench"); // SETS SHAPE TEXTURE
-
-	m_basicMeshes->DrawBoxMesh();
+	AddSceneObject(leftBench, MESH_BOX,
+		glm::vec3(0.5f, 2.5f, 10.75f),	// SCALE
+		glm::vec3(0.0f, 0.0f, 90.0f),	// ROTATION
+		glm::vec3(-15.25f, 3.025f, 3.0f),	// POSITION
+		glm::vec4(0.15f, 0.15f, 0.15f, 1.0f),
+		"rubberMAT", "bench", glm::vec2(0.75f, 0.75f));
 
 	// FAR BOTTOM SUPPORT BAR
-	SetTransformations(
-		glm::vec3(1.075f, 0.5f, 3.5f),     // SCALE
-		0.0f, 90.0f, 0.0f,               // ROTAION
-		glm::vec3(-15.25f, 0.25f, -1.25f)   // POSITION
-	);
-	SetShaderColor(0.25f, 0.25f, 0.25f, 1.0f); // Sets Steel Color
-	SetTextureUVScale(35.0f, 35.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("metal"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawBoxMesh();
+	AddSceneObject(leftBench, MESH_BOX,
+		glm::vec3(1.075f, 0.5f, 3.5f),	// SCALE
+		glm::vec3(0.0f, 90.0f, 0.0f),	// ROTATION
+		glm::vec3(-15.25f, 0.25f, -1.25f),	// POSITION
+		glm::vec4(0.25f, 0.25f, 0.25f, 1.0f),
+		"metalMAT", "metal", glm::vec2(35.0f, 35.0f));
 
 	// FAR VERTICAL SUPPORT PILLAR
-	SetTransformations(
-		glm::vec3(1.075f, 1.0f, 2.85f),     // SCALE
-		90.0f, 0.0f, 0.0f,               // ROTAION
-		glm::vec3(-15.25f, 1.345f, -1.25f)   // POSITION
-	);
-	SetShaderColor(0.25f, 0.25f, 0.25f, 1.0f); // Sets Steel Color
-	SetTextureUVScale(35.0f, 35.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("metal"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawBoxMesh();
+	AddSceneObject(leftBench, MESH_BOX,
+		glm::vec3(1.075f, 1.0f, 2.85f),	// SCALE
+		glm::vec3(90.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(-15.25f, 1.345f, -1.25f),	// POSITION
+		glm::vec4(0.25f, 0.25f, 0.25f, 1.0f),
+		"metalMAT", "metal", glm::vec2(35.0f, 35.0f));
 
 	// NEAR BOTTOM SUPPORT BAR
-	SetTransformations(
-		glm::vec3(1.075f, 0.5f, 3.5f),     // SCALE
-		0.0f, 90.0f, 0.0f,               // ROTAION
-		glm::vec3(-15.25f, 0.25f, 7.15f)   // POSITION
-	);
-	SetShaderColor(0.25f, 0.25f, 0.25f, 1.0f); // Sets Steel Color
-	SetTextureUVScale(35.0f, 35.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("metal"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawBoxMesh();
+	AddSceneObject(leftBench, MESH_BOX,
+		glm::vec3(1.075f, 0.5f, 3.5f),	// SCALE
+		glm::vec3(0.0f, 90.0f, 0.0f),	// ROTATION
+		glm::vec3(-15.25f, 0.25f, 7.15f),	// POSITION
+		glm::vec4(0.25f, 0.25f, 0.25f, 1.0f),
+		"metalMAT", "metal", glm::vec2(35.0f, 35.0f));
 
 	// NEAR VERTICAL SUPPORT PILLAR
-	SetTransformations(
-		glm::vec3(1.075f, 1.0f, 2.85f),     // SCALE
-		90.0f, 0.0f, 0.0f,               // ROTAION
-		glm::vec3(-15.25f, 1.345f, 7.15f)   // POSITION
-	);
-	SetShaderColor(0.25f, 0.25f, 0.25f, 1.0f); // Sets Steel Color
-	SetTextureUVScale(35.0f, 35.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("metal"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawBoxMesh();
+	AddSceneObject(leftBench, MESH_BOX,
+		glm::vec3(1.075f, 1.0f, 2.85f),	// SCALE
+		glm::vec3(90.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(-15.25f, 1.345f, 7.15f),	// POSITION
+		glm::vec4(0.25f, 0.25f, 0.25f, 1.0f),
+		"metalMAT", "metal", glm::vec2(35.0f, 35.0f));
 
 	// RIGHT SIDE BENCH
+	int rightBench = AddSceneGroup(-1);
 
 	// "SEAT" PLATFORM
-	SetTransformations(
-		glm::vec3(0.5f, 2.5f, 10.75f),    // SCALE
-		0.0f, 0.0f, 90.0f,              // ROTAION
-		glm::vec3(-5.25f, 3.025f, 3.0f)  // POSITION
-	);
-	SetShaderColor(0.15f, 0.15f, 0.15f, 1.0f); // Sets Dark Grey Color
-	SetTextureUVScale(0.75f, 0.75f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("rubberMAT");
-	SetShaderTexture("bench"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawBoxMesh();
+	AddSceneObject(rightBench, MESH_BOX,
+		glm::vec3(0.5f, 2.5f, 10.75f),	// SCALE
+		glm::vec3(0.0f, 0.0f, 90.0f),	// ROTATION
+		glm::vec3(-5.25f, 3.025f, 3.0f),	// POSITION
+		glm::vec4(0.15f, 0.15f, 0.15f, 1.0f),
+		"rubberMAT", "bench", glm::vec2(0.75f, 0.75f));
 
 	// FAR BOTTOM SUPPORT BAR
-	SetTransformations(
-		glm::vec3(1.075f, 0.5f, 3.5f),     // SCALE
-		0.0f, 90.0f, 0.0f,               // ROTAION
-		glm::vec3(-5.25f, 0.25f, -1.25f)   // POSITION
-	);
-	SetShaderColor(0.25f, 0.25f, 0.25f, 1.0f); // Sets Steel Color
-	SetTextureUVScale(35.0f, 35.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("metal"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawBoxMesh();
+	AddSceneObject(rightBench, MESH_BOX,
+		glm::vec3(1.075f, 0.5f, 3.5f),	// SCALE
+		glm::vec3(0.0f, 90.0f, 0.0f),	// ROTATION
+		glm::vec3(-5.25f, 0.25f, -1.25f),	// POSITION
+		glm::vec4(0.25f, 0.25f, 0.25f, 1.0f),
+		"metalMAT", "metal", glm::vec2(35.0f, 35.0f));
 
 	// FAR VERTICAL SUPPORT PILLAR
-	SetTransformations(
-		glm::vec3(1.075f, 1.0f, 2.85f),     // SCALE
-		90.0f, 0.0f, 0.0f,               // ROTAION
-		glm::vec3(-5.25f, 1.345f, -1.25f)   // POSITION
-	);
-	SetShaderColor(0.25f, 0.25f, 0.25f, 1.0f); // Sets Steel Color
-	SetTextureUVScale(35.0f, 35.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("metal"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawBoxMesh();
+	AddSceneObject(rightBench, MESH_BOX,
+		glm::vec3(1.075f, 1.0f, 2.85f),	// SCALE
+		glm::vec3(90.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(-5.25f, 1.345f, -1.25f),	// POSITION
+		glm::vec4(0.25f, 0.25f, 0.25f, 1.0f),
+		"metalMAT", "metal", glm::vec2(35.0f, 35.0f));
 
 	// NEAR BOTTOM SUPPORT BAR
-	SetTransformations(
-		glm::vec3(1.075f, 0.5f, 3.5f),     // SCALE
-		0.0f, 90.0f, 0.0f,               // ROTAION
-		glm::vec3(-5.25f, 0.25f, 7.15f)   // POSITION
-	);
-	SetShaderColor(0.25f, 0.25f, 0.25f, 1.0f); // Sets Steel Color
-	SetTextureUVScale(35.0f, 35.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("metal"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawBoxMesh();
+	AddSceneObject(rightBench, MESH_BOX,
+		glm::vec3(1.075f, 0.5f, 3.5f),	// SCALE
+		glm::vec3(0.0f, 90.0f, 0.0f),	// ROTATION
+		glm::vec3(-5.25f, 0.25f, 7.15f),	// POSITION
+		glm::vec4(0.25f, 0.25f, 0.25f, 1.0f),
+		"metalMAT", "metal", glm::vec2(35.0f, 35.0f));
 
 	// NEAR VERTICAL SUPPORT PILLAR
-	SetTransformations(
-		glm::vec3(1.075f, 1.0f, 2.85f),     // SCALE
-		90.0f, 0.0f, 0.0f,               // ROTAION
-		glm::vec3(-5.25f, 1.345f, 7.15f)   // POSITION
-	);
-	SetShaderColor(0.25f, 0.25f, 0.25f, 1.0f); // Sets Steel Color
-	SetTextureUVScale(35.0f, 35.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("metal"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawBoxMesh();
+	AddSceneObject(rightBench, MESH_BOX,
+		glm::vec3(1.075f, 1.0f, 2.85f),	// SCALE
+		glm::vec3(90.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(-5.25f, 1.345f, 7.15f),	// POSITION
+		glm::vec4(0.25f, 0.25f, 0.25f, 1.0f),
+		"metalMAT", "metal", glm::vec2(35.0f, 35.0f));
 
 
 	// DUMBBELL RACK
+	int dumbbellRack = AddSceneGroup(-1);
 
 	// DUMBBELL HOLDER BAR
-	SetTransformations(
-		glm::vec3(17.5f, 0.8f, 0.4f),     // SCALE
-		90.0f, 0.0f, 0.0f,               // ROTAION
-		glm::vec3(-10.25f, 5.345f, -10.15f)   // POSITION
-	);
-	SetShaderColor(0.25f, 0.25f, 0.25f, 1.0f); // Sets Steel Color
-	SetTextureUVScale(35.0f, 35.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("metal"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawBoxMesh();
+	AddSceneObject(dumbbellRack, MESH_BOX,
+		glm::vec3(17.5f, 0.8f, 0.4f),	// SCALE
+		glm::vec3(90.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(-10.25f, 5.345f, -10.15f),	// POSITION
+		glm::vec4(0.25f, 0.25f, 0.25f, 1.0f),
+		"metalMAT", "metal", glm::vec2(35.0f, 35.0f));
 
 	// LEFT CROSS SUPPORT BAR
-	SetTransformations(
-		glm::vec3(0.8f, 3.0f, 1.0f),     // SCALE
-		90.0f, 0.0f, 0.0f,               // ROTAION
-		glm::vec3(-18.6f, 5.0f, -10.15f)   // POSITION
-	);
-	SetShaderColor(0.25f, 0.25f, 0.25f, 1.0f); // Sets Steel Color
-	SetTextureUVScale(35.0f, 35.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("metal"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawBoxMesh();
+	AddSceneObject(dumbbellRack, MESH_BOX,
+		glm::vec3(0.8f, 3.0f, 1.0f),	// SCALE
+		glm::vec3(90.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(-18.6f, 5.0f, -10.15f),	// POSITION
+		glm::vec4(0.25f, 0.25f, 0.25f, 1.0f),
+		"metalMAT", "metal", glm::vec2(35.0f, 35.0f));
 
 	// LEFT CLOSE SUPPORT BAR
-	SetTransformations(
-		glm::vec3(0.8f, 6.0f, 1.0f),     // SCALE
-		-20.0f, 0.0f, 0.0f,               // ROTAION
-		glm::vec3(-18.6f, 2.345f, -8.1)   // POSITION
-	);
-	SetShaderColor(0.25f, 0.25f, 0.25f, 1.0f); // Sets Steel Color
-	SetTextureUVScale(35.0f, 35.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("metal"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawBoxMesh();
+	AddSceneObject(dumbbellRack, MESH_BOX,
+		glm::vec3(0.8f, 6.0f, 1.0f),	// SCALE
+		glm::vec3(-20.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(-18.6f, 2.345f, -8.1f),	// POSITION
+		glm::vec4(0.25f, 0.25f, 0.25f, 1.0f),
+		"metalMAT", "metal", glm::vec2(35.0f, 35.0f));
 
 	// LEFT FAR SUPPORT BAR
-	SetTransformations(
-		glm::vec3(0.8f, 6.0f, 1.0f),     // SCALE
-		20.0f, 0.0f, 0.0f,               // ROTAION
-		glm::vec3(-18.6f, 2.345f, -12.15f)   // POSITION
-	);
-	SetShaderColor(0.25f, 0.25f, 0.25f, 1.0f); // Sets Steel Color
-	SetTextureUVScale(35.0f, 35.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("metal"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawBoxMesh();
+	AddSceneObject(dumbbellRack, MESH_BOX,
+		glm::vec3(0.8f, 6.0f, 1.0f),	// SCALE
+		glm::vec3(20.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(-18.6f, 2.345f, -12.15f),	// POSITION
+		glm::vec4(0.25f, 0.25f, 0.25f, 1.0f),
+		"metalMAT", "metal", glm::vec2(35.0f, 35.0f));
 
 	// MIDDLE CROSS SUPPORT BAR
-	SetTransformations(
-		glm::vec3(0.8f, 3.0f, 1.0f),     // SCALE
-		90.0f, 0.0f, 0.0f,               // ROTAION
-		glm::vec3(-10.25f, 5.0f, -10.15f)   // POSITION
-	);
-	SetShaderColor(0.25f, 0.25f, 0.25f, 1.0f); // Sets Steel Color
-	SetTextureUVScale(35.0f, 35.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("metal"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawBoxMesh();
+	AddSceneObject(dumbbellRack, MESH_BOX,
+		glm::vec3(0.8f, 3.0f, 1.0f),	// SCALE
+		glm::vec3(90.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(-10.25f, 5.0f, -10.15f),	// POSITION
+		glm::vec4(0.25f, 0.25f, 0.25f, 1.0f),
+		"metalMAT", "metal", glm::vec2(35.0f, 35.0f));
 
 	// MIDDLE CLOSE SUPPORT BAR
-	SetTransformations(
-		glm::vec3(0.8f, 6.0f, 1.0f),     // SCALE
-		-20.0f, 0.0f, 0.0f,               // ROTAION
-		glm::vec3(-10.25f, 2.345f, -8.1f)   // POSITION
-	);
-	SetShaderColor(0.25f, 0.25f, 0.25f, 1.0f); // Sets Steel Color
-	SetTextureUVScale(35.0f, 35.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("metal"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawBoxMesh();
+	AddSceneObject(dumbbellRack, MESH_BOX,
+		glm::vec3(0.8f, 6.0f, 1.0f),	// SCALE
+		glm::vec3(-20.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(-10.25f, 2.345f, -8.1f),	// POSITION
+		glm::vec4(0.25f, 0.25f, 0.25f, 1.0f),
+		"metalMAT", "metal", glm::vec2(35.0f, 35.0f));
 
 	// MIDDLE FAR SUPPORT BAR
-	SetTransformations(
-		glm::vec3(0.8f, 6.0f, 1.0f),     // SCALE
-		20.0f, 0.0f, 0.0f,               // ROTAION
-		glm::vec3(-10.25f, 2.345f, -12.15f)   // POSITION
-	);
-	SetShaderColor(0.25f, 0.25f, 0.25f, 1.0f); // Sets Steel Color
-	SetTextureUVScale(35.0f, 35.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("metal"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawBoxMesh();
+	AddSceneObject(dumbbellRack, MESH_BOX,
+		glm::vec3(0.8f, 6.0f, 1.0f),	// SCALE
+		glm::vec3(20.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(-10.25f, 2.345f, -12.15f),	// POSITION
+		glm::vec4(0.25f, 0.25f, 0.25f, 1.0f),
+		"metalMAT", "metal", glm::vec2(35.0f, 35.0f));
 
 	// RIGHT CROSS SUPPORT BAR
-	SetTransformations(
-		glm::vec3(0.8f, 3.0f, 1.0f),     // SCALE
-		90.0f, 0.0f, 0.0f,               // ROTAION
-		glm::vec3(-1.9f, 5.0f, -10.15f)   // POSITION
-	);
-	SetShaderColor(0.25f, 0.25f, 0.25f, 1.0f); // Sets Steel Color
-	SetTextureUVScale(35.0f, 35.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("metal"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawBoxMesh();
+	AddSceneObject(dumbbellRack, MESH_BOX,
+		glm::vec3(0.8f, 3.0f, 1.0f),	// SCALE
+		glm::vec3(90.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(-1.9f, 5.0f, -10.15f),	// POSITION
+		glm::vec4(0.25f, 0.25f, 0.25f, 1.0f),
+		"metalMAT", "metal", glm::vec2(35.0f, 35.0f));
 
 	// RIGHT CLOSE SUPPORT BAR
-	SetTransformations(
-		glm::vec3(0.8f, 6.0f, 1.0f),     // SCALE
-		-20.0f, 0.0f, 0.0f,               // ROTAION
-		glm::vec3(-1.9, 2.345f, -8.1f)   // POSITION
-	);
-	SetShaderColor(0.25f, 0.25f, 0.25f, 1.0f); // Sets Steel Color
-	SetTextureUVScale(35.0f, 35.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("metal"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawBoxMesh();
+	AddSceneObject(dumbbellRack, MESH_BOX,
+		glm::vec3(0.8f, 6.0f, 1.0f),	// SCALE
+		glm::vec3(-20.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(-1.9f, 2.345f, -8.1f),	// POSITION
+		glm::vec4(0.25f, 0.25f, 0.25f, 1.0f),
+		"metalMAT", "metal", glm::vec2(35.0f, 35.0f));
 
 	// RIGHT FAR SUPPORT BAR
-	SetTransformations(
-		glm::vec3(0.8f, 6.0f, 1.0f),     // SCALE
-		20.0f, 0.0f, 0.0f,               // ROTAION
-		glm::vec3(-1.9f, 2.345f, -12.15f)   // POSITION
-	);
-	SetShaderColor(0.25f, 0.25f, 0.25f, 1.0f); // Sets Steel Color
-	SetTextureUVScale(35.0f, 35.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("metal"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawBoxMesh();
+	AddSceneObject(dumbbellRack, MESH_BOX,
+		glm::vec3(0.8f, 6.0f, 1.0f),	// SCALE
+		glm::vec3(20.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(-1.9f, 2.345f, -12.15f),	// POSITION
+		glm::vec4(0.25f, 0.25f, 0.25f, 1.0f),
+		"metalMAT", "metal", glm::vec2(35.0f, 35.0f));
 
 
 	// YORK GLOBE DUMBBELLS (STARTING ON FAR LEFT SIDE OF RACK)
 
 	// LEFT 65LB DUMBBELL
 	// MIDDLE GRIP
-	SetTransformations(
-		glm::vec3(0.2f, 1.2f, 0.2f),     // SCALE
-		90.0f, 0.0f, 0.0f,               // ROTAION
-		glm::vec3(-17.5f, 5.75f, -10.75f)   // POSITION
-	);
-	SetShaderColor(0.25f, 0.25f, 0.25f, 1.0f); // Sets Steel Color
-	SetTextureUVScale(1.0f, 1.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("dbell"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawCylinderMesh();
+	AddSceneObject(dumbbellRack, MESH_CYLINDER,
+		glm::vec3(0.2f, 1.2f, 0.2f),	// SCALE
+		glm::vec3(90.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(-17.5f, 5.75f, -10.75f),	// POSITION
+		glm::vec4(0.25f, 0.25f, 0.25f, 1.0f),
+		"metalMAT", "dbell", glm::vec2(1.0f, 1.0f));
 
 	// REAR WEIGHT GLOBE
-	SetTransformations(
-		glm::vec3(0.75f, 0.75f, 0.75f),     // SCALE
-		0.0f, 0.0f, 0.0f,               // ROTAION
-		glm::vec3(-17.5f, 5.75f, -11.45f)   // POSITION
-	);
-	SetShaderColor(0.25f, 0.25f, 0.25f, 1.0f); // Sets Steel Color
-	SetTextureUVScale(1.0f, 1.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("dbell"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawSphereMesh();
+	AddSceneObject(dumbbellRack, MESH_SPHERE,
+		glm::vec3(0.75f, 0.75f, 0.75f),	// SCALE
+		glm::vec3(0.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(-17.5f, 5.75f, -11.45f),	// POSITION
+		glm::vec4(0.25f, 0.25f, 0.25f, 1.0f),
+		"metalMAT", "dbell", glm::vec2(1.0f, 1.0f));
 
 	// FRONT WEIGHT GLOBE
-	SetTransformations(
-		glm::vec3(0.75f, 0.75f, 0.75f),     // SCALE
-		0.0f, 0.0f, 0.0f,               // ROTAION
-		glm::vec3(-17.5f, 5.75f, -8.85f)   // POSITION
-	);
-	SetShaderColor(0.25f, 0.25f, 0.25f, 1.0f); // Sets Steel Color
-	SetTextureUVScale(1.0f, 1.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("dbell"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawSphereMesh();
+	AddSceneObject(dumbbellRack, MESH_SPHERE,
+		glm::vec3(0.75f, 0.75f, 0.75f),	// SCALE
+		glm::vec3(0.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(-17.5f, 5.75f, -8.85f),	// POSITION
+		glm::vec4(0.25f, 0.25f, 0.25f, 1.0f),
+		"metalMAT", "dbell", glm::vec2(1.0f, 1.0f));
 
 
 	// RIGHT 65LB DUMBBELL
 	// MIDDLE GRIP
-	SetTransformations(
-		glm::vec3(0.2f, 1.2f, 0.2f),     // SCALE
-		90.0f, 0.0f, 0.0f,               // ROTAION
-		glm::vec3(-15.75f, 5.75f, -10.75f)   // POSITION
-	);
-	SetShaderColor(0.25f, 0.25f, 0.25f, 1.0f); // Sets Steel Color
-	SetTextureUVScale(1.0f, 1.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("dbell"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawCylinderMesh();
+	AddSceneObject(dumbbellRack, MESH_CYLINDER,
+		glm::vec3(0.2f, 1.2f, 0.2f),	// SCALE
+		glm::vec3(90.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(-15.75f, 5.75f, -10.75f),	// POSITION
+		glm::vec4(0.25f, 0.25f, 0.25f, 1.0f),
+		"metalMAT", "dbell", glm::vec2(1.0f, 1.0f));
 
 	// REAR WEIGHT GLOBE
-	SetTransformations(
-		glm::vec3(0.75f, 0.75f, 0.75f),     // SCALE
-		0.0f, 0.0f, 0.0f,               // ROTAION
-		glm::vec3(-15.75f, 5.75f, -11.45f)   // POSITION
-	);
-	SetShaderColor(0.25f, 0.25f, 0.25f, 1.0f); // Sets Steel Color
-	SetTextureUVScale(1.0f, 1.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("dbell"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawSphereMesh();
+	AddSceneObject(dumbbellRack, MESH_SPHERE,
+		glm::vec3(0.75f, 0.75f, 0.75f),	// SCALE
+		glm::vec3(0.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(-15.75f, 5.75f, -11.45f),	// POSITION
+		glm::vec4(0.25f, 0.25f, 0.25f, 1.0f),
+		"metalMAT", "dbell", glm::vec2(1.0f, 1.0f));
 
 	// FRONT WEIGHT GLOBE
-	SetTransformations(
-		glm::vec3(0.75f, 0.75f, 0.75f),     // SCALE
-		0.0f, 0.0f, 0.0f,               // ROTAION
-		glm::vec3(-15.75f, 5.75f, -8.85f)   // POSITION
-	);
-	SetShaderColor(0.25f, 0.25f, 0.25f, 1.0f); // Sets Steel Color
-	SetTextureUVScale(1.0f, 1.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("dbell"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawSphereMesh();
+	AddSceneObject(dumbbellRack, MESH_SPHERE,
+		glm::vec3(0.75f, 0.75f, 0.75f),	// SCALE
+		glm::vec3(0.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(-15.75f, 5.75f, -8.85f),	// POSITION
+		glm::vec4(0.25f, 0.25f, 0.25f, 1.0f),
+		"metalMAT", "dbell", glm::vec2(1.0f, 1.0f));
 
 
 	// LEFT 95LB DUMBBELL
 	// MIDDLE GRIP
-	SetTransformations(
-		glm::vec3(0.2f, 1.2f, 0.2f),     // SCALE
-		90.0f, 0.0f, 0.0f,               // ROTAION
-		glm::vec3(-13.5f, 5.75f, -10.75f)   // POSITION
-	);
-	SetShaderColor(0.25f, 0.25f, 0.25f, 1.0f); // Sets Steel Color
-	SetTextureUVScale(1.0f, 1.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("dbell"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawCylinderMesh();
+	AddSceneObject(dumbbellRack, MESH_CYLINDER,
+		glm::vec3(0.2f, 1.2f, 0.2f),	// SCALE
+		glm::vec3(90.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(-13.5f, 5.75f, -10.75f),	// POSITION
+		glm::vec4(0.25f, 0.25f, 0.25f, 1.0f),
+		"metalMAT", "dbell", glm::vec2(1.0f, 1.0f));
 
 	// REAR WEIGHT GLOBE
-	SetTransformations(
-		glm::vec3(0.875f, 0.875f, 0.875f),     // SCALE
-		0.0f, 0.0f, 0.0f,               // ROTAION
-		glm::vec3(-13.5f, 5.75f, -11.55f)   // POSITION
-	);
-	SetShaderColor(0.25f, 0.25f, 0.25f, 1.0f); // Sets Steel Color
-	SetTextureUVScale(1.0f, 1.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("dbell"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawSphereMesh();
+	AddSceneObject(dumbbellRack, MESH_SPHERE,
+		glm::vec3(0.875f, 0.875f, 0.875f),	// SCALE
+		glm::vec3(0.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(-13.5f, 5.75f, -11.55f),	// POSITION
+		glm::vec4(0.25f, 0.25f, 0.25f, 1.0f),
+		"metalMAT", "dbell", glm::vec2(1.0f, 1.0f));
 
 	// FRONT WEIGHT GLOBE
-	SetTransformations(
-		glm::vec3(0.875f, 0.875f, 0.875f),     // SCALE
-		0.0f, 0.0f, 0.0f,               // ROTAION
-		glm::vec3(-13.5f, 5.75f, -8.75f)   // POSITION
-	);
-	SetShaderColor(0.25f, 0.25f, 0.25f, 1.0f); // Sets Steel Color
-	SetTextureUVScale(1.0f, 1.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("dbell"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawSphereMesh();
+	AddSceneObject(dumbbellRack, MESH_SPHERE,
+		glm::vec3(0.875f, 0.875f, 0.875f),	// SCALE
+		glm::vec3(0.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(-13.5f, 5.75f, -8.75f),	// POSITION
+		glm::vec4(0.25f, 0.25f, 0.25f, 1.0f),
+		"metalMAT", "dbell", glm::vec2(1.0f, 1.0f));
 
 
 	// RIGHT 95LB DUMBBELL
 	// MIDDLE GRIP
-	SetTransformations(
-		glm::vec3(0.2f, 1.2f, 0.2f),     // SCALE
-		90.0f, 0.0f, 0.0f,               // ROTAION
-		glm::vec3(-11.5f, 5.75f, -10.75f)   // POSITION
-	);
-	SetShaderColor(0.25f, 0.25f, 0.25f, 1.0f); // Sets Steel Color
-	SetTextureUVScale(1.0f, 1.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("dbell"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawCylinderMesh();
+	AddSceneObject(dumbbellRack, MESH_CYLINDER,
+		glm::vec3(0.2f, 1.2f, 0.2f),	// SCALE
+		glm::vec3(90.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(-11.5f, 5.75f, -10.75f),	// POSITION
+		glm::vec4(0.25f, 0.25f, 0.25f, 1.0f),
+		"metalMAT", "dbell", glm::vec2(1.0f, 1.0f));
 
 	// REAR WEIGHT GLOBE
-	SetTransformations(
-		glm::vec3(0.875f, 0.875f, 0.875f),     // SCALE
-		0.0f, 0.0f, 0.0f,               // ROTAION
-		glm::vec3(-11.5f, 5.75f, -11.55f)   // POSITION
-	);
-	SetShaderColor(0.25f, 0.25f, 0.25f, 1.0f); // Sets Steel Color
-	SetTextureUVScale(1.0f, 1.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("dbell"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawSphereMesh();
+	AddSceneObject(dumbbellRack, MESH_SPHERE,
+		glm::vec3(0.875f, 0.875f, 0.875f),	// SCALE
+		glm::vec3(0.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(-11.5f, 5.75f, -11.55f),	// POSITION
+		glm::vec4(0.25f, 0.25f, 0.25f, 1.0f),
+		"metalMAT", "dbell", glm::vec2(1.0f, 1.0f));
 
 	// FRONT WEIGHT GLOBE
-	SetTransformations(
-		glm::vec3(0.875f, 0.875f, 0.875f),     // SCALE
-		0.0f, 0.0f, 0.0f,               // ROTAION
-		glm::vec3(-11.5f, 5.75f, -8.75f)   // POSITION
-	);
-	SetShaderColor(0.25f, 0.25f, 0.25f, 1.0f); // Sets Steel Color
-	SetTextureUVScale(1.0f, 1.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("dbell"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawSphereMesh();
+	AddSceneObject(dumbbellRack, MESH_SPHERE,
+		glm::vec3(0.875f, 0.875f, 0.875f),	// SCALE
+		glm::vec3(0.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(-11.5f, 5.75f, -8.75f),	// POSITION
+		glm::vec4(0.25f, 0.25f, 0.25f, 1.0f),
+		"metalMAT", "dbell", glm::vec2(1.0f, 1.0f));
 
 
 	// LEFT 125LB DUMBBELL
 	// MIDDLE GRIP
-	SetTransformations(
-		glm::vec3(0.2f, 1.2f, 0.2f),     // SCALE
-		90.0f, 0.0f, 0.0f,               // ROTAION
-		glm::vec3(-8.85f, 5.75f, -10.75f)   // POSITION
-	);
-	SetShaderColor(0.25f, 0.25f, 0.25f, 1.0f); // Sets Steel Color
-	SetTextureUVScale(1.0f, 1.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("dbell"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawCylinderMesh();
+	AddSceneObject(dumbbellRack, MESH_CYLINDER,
+		glm::vec3(0.2f, 1.2f, 0.2f),	// SCALE
+		glm::vec3(90.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(-8.85f, 5.75f, -10.75f),	// POSITION
+		glm::vec4(0.25f, 0.25f, 0.25f, 1.0f),
+		"metalMAT", "dbell", glm::vec2(1.0f, 1.0f));
 
 	// REAR WEIGHT GLOBE
-	SetTransformations(
-		glm::vec3(1.0f, 1.0f, 1.0f),     // SCALE
-		0.0f, 0.0f, 0.0f,               // ROTAION
-		glm::vec3(-8.85f, 5.75f, -11.65f)   // POSITION
-	);
-	SetShaderColor(0.25f, 0.25f, 0.25f, 1.0f); // Sets Steel Color
-	SetTextureUVScale(1.0f, 1.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("dbell"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawSphereMesh();
+	AddSceneObject(dumbbellRack, MESH_SPHERE,
+		glm::vec3(1.0f, 1.0f, 1.0f),	// SCALE
+		glm::vec3(0.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(-8.85f, 5.75f, -11.65f),	// POSITION
+		glm::vec4(0.25f, 0.25f, 0.25f, 1.0f),
+		"metalMAT", "dbell", glm::vec2(1.0f, 1.0f));
 
 	// FRONT WEIGHT GLOBE
-	SetTransformations(
-		glm::vec3(1.0f, 1.0f, 1.0f),     // SCALE
-		0.0f, 0.0f, 0.0f,               // ROTAION
-		glm::vec3(-8.85f, 5.75f, -8.65f)   // POSITION
-	);
-	SetShaderColor(0.25f, 0.25f, 0.25f, 1.0f); // Sets Steel Color
-	SetTextureUVScale(1.0f, 1.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("dbell"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawSphereMesh();
+	AddSceneObject(dumbbellRack, MESH_SPHERE,
+		glm::vec3(1.0f, 1.0f, 1.0f),	// SCALE
+		glm::vec3(0.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(-8.85f, 5.75f, -8.65f),	// POSITION
+		glm::vec4(0.25f, 0.25f, 0.25f, 1.0f),
+		"metalMAT", "dbell", glm::vec2(1.0f, 1.0f));
 
 
 	// RIGHT 125LB DUMBBELL
 	// MIDDLE GRIP
-	SetTransformations(
-		glm::vec3(0.2f, 1.2f, 0.2f),     // SCALE
-		90.0f, 0.0f, 0.0f,               // ROTAION
-		glm::vec3(-6.85f, 5.75f, -10.75f)   // POSITION
-	);
-	SetShaderColor(0.25f, 0.25f, 0.25f, 1.0f); // Sets Steel Color
-	SetTextureUVScale(1.0f, 1.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("dbell"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawCylinderMesh();
+	AddSceneObject(dumbbellRack, MESH_CYLINDER,
+		glm::vec3(0.2f, 1.2f, 0.2f),	// SCALE
+		glm::vec3(90.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(-6.85f, 5.75f, -10.75f),	// POSITION
+		glm::vec4(0.25f, 0.25f, 0.25f, 1.0f),
+		"metalMAT", "dbell", glm::vec2(1.0f, 1.0f));
 
 	// REAR WEIGHT GLOBE
-	SetTransformations(
-		glm::vec3(1.0f, 1.0f, 1.0f),     // SCALE
-		0.0f, 0.0f, 0.0f,               // ROTAION
-		glm::vec3(-6.85f, 5.75f, -11.65f)   // POSITION
-	);
-	SetShaderColor(0.25f, 0.25f, 0.25f, 1.0f); // Sets Steel Color
-	SetTextureUVScale(1.0f, 1.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("dbell"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawSphereMesh();
+	AddSceneObject(dumbbellRack, MESH_SPHERE,
+		glm::vec3(1.0f, 1.0f, 1.0f),	// SCALE
+		glm::vec3(0.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(-6.85f, 5.75f, -11.65f),	// POSITION
+		glm::vec4(0.25f, 0.25f, 0.25f, 1.0f),
+		"metalMAT", "dbell", glm::vec2(1.0f, 1.0f));
 
 	// FRONT WEIGHT GLOBE
-	SetTransformations(
-		glm::vec3(1.0f, 1.0f, 1.0f),     // SCALE
-		0.0f, 0.0f, 0.0f,               // ROTAION
-		glm::vec3(-6.85f, 5.75f, -8.65f)   // POSITION
-	);
-	SetShaderColor(0.25f, 0.25f, 0.25f, 1.0f); // Sets Steel Color
-	SetTextureUVScale(1.0f, 1.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("dbell"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawSphereMesh();
+	AddSceneObject(dumbbellRack, MESH_SPHERE,
+		glm::vec3(1.0f, 1.0f, 1.0f),	// SCALE
+		glm::vec3(0.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(-6.85f, 5.75f, -8.65f),	// POSITION
+		glm::vec4(0.25f, 0.25f, 0.25f, 1.0f),
+		"metalMAT", "dbell", glm::vec2(1.0f, 1.0f));
+
 
+	// FLOOR DUMBBELLS
+	int floorDumbbells = AddSceneGroup(-1);
 
 	// LEFT 155LB DUMBBELL
 	// MIDDLE GRIP
-	SetTransformations(
-		glm::vec3(0.2f, 1.2f, 0.2f),     // SCALE
-		90.0f, 0.0f, 0.0f,               // ROTAION
-		glm::vec3(-9.35f, 1.15f, 1.55f)   // POSITION
-	);
-	SetShaderColor(0.25f, 0.25f, 0.25f, 1.0f); // Sets Steel Color
-	SetTextureUVScale(1.0f, 1.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("dbell"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawCylinderMesh();
+	AddSceneObject(floorDumbbells, MESH_CYLINDER,
+		glm::vec3(0.2f, 1.2f, 0.2f),	// SCALE
+		glm::vec3(90.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(-9.35f, 1.15f, 1.55f),	// POSITION
+		glm::vec4(0.25f, 0.25f, 0.25f, 1.0f),
+		"metalMAT", "dbell", glm::vec2(1.0f, 1.0f));
 
 	// REAR WEIGHT GLOBE
-	SetTransformations(
-		glm::vec3(1.2f, 1.2f, 1.2f),     // SCALE
-		0.0f, 0.0f, 0.0f,               // ROTAION
-		glm::vec3(-9.35f, 1.15f, 3.875f)   // POSITION
-	);
-	SetShaderColor(0.25f, 0.25f, 0.25f, 1.0f); // Sets Steel Color
-	SetTextureUVScale(1.0f, 1.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("dbell"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawSphereMesh();
+	AddSceneObject(floorDumbbells, MESH_SPHERE,
+		glm::vec3(1.2f, 1.2f, 1.2f),	// SCALE
+		glm::vec3(0.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(-9.35f, 1.15f, 3.875f),	// POSITION
+		glm::vec4(0.25f, 0.25f, 0.25f, 1.0f),
+		"metalMAT", "dbell", glm::vec2(1.0f, 1.0f));
 
 	// FRONT WEIGHT GLOBE
-	SetTransformations(
-		glm::vec3(1.2f, 1.2f, 1.2f),     // SCALE
-		0.0f, 0.0f, 0.0f,               // ROTAION
-		glm::vec3(-9.35f, 1.15f, 0.475f)   // POSITION
-	);
-	SetShaderColor(0.25f, 0.25f, 0.25f, 1.0f); // Sets Steel Color
-	SetTextureUVScale(1.0f, 1.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("dbell"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawSphereMesh();
+	AddSceneObject(floorDumbbells, MESH_SPHERE,
+		glm::vec3(1.2f, 1.2f, 1.2f),	// SCALE
+		glm::vec3(0.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(-9.35f, 1.15f, 0.475f),	// POSITION
+		glm::vec4(0.25f, 0.25f, 0.25f, 1.0f),
+		"metalMAT", "dbell", glm::vec2(1.0f, 1.0f));
 
 
 	// RIGHT 155LB DUMBBELL
 	// MIDDLE GRIP
-	SetTransformations(
-		glm::vec3(0.2f, 1.2f, 0.2f),     // SCALE
-		90.0f, 0.0f, 0.0f,               // ROTAION
-		glm::vec3(-1.15f, 1.15f, 1.55f)   // POSITION
-	);
-	SetShaderColor(0.25f, 0.25f, 0.25f, 1.0f); // Sets Steel Color
-	SetTextureUVScale(1.0f, 1.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("dbell"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawCylinderMesh();
+	AddSceneObject(floorDumbbells, MESH_CYLINDER,
+		glm::vec3(0.2f, 1.2f, 0.2f),	// SCALE
+		glm::vec3(90.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(-1.15f, 1.15f, 1.55f),	// POSITION
+		glm::vec4(0.25f, 0.25f, 0.25f, 1.0f),
+		"metalMAT", "dbell", glm::vec2(1.0f, 1.0f));
 
 	// REAR WEIGHT GLOBE
-	SetTransformations(
-		glm::vec3(1.2f, 1.2f, 1.2f),     // SCALE
-		0.0f, 0.0f, 0.0f,               // ROTAION
-		glm::vec3(-1.15f, 1.15f, 3.875f)   // POSITION
-	);
-	SetShaderColor(0.25f, 0.25f, 0.25f, 1.0f); // Sets Steel Color
-	SetTextureUVScale(1.0f, 1.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("dbell"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawSphereMesh();
+	AddSceneObject(floorDumbbells, MESH_SPHERE,
+		glm::vec3(1.2f, 1.2f, 1.2f),	// SCALE
+		glm::vec3(0.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(-1.15f, 1.15f, 3.875f),	// POSITION
+		glm::vec4(0.25f, 0.25f, 0.25f, 1.0f),
+		"metalMAT", "dbell", glm::vec2(1.0f, 1.0f));
 
 	// FRONT WEIGHT GLOBE
-	SetTransformations(
-		glm::vec3(1.2f, 1.2f, 1.2f),     // SCALE
-		0.0f, 0.0f, 0.0f,               // ROTAION
-		glm::vec3(-1.15f, 1.15f, 0.475f)   // POSITION
-	);
-	SetShaderColor(0.25f, 0.25f, 0.25f, 1.0f); // Sets Steel Color
-	SetTextureUVScale(1.0f, 1.0f); // ADJUSTS TEXTURE SCALING
-	SetShaderMaterial("metalMAT");
-	SetShaderTexture("dbell"); // SETS SHAPE TEXTURE
-	m_basicMeshes->DrawSphereMesh();
+	AddSceneObject(floorDumbbells, MESH_SPHERE,
+		glm::vec3(1.2f, 1.2f, 1.2f),	// SCALE
+		glm::vec3(0.0f, 0.0f, 0.0f),	// ROTATION
+		glm::vec3(-1.15f, 1.15f, 0.475f),	// POSITION
+		glm::vec4(0.25f, 0.25f, 0.25f, 1.0f),
+		"metalMAT", "dbell", glm::vec2(1.0f, 1.0f));
+}
+
+/***********************************************************
+ *  RenderScene()
+ *
+ *  This method is used for rendering the 3D scene by 
+ *  drawing the retained scene objects
+ ***********************************************************/
+void SceneManager::RenderScene()
+{
+	// the transient data of the last frame is released
+	m_frameArena->Reset();
+
+	// apply the edited shader, texture and scene files first
+	ApplyFileChanges();
+	// rebuild the matrices of any objects that have changed
+	UpdateSceneObjects();
+	// show the textures that finished loading since the last frame
+	UpdateGLTextures();
+
+	if (NULL == m_pUniformCache)
+	{
+		return;
+	}
+
+	// the shader variants follow the lights that are switched on
+	UpdateDrawPrograms();
+	// re-sort the draws after objects were added
+	if (m_bDrawQueueDirty == true)
+	{
+		BuildDrawQueue();
+	}
+
+	// other code may have changed the shader since the last frame
+	ResetRenderState();
+	// the clustered lights follow the camera of this frame
+	UpdateLightClusters();
+	// and so do the shadow cascades
+	UpdateShadows();
+	SetShadowUniforms();
+
+	// the GPU path culls the objects itself
+	if (m_bUseGpuCulling == true)
+	{
+		RenderSceneIndirect();
+		return;
+	}
+
+	// skip the objects outside of the view
+	CullSceneObjects();
+
+	if (m_bUseInstancing == true)
+	{
+		SelectObjectLods();
+		RenderSceneBatches();
+	}
+	else
+	{
+		// the shape meshes of the per object path have no
+		// detail levels
+		RenderSceneObjects();
+	}
+}
+
+/***********************************************************
+ *  ResetFrameCounters()
+ *
+ *  This method is used for resetting the draw call and
+ *  render state change counters, once per frame.
+ ***********************************************************/
+void SceneManager::ResetFrameCounters()
+{
+	m_drawCallCount = 0;
+	m_stateChangeCount = 0;
+}
+
+/***********************************************************
+ *  IsLoadingTextures()
+ *
+ *  This method is used for checking whether scene textures
+ *  are still loading, or the texture arrays still need to be
+ *  built from them.
+ ***********************************************************/
+bool SceneManager::IsLoadingTextures()
+{
+	if ((NULL != m_textureLoader) && (m_textureLoader->IsIdle() == false))
+	{
+		return(true);
+	}
+
+	return(m_bTextureArraysDirty);
+}
+
+/***********************************************************
+ *  IsRedrawNeeded()
+ *
+ *  This method is used for checking whether the scene
+ *  changed since the last frame - moved or added objects,
+ *  textures that are still loading and watched files that
+ *  were saved are all applied by the next RenderScene().
+ ***********************************************************/
+bool SceneManager::IsRedrawNeeded()
+{
+	if ((m_bSceneDirty == true) || (m_bDrawQueueDirty == true))
+	{
+		return(true);
+	}
+	if ((NULL != m_fileWatcher) && (m_fileWatcher->HasChangedFiles() == true))
+	{
+		return(true);
+	}
+
+	return(IsLoadingTextures());
+}
+
+/***********************************************************
+ *  RenderSceneObjects()
+ *
+ *  This method is used for drawing the retained scene one
+ *  object at a time with the basic shape meshes, in the
+ *  order of the sorted draw queue.  With the draw record
+ *  ring, the values of every draw are written to its record
+ *  and a draw only sets the record index, otherwise they are
+ *  set as uniforms.
+ ***********************************************************/
+void SceneManager::RenderSceneObjects()
+{
+	const std::vector<DrawQueue::DRAW_RECORD>& records = m_drawQueue.GetRecords();
+
+	if (m_renderState.bUseInstancing != 0)
+	{
+		m_pUniformCache->SetBool(m_uniforms.bUseInstancing, false);
+		m_renderState.bUseInstancing = 0;
+	}
+
+	UBO_DRAW_RECORD* drawRecords = NULL;
+	if ((NULL != m_drawRing) && (m_drawRing->Reserve((int)records.size()) == true))
+	{
+		drawRecords = m_drawRing->BeginFrame();
+	}
+	if (NULL != drawRecords)
+	{
+		m_pUniformCache->SetBool(m_uniforms.bUseDrawRecords, true);
+		m_pUniformCache->SetBool(m_uniforms.bUseMaterialIndex, true);
+		m_renderState.bUseDrawRecords = 1;
+		m_renderState.bUseMaterialIndex = 1;
+	}
+
+	int drawCount = 0;
+	for (size_t r = 0; r < records.size(); r++)
+	{
+		if (m_objectVisible[records[r].objectIndex] == 0)
+		{
+			continue;
+		}
+
+		const SCENE_OBJECT& object = m_sceneObjects[records[r].objectIndex];
+
+		if (NULL != drawRecords)
+		{
+			// the material comes from the material block
+			ApplyRenderState(GetTextureBinding(object.textureSlot), -1);
+
+			UBO_DRAW_RECORD& record = drawRecords[drawCount];
+			record.model = object.worldMatrix;
+			record.color = object.color;
+			record.UVscale = object.UVscale;
+			record.textureLayer = 0.0f;
+			if ((m_bUseTextureArrays == true) && (object.textureSlot >= 0))
+			{
+				record.textureLayer = (float)m_textureStorage->GetLayer(object.textureSlot);
+			}
+			record.materialIndex = (float)std::max(object.materialIndex, 0);
+
+			m_pUniformCache->SetInt(m_uniforms.drawIndex, m_drawRing->BindRecord(drawCount));
+		}
+		else
+		{
+			ApplyRenderState(GetTextureBinding(object.textureSlot), object.materialIndex);
+
+			// the transformation, color and UV scale are different
+			// for every object and are always set
+			m_pUniformCache->SetMat4(m_uniforms.model, object.worldMatrix);
+			m_pUniformCache->SetVec4(m_uniforms.objectColor, object.color);
+			if (object.textureSlot >= 0)
+			{
+				SetTextureUVScale(object.UVscale.x, object.UVscale.y);
+				if (m_bUseTextureArrays == true)
+				{
+					m_pUniformCache->SetFloat(m_uniforms.textureLayer, (float)m_textureStorage->GetLayer(object.textureSlot));
+				}
+			}
+		}
+
+		DrawSceneMesh(object.mesh);
+		drawCount++;
+		m_drawCallCount++;
+	}
+
+	if (NULL != drawRecords)
+	{
+		m_drawRing->EndFrame();
+		m_pUniformCache->SetBool(m_uniforms.bUseMaterialIndex, false);
+		m_pUniformCache->SetBool(m_uniforms.bUseDrawRecords, false);
+		m_renderState.bUseDrawRecords = 0;
+		m_renderState.bUseMaterialIndex = 0;
+	}
+}
+
+/***********************************************************
+ *  RenderSceneBatches()
+ *
+ *  This method is used for drawing the retained scene with
+ *  one instanced draw call per mesh, material and texture.
+ *  The model matrix, color and UV scale of every object come
+ *  from the instance buffer instead of shader uniforms.
+ ***********************************************************/
+void SceneManager::RenderSceneBatches()
+{
+	// refresh the instance buffer after objects were added or
+	// moved, or other objects came into view
+	if ((m_bInstancesDirty == true) || (m_bVisibilityDirty == true))
+	{
+		UpdateInstanceData();
+	}
+
+	m_pUniformCache->SetBool(m_uniforms.bUseInstancing, true);
+	m_renderState.bUseInstancing = 1;
+
+	if (m_renderMode == RENDER_DEPTH_PREPASS)
+	{
+		BeginDepthPrepass();
+		DrawSceneBatches();
+		BeginShadingPass();
+	}
+	DrawSceneBatches();
+	if (m_renderMode == RENDER_DEPTH_PREPASS)
+	{
+		EndShadingPass();
+	}
+
+	m_pUniformCache->SetBool(m_uniforms.bUseInstancing, false);
+	m_renderState.bUseInstancing = 0;
+}
+
+/***********************************************************
+ *  DrawSceneBatches()
+ *
+ *  This method is used for drawing the instanced batches of
+ *  the visible objects.  The depth pre-pass sets no texture
+ *  or material.
+ ***********************************************************/
+void SceneManager::DrawSceneBatches()
+{
+	for (size_t b = 0; b < m_drawBatches.size(); b++)
+	{
+		const DRAW_BATCH& batch = m_drawBatches[b];
 
+		if (m_bDrawingDepth == true)
+		{
+			ApplyRenderState(-1, -1);
+		}
+		else
+		{
+			ApplyRenderState(batch.textureBinding, batch.materialIndex);
+		}
+		DrawSceneMeshInstanced(batch.mesh, batch.firstInstance, batch.instanceCount, batch.lod);
+		m_drawCallCount++;
+	}
 }
@@ -11,8 +11,29 @@
 
 #include "ShaderManager.h"
 #include "ShapeMeshes.h"
+#include "InstancedMeshes.h"
+#include "UniformCache.h"
+#include "UniformBuffers.h"
+#include "DrawQueue.h"
+#include "TagRegistry.h"
+#include "TextureLoader.h"
+#include "TextureStorage.h"
+#include "SceneBVH.h"
+#include "GpuCulling.h"
+#include "HiZBuffer.h"
+#include "DrawRecordRing.h"
+#include "TransformBatch.h"
+#include "JobSystem.h"
+#include "SceneFile.h"
+#include "FileWatcher.h"
+#include "LightClusters.h"
+#include "ShaderVariants.h"
+#include "ShadowMaps.h"
+#include "FrameArena.h"
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 
 /***********************************************************
@@ -25,7 +46,10 @@ class SceneManager
 {
 public:
 	// constructor
-	SceneManager(ShaderManager *pShaderManager);
+	SceneManager(
+		ShaderManager *pShaderManager,
+		UniformCache* pUniformCache,
+		UniformBuffers* pUniformBuffers);
 	// destructor
 	~SceneManager();
 
@@ -33,6 +57,8 @@ public:
 	{
 		std::string tag;
 		uint32_t ID;
+		// the image file the texture was loaded from
+		std::string filename;
 	};
 
 	struct OBJECT_MATERIAL
@@ -45,29 +71,368 @@ public:
 		std::string tag;
 	};
 
+	// basic mesh shapes that a retained scene object can draw
+	enum MESH_TYPE
+	{
+		MESH_NONE,		// group node - transforms children only
+		MESH_PLANE,
+		MESH_BOX,
+		MESH_CYLINDER,
+		MESH_SPHERE
+	};
+
+	// the passes that draw the retained scene
+	enum RENDER_MODE
+	{
+		// one pass that shades every fragment that is drawn
+		RENDER_FORWARD,
+		// a depth only pass first, so the shaded pass only shades
+		// the nearest fragment of every pixel
+		RENDER_DEPTH_PREPASS
+	};
+
+	// retained scene node - built once, redrawn every frame
+	struct SCENE_OBJECT
+	{
+		MESH_TYPE mesh;
+		// index of the parent node, or -1 for a root node
+		int parent;
+		// local transformation values
+		glm::vec3 scaleXYZ;
+		glm::vec3 rotationDegrees;
+		glm::vec3 positionXYZ;
+		// cached local and world matrices
+		glm::mat4 localMatrix;
+		glm::mat4 worldMatrix;
+		// set when the local transformation needs to be rebuilt
+		bool bDirty;
+		// set when the world matrix changed during the last update
+		bool bMoved;
+		// pre-resolved shader state for the draw
+		glm::vec4 color;
+		glm::vec2 UVscale;
+		int materialIndex;
+		int textureSlot;
+	};
+
+	// neighbouring draw queue records sharing a mesh, detail
+	// level, material and texture that are drawn with a single
+	// instanced call
+	struct DRAW_BATCH
+	{
+		MESH_TYPE mesh;
+		// level of detail of the mesh
+		int lod;
+		int materialIndex;
+		int textureBinding;
+		int firstInstance;
+		int instanceCount;
+	};
+
+	// the draw batches and instance values built from one chunk
+	// of the draw queue, merged in chunk order afterwards
+	struct INSTANCE_LIST
+	{
+		std::vector<DRAW_BATCH> batches;
+		std::vector<InstancedMeshes::INSTANCE_DATA> instances;
+	};
+
+	// shader state set by the last draw, -1 when unknown, used
+	// for skipping uniform updates that would not change anything
+	struct RENDER_STATE
+	{
+		// the program the uniforms below were set into, 0 when unknown
+		GLuint programID;
+		int textureBinding;
+		int materialIndex;
+		int bUseTexture;
+		int bUseInstancing;
+		int bUseMaterialIndex;
+		int bUseDrawRecords;
+	};
+
+	// objects of one texture binding and mesh, drawn with one
+	// indirect command per detail level that the GPU culling
+	// pass fills in
+	struct INDIRECT_GROUP
+	{
+		MESH_TYPE mesh;
+		int textureBinding;
+		int objectCount;
+		// the command of detail level 0 and the number of levels
+		int firstCommand;
+		int lodCount;
+	};
+
+	// handles of the shader uniforms set while rendering
+	struct SHADER_UNIFORMS
+	{
+		int model;
+		int objectColor;
+		int objectTexture;
+		int objectTextureArray;
+		int textureLayer;
+		int bUseTextureArray;
+		int UVscale;
+		int bUseTexture;
+		int bUseLighting;
+		int bUseInstancing;
+		int bUseMaterialIndex;
+		int bUseDrawRecords;
+		int drawIndex;
+		int materialDiffuseColor;
+		int materialSpecularColor;
+		int materialShininess;
+		int bUseLightClusters;
+		int clusterLights;
+		int clusterEntries;
+		int clusterParameters;
+		int bUseCascadeShadows;
+		int cascadeShadowMap;
+		int cascadeMatrices[ShadowMaps::CASCADE_COUNT];
+		int cascadeSplits;
+		int pointShadowMap;
+		int pointShadowParameters;
+		int pointShadowMask;
+	};
+
 private:
 	// pointer to shader manager object
 	ShaderManager* m_pShaderManager;
+	// pointer to the cached shader uniform locations
+	UniformCache* m_pUniformCache;
+	// pointer to the shared camera and light uniform buffers
+	UniformBuffers* m_pUniformBuffers;
 	// pointer to basic shapes object
 	ShapeMeshes* m_basicMeshes;
-	// total number of loaded textures
-	int m_loadedTextures;
-	// loaded textures info
-	TEXTURE_INFO m_textureIDs[16];
-	// defined object materials
+	// pointer to instanced shapes object
+	InstancedMeshes* m_instancedMeshes;
+	// pointer to the background texture loader
+	TextureLoader* m_textureLoader;
+	// loaded textures info, indexed by texture slot
+	std::vector<TEXTURE_INFO> m_textureIDs;
+	// texture slot of every loaded texture tag
+	TagRegistry m_textureTags;
+	// the textures below this slot stay bound to the unit of the
+	// same number, the others share the overflow unit on demand
+	int m_residentTextures;
+	int m_overflowTextureUnit;
+	// texture slot currently bound to the overflow unit
+	int m_overflowTextureSlot;
+	// pointer to the texture arrays built from the loaded textures
+	TextureStorage* m_textureStorage;
+	// the texture unit reserved for the texture arrays
+	int m_arrayTextureUnit;
+	// true when textured objects are drawn from the texture arrays
+	bool m_bUseTextureArrays;
+	// true when the loaded textures changed since the arrays were built
+	bool m_bTextureArraysDirty;
+	// defined object materials, indexed by material ID
 	std::vector<OBJECT_MATERIAL> m_objectMaterials;
+	// material ID of every defined material tag
+	TagRegistry m_materialTags;
+	// retained scene nodes, parents always precede their children
+	std::vector<SCENE_OBJECT> m_sceneObjects;
+	// world bounds and visibility of every scene node
+	std::vector<AABB> m_objectBounds;
+	std::vector<uint8_t> m_objectVisible;
+	// detail level of every scene node in the last frame
+	std::vector<uint8_t> m_objectLods;
+	// choose the detail level of curved meshes by screen size
+	bool m_bUseLod;
+	// fraction of a switching size that an object has to move
+	// past before its detail level changes
+	float m_lodHysteresis;
+	// the camera the detail levels were chosen for
+	glm::mat4 m_lodViewProjection;
+	// hierarchy over the bounds of the drawn scene nodes
+	SceneBVH m_sceneBVH;
+	// true when nodes were added and the hierarchy is rebuilt
+	bool m_bBVHDirty;
+	// true when nodes moved and the hierarchy is refitted
+	bool m_bBoundsDirty;
+	// the camera the visibility flags were computed for
+	glm::mat4 m_cullViewProjection;
+	// true when the visibility changed since the instances were written
+	bool m_bVisibilityDirty;
+	// cull the scene nodes against the view frustum
+	bool m_bUseCulling;
+	// cached handles of the shader uniforms
+	SHADER_UNIFORMS m_uniforms;
+	// true when at least one scene node needs its matrices rebuilt
+	bool m_bSceneDirty;
+	// the transformations of the changed nodes, kept to reuse
+	// their memory, and their node indices and new local matrices
+	// in the frame arena
+	TransformBatch m_dirtyTransforms;
+	int* m_dirtyObjects;
+	glm::mat4* m_dirtyMatrices;
+	// pointer to the linear allocator of the transient data of
+	// the current frame, reset by RenderScene()
+	FrameArena* m_frameArena;
+	// pointer to the worker threads that share the scene update
+	JobSystem* m_jobSystem;
+	// number of threads for the job system, 0 for one per core
+	int m_jobThreadCount;
+	// the draw queue index where every run of equal sort keys
+	// starts, in the frame arena, and the instance lists built
+	// from them
+	size_t* m_sortRuns;
+	std::vector<INSTANCE_LIST> m_instanceLists;
+	// drawn objects sorted by render state
+	DrawQueue m_drawQueue;
+	// true when objects were added and the queue must be rebuilt
+	bool m_bDrawQueueDirty;
+	// shader state of the last submitted draw
+	RENDER_STATE m_renderState;
+	// draw calls and render state changes since the last reset
+	int m_drawCallCount;
+	int m_stateChangeCount;
+	// instanced draw batches of the instance buffer
+	std::vector<DRAW_BATCH> m_drawBatches;
+	// true when the instance buffer no longer matches the scene
+	bool m_bInstancesDirty;
+	// draw the scene with instanced batches instead of per object
+	bool m_bUseInstancing;
+	// pointer to the mapped ring the per object path streams its
+	// draw values through, NULL when they are set as uniforms
+	DrawRecordRing* m_drawRing;
+	// pointer to the compute culling pass and its draw commands
+	GpuCulling* m_gpuCulling;
+	// cull and draw the scene on the GPU when it is supported
+	bool m_bUseGpuCulling;
+	// the indirect draw groups, in command buffer order
+	std::vector<INDIRECT_GROUP> m_indirectGroups;
+	// pointer to the occluder depth pyramid of the GPU path
+	HiZBuffer* m_hiZBuffer;
+	// hide the objects behind the large occluders on the GPU path
+	bool m_bUseOcclusion;
+	// the occluders drawn into the depth pyramid, one batch per mesh
+	std::vector<DRAW_BATCH> m_occluderBatches;
+	// pointer to the pass that bins the point lights with a radius
+	// into view clusters, NULL when they are not drawn
+	LightClusters* m_lightClusters;
+	// bin the clustered lights on the GPU when it is supported
+	bool m_bUseLightClusters;
+	// the point lights with a radius, in light buffer order
+	std::vector<LightClusters::CLUSTER_LIGHT> m_clusterLights;
+	// true when the clustered lights changed since their upload
+	bool m_bClusterLightsDirty;
+	// the texture units reserved for the clustered light buffers
+	int m_clusterLightUnit;
+	int m_clusterEntryUnit;
+	// true when the light clusters are bound for this frame
+	bool m_bDrawLightClusters;
+	// number of ceiling lights spread over the scene grid
+	int m_ceilingLightCount;
+	// number of copies of the scene prefabs along X and Z
+	int m_gridColumns;
+	int m_gridRows;
+	// the scene file to load instead of the defined scene, empty
+	// for the defined scene
+	std::string m_sceneFile;
+	// number of scene nodes that came from the scene file
+	int m_sceneFileNodes;
+	// pointer to the watcher of the files the scene was built
+	// from, NULL when they are not reloaded
+	FileWatcher* m_fileWatcher;
+	// the shader files of the scene program
+	std::string m_vertexShaderFile;
+	std::string m_fragmentShaderFile;
+	// pointer to the specialized variants of the scene program,
+	// NULL when every draw uses the loaded program
+	ShaderVariants* m_shaderVariants;
+	// draw with the specialized variants when they build
+	bool m_bUseShaderVariants;
+	// the programs of the untextured and the textured draws for
+	// the current light setup
+	GLuint m_drawPrograms[2];
+	// the cheap program of the depth pre-pass, 0 for the loaded
+	// program
+	GLuint m_depthProgram;
+	// the passes that draw the scene
+	RENDER_MODE m_renderMode;
+	// true while the depth pre-pass is drawn
+	bool m_bDrawingDepth;
+	// pointer to the shadow maps of the directional light and the
+	// point lights of the light block, NULL when nothing casts
+	// shadows
+	ShadowMaps* m_shadowMaps;
+	// draw the shadow maps when they are supported
+	bool m_bUseShadows;
+	// pointer to the shapes the casters are drawn with, which
+	// hold the caster instances in their own instance buffer
+	InstancedMeshes* m_shadowMeshes;
+	// the casters drawn into the cached maps and the casters drawn
+	// every frame, one batch per mesh
+	std::vector<DRAW_BATCH> m_staticCasterBatches;
+	std::vector<DRAW_BATCH> m_dynamicCasterBatches;
+	// the instance values of every caster, the dynamic casters
+	// start at the first dynamic instance in this node order
+	std::vector<InstancedMeshes::INSTANCE_DATA> m_casterInstances;
+	std::vector<int> m_dynamicCasters;
+	int m_firstDynamicInstance;
+	// 1 for the nodes that moved after the cached maps were drawn
+	std::vector<unsigned char> m_objectDynamic;
+	// true when the casters have to be sorted into static and
+	// dynamic batches again
+	bool m_bShadowCastersDirty;
+	// true when a dynamic caster moved since the last frame
+	bool m_bDynamicCastersMoved;
+	// true once the cached maps were drawn for the first time
+	bool m_bStaticShadowsBuilt;
+	// the bounds of every caster
+	glm::vec3 m_shadowSceneMin;
+	glm::vec3 m_shadowSceneMax;
+	// true when the cached cascades hold the static casters, and
+	// a bit per point light whose cached faces do
+	bool m_bCascadesCached;
+	int m_pointShadowCached;
+	// the positions the cached faces of the point lights are for
+	glm::vec3 m_pointShadowPositions[TOTAL_POINT_LIGHTS];
+	// the maps drawn for this frame - the cascades and a bit per
+	// point light of the light block
+	bool m_bCascadeShadows;
+	int m_pointShadowMask;
+	// the texture units reserved for the shadow maps
+	int m_cascadeShadowUnit;
+	int m_pointShadowUnit;
 
 	// load texture images and convert to OpenGL texture data
-	bool CreateGLTexture(const char* filename, std::string tag);
+	bool CreateGLTexture(const char* filename, std::string_view tag);
+	// associate a created OpenGL texture with its tag
+	void RegisterGLTexture(GLuint textureID, const char* filename, std::string_view tag);
+	// queue a texture image to be loaded in the background, the
+	// slot shows a placeholder texture until the load finishes
+	bool LoadGLTextureAsync(const char* filename, std::string_view tag);
+	// swap in the textures that finished loading in the background
+	void UpdateGLTextures();
 	// bind loaded OpenGL textures to slots in memory
 	void BindGLTextures();
 	// free the loaded OpenGL textures
 	void DestroyGLTextures();
 	// find a loaded texture by tag
-	int FindTextureID(std::string tag);
-	int FindTextureSlot(std::string tag);
+	int FindTextureID(std::string_view tag) const;
+	int FindTextureSlot(std::string_view tag) const;
+	// get the texture unit that a texture slot is bound to
+	int BindTextureSlot(int textureSlot);
+	// copy the loaded textures into texture arrays when possible
+	void BuildTextureArrays();
+	// get the texture binding that sorts and batches a texture slot
+	int GetTextureBinding(int textureSlot) const;
+	// add a material, replacing one with the same tag
+	int AddObjectMaterial(const OBJECT_MATERIAL& material);
 	// find a defined material by tag
-	bool FindMaterial(std::string tag, OBJECT_MATERIAL& material);
+	bool FindMaterial(std::string_view tag, OBJECT_MATERIAL& material) const;
+	int FindMaterialIndex(std::string_view tag) const;
+
+	// build the model matrix from the passed in transformation values
+	glm::mat4 CalculateModelMatrix(
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
 
 	// set the transformation values 
 	// into the transform buffer
@@ -87,7 +452,7 @@ private:
 
 	// set the texture data into the shader
 	void SetShaderTexture(
-		std::string textureTag);
+		std::string_view textureTag);
 
 	// set the UV scale for the texture mapping
 	void SetTextureUVScale(
@@ -95,7 +460,180 @@ private:
 
 	// set the object material into the shader
 	void SetShaderMaterial(
-		std::string materialTag);
+		std::string_view materialTag);
+	void SetShaderMaterial(
+		const OBJECT_MATERIAL& material);
+
+	// add a group node that only transforms its children
+	int AddSceneGroup(int parent);
+	// add a drawn node to the retained scene
+	int AddSceneObject(
+		int parent,
+		MESH_TYPE mesh,
+		glm::vec3 scaleXYZ,
+		glm::vec3 rotationDegrees,
+		glm::vec3 positionXYZ,
+		glm::vec4 color,
+		const char* materialTag,
+		const char* textureTag,
+		glm::vec2 UVscale);
+	// add a node whose material and texture are already resolved
+	int AddSceneNode(
+		int parent,
+		MESH_TYPE mesh,
+		glm::vec3 scaleXYZ,
+		glm::vec3 rotationDegrees,
+		glm::vec3 positionXYZ,
+		glm::vec4 color,
+		int materialIndex,
+		int textureSlot,
+		glm::vec2 UVscale);
+	// load the textures, materials, lights and nodes of a scene file
+	bool LoadSceneFile(const char* filename);
+	// register the textures and materials and set the lights of
+	// a scene file
+	void LoadSceneFileResources(
+		const SceneFile& sceneFile,
+		std::vector<int>& textureSlots,
+		std::vector<int>& materialIndices);
+	// add the nodes of a scene file to the retained scene
+	void AddSceneFileNodes(
+		const SceneFile& sceneFile,
+		const std::vector<int>& textureSlots,
+		const std::vector<int>& materialIndices);
+	// update the retained nodes from a changed scene file with the
+	// same hierarchy - returns -1 when the hierarchy differs
+	int PatchSceneFileNodes(
+		const SceneFile& sceneFile,
+		const std::vector<int>& textureSlots,
+		const std::vector<int>& materialIndices);
+	// apply a changed scene file to the running scene
+	void ReloadSceneFile();
+	// apply the changes of the watched files
+	void ApplyFileChanges();
+	// load a changed texture image into the slots that use it
+	void ReloadTexture(const std::string& filename);
+	// rebuild the scene program from its changed shader files
+	bool ReloadShaders();
+	// rebuild the cached world matrices of dirty nodes
+	void UpdateSceneObjects();
+	// copy the prefab groups of the scene into the grid cells
+	void ReplicateSceneGrid();
+	// the bounds of a basic mesh in its own space
+	static AABB GetMeshBounds(MESH_TYPE mesh);
+	// find the scene nodes inside the camera view frustum
+	void CullSceneObjects();
+	// number of detail levels of a basic mesh
+	static int GetMeshLodCount(MESH_TYPE mesh);
+	// the detail level of a box for its screen size
+	int SelectMeshLod(
+		const AABB& bounds,
+		const glm::mat4& viewProjection,
+		float lodScale,
+		int lastLod,
+		int lodCount) const;
+	// choose the detail level of the visible scene nodes
+	void SelectObjectLods();
+	// draw the basic mesh assigned to a scene node
+	void DrawSceneMesh(MESH_TYPE mesh);
+	// sort the drawn objects by render state and group them
+	// into instanced draw batches
+	void BuildDrawQueue();
+	// refresh the instance values in draw queue order
+	void UpdateInstanceData();
+	// build the batches and instances of a range of sort runs
+	void BuildRunInstances(size_t firstRun, size_t lastRun, INSTANCE_LIST& list) const;
+	// run a loop body on the job system, or on this thread when
+	// there is none
+	void ParallelFor(int count, int minChunk, const JobSystem::RANGE_FUNCTION& function);
+	// forget the shader state of the last draw
+	void ResetRenderState();
+	// set the texture and material of the next draw, skipping
+	// the uniforms that already hold the requested values
+	void ApplyRenderState(int textureBinding, int materialIndex);
+	// draw a range of instances of a basic mesh
+	void DrawSceneMeshInstanced(MESH_TYPE mesh, int firstInstance, int instanceCount, int lod);
+	// draw the retained scene one object at a time
+	void RenderSceneObjects();
+	// draw the retained scene as instanced batches
+	void RenderSceneBatches();
+	// copy the defined materials into the material block
+	bool UploadSceneMaterials();
+	// create the GPU culling pass, falling back to the CPU path
+	void InitializeGpuCulling();
+	// create the draw record ring of the per object path
+	void InitializeDrawRing();
+	// add a point light with a radius to the clustered lights
+	void AddClusteredLight(
+		glm::vec3 position,
+		float radius,
+		glm::vec3 ambient,
+		glm::vec3 diffuse,
+		glm::vec3 specular);
+	// spread the requested ceiling lights over the scene grid
+	void AddCeilingLights();
+	// create the light cluster pass
+	void InitializeLightClusters();
+	// bin the clustered lights for the current camera and bind
+	// them for the scene shaders
+	void UpdateLightClusters();
+	// set the light cluster uniforms into the current program
+	void SetLightClusterUniforms();
+	// create the shader variant cache and build the variants of
+	// the current light setup
+	void InitializeShaderVariants();
+	// choose the programs of the draws for the current light setup
+	void UpdateDrawPrograms();
+	// the program that draws with a texture binding
+	GLuint GetDrawProgram(int textureBinding) const;
+	// make a draw program current along with the uniforms that
+	// are only set once per pass
+	void UseDrawProgram(GLuint programID);
+	// the mesh arena range of a basic mesh
+	MeshArena::MESH_RANGE GetMeshRange(MESH_TYPE mesh, int lod) const;
+	// true when a drawn scene node is large enough to hide
+	// other objects behind it
+	bool IsOccluder(int objectIndex) const;
+	// describe the drawn objects and their draw groups to the
+	// GPU culling pass
+	void BuildGpuObjects();
+	// draw the occluders into the depth pyramid
+	void RenderOccluderDepth();
+	// cull the retained scene on the GPU and draw it with one
+	// multi-draw per texture binding
+	void RenderSceneIndirect();
+	// draw the indirect groups of the GPU path
+	void DrawIndirectGroups();
+	// draw the instanced batches of the CPU path
+	void DrawSceneBatches();
+	// switch to drawing depth only, and then to shading the
+	// fragments that are equal to the drawn depth
+	void BeginDepthPrepass();
+	void BeginShadingPass();
+	// restore the depth state after the shaded pass
+	void EndShadingPass();
+	// create the shadow maps and the caster shapes
+	void InitializeShadows();
+	// sort the casters into the static and the dynamic batches
+	void BuildShadowCasters();
+	// copy the moved dynamic casters into the caster instances
+	void UpdateDynamicCasters();
+	// sort the casters again and redraw every cached map, after
+	// nodes were added or replaced
+	void InvalidateShadowCasters();
+	// draw the caster batches of a list
+	void DrawShadowCasters(const std::vector<DRAW_BATCH>& batches);
+	// bring a layer of the shadow maps up to date
+	void DrawShadowLayer(
+		ShadowMaps::SHADOW_TARGET target,
+		int layer,
+		const glm::mat4& viewProjection,
+		bool bRedrawStatic,
+		bool bRedrawDynamic);
+	// draw the shadow maps of the lights for this frame
+	void UpdateShadows();
+	// set the shadow uniforms of this frame into the current program
+	void SetShadowUniforms();
 
 public:
 
@@ -104,11 +642,88 @@ public:
 	void PrepareScene();
 	void RenderScene();
 
+	// set the shader files the scene program was loaded from, for
+	// building its variants and reloading it - call before
+	// PrepareScene()
+	void SetShaderFiles(const char* vertexShaderFile, const char* fragmentShaderFile);
+	// allow or forbid the specialized variants of the scene
+	// program - call before PrepareScene()
+	void SetShaderVariantsEnabled(bool bEnabled);
+
+	// watch the shader, texture and scene files and apply their
+	// changes between frames - call after PrepareScene()
+	void EnableHotReload();
+
+	// set the number of threads that share the scene update, 0
+	// for one per core and 1 for none - call before PrepareScene()
+	void SetJobThreadCount(int threadCount);
+
+	// load the scene from a scene file instead of the defined
+	// scene - call before PrepareScene()
+	void SetSceneFile(const char* filename);
+
+	// replicate the scene prefabs into a grid of columns x rows
+	// cells for stress testing - call before PrepareScene()
+	void SetSceneGrid(int columns, int rows);
+	// the center and the radius of the area the grid covers
+	void GetSceneGridBounds(glm::vec3& center, float& radius) const;
+
+	// draw calls and render state changes since the last reset
+	int GetDrawCallCount() const { return(m_drawCallCount); }
+	int GetStateChangeCount() const { return(m_stateChangeCount); }
+	void ResetFrameCounters();
+
+	// true while scene textures are still loading
+	bool IsLoadingTextures();
+	// true when the next RenderScene() may draw something other
+	// than the last frame with the same view
+	bool IsRedrawNeeded();
+
+	// turn the view frustum culling on or off
+	void SetCullingEnabled(bool bEnabled);
+	// draw the scene as instanced batches or one object at a
+	// time - call before PrepareScene()
+	void SetInstancingEnabled(bool bEnabled);
+	// choose the passes that draw the scene - call before
+	// PrepareScene()
+	void SetRenderMode(RENDER_MODE renderMode);
+	// allow or forbid the shadow maps - call before PrepareScene()
+	void SetShadowsEnabled(bool bEnabled);
+	// allow or forbid culling and drawing the scene on the GPU -
+	// call before PrepareScene()
+	void SetGpuCullingEnabled(bool bEnabled);
+	// allow or forbid the occlusion culling of the GPU path -
+	// call before PrepareScene()
+	void SetOcclusionCullingEnabled(bool bEnabled);
+	// allow or forbid the clustered point lights - call before
+	// PrepareScene()
+	void SetLightClustersEnabled(bool bEnabled);
+	// spread a grid of clustered ceiling lights over the scene
+	// grid for stress testing - call before PrepareScene()
+	void SetCeilingLightCount(int lightCount);
+	// number of point lights with a radius
+	int GetClusteredLightCount() const { return((int)m_clusterLights.size()); }
+
+	// turn the screen size based level of detail on or off
+	void SetLodEnabled(bool bEnabled);
+	// set how far past a switching size an object has to move
+	// before its detail level changes, 0 switches right away
+	void SetLodHysteresis(float hysteresis);
+
 	// LOADS TEXTURES FROM FILES
 	void LoadSceneTextures();
 	// pre-set light sources for 3D scene
 	void SetupSceneLights();
 	// pre-define the object materials for lighting
 	void DefineObjectMaterials();
+	// define the retained objects that make up the 3D scene
+	void DefineSceneObjects();
+
+	// move a retained scene node - it is rebuilt on the next render
+	void SetObjectTransform(
+		int objectIndex,
+		glm::vec3 scaleXYZ,
+		glm::vec3 rotationDegrees,
+		glm::vec3 positionXYZ);
 
 };
\ No newline at end of file
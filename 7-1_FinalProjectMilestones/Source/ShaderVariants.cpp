@@ -0,0 +1,167 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadervariants.cpp
+// ============
+// specialized variants of the scene program for a texture and light setup
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShaderVariants.h"
+#include "ProgramBuilder.h"
+
+#include <iostream>
+#include <sstream>
+
+/***********************************************************
+ *  ShaderVariants()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ShaderVariants::ShaderVariants(UniformCache* pUniformCache, UniformBuffers* pUniformBuffers)
+{
+	m_pUniformCache = pUniformCache;
+	m_pUniformBuffers = pUniformBuffers;
+}
+
+/***********************************************************
+ *  ~ShaderVariants()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ShaderVariants::~ShaderVariants()
+{
+	Clear();
+	m_pUniformCache = NULL;
+	m_pUniformBuffers = NULL;
+}
+
+/***********************************************************
+ *  SetShaderFiles()
+ *
+ *  This method is used for setting the shader files of the
+ *  scene program.  The variants that were already built
+ *  are kept until Clear() is called.
+ ***********************************************************/
+void ShaderVariants::SetShaderFiles(const char* vertexShaderFile, const char* fragmentShaderFile)
+{
+	m_vertexShaderFile = (NULL != vertexShaderFile) ? vertexShaderFile : "";
+	m_fragmentShaderFile = (NULL != fragmentShaderFile) ? fragmentShaderFile : "";
+}
+
+/***********************************************************
+ *  GetLightKey()
+ *
+ *  This method is used for getting the key bits of the
+ *  lights that are switched on in a light block.
+ ***********************************************************/
+unsigned int ShaderVariants::GetLightKey(const UBO_LIGHT_BLOCK& lights)
+{
+	unsigned int key = 0;
+
+	if (lights.directionalLight.bActive != 0)
+	{
+		key |= VARIANT_DIRECTIONAL_LIGHT;
+	}
+	for (int i = 0; i < TOTAL_POINT_LIGHTS; i++)
+	{
+		if (lights.pointLights[i].bActive != 0)
+		{
+			key |= 1u << (POINT_LIGHT_SHIFT + i);
+		}
+	}
+	if (lights.spotLight.bActive != 0)
+	{
+		key |= VARIANT_SPOT_LIGHT;
+	}
+
+	return(key);
+}
+
+/***********************************************************
+ *  GetDefines()
+ *
+ *  This method is used for writing the #define lines that
+ *  the fragment shader reads its fixed setup from.
+ ***********************************************************/
+std::string ShaderVariants::GetDefines(unsigned int key)
+{
+	std::ostringstream defines;
+
+	defines << "#define SHADER_VARIANT 1\n";
+	defines << "#define VARIANT_TEXTURE " << (((key & VARIANT_TEXTURE) != 0) ? 1 : 0) << "\n";
+	defines << "#define VARIANT_LIGHTING " << (((key & VARIANT_LIGHTING) != 0) ? 1 : 0) << "\n";
+	defines << "#define VARIANT_DIRECTIONAL_LIGHT " << (((key & VARIANT_DIRECTIONAL_LIGHT) != 0) ? 1 : 0) << "\n";
+	defines << "#define VARIANT_POINT_LIGHTS " << ((key >> POINT_LIGHT_SHIFT) & ((1u << TOTAL_POINT_LIGHTS) - 1u)) << "\n";
+	defines << "#define VARIANT_SPOT_LIGHT " << (((key & VARIANT_SPOT_LIGHT) != 0) ? 1 : 0) << "\n";
+
+	return(defines.str());
+}
+
+/***********************************************************
+ *  GetProgram()
+ *
+ *  This method is used for getting the program of a variant
+ *  key.  A new variant is built from the shader files, its
+ *  uniform blocks are connected to the shared buffers and
+ *  its uniform locations are added to the cache.  The
+ *  program that was current before stays current.
+ ***********************************************************/
+GLuint ShaderVariants::GetProgram(unsigned int key)
+{
+	std::unordered_map<unsigned int, GLuint>::const_iterator found = m_programs.find(key);
+	if (found != m_programs.end())
+	{
+		return(found->second);
+	}
+
+	GLuint programID = 0;
+	if ((m_vertexShaderFile.empty() == false) && (m_fragmentShaderFile.empty() == false))
+	{
+		programID = ProgramBuilder::BuildProgram(
+			m_vertexShaderFile.c_str(),
+			m_fragmentShaderFile.c_str(),
+			GetDefines(key));
+	}
+
+	if (programID == 0)
+	{
+		std::cout << "Could not build shader variant " << key << ", using the generic program" << std::endl;
+	}
+	else
+	{
+		if (NULL != m_pUniformBuffers)
+		{
+			m_pUniformBuffers->BindToProgram(programID);
+		}
+		if (NULL != m_pUniformCache)
+		{
+			m_pUniformCache->AddProgram(programID);
+		}
+	}
+
+	m_programs[key] = programID;
+
+	return(programID);
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for deleting every built variant and
+ *  removing it from the uniform cache.
+ ***********************************************************/
+void ShaderVariants::Clear()
+{
+	for (std::unordered_map<unsigned int, GLuint>::const_iterator variant = m_programs.begin();
+		variant != m_programs.end(); ++variant)
+	{
+		if (variant->second == 0)
+		{
+			continue;
+		}
+		if (NULL != m_pUniformCache)
+		{
+			m_pUniformCache->RemoveProgram(variant->second);
+		}
+		glDeleteProgram(variant->second);
+	}
+	m_programs.clear();
+}
@@ -0,0 +1,81 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadervariants.h
+// ============
+// specialized variants of the scene program for a texture and light setup
+//
+//  The scene fragment shader decides per fragment whether the object is
+//  textured and lit, and which lights of the light block are active.  A
+//  variant is the same program built with those decisions as #define values,
+//  so the compiler removes the branches and the code of the inactive lights.
+//  Variants are built on first use and cached by the key of their setup -
+//  the loaded program stays the fallback for a variant that does not build.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "UniformBuffers.h"
+#include "UniformCache.h"
+
+#include <GL/glew.h>
+
+#include <string>
+#include <unordered_map>
+
+/***********************************************************
+ *  ShaderVariants
+ *
+ *  This class contains the built variants of the scene
+ *  program, by variant key.  Every variant is added to the
+ *  uniform cache and connected to the uniform buffers.
+ ***********************************************************/
+class ShaderVariants
+{
+public:
+	// the bits of a variant key
+	enum VARIANT_FLAGS
+	{
+		VARIANT_TEXTURE = 1u << 0,
+		VARIANT_LIGHTING = 1u << 1,
+		VARIANT_DIRECTIONAL_LIGHT = 1u << 2,
+		VARIANT_SPOT_LIGHT = 1u << 3
+	};
+	// the active point lights of the light block are a bit mask
+	// starting at this bit of the key
+	static const int POINT_LIGHT_SHIFT = 4;
+
+	// constructor
+	ShaderVariants(UniformCache* pUniformCache, UniformBuffers* pUniformBuffers);
+	// destructor
+	~ShaderVariants();
+
+	// set the shader files the variants are built from
+	void SetShaderFiles(const char* vertexShaderFile, const char* fragmentShaderFile);
+
+	// the key bits of the active lights of a light block
+	static unsigned int GetLightKey(const UBO_LIGHT_BLOCK& lights);
+
+	// get the program of a variant, building it on first use -
+	// returns 0 when the variant does not build
+	GLuint GetProgram(unsigned int key);
+
+	// number of requested variants, built or not
+	int GetProgramCount() const { return((int)m_programs.size()); }
+
+	// delete every variant, so they are built again from the
+	// current shader files
+	void Clear();
+
+private:
+	// pointer to the cached uniform locations
+	UniformCache* m_pUniformCache;
+	// pointer to the uniform buffers the blocks are bound to
+	UniformBuffers* m_pUniformBuffers;
+	std::string m_vertexShaderFile;
+	std::string m_fragmentShaderFile;
+	// the program of every requested key, 0 for a variant that
+	// did not build, so it is not built again every frame
+	std::unordered_map<unsigned int, GLuint> m_programs;
+
+	// the #define lines of a variant key
+	static std::string GetDefines(unsigned int key);
+};
@@ -0,0 +1,463 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadowmaps.cpp
+// ============
+// cascaded shadow maps for the directional light and cube shadow maps for the
+// point lights of the light block
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShadowMaps.h"
+#include "ProgramBuilder.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// the cascades cover the view up to this depth
+	const float g_ShadowDistance = 60.0f;
+	// the nearest cascade starts at least this far from the camera
+	const float g_MinShadowNear = 0.1f;
+	// blend between uniform (0) and logarithmic (1) cascade splits
+	const float g_CascadeSplitBlend = 0.75f;
+	// the grid step of a cascade center as a fraction of the
+	// bounding sphere radius of its slice - a cascade covers its
+	// sphere plus the step, so the snapped center never moves the
+	// slice out of the map
+	const float g_CascadeSnapFraction = 0.25f;
+	// the bounding sphere radius is rounded up to this step, so the
+	// rounding of the sphere math does not change the matrix
+	const float g_CascadeRadiusStep = 1.0f / 16.0f;
+	// the near plane of the point light faces
+	const float g_PointNear = 0.1f;
+	// slope scaled depth offset of the casters against shadow acne
+	const float g_OffsetFactor = 2.0f;
+	const float g_OffsetUnits = 4.0f;
+
+	// the look and up directions of the cube faces, in the
+	// +X, -X, +Y, -Y, +Z, -Z order of OpenGL cube maps - must
+	// match the scene fragment shader
+	const glm::vec3 g_FaceDirections[ShadowMaps::CUBE_FACES] =
+	{
+		glm::vec3(1.0f, 0.0f, 0.0f),
+		glm::vec3(-1.0f, 0.0f, 0.0f),
+		glm::vec3(0.0f, 1.0f, 0.0f),
+		glm::vec3(0.0f, -1.0f, 0.0f),
+		glm::vec3(0.0f, 0.0f, 1.0f),
+		glm::vec3(0.0f, 0.0f, -1.0f)
+	};
+	const glm::vec3 g_FaceUps[ShadowMaps::CUBE_FACES] =
+	{
+		glm::vec3(0.0f, -1.0f, 0.0f),
+		glm::vec3(0.0f, -1.0f, 0.0f),
+		glm::vec3(0.0f, 0.0f, 1.0f),
+		glm::vec3(0.0f, 0.0f, -1.0f),
+		glm::vec3(0.0f, -1.0f, 0.0f),
+		glm::vec3(0.0f, -1.0f, 0.0f)
+	};
+
+	// the normalized device depth of a view depth
+	float ViewDepthToNdc(const glm::mat4& projection, float depth)
+	{
+		glm::vec4 clip = projection * glm::vec4(0.0f, 0.0f, -depth, 1.0f);
+		return(clip.z / clip.w);
+	}
+}
+
+/***********************************************************
+ *  ShadowMaps()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ShadowMaps::ShadowMaps()
+{
+	m_programID = 0;
+	m_viewProjectionLocation = -1;
+	m_framebuffer = 0;
+	m_cascadeTextures[0] = 0;
+	m_cascadeTextures[1] = 0;
+	m_pointTextures[0] = 0;
+	m_pointTextures[1] = 0;
+	for (int c = 0; c < CASCADE_COUNT; c++)
+	{
+		m_cascadeMatrices[c] = glm::mat4(0.0f);
+	}
+	m_cascadeSplits = glm::vec4(0.0f);
+	m_pointRange = 100.0f;
+	m_savedProgram = 0;
+	m_savedFramebuffer = 0;
+	m_savedViewport[0] = 0;
+	m_savedViewport[1] = 0;
+	m_savedViewport[2] = 0;
+	m_savedViewport[3] = 0;
+}
+
+/***********************************************************
+ *  ~ShadowMaps()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ShadowMaps::~ShadowMaps()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  IsSupported()
+ *
+ *  This method is used for checking whether the context can
+ *  create immutable texture arrays and copy between them.
+ ***********************************************************/
+bool ShadowMaps::IsSupported()
+{
+	if (GLEW_VERSION_4_3)
+	{
+		return(true);
+	}
+
+	return((GLEW_ARB_copy_image && GLEW_ARB_texture_storage) ? true : false);
+}
+
+/***********************************************************
+ *  CreateMapTexture()
+ *
+ *  This method is used for creating a depth texture array
+ *  that is sampled with depth comparison and bilinear
+ *  filtering, which averages four comparisons.  For the
+ *  cascades, everything outside of the map is lit.
+ ***********************************************************/
+GLuint ShadowMaps::CreateMapTexture(int size, int layerCount, bool bBorder)
+{
+	GLuint textureID = 0;
+	const GLfloat border[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+	glGenTextures(1, &textureID);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+	glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_DEPTH_COMPONENT32F, size, size, layerCount);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, (bBorder == true) ? GL_CLAMP_TO_BORDER : GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, (bBorder == true) ? GL_CLAMP_TO_BORDER : GL_CLAMP_TO_EDGE);
+	glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, border);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	return(textureID);
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for building the depth only caster
+ *  program and creating the cached and sampled maps and the
+ *  framebuffer they are drawn with.
+ ***********************************************************/
+bool ShadowMaps::Initialize(const char* vertexShaderFile, const char* fragmentShaderFile)
+{
+	m_programID = ProgramBuilder::BuildProgram(vertexShaderFile, fragmentShaderFile);
+	if (m_programID == 0)
+	{
+		return(false);
+	}
+	m_viewProjectionLocation = glGetUniformLocation(m_programID, "lightViewProjection");
+
+	for (int i = 0; i < 2; i++)
+	{
+		m_cascadeTextures[i] = CreateMapTexture(CASCADE_SIZE, CASCADE_COUNT, true);
+		m_pointTextures[i] = CreateMapTexture(CUBE_SIZE, POINT_LAYER_COUNT, false);
+	}
+
+	GLint previousFramebuffer = 0;
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+
+	glGenFramebuffers(1, &m_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_cascadeTextures[0], 0, 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)previousFramebuffer);
+
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Shadow map framebuffer is incomplete: " << status << std::endl;
+		Destroy();
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  UpdateCascades()
+ *
+ *  This method is used for fitting the cascades to a view.
+ *  The view depth range up to the shadow distance is split
+ *  into slices, and every cascade covers the bounding sphere
+ *  of its slice.  The sphere comes from the projection alone,
+ *  so only its center moves with the camera, and the center
+ *  is snapped to a grid of whole texels in light space.  The
+ *  depth range of every cascade is the scene bounds, so any
+ *  caster between the light and the slice is drawn.
+ ***********************************************************/
+int ShadowMaps::UpdateCascades(
+	const glm::vec3& lightDirection,
+	const glm::mat4& view,
+	const glm::mat4& projection,
+	const glm::vec3& sceneMin,
+	const glm::vec3& sceneMax)
+{
+	// the view depths of the near and the far plane
+	glm::mat4 inverseProjection = glm::inverse(projection);
+	glm::vec4 nearPoint = inverseProjection * glm::vec4(0.0f, 0.0f, -1.0f, 1.0f);
+	glm::vec4 farPoint = inverseProjection * glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+	float viewNear = std::max(-nearPoint.z / nearPoint.w, g_MinShadowNear);
+	float viewFar = std::min(-farPoint.z / farPoint.w, g_ShadowDistance);
+	viewFar = std::max(viewFar, viewNear * 2.0f);
+
+	float splits[CASCADE_COUNT + 1];
+	splits[0] = viewNear;
+	for (int c = 1; c <= CASCADE_COUNT; c++)
+	{
+		float fraction = (float)c / (float)CASCADE_COUNT;
+		float uniformSplit = viewNear + (viewFar - viewNear) * fraction;
+		float logSplit = viewNear * std::pow(viewFar / viewNear, fraction);
+		splits[c] = uniformSplit + (logSplit - uniformSplit) * g_CascadeSplitBlend;
+	}
+	m_cascadeSplits = glm::vec4(splits[1], splits[2], splits[3], 0.0f);
+
+	// the light looks along its direction from the origin
+	glm::vec3 direction = glm::normalize(lightDirection);
+	glm::vec3 up = (std::fabs(direction.y) > 0.99f) ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+	glm::mat4 lightView = glm::lookAt(glm::vec3(0.0f), direction, up);
+
+	// the light space depth range of the scene bounds
+	float minDepth = 3.0e38f;
+	float maxDepth = -3.0e38f;
+	for (int corner = 0; corner < 8; corner++)
+	{
+		glm::vec3 position(
+			((corner & 1) != 0) ? sceneMax.x : sceneMin.x,
+			((corner & 2) != 0) ? sceneMax.y : sceneMin.y,
+			((corner & 4) != 0) ? sceneMax.z : sceneMin.z);
+		float depth = (lightView * glm::vec4(position, 1.0f)).z;
+		minDepth = std::min(minDepth, depth);
+		maxDepth = std::max(maxDepth, depth);
+	}
+
+	glm::mat4 inverseView = glm::inverse(view);
+	int changedCascades = 0;
+	for (int c = 0; c < CASCADE_COUNT; c++)
+	{
+		// the view space corners of the slice
+		float ndcNear = ViewDepthToNdc(projection, splits[c]);
+		float ndcFar = ViewDepthToNdc(projection, splits[c + 1]);
+		glm::vec3 corners[8];
+		glm::vec3 center(0.0f);
+		for (int corner = 0; corner < 8; corner++)
+		{
+			glm::vec4 ndc(
+				((corner & 1) != 0) ? 1.0f : -1.0f,
+				((corner & 2) != 0) ? 1.0f : -1.0f,
+				((corner & 4) != 0) ? ndcFar : ndcNear,
+				1.0f);
+			glm::vec4 position = inverseProjection * ndc;
+			corners[corner] = glm::vec3(position) / position.w;
+			center += corners[corner] / 8.0f;
+		}
+		float radius = 0.0f;
+		for (int corner = 0; corner < 8; corner++)
+		{
+			radius = std::max(radius, glm::length(corners[corner] - center));
+		}
+		radius = std::ceil(radius / g_CascadeRadiusStep) * g_CascadeRadiusStep;
+
+		// the half size of the map and its texel grid
+		float halfSize = radius * (1.0f + g_CascadeSnapFraction);
+		float texelSize = 2.0f * halfSize / (float)CASCADE_SIZE;
+		float step = std::max(std::floor(radius * g_CascadeSnapFraction / texelSize), 1.0f) * texelSize;
+
+		glm::vec4 lightCenter = lightView * inverseView * glm::vec4(center, 1.0f);
+		float centerX = std::floor(lightCenter.x / step + 0.5f) * step;
+		float centerY = std::floor(lightCenter.y / step + 0.5f) * step;
+
+		glm::mat4 cascadeProjection = glm::ortho(
+			centerX - halfSize, centerX + halfSize,
+			centerY - halfSize, centerY + halfSize,
+			-maxDepth - 1.0f, -minDepth + 1.0f);
+		glm::mat4 cascadeMatrix = cascadeProjection * lightView;
+
+		if (cascadeMatrix != m_cascadeMatrices[c])
+		{
+			m_cascadeMatrices[c] = cascadeMatrix;
+			changedCascades |= 1 << c;
+		}
+	}
+
+	return(changedCascades);
+}
+
+/***********************************************************
+ *  SetPointRange()
+ *
+ *  This method is used for setting the far plane of the
+ *  point light faces.
+ ***********************************************************/
+void ShadowMaps::SetPointRange(float range)
+{
+	m_pointRange = std::max(range, g_PointNear * 2.0f);
+}
+
+/***********************************************************
+ *  GetFaceMatrix()
+ *
+ *  This method is used for getting the 90 degree view
+ *  projection of a cube face of a point light.
+ ***********************************************************/
+glm::mat4 ShadowMaps::GetFaceMatrix(const glm::vec3& lightPosition, int face) const
+{
+	glm::mat4 faceProjection = glm::perspective(glm::radians(90.0f), 1.0f, g_PointNear, m_pointRange);
+	glm::mat4 faceView = glm::lookAt(lightPosition, lightPosition + g_FaceDirections[face], g_FaceUps[face]);
+
+	return(faceProjection * faceView);
+}
+
+/***********************************************************
+ *  GetPointParameters()
+ *
+ *  This method is used for getting the near and far plane
+ *  of the cube faces, for turning a distance along the
+ *  major axis into the depth of the face.
+ ***********************************************************/
+glm::vec2 ShadowMaps::GetPointParameters() const
+{
+	return(glm::vec2(g_PointNear, m_pointRange));
+}
+
+/***********************************************************
+ *  BeginPass()
+ *
+ *  This method is used for binding the caster program and
+ *  the shadow framebuffer.  The casters are drawn with a
+ *  slope scaled depth offset.
+ ***********************************************************/
+void ShadowMaps::BeginPass()
+{
+	glGetIntegerv(GL_CURRENT_PROGRAM, &m_savedProgram);
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &m_savedFramebuffer);
+	glGetIntegerv(GL_VIEWPORT, m_savedViewport);
+
+	glUseProgram(m_programID);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glDepthMask(GL_TRUE);
+	glDepthFunc(GL_LESS);
+	glEnable(GL_POLYGON_OFFSET_FILL);
+	glPolygonOffset(g_OffsetFactor, g_OffsetUnits);
+}
+
+/***********************************************************
+ *  BeginLayer()
+ *
+ *  This method is used for attaching a layer of the cached
+ *  or the sampled maps and setting the view projection of
+ *  the casters drawn into it.  A cached layer is cleared,
+ *  a sampled layer keeps the copy of its cached layer.
+ ***********************************************************/
+void ShadowMaps::BeginLayer(SHADOW_TARGET target, bool bCached, int layer, const glm::mat4& viewProjection)
+{
+	int index = (bCached == true) ? 0 : 1;
+	GLuint textureID = (target == TARGET_CASCADE) ? m_cascadeTextures[index] : m_pointTextures[index];
+	int size = (target == TARGET_CASCADE) ? CASCADE_SIZE : CUBE_SIZE;
+
+	glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, textureID, 0, layer);
+	glViewport(0, 0, size, size);
+	if (bCached == true)
+	{
+		glClear(GL_DEPTH_BUFFER_BIT);
+	}
+	glUniformMatrix4fv(m_viewProjectionLocation, 1, GL_FALSE, &viewProjection[0][0]);
+}
+
+/***********************************************************
+ *  CopyCachedLayer()
+ *
+ *  This method is used for copying a cached layer over its
+ *  sampled layer, before the dynamic casters are drawn.
+ ***********************************************************/
+void ShadowMaps::CopyCachedLayer(SHADOW_TARGET target, int layer)
+{
+	const GLuint* textures = (target == TARGET_CASCADE) ? m_cascadeTextures : m_pointTextures;
+	int size = (target == TARGET_CASCADE) ? CASCADE_SIZE : CUBE_SIZE;
+
+	glCopyImageSubData(
+		textures[0], GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer,
+		textures[1], GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer,
+		size, size, 1);
+}
+
+/***********************************************************
+ *  EndPass()
+ *
+ *  This method is used for restoring the program, the
+ *  framebuffer and the viewport of the scene.
+ ***********************************************************/
+void ShadowMaps::EndPass()
+{
+	glDisable(GL_POLYGON_OFFSET_FILL);
+	glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)m_savedFramebuffer);
+	glViewport(m_savedViewport[0], m_savedViewport[1], m_savedViewport[2], m_savedViewport[3]);
+	glUseProgram((GLuint)m_savedProgram);
+}
+
+/***********************************************************
+ *  BindTextures()
+ *
+ *  This method is used for binding the sampled maps to the
+ *  texture units the scene shaders read them from.  Texture
+ *  unit 0 is active again afterwards.
+ ***********************************************************/
+void ShadowMaps::BindTextures(int cascadeTextureUnit, int pointTextureUnit) const
+{
+	glActiveTexture(GL_TEXTURE0 + cascadeTextureUnit);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, m_cascadeTextures[1]);
+	glActiveTexture(GL_TEXTURE0 + pointTextureUnit);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, m_pointTextures[1]);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for releasing the program, the
+ *  framebuffer and the maps.
+ ***********************************************************/
+void ShadowMaps::Destroy()
+{
+	if (m_framebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &m_framebuffer);
+		m_framebuffer = 0;
+	}
+	for (int i = 0; i < 2; i++)
+	{
+		if (m_cascadeTextures[i] != 0)
+		{
+			glDeleteTextures(1, &m_cascadeTextures[i]);
+			m_cascadeTextures[i] = 0;
+		}
+		if (m_pointTextures[i] != 0)
+		{
+			glDeleteTextures(1, &m_pointTextures[i]);
+			m_pointTextures[i] = 0;
+		}
+	}
+	if (m_programID != 0)
+	{
+		glDeleteProgram(m_programID);
+		m_programID = 0;
+	}
+}
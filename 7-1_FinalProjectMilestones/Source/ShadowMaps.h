@@ -0,0 +1,120 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadowmaps.h
+// ============
+// cascaded shadow maps for the directional light and cube shadow maps for the
+// point lights of the light block
+//
+//  The view is split into depth slices and each slice gets an orthographic
+//  shadow map of the directional light that covers the bounding sphere of the
+//  slice.  The sphere only depends on the camera projection, and its center
+//  is snapped to a grid in light space, so a cascade keeps the same matrix
+//  while the camera moves within a grid step.  The point lights get the six
+//  faces of a cube map, stored as layers of a texture array so the scene
+//  shader samples every map with a plain 2D array shadow sampler.
+//
+//  Every map exists twice.  The static casters are drawn into a cached layer
+//  only when its matrix or the static casters change, and the sampled layer
+//  is a copy of the cached one with the dynamic casters drawn on top.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "UniformBuffers.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  ShadowMaps
+ *
+ *  This class contains the shadow map textures, the
+ *  framebuffer they are drawn with, the depth only program
+ *  of the casters and the matrices of every map.
+ ***********************************************************/
+class ShadowMaps
+{
+public:
+	// the cascades of the directional light, must match the
+	// scene fragment shader
+	static const int CASCADE_COUNT = 3;
+	static const int CASCADE_SIZE = 1024;
+	// the cube faces of every point light of the light block
+	static const int CUBE_FACES = 6;
+	static const int CUBE_SIZE = 512;
+	static const int POINT_LAYER_COUNT = TOTAL_POINT_LIGHTS * CUBE_FACES;
+
+	// the maps that a caster pass draws into
+	enum SHADOW_TARGET
+	{
+		TARGET_CASCADE,
+		TARGET_POINT
+	};
+
+	// constructor
+	ShadowMaps();
+	// destructor
+	~ShadowMaps();
+
+	// true when the context can copy the cached layers
+	static bool IsSupported();
+
+	// build the caster program and create the maps - needs a
+	// current GL context
+	bool Initialize(const char* vertexShaderFile, const char* fragmentShaderFile);
+
+	// fit the cascades of a directional light to a view and the
+	// scene bounds - returns a bit per cascade whose matrix changed
+	int UpdateCascades(
+		const glm::vec3& lightDirection,
+		const glm::mat4& view,
+		const glm::mat4& projection,
+		const glm::vec3& sceneMin,
+		const glm::vec3& sceneMax);
+	const glm::mat4& GetCascadeMatrix(int cascade) const { return(m_cascadeMatrices[cascade]); }
+	// the view depth where every cascade ends, in xyz
+	const glm::vec4& GetCascadeSplits() const { return(m_cascadeSplits); }
+
+	// set the far plane of the point light faces, every caster
+	// has to be closer to the lights than this
+	void SetPointRange(float range);
+	// the view projection of a cube face of a point light
+	glm::mat4 GetFaceMatrix(const glm::vec3& lightPosition, int face) const;
+	// the near and far plane of the cube faces
+	glm::vec2 GetPointParameters() const;
+
+	// bind the caster program and the shadow framebuffer - the
+	// program, framebuffer and viewport are restored by EndPass()
+	void BeginPass();
+	// draw into a layer of the cached or the sampled maps with a
+	// view projection - the cached layers are cleared first
+	void BeginLayer(SHADOW_TARGET target, bool bCached, int layer, const glm::mat4& viewProjection);
+	// copy a cached layer into the sampled maps
+	void CopyCachedLayer(SHADOW_TARGET target, int layer);
+	void EndPass();
+
+	// bind the sampled maps for the scene shaders
+	void BindTextures(int cascadeTextureUnit, int pointTextureUnit) const;
+
+	// release the program, the framebuffer and the textures
+	void Destroy();
+
+private:
+	GLuint m_programID;
+	GLint m_viewProjectionLocation;
+	GLuint m_framebuffer;
+	// the cached and the sampled maps
+	GLuint m_cascadeTextures[2];
+	GLuint m_pointTextures[2];
+
+	glm::mat4 m_cascadeMatrices[CASCADE_COUNT];
+	glm::vec4 m_cascadeSplits;
+	float m_pointRange;
+
+	// the state replaced by BeginPass()
+	GLint m_savedProgram;
+	GLint m_savedFramebuffer;
+	GLint m_savedViewport[4];
+
+	// create a depth texture array for a map
+	static GLuint CreateMapTexture(int size, int layerCount, bool bBorder);
+};
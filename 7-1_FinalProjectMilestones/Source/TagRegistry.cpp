@@ -0,0 +1,74 @@
+///////////////////////////////////////////////////////////////////////////////
+// tagregistry.cpp
+// ============
+// intern string tags into small integer IDs for constant time lookups
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TagRegistry.h"
+
+/***********************************************************
+ *  Intern()
+ *
+ *  This method is used for getting the ID of a tag.  A tag
+ *  that is not registered yet is copied into the registry
+ *  and receives the next free ID.
+ ***********************************************************/
+int TagRegistry::Intern(std::string_view tag)
+{
+	int id = Find(tag);
+	if (id >= 0)
+	{
+		return(id);
+	}
+
+	id = (int)m_tags.size();
+	m_tags.emplace_back(tag);
+	m_ids.emplace(std::string_view(m_tags.back()), id);
+
+	return(id);
+}
+
+/***********************************************************
+ *  Find()
+ *
+ *  This method is used for getting the ID of a registered
+ *  tag.  A miss is reported by returning -1.
+ ***********************************************************/
+int TagRegistry::Find(std::string_view tag) const
+{
+	std::unordered_map<std::string_view, int>::const_iterator found = m_ids.find(tag);
+	if (found == m_ids.end())
+	{
+		return(-1);
+	}
+
+	return(found->second);
+}
+
+/***********************************************************
+ *  GetTag()
+ *
+ *  This method is used for getting the tag that belongs to
+ *  a registered ID.
+ ***********************************************************/
+std::string_view TagRegistry::GetTag(int id) const
+{
+	if ((id < 0) || (id >= (int)m_tags.size()))
+	{
+		return(std::string_view());
+	}
+
+	return(m_tags[id]);
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing all of the registered
+ *  tags.  Previously returned IDs are no longer valid.
+ ***********************************************************/
+void TagRegistry::Clear()
+{
+	m_ids.clear();
+	m_tags.clear();
+}
@@ -0,0 +1,47 @@
+///////////////////////////////////////////////////////////////////////////////
+// tagregistry.h
+// ============
+// intern string tags into small integer IDs for constant time lookups
+//
+//  A tag is copied into the registry once, when it is first interned, and is
+//  looked up through a hash table afterwards.  The lookups take string_view so
+//  that string literals and substrings are searched without building a
+//  temporary std::string.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/***********************************************************
+ *  TagRegistry
+ *
+ *  This class contains the interned tags of one kind of
+ *  resource.  IDs are handed out in order starting at zero,
+ *  so they can index a parallel array of the resources.
+ ***********************************************************/
+class TagRegistry
+{
+public:
+	// get the ID of a tag, registering it when it is new
+	int Intern(std::string_view tag);
+	// get the ID of a registered tag, or -1 when it is unknown
+	int Find(std::string_view tag) const;
+	// get the tag of a registered ID, empty when it is unknown
+	std::string_view GetTag(int id) const;
+
+	// the number of registered tags
+	int Size() const { return((int)m_tags.size()); }
+	// remove all of the registered tags
+	void Clear();
+
+private:
+	// the tag storage - a deque never moves its elements, so the
+	// views used as hash keys stay valid as tags are added
+	std::deque<std::string> m_tags;
+	// the ID of every registered tag
+	std::unordered_map<std::string_view, int> m_ids;
+};
@@ -0,0 +1,689 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturecache.cpp
+// ============
+// GPU-compressed texture cache files - BC1/BC3 blocks with prebuilt mipmaps
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureCache.h"
+#include "TextureStorage.h"
+
+// the implementation of the image library is compiled in SceneManager.cpp
+#include "stb_image.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+	// the identifier that starts every KTX 1.1 file
+	const unsigned char g_KTXIdentifier[12] =
+	{
+		0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A
+	};
+	const uint32_t g_KTXEndianness = 0x04030201;
+	const char* g_CacheExtension = ".ktx";
+
+	// the fields that follow the identifier of a KTX 1.1 file
+	struct KTX_HEADER
+	{
+		uint32_t endianness;
+		uint32_t glType;
+		uint32_t glTypeSize;
+		uint32_t glFormat;
+		uint32_t glInternalFormat;
+		uint32_t glBaseInternalFormat;
+		uint32_t pixelWidth;
+		uint32_t pixelHeight;
+		uint32_t pixelDepth;
+		uint32_t numberOfArrayElements;
+		uint32_t numberOfFaces;
+		uint32_t numberOfMipmapLevels;
+		uint32_t bytesOfKeyValueData;
+	};
+
+	// get the number of bytes of one compressed level
+	size_t GetLevelSize(GLenum internalFormat, int width, int height)
+	{
+		size_t blockBytes = (internalFormat == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT) ? 16 : 8;
+		size_t blocksWide = (size_t)std::max(1, (width + 3) / 4);
+		size_t blocksHigh = (size_t)std::max(1, (height + 3) / 4);
+
+		return(blocksWide * blocksHigh * blockBytes);
+	}
+
+	// pack an 8 bit per channel color into 5:6:5 bits
+	uint16_t PackColor565(const unsigned char* color)
+	{
+		return((uint16_t)(((color[0] >> 3) << 11) | ((color[1] >> 2) << 5) | (color[2] >> 3)));
+	}
+
+	// expand a 5:6:5 color back to 8 bits per channel
+	void UnpackColor565(uint16_t packed, int* color)
+	{
+		int red = (packed >> 11) & 0x1F;
+		int green = (packed >> 5) & 0x3F;
+		int blue = packed & 0x1F;
+
+		color[0] = (red << 3) | (red >> 2);
+		color[1] = (green << 2) | (green >> 4);
+		color[2] = (blue << 3) | (blue >> 2);
+	}
+
+	// write a value into a byte stream, least significant byte first
+	void WriteLittleEndian(unsigned char* output, uint64_t value, int byteCount)
+	{
+		for (int i = 0; i < byteCount; i++)
+		{
+			output[i] = (unsigned char)((value >> (8 * i)) & 0xFF);
+		}
+	}
+
+	/***********************************************************
+	 *  EncodeColorBlock()
+	 *
+	 *  This function is used for compressing the colors of a
+	 *  4x4 block of RGBA pixels into an 8 byte BC1 block.  The
+	 *  endpoints are the corners of the slightly inset color
+	 *  bounding box, and every pixel takes the nearest of the
+	 *  four palette colors.
+	 ***********************************************************/
+	void EncodeColorBlock(const unsigned char block[16][4], unsigned char* output)
+	{
+		unsigned char minColor[3] = { 255, 255, 255 };
+		unsigned char maxColor[3] = { 0, 0, 0 };
+
+		for (int i = 0; i < 16; i++)
+		{
+			for (int c = 0; c < 3; c++)
+			{
+				minColor[c] = std::min(minColor[c], block[i][c]);
+				maxColor[c] = std::max(maxColor[c], block[i][c]);
+			}
+		}
+
+		// insetting the box by 1/16 of its size moves the endpoints
+		// off outliers and lowers the average error
+		for (int c = 0; c < 3; c++)
+		{
+			int inset = (maxColor[c] - minColor[c]) >> 4;
+			minColor[c] = (unsigned char)std::min(255, minColor[c] + inset);
+			maxColor[c] = (unsigned char)std::max(0, maxColor[c] - inset);
+		}
+
+		uint16_t color0 = PackColor565(maxColor);
+		uint16_t color1 = PackColor565(minColor);
+		uint32_t indices = 0;
+
+		// the four color mode needs the first endpoint to be larger
+		if (color0 < color1)
+		{
+			std::swap(color0, color1);
+		}
+
+		if (color0 != color1)
+		{
+			int palette[4][3];
+			UnpackColor565(color0, palette[0]);
+			UnpackColor565(color1, palette[1]);
+			for (int c = 0; c < 3; c++)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+
+			for (int i = 0; i < 16; i++)
+			{
+				int bestIndex = 0;
+				int bestDistance = 0x7FFFFFFF;
+				for (int p = 0; p < 4; p++)
+				{
+					int distance = 0;
+					for (int c = 0; c < 3; c++)
+					{
+						int delta = (int)block[i][c] - palette[p][c];
+						distance += delta * delta;
+					}
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						bestIndex = p;
+					}
+				}
+				indices |= (uint32_t)bestIndex << (2 * i);
+			}
+		}
+
+		WriteLittleEndian(output, color0, 2);
+		WriteLittleEndian(output + 2, color1, 2);
+		WriteLittleEndian(output + 4, indices, 4);
+	}
+
+	/***********************************************************
+	 *  EncodeAlphaBlock()
+	 *
+	 *  This function is used for compressing the alpha values
+	 *  of a 4x4 block of RGBA pixels into the 8 byte alpha part
+	 *  of a BC3 block, using the eight value palette between
+	 *  the largest and smallest alpha.
+	 ***********************************************************/
+	void EncodeAlphaBlock(const unsigned char block[16][4], unsigned char* output)
+	{
+		int alpha0 = 0;
+		int alpha1 = 255;
+		uint64_t indices = 0;
+
+		for (int i = 0; i < 16; i++)
+		{
+			alpha0 = std::max(alpha0, (int)block[i][3]);
+			alpha1 = std::min(alpha1, (int)block[i][3]);
+		}
+
+		if (alpha0 != alpha1)
+		{
+			int palette[8];
+			palette[0] = alpha0;
+			palette[1] = alpha1;
+			for (int p = 2; p < 8; p++)
+			{
+				palette[p] = ((8 - p) * alpha0 + (p - 1) * alpha1) / 7;
+			}
+
+			for (int i = 0; i < 16; i++)
+			{
+				int bestIndex = 0;
+				int bestDistance = 256;
+				for (int p = 0; p < 8; p++)
+				{
+					int distance = std::abs((int)block[i][3] - palette[p]);
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						bestIndex = p;
+					}
+				}
+				indices |= (uint64_t)bestIndex << (3 * i);
+			}
+		}
+
+		output[0] = (unsigned char)alpha0;
+		output[1] = (unsigned char)alpha1;
+		WriteLittleEndian(output + 2, indices, 6);
+	}
+
+	/***********************************************************
+	 *  CompressLevel()
+	 *
+	 *  This function is used for compressing one RGBA mipmap
+	 *  level block by block.  Blocks that reach past the right
+	 *  or top edge repeat the edge pixels.
+	 ***********************************************************/
+	void CompressLevel(
+		const std::vector<unsigned char>& rgba,
+		int width,
+		int height,
+		GLenum internalFormat,
+		unsigned char* output)
+	{
+		unsigned char block[16][4];
+		bool bAlpha = (internalFormat == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT);
+
+		for (int blockY = 0; blockY < height; blockY += 4)
+		{
+			for (int blockX = 0; blockX < width; blockX += 4)
+			{
+				for (int y = 0; y < 4; y++)
+				{
+					int sourceY = std::min(blockY + y, height - 1);
+					for (int x = 0; x < 4; x++)
+					{
+						int sourceX = std::min(blockX + x, width - 1);
+						memcpy(block[y * 4 + x], &rgba[((size_t)sourceY * width + sourceX) * 4], 4);
+					}
+				}
+
+				if (bAlpha == true)
+				{
+					EncodeAlphaBlock(block, output);
+					output += 8;
+				}
+				EncodeColorBlock(block, output);
+				output += 8;
+			}
+		}
+	}
+
+	/***********************************************************
+	 *  DownsampleLevel()
+	 *
+	 *  This function is used for building the next mipmap level
+	 *  by averaging every 2x2 pixel square of an RGBA level.
+	 ***********************************************************/
+	void DownsampleLevel(
+		const std::vector<unsigned char>& source,
+		int width,
+		int height,
+		std::vector<unsigned char>& destination,
+		int& nextWidth,
+		int& nextHeight)
+	{
+		nextWidth = std::max(1, width / 2);
+		nextHeight = std::max(1, height / 2);
+		destination.resize((size_t)nextWidth * nextHeight * 4);
+
+		for (int y = 0; y < nextHeight; y++)
+		{
+			int y0 = std::min(y * 2, height - 1);
+			int y1 = std::min(y * 2 + 1, height - 1);
+			for (int x = 0; x < nextWidth; x++)
+			{
+				int x0 = std::min(x * 2, width - 1);
+				int x1 = std::min(x * 2 + 1, width - 1);
+				for (int c = 0; c < 4; c++)
+				{
+					int sum =
+						source[((size_t)y0 * width + x0) * 4 + c] +
+						source[((size_t)y0 * width + x1) * 4 + c] +
+						source[((size_t)y1 * width + x0) * 4 + c] +
+						source[((size_t)y1 * width + x1) * 4 + c];
+					destination[((size_t)y * nextWidth + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+				}
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  GetCachePath()
+ *
+ *  This method is used for getting the name of the cache
+ *  file that belongs to a source image file.
+ ***********************************************************/
+std::string TextureCache::GetCachePath(const char* sourceFile)
+{
+	std::filesystem::path cachePath(sourceFile);
+	cachePath.replace_extension(g_CacheExtension);
+
+	return(cachePath.string());
+}
+
+/***********************************************************
+ *  IsCacheCurrent()
+ *
+ *  This method is used for checking whether the cache file
+ *  of a source image can be used.  A cache file without a
+ *  source image is always current.
+ ***********************************************************/
+bool TextureCache::IsCacheCurrent(const char* sourceFile)
+{
+	std::error_code error;
+	std::filesystem::path cachePath(GetCachePath(sourceFile));
+
+	if (std::filesystem::exists(cachePath, error) == false)
+	{
+		return(false);
+	}
+	if (std::filesystem::exists(sourceFile, error) == false)
+	{
+		return(true);
+	}
+
+	std::filesystem::file_time_type cacheTime = std::filesystem::last_write_time(cachePath, error);
+	if (error)
+	{
+		return(false);
+	}
+	std::filesystem::file_time_type sourceTime = std::filesystem::last_write_time(sourceFile, error);
+	if (error)
+	{
+		return(false);
+	}
+
+	return(cacheTime >= sourceTime);
+}
+
+/***********************************************************
+ *  IsSupported()
+ *
+ *  This method is used for checking whether the driver can
+ *  sample the BC1 and BC3 formats of the cache files.
+ ***********************************************************/
+bool TextureCache::IsSupported()
+{
+	return(GLEW_EXT_texture_compression_s3tc ? true : false);
+}
+
+/***********************************************************
+ *  Compress()
+ *
+ *  This method is used for building the compressed mipmap
+ *  chain of a decoded image.  RGB images are stored as BC1
+ *  and RGBA images as BC3.
+ ***********************************************************/
+bool TextureCache::Compress(
+	const unsigned char* pixels,
+	int width,
+	int height,
+	int colorChannels,
+	COMPRESSED_TEXTURE& texture)
+{
+	if ((NULL == pixels) || (width <= 0) || (height <= 0))
+	{
+		return(false);
+	}
+
+	if (colorChannels == 3)
+	{
+		texture.internalFormat = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+		texture.baseFormat = GL_RGB;
+	}
+	else if (colorChannels == 4)
+	{
+		texture.internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		texture.baseFormat = GL_RGBA;
+	}
+	else
+	{
+		std::cout << "Not implemented to handle image with " << colorChannels << " channels" << std::endl;
+		return(false);
+	}
+
+	texture.width = width;
+	texture.height = height;
+	texture.data.clear();
+	texture.levelOffsets.clear();
+	texture.levelSizes.clear();
+
+	// the mipmaps are built from full RGBA pixels
+	std::vector<unsigned char> level((size_t)width * height * 4);
+	for (size_t i = 0; i < (size_t)width * height; i++)
+	{
+		level[i * 4 + 0] = pixels[i * colorChannels + 0];
+		level[i * 4 + 1] = pixels[i * colorChannels + 1];
+		level[i * 4 + 2] = pixels[i * colorChannels + 2];
+		level[i * 4 + 3] = (colorChannels == 4) ? pixels[i * colorChannels + 3] : 255;
+	}
+
+	int levelWidth = width;
+	int levelHeight = height;
+	std::vector<unsigned char> nextLevel;
+	while (true)
+	{
+		size_t levelSize = GetLevelSize(texture.internalFormat, levelWidth, levelHeight);
+		size_t levelOffset = texture.data.size();
+
+		texture.data.resize(levelOffset + levelSize);
+		CompressLevel(level, levelWidth, levelHeight, texture.internalFormat, &texture.data[levelOffset]);
+		texture.levelOffsets.push_back(levelOffset);
+		texture.levelSizes.push_back(levelSize);
+
+		if ((levelWidth == 1) && (levelHeight == 1))
+		{
+			break;
+		}
+
+		DownsampleLevel(level, levelWidth, levelHeight, nextLevel, levelWidth, levelHeight);
+		level.swap(nextLevel);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  WriteFile()
+ *
+ *  This method is used for writing a compressed mipmap
+ *  chain into a KTX 1.1 cache file.
+ ***********************************************************/
+bool TextureCache::WriteFile(const char* cacheFile, const COMPRESSED_TEXTURE& texture)
+{
+	std::ofstream file(cacheFile, std::ios::binary | std::ios::trunc);
+	if (!file)
+	{
+		std::cout << "Could not write texture cache:" << cacheFile << std::endl;
+		return(false);
+	}
+
+	KTX_HEADER header;
+	header.endianness = g_KTXEndianness;
+	// compressed data has no pixel type or pixel format
+	header.glType = 0;
+	header.glTypeSize = 1;
+	header.glFormat = 0;
+	header.glInternalFormat = texture.internalFormat;
+	header.glBaseInternalFormat = texture.baseFormat;
+	header.pixelWidth = (uint32_t)texture.width;
+	header.pixelHeight = (uint32_t)texture.height;
+	header.pixelDepth = 0;
+	header.numberOfArrayElements = 0;
+	header.numberOfFaces = 1;
+	header.numberOfMipmapLevels = (uint32_t)texture.levelSizes.size();
+	header.bytesOfKeyValueData = 0;
+
+	file.write((const char*)g_KTXIdentifier, sizeof(g_KTXIdentifier));
+	file.write((const char*)&header, sizeof(header));
+
+	// the compressed blocks are 8 or 16 bytes, so every level is
+	// already padded to the four byte boundary of the format
+	for (size_t level = 0; level < texture.levelSizes.size(); level++)
+	{
+		uint32_t imageSize = (uint32_t)texture.levelSizes[level];
+		file.write((const char*)&imageSize, sizeof(imageSize));
+		file.write((const char*)&texture.data[texture.levelOffsets[level]], imageSize);
+	}
+
+	return(file.good());
+}
+
+/***********************************************************
+ *  ReadFile()
+ *
+ *  This method is used for reading a KTX 1.1 cache file
+ *  written by WriteFile().  Files in any other layout are
+ *  rejected so that the source image is loaded instead.
+ ***********************************************************/
+bool TextureCache::ReadFile(const char* cacheFile, COMPRESSED_TEXTURE& texture)
+{
+	std::ifstream file(cacheFile, std::ios::binary);
+	if (!file)
+	{
+		return(false);
+	}
+
+	unsigned char identifier[12];
+	KTX_HEADER header;
+	file.read((char*)identifier, sizeof(identifier));
+	file.read((char*)&header, sizeof(header));
+	if ((!file) ||
+		(memcmp(identifier, g_KTXIdentifier, sizeof(g_KTXIdentifier)) != 0) ||
+		(header.endianness != g_KTXEndianness) ||
+		(header.glType != 0) ||
+		((header.glInternalFormat != GL_COMPRESSED_RGB_S3TC_DXT1_EXT) &&
+		 (header.glInternalFormat != GL_COMPRESSED_RGBA_S3TC_DXT5_EXT)) ||
+		(header.pixelDepth > 1) ||
+		(header.numberOfArrayElements != 0) ||
+		(header.numberOfFaces != 1) ||
+		(header.pixelWidth == 0) ||
+		(header.pixelHeight == 0))
+	{
+		std::cout << "Unsupported texture cache file:" << cacheFile << std::endl;
+		return(false);
+	}
+
+	// a chain longer than the full chain of the image size would
+	// read past the real levels
+	if (header.numberOfMipmapLevels > (uint32_t)TextureStorage::GetMipLevelCount(
+		(int)std::min<uint32_t>(header.pixelWidth, INT_MAX),
+		(int)std::min<uint32_t>(header.pixelHeight, INT_MAX)))
+	{
+		std::cout << "Corrupt texture cache file:" << cacheFile << std::endl;
+		return(false);
+	}
+
+	file.seekg(header.bytesOfKeyValueData, std::ios::cur);
+
+	texture.internalFormat = header.glInternalFormat;
+	texture.baseFormat = header.glBaseInternalFormat;
+	texture.width = (int)header.pixelWidth;
+	texture.height = (int)header.pixelHeight;
+	texture.data.clear();
+	texture.levelOffsets.clear();
+	texture.levelSizes.clear();
+
+	uint32_t levels = std::max<uint32_t>(1, header.numberOfMipmapLevels);
+	for (uint32_t level = 0; level < levels; level++)
+	{
+		int levelWidth = std::max(1, texture.width >> level);
+		int levelHeight = std::max(1, texture.height >> level);
+		uint32_t imageSize = 0;
+
+		file.read((char*)&imageSize, sizeof(imageSize));
+		if ((!file) || (imageSize != GetLevelSize(texture.internalFormat, levelWidth, levelHeight)))
+		{
+			std::cout << "Corrupt texture cache file:" << cacheFile << std::endl;
+			return(false);
+		}
+
+		size_t levelOffset = texture.data.size();
+		texture.data.resize(levelOffset + imageSize);
+		file.read((char*)&texture.data[levelOffset], imageSize);
+		if (!file)
+		{
+			std::cout << "Corrupt texture cache file:" << cacheFile << std::endl;
+			return(false);
+		}
+		texture.levelOffsets.push_back(levelOffset);
+		texture.levelSizes.push_back(imageSize);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  CreateGLTexture()
+ *
+ *  This method is used for creating an OpenGL texture from
+ *  a compressed mipmap chain.  No mipmaps are generated, the
+ *  prebuilt levels are uploaded as they are.
+ ***********************************************************/
+GLuint TextureCache::CreateGLTexture(
+	const COMPRESSED_TEXTURE& texture,
+	const unsigned char* pixelBase)
+{
+	GLuint textureID = 0;
+
+	// the prebuilt levels fill immutable storage of the same size
+	textureID = TextureStorage::CreateTexture2D(texture.internalFormat,
+		texture.width, texture.height, (int)texture.levelSizes.size());
+
+	// set the texture wrapping parameters
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	// set texture filtering parameters - minified textures blend
+	// between the prebuilt levels when there is more than one
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+		(texture.levelSizes.size() > 1) ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	for (size_t level = 0; level < texture.levelSizes.size(); level++)
+	{
+		int levelWidth = std::max(1, texture.width >> level);
+		int levelHeight = std::max(1, texture.height >> level);
+		const void* levelData = NULL;
+
+		if (NULL != pixelBase)
+		{
+			levelData = pixelBase + texture.levelOffsets[level];
+		}
+		else
+		{
+			// an offset into the bound pixel unpack buffer
+			levelData = reinterpret_cast<const void*>((uintptr_t)texture.levelOffsets[level]);
+		}
+
+		glCompressedTexSubImage2D(GL_TEXTURE_2D, (GLint)level, 0, 0,
+			levelWidth, levelHeight, texture.internalFormat,
+			(GLsizei)texture.levelSizes[level], levelData);
+	}
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	return(textureID);
+}
+
+/***********************************************************
+ *  BuildDirectory()
+ *
+ *  This method is used for building the cache files of all
+ *  the PNG images in a directory.  Cache files that are
+ *  newer than their image are kept unless bForce is set.
+ ***********************************************************/
+bool TextureCache::BuildDirectory(const char* directory, bool bForce)
+{
+	std::error_code error;
+	bool bSuccess = true;
+	int builtFiles = 0;
+
+	std::filesystem::directory_iterator entries(directory, error);
+	if (error)
+	{
+		std::cout << "Could not open texture directory:" << directory << std::endl;
+		return(false);
+	}
+
+	// the cache stores rows bottom first, the same as the images
+	// loaded at runtime
+	stbi_set_flip_vertically_on_load(true);
+
+	for (const std::filesystem::directory_entry& entry : entries)
+	{
+		std::string extension = entry.path().extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+		if ((entry.is_regular_file(error) == false) || (extension != ".png"))
+		{
+			continue;
+		}
+
+		std::string sourceFile = entry.path().string();
+		std::string cacheFile = GetCachePath(sourceFile.c_str());
+		if ((bForce == false) && (IsCacheCurrent(sourceFile.c_str()) == true))
+		{
+			std::cout << "Texture cache is up to date:" << cacheFile << std::endl;
+			continue;
+		}
+
+		int width = 0;
+		int height = 0;
+		int colorChannels = 0;
+		unsigned char* image = stbi_load(sourceFile.c_str(), &width, &height, &colorChannels, 0);
+		if (NULL == image)
+		{
+			std::cout << "Could not load image:" << sourceFile << std::endl;
+			bSuccess = false;
+			continue;
+		}
+
+		COMPRESSED_TEXTURE texture;
+		bool bBuilt = Compress(image, width, height, colorChannels, texture) &&
+			WriteFile(cacheFile.c_str(), texture);
+		stbi_image_free(image);
+
+		if (bBuilt == false)
+		{
+			bSuccess = false;
+			continue;
+		}
+
+		std::cout << "Built texture cache:" << cacheFile << ", " << texture.levelSizes.size()
+			<< " levels, " << texture.data.size() << " bytes" << std::endl;
+		builtFiles++;
+	}
+
+	std::cout << builtFiles << " texture cache files built in " << directory << std::endl;
+
+	return(bSuccess);
+}
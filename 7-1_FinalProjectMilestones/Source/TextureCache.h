@@ -0,0 +1,71 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturecache.h
+// ============
+// GPU-compressed texture cache files - BC1/BC3 blocks with prebuilt mipmaps
+//
+//  Every source image can have a cache file next to it with the same name and
+//  a .ktx extension.  The cache file is a KTX 1.1 container holding the whole
+//  mipmap chain already compressed, BC1 for RGB images and BC3 for RGBA
+//  images, so loading it needs no image decoding and no mipmap generation.
+//  Rows are stored bottom row first, as OpenGL expects them.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  TextureCache
+ *
+ *  This class contains the code for building, writing and
+ *  reading the compressed texture cache files, and for
+ *  creating OpenGL textures from them.
+ ***********************************************************/
+class TextureCache
+{
+public:
+	// a compressed mipmap chain kept in memory
+	struct COMPRESSED_TEXTURE
+	{
+		GLenum internalFormat;
+		GLenum baseFormat;
+		int width;
+		int height;
+		// every mipmap level back to back, largest first
+		std::vector<unsigned char> data;
+		std::vector<size_t> levelOffsets;
+		std::vector<size_t> levelSizes;
+	};
+
+	// get the cache file name used for a source image file
+	static std::string GetCachePath(const char* sourceFile);
+	// true when the cache file exists and is newer than the source
+	static bool IsCacheCurrent(const char* sourceFile);
+	// true when the GL driver can sample the cached formats
+	static bool IsSupported();
+
+	// compress decoded RGB or RGBA pixels into a mipmap chain
+	static bool Compress(
+		const unsigned char* pixels,
+		int width,
+		int height,
+		int colorChannels,
+		COMPRESSED_TEXTURE& texture);
+	// write and read the KTX cache files
+	static bool WriteFile(const char* cacheFile, const COMPRESSED_TEXTURE& texture);
+	static bool ReadFile(const char* cacheFile, COMPRESSED_TEXTURE& texture);
+
+	// create an OpenGL texture from the compressed levels - when
+	// pixelBase is NULL the levels are read from the bound pixel
+	// unpack buffer, at the offsets where they are in memory
+	static GLuint CreateGLTexture(
+		const COMPRESSED_TEXTURE& texture,
+		const unsigned char* pixelBase);
+
+	// build the cache files of every PNG image in a directory
+	static bool BuildDirectory(const char* directory, bool bForce);
+};
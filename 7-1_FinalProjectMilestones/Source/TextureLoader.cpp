@@ -0,0 +1,407 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureloader.cpp
+// ============
+// decode texture images on worker threads and upload them on the GL thread
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureLoader.h"
+
+// the implementation of the image library is compiled in SceneManager.cpp
+#include "stb_image.h"
+
+#include "TextureStorage.h"
+
+#include <cstring>
+#include <iostream>
+
+/***********************************************************
+ *  TextureLoader()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureLoader::TextureLoader()
+{
+	m_pendingTextures = 0;
+	m_bStopping = false;
+	m_placeholderID = 0;
+	m_uploadBuffer = 0;
+}
+
+/***********************************************************
+ *  ~TextureLoader()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureLoader::~TextureLoader()
+{
+	Shutdown();
+}
+
+/***********************************************************
+ *  StartWorkers()
+ *
+ *  This method is used for starting one decode worker per
+ *  spare hardware thread, leaving one for the render thread.
+ ***********************************************************/
+void TextureLoader::StartWorkers()
+{
+	unsigned int workerCount = std::thread::hardware_concurrency();
+	if (workerCount > 1)
+	{
+		workerCount--;
+	}
+	else
+	{
+		workerCount = 1;
+	}
+
+	// the vertical flip setting is global to the image library, so
+	// it is set once here before any worker can read it
+	stbi_set_flip_vertically_on_load(true);
+
+	m_bStopping = false;
+	for (unsigned int i = 0; i < workerCount; i++)
+	{
+		m_workers.emplace_back(&TextureLoader::WorkerMain, this);
+	}
+}
+
+/***********************************************************
+ *  WorkerMain()
+ *
+ *  This method is used as the loop of every worker thread.
+ *  Each queued image file is decoded into memory and handed
+ *  over to the render thread for the upload.
+ ***********************************************************/
+void TextureLoader::WorkerMain()
+{
+	while (true)
+	{
+		DECODE_JOB job;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_jobQueued.wait(lock, [this] { return(m_bStopping || !m_jobs.empty()); });
+			if (m_bStopping == true)
+			{
+				return;
+			}
+			job = m_jobs.front();
+			m_jobs.pop_front();
+		}
+
+		DECODED_IMAGE image;
+		image.filename = job.filename;
+		image.textureSlot = job.textureSlot;
+		image.pixels = NULL;
+		image.width = 0;
+		image.height = 0;
+		image.colorChannels = 0;
+		image.bCompressed = false;
+
+		if ((job.bUseCache == true) &&
+			(TextureCache::IsCacheCurrent(job.filename.c_str()) == true))
+		{
+			std::string cacheFile = TextureCache::GetCachePath(job.filename.c_str());
+			image.bCompressed = TextureCache::ReadFile(cacheFile.c_str(), image.compressed);
+		}
+
+		if (image.bCompressed == true)
+		{
+			image.width = image.compressed.width;
+			image.height = image.compressed.height;
+		}
+		else
+		{
+			image.pixels = stbi_load(
+				job.filename.c_str(),
+				&image.width,
+				&image.height,
+				&image.colorChannels,
+				0);
+		}
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_decoded.push_back(std::move(image));
+	}
+}
+
+/***********************************************************
+ *  GetPlaceholderID()
+ *
+ *  This method is used for getting the texture shown in a
+ *  slot until its image is uploaded - a single grey texel.
+ ***********************************************************/
+GLuint TextureLoader::GetPlaceholderID()
+{
+	if (m_placeholderID == 0)
+	{
+		const unsigned char greyTexel[4] = { 128, 128, 128, 255 };
+
+		glGenTextures(1, &m_placeholderID);
+		glBindTexture(GL_TEXTURE_2D, m_placeholderID);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, greyTexel);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+
+	return(m_placeholderID);
+}
+
+/***********************************************************
+ *  QueueTexture()
+ *
+ *  This method is used for queueing an image file to be
+ *  decoded by the workers.  The workers are started with the
+ *  first queued image.
+ ***********************************************************/
+void TextureLoader::QueueTexture(const char* filename, int textureSlot)
+{
+	if (m_workers.empty())
+	{
+		StartWorkers();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		DECODE_JOB job;
+		job.filename = filename;
+		job.textureSlot = textureSlot;
+		job.bUseCache = TextureCache::IsSupported();
+		m_jobs.push_back(job);
+		m_pendingTextures++;
+	}
+	m_jobQueued.notify_one();
+}
+
+/***********************************************************
+ *  IsIdle()
+ *
+ *  This method is used for checking whether every queued
+ *  image has been decoded and uploaded.
+ ***********************************************************/
+bool TextureLoader::IsIdle()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return(m_pendingTextures == 0);
+}
+
+/***********************************************************
+ *  UploadDecodedTextures()
+ *
+ *  This method is used for turning decoded images into
+ *  OpenGL textures.  Only a few images are uploaded per call
+ *  so a large batch of finished decodes does not stall the
+ *  frame.  Images that failed to decode are reported and
+ *  their slots keep showing the placeholder.
+ ***********************************************************/
+int TextureLoader::UploadDecodedTextures(std::vector<LOADED_TEXTURE>& loaded, int maxUploads)
+{
+	int uploaded = 0;
+
+	while (uploaded < maxUploads)
+	{
+		DECODED_IMAGE image;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_decoded.empty())
+			{
+				break;
+			}
+			image = std::move(m_decoded.front());
+			m_decoded.pop_front();
+			m_pendingTextures--;
+		}
+
+		if ((image.pixels == NULL) && (image.bCompressed == false))
+		{
+			std::cout << "Could not load image:" << image.filename << std::endl;
+			continue;
+		}
+
+		GLuint textureID = UploadImage(image);
+		if (image.pixels != NULL)
+		{
+			stbi_image_free(image.pixels);
+		}
+
+		if (textureID != 0)
+		{
+			if (image.bCompressed == true)
+			{
+				std::cout << "Successfully loaded cached texture:" << TextureCache::GetCachePath(image.filename.c_str()) << ", width:" << image.width << ", height:" << image.height << std::endl;
+			}
+			else
+			{
+				std::cout << "Successfully loaded image:" << image.filename << ", width:" << image.width << ", height:" << image.height << ", channels:" << image.colorChannels << std::endl;
+			}
+
+			LOADED_TEXTURE texture;
+			texture.textureSlot = image.textureSlot;
+			texture.textureID = textureID;
+			loaded.push_back(texture);
+			uploaded++;
+		}
+	}
+
+	return(uploaded);
+}
+
+/***********************************************************
+ *  UploadImage()
+ *
+ *  This method is used for creating an OpenGL texture from
+ *  a decoded image.  The pixels are copied into a pixel
+ *  unpack buffer and the texture is filled from the buffer,
+ *  so the driver can transfer them without blocking on the
+ *  client memory.
+ ***********************************************************/
+GLuint TextureLoader::UploadImage(const DECODED_IMAGE& image)
+{
+	GLenum internalFormat = GL_RGB8;
+	GLenum pixelFormat = GL_RGB;
+	GLuint textureID = 0;
+
+	if (m_uploadBuffer == 0)
+	{
+		glGenBuffers(1, &m_uploadBuffer);
+	}
+
+	// the compressed levels are uploaded as they are, the same way
+	if (image.bCompressed == true)
+	{
+		const TextureCache::COMPRESSED_TEXTURE& compressed = image.compressed;
+		GLsizeiptr dataSize = (GLsizeiptr)compressed.data.size();
+		const unsigned char* pixelBase = compressed.data.data();
+
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_uploadBuffer);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, dataSize, NULL, GL_STREAM_DRAW);
+		void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, dataSize,
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+		if (mapped != NULL)
+		{
+			memcpy(mapped, pixelBase, (size_t)dataSize);
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+			pixelBase = NULL;
+		}
+		else
+		{
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		}
+
+		textureID = TextureCache::CreateGLTexture(compressed, pixelBase);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		return(textureID);
+	}
+
+	// if the loaded image is in RGB format
+	if (image.colorChannels == 3)
+	{
+		internalFormat = GL_RGB8;
+		pixelFormat = GL_RGB;
+	}
+	// if the loaded image is in RGBA format - it supports transparency
+	else if (image.colorChannels == 4)
+	{
+		internalFormat = GL_RGBA8;
+		pixelFormat = GL_RGBA;
+	}
+	else
+	{
+		std::cout << "Not implemented to handle image with " << image.colorChannels << " channels" << std::endl;
+		return(0);
+	}
+
+	GLsizeiptr imageSize = (GLsizeiptr)image.width * image.height * image.colorChannels;
+	const void* pixelSource = image.pixels;
+
+	// orphan the previous upload and copy the pixels into new storage
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_uploadBuffer);
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, imageSize, NULL, GL_STREAM_DRAW);
+	void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, imageSize,
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	if (mapped != NULL)
+	{
+		memcpy(mapped, image.pixels, (size_t)imageSize);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		// with a bound unpack buffer the pixel pointer is an offset
+		pixelSource = NULL;
+	}
+	else
+	{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+
+	// allocate immutable storage for the whole mipmap chain
+	textureID = TextureStorage::CreateTexture2D(internalFormat, image.width, image.height,
+		TextureStorage::GetMipLevelCount(image.width, image.height));
+
+	// set the texture wrapping parameters
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	// set texture filtering parameters - minified textures blend
+	// between the generated mipmap levels
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	// rows of RGB images are not always four byte aligned
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image.width, image.height,
+		pixelFormat, GL_UNSIGNED_BYTE, pixelSource);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	// generate the texture mipmaps for mapping textures to lower resolutions
+	glGenerateMipmap(GL_TEXTURE_2D);
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	return(textureID);
+}
+
+/***********************************************************
+ *  Shutdown()
+ *
+ *  This method is used for stopping the workers, freeing
+ *  any decoded images that were never uploaded and deleting
+ *  the GL objects of the loader.
+ ***********************************************************/
+void TextureLoader::Shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_bStopping = true;
+	}
+	m_jobQueued.notify_all();
+
+	for (size_t i = 0; i < m_workers.size(); i++)
+	{
+		m_workers[i].join();
+	}
+	m_workers.clear();
+
+	while (!m_decoded.empty())
+	{
+		if (m_decoded.front().pixels != NULL)
+		{
+			stbi_image_free(m_decoded.front().pixels);
+		}
+		m_decoded.pop_front();
+	}
+	m_jobs.clear();
+	m_pendingTextures = 0;
+
+	if (m_uploadBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_uploadBuffer);
+		m_uploadBuffer = 0;
+	}
+	if (m_placeholderID != 0)
+	{
+		glDeleteTextures(1, &m_placeholderID);
+		m_placeholderID = 0;
+	}
+}
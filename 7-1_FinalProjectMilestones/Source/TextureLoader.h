@@ -0,0 +1,115 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureloader.h
+// ============
+// decode texture images on worker threads and upload them on the GL thread
+//
+//  Image files are decoded by a pool of worker threads while the application
+//  keeps rendering.  The decoded pixels are handed back to the render thread,
+//  which is the only thread allowed to touch OpenGL, and uploaded through a
+//  pixel unpack buffer a few textures per frame.  Images with a current
+//  compressed cache file are read from the cache instead of being decoded.
+//  Until a texture's upload finishes, its slot shows a shared placeholder
+//  texture.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include "TextureCache.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  TextureLoader
+ *
+ *  This class contains the worker pool that decodes texture
+ *  images and the render thread side that turns the decoded
+ *  images into OpenGL textures.
+ ***********************************************************/
+class TextureLoader
+{
+public:
+	// constructor
+	TextureLoader();
+	// destructor
+	~TextureLoader();
+
+	// a finished texture and the slot it was requested for
+	struct LOADED_TEXTURE
+	{
+		int textureSlot;
+		GLuint textureID;
+	};
+
+	// get the texture shown while a slot is loading - the first
+	// call creates it, so it must come from the GL thread
+	GLuint GetPlaceholderID();
+
+	// queue an image file to be decoded for a texture slot
+	void QueueTexture(const char* filename, int textureSlot);
+
+	// upload up to maxUploads decoded images as textures, must be
+	// called from the GL thread - returns the number of entries
+	// added to the loaded list
+	int UploadDecodedTextures(std::vector<LOADED_TEXTURE>& loaded, int maxUploads);
+
+	// true when every queued image has been uploaded
+	bool IsIdle();
+
+	// stop the workers and release the GL objects of the loader
+	void Shutdown();
+
+private:
+	// an image file waiting to be decoded
+	struct DECODE_JOB
+	{
+		std::string filename;
+		int textureSlot;
+		// read the compressed cache file when it is current
+		bool bUseCache;
+	};
+
+	// a decoded image waiting to be uploaded
+	struct DECODED_IMAGE
+	{
+		std::string filename;
+		int textureSlot;
+		unsigned char* pixels;
+		int width;
+		int height;
+		int colorChannels;
+		// set when the compressed cache file was read instead
+		bool bCompressed;
+		TextureCache::COMPRESSED_TEXTURE compressed;
+	};
+
+	// the decode workers
+	std::vector<std::thread> m_workers;
+	// guards the job and decoded lists and the counters below
+	std::mutex m_mutex;
+	// signalled when a job is queued or the workers must stop
+	std::condition_variable m_jobQueued;
+	std::deque<DECODE_JOB> m_jobs;
+	std::deque<DECODED_IMAGE> m_decoded;
+	// queued images that have not been uploaded yet
+	int m_pendingTextures;
+	// set when the workers must exit
+	bool m_bStopping;
+
+	// the placeholder texture and the pixel upload buffer
+	GLuint m_placeholderID;
+	GLuint m_uploadBuffer;
+
+	// start the worker threads
+	void StartWorkers();
+	// the decode loop run by every worker thread
+	void WorkerMain();
+	// create an OpenGL texture from a decoded image
+	GLuint UploadImage(const DECODED_IMAGE& image);
+};
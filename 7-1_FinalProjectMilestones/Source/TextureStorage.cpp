@@ -0,0 +1,285 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturestorage.cpp
+// ============
+// immutable texture storage and texture arrays of same-size textures
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureStorage.h"
+
+#include <algorithm>
+#include <iostream>
+
+/***********************************************************
+ *  TextureStorage()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureStorage::TextureStorage()
+{
+}
+
+/***********************************************************
+ *  ~TextureStorage()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureStorage::~TextureStorage()
+{
+	DestroyArrays();
+}
+
+/***********************************************************
+ *  GetMipLevelCount()
+ *
+ *  This method is used for getting the number of levels of
+ *  a full mipmap chain.
+ ***********************************************************/
+int TextureStorage::GetMipLevelCount(int width, int height)
+{
+	int levels = 1;
+	int size = std::max(width, height);
+
+	while (size > 1)
+	{
+		size /= 2;
+		levels++;
+	}
+
+	return(levels);
+}
+
+/***********************************************************
+ *  CreateTexture2D()
+ *
+ *  This method is used for creating a 2D texture and its
+ *  storage.  The texture is left bound to GL_TEXTURE_2D so
+ *  the caller can fill the levels with glTex(Sub)Image2D.
+ *  Without immutable storage, every level is allocated with
+ *  glTexImage2D instead.
+ ***********************************************************/
+GLuint TextureStorage::CreateTexture2D(
+	GLenum internalFormat,
+	int width,
+	int height,
+	int levels)
+{
+	GLuint textureID = 0;
+
+	glGenTextures(1, &textureID);
+	glBindTexture(GL_TEXTURE_2D, textureID);
+
+	if (GLEW_VERSION_4_2 || GLEW_ARB_texture_storage)
+	{
+		glTexStorage2D(GL_TEXTURE_2D, levels, internalFormat, width, height);
+	}
+	else
+	{
+		// the pixel format of an empty level does not matter for
+		// uncompressed formats, so any matching one is passed
+		GLenum pixelFormat = ((internalFormat == GL_RGBA8) ||
+			(internalFormat == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT)) ? GL_RGBA : GL_RGB;
+		for (int level = 0; level < levels; level++)
+		{
+			glTexImage2D(GL_TEXTURE_2D, level, internalFormat,
+				std::max(1, width >> level), std::max(1, height >> level), 0,
+				pixelFormat, GL_UNSIGNED_BYTE, NULL);
+		}
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+	}
+
+	return(textureID);
+}
+
+/***********************************************************
+ *  IsArraySupported()
+ *
+ *  This method is used for checking whether the driver can
+ *  copy immutable textures into texture array layers.
+ ***********************************************************/
+bool TextureStorage::IsArraySupported()
+{
+	return(((GLEW_VERSION_4_3) || (GLEW_ARB_copy_image && GLEW_ARB_texture_storage)) ? true : false);
+}
+
+/***********************************************************
+ *  BuildArrays()
+ *
+ *  This method is used for grouping the passed in textures
+ *  by size, format and mipmap level count, and copying each
+ *  group into the layers of one texture array on the GPU.
+ *  The index of a texture in the list is its texture slot.
+ ***********************************************************/
+bool TextureStorage::BuildArrays(const std::vector<GLuint>& textureIDs)
+{
+	DestroyArrays();
+
+	if ((IsArraySupported() == false) || (textureIDs.empty()))
+	{
+		return(false);
+	}
+
+	m_slotArrays.assign(textureIDs.size(), -1);
+	m_slotLayers.assign(textureIDs.size(), -1);
+
+	// find the array of every texture from its storage
+	for (size_t slot = 0; slot < textureIDs.size(); slot++)
+	{
+		GLint immutable = GL_FALSE;
+		GLint levels = 0;
+		GLint internalFormat = 0;
+		GLint width = 0;
+		GLint height = 0;
+
+		glBindTexture(GL_TEXTURE_2D, textureIDs[slot]);
+		glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_IMMUTABLE_FORMAT, &immutable);
+		glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_IMMUTABLE_LEVELS, &levels);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &internalFormat);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+
+		// only immutable textures have a fixed level count to copy
+		if (immutable == GL_FALSE)
+		{
+			glBindTexture(GL_TEXTURE_2D, 0);
+			m_slotArrays.clear();
+			m_slotLayers.clear();
+			return(false);
+		}
+
+		int arrayIndex = -1;
+		for (size_t a = 0; a < m_arrays.size(); a++)
+		{
+			if ((m_arrays[a].internalFormat == (GLenum)internalFormat) &&
+				(m_arrays[a].width == width) &&
+				(m_arrays[a].height == height) &&
+				(m_arrays[a].levels == levels))
+			{
+				arrayIndex = (int)a;
+				break;
+			}
+		}
+
+		if (arrayIndex < 0)
+		{
+			TEXTURE_ARRAY textureArray;
+			textureArray.ID = 0;
+			textureArray.internalFormat = (GLenum)internalFormat;
+			textureArray.width = width;
+			textureArray.height = height;
+			textureArray.levels = levels;
+			textureArray.layers = 0;
+			m_arrays.push_back(textureArray);
+			arrayIndex = (int)m_arrays.size() - 1;
+		}
+
+		m_slotArrays[slot] = arrayIndex;
+		m_slotLayers[slot] = m_arrays[arrayIndex].layers;
+		m_arrays[arrayIndex].layers++;
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	// allocate the arrays and copy every level of every texture
+	for (size_t a = 0; a < m_arrays.size(); a++)
+	{
+		TEXTURE_ARRAY& textureArray = m_arrays[a];
+
+		glGenTextures(1, &textureArray.ID);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, textureArray.ID);
+		glTexStorage3D(GL_TEXTURE_2D_ARRAY, textureArray.levels, textureArray.internalFormat,
+			textureArray.width, textureArray.height, textureArray.layers);
+
+		// the same sampling as the single textures
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER,
+			(textureArray.levels > 1) ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	}
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	for (size_t slot = 0; slot < textureIDs.size(); slot++)
+	{
+		const TEXTURE_ARRAY& textureArray = m_arrays[m_slotArrays[slot]];
+
+		for (int level = 0; level < textureArray.levels; level++)
+		{
+			glCopyImageSubData(
+				textureIDs[slot], GL_TEXTURE_2D, level, 0, 0, 0,
+				textureArray.ID, GL_TEXTURE_2D_ARRAY, level, 0, 0, m_slotLayers[slot],
+				std::max(1, textureArray.width >> level),
+				std::max(1, textureArray.height >> level),
+				1);
+		}
+	}
+
+	std::cout << textureIDs.size() << " textures placed in " << m_arrays.size() << " texture arrays" << std::endl;
+
+	return(true);
+}
+
+/***********************************************************
+ *  DestroyArrays()
+ *
+ *  This method is used for deleting the texture arrays.
+ ***********************************************************/
+void TextureStorage::DestroyArrays()
+{
+	for (size_t a = 0; a < m_arrays.size(); a++)
+	{
+		if (m_arrays[a].ID != 0)
+		{
+			glDeleteTextures(1, &m_arrays[a].ID);
+		}
+	}
+	m_arrays.clear();
+	m_slotArrays.clear();
+	m_slotLayers.clear();
+}
+
+/***********************************************************
+ *  GetArrayIndex()
+ *
+ *  This method is used for getting the texture array that
+ *  holds a texture slot, or -1 when it is in none.
+ ***********************************************************/
+int TextureStorage::GetArrayIndex(int textureSlot) const
+{
+	if ((textureSlot < 0) || (textureSlot >= (int)m_slotArrays.size()))
+	{
+		return(-1);
+	}
+
+	return(m_slotArrays[textureSlot]);
+}
+
+/***********************************************************
+ *  GetLayer()
+ *
+ *  This method is used for getting the layer that holds a
+ *  texture slot within its texture array.
+ ***********************************************************/
+int TextureStorage::GetLayer(int textureSlot) const
+{
+	if ((textureSlot < 0) || (textureSlot >= (int)m_slotLayers.size()))
+	{
+		return(0);
+	}
+
+	return(m_slotLayers[textureSlot]);
+}
+
+/***********************************************************
+ *  GetArrayID()
+ *
+ *  This method is used for getting the OpenGL texture of a
+ *  texture array.
+ ***********************************************************/
+GLuint TextureStorage::GetArrayID(int arrayIndex) const
+{
+	if ((arrayIndex < 0) || (arrayIndex >= (int)m_arrays.size()))
+	{
+		return(0);
+	}
+
+	return(m_arrays[arrayIndex].ID);
+}
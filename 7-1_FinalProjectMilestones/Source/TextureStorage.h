@@ -0,0 +1,75 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturestorage.h
+// ============
+// immutable texture storage and texture arrays of same-size textures
+//
+//  Textures are allocated with glTexStorage2D when the driver supports it, so
+//  their size, format and mipmap levels are fixed.  Loaded textures that share
+//  a size, format and level count are then copied into the layers of one
+//  GL_TEXTURE_2D_ARRAY, and the shaders pick a layer per draw or per instance
+//  instead of switching the bound texture.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <vector>
+
+/***********************************************************
+ *  TextureStorage
+ *
+ *  This class contains the helpers for allocating immutable
+ *  textures, and the texture arrays built from the loaded
+ *  textures of the scene.
+ ***********************************************************/
+class TextureStorage
+{
+public:
+	// constructor
+	TextureStorage();
+	// destructor
+	~TextureStorage();
+
+	// the number of mipmap levels down to 1x1
+	static int GetMipLevelCount(int width, int height);
+	// create a bound 2D texture with storage for every level
+	static GLuint CreateTexture2D(
+		GLenum internalFormat,
+		int width,
+		int height,
+		int levels);
+
+	// true when texture arrays can be built from loaded textures
+	static bool IsArraySupported();
+
+	// copy the passed in textures into texture arrays - returns
+	// false when a texture cannot be placed in any array
+	bool BuildArrays(const std::vector<GLuint>& textureIDs);
+	// delete the texture arrays
+	void DestroyArrays();
+
+	// the texture array and layer that hold a texture slot
+	int GetArrayIndex(int textureSlot) const;
+	int GetLayer(int textureSlot) const;
+	// the OpenGL texture of an array
+	GLuint GetArrayID(int arrayIndex) const;
+	int GetArrayCount() const { return((int)m_arrays.size()); }
+
+private:
+	// one texture array and the shape of its layers
+	struct TEXTURE_ARRAY
+	{
+		GLuint ID;
+		GLenum internalFormat;
+		int width;
+		int height;
+		int levels;
+		int layers;
+	};
+
+	std::vector<TEXTURE_ARRAY> m_arrays;
+	// the array and layer of every texture slot
+	std::vector<int> m_slotArrays;
+	std::vector<int> m_slotLayers;
+};
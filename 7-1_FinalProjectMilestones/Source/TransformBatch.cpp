@@ -0,0 +1,522 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformbatch.cpp
+// ============
+// compute the model matrices of many objects at once from their scale,
+// rotation and position
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TransformBatch.h"
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+// the widest instruction set the compiler was allowed to use -
+// the AVX2 path needs /arch:AVX2 or -mavx2
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define TRANSFORM_SIMD_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define TRANSFORM_SIMD_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define TRANSFORM_SIMD_NEON
+#endif
+
+// declaration of global variables
+namespace
+{
+	const float g_DegreesToRadians = 3.14159265358979f / 180.0f;
+
+	// the quarter turns of an angle, and pi/2 split in three
+	// parts so the reduced angle keeps its precision
+	const float g_TwoOverPi = 0.636619772367581f;
+	const float g_HalfPiA = 1.5703125f;
+	const float g_HalfPiB = 4.837512969970703125e-4f;
+	const float g_HalfPiC = 7.54978995489188216e-8f;
+	// minimax polynomials of sin and cos on [-pi/4, pi/4]
+	const float g_Sin1 = -1.6666654611e-1f;
+	const float g_Sin2 = 8.3321608736e-3f;
+	const float g_Sin3 = -1.9515295891e-4f;
+	const float g_Cos1 = 4.166664568298827e-2f;
+	const float g_Cos2 = -1.388731625493765e-3f;
+	const float g_Cos3 = 2.443315711809948e-5f;
+
+#if defined(TRANSFORM_SIMD_AVX2)
+	const int g_Lanes = 8;
+	typedef __m256 VFLOAT;
+	typedef __m256i VINT;
+
+	inline VFLOAT VLoad(const float* values) { return(_mm256_loadu_ps(values)); }
+	inline void VStore(float* values, VFLOAT v) { _mm256_storeu_ps(values, v); }
+	inline VFLOAT VSet(float value) { return(_mm256_set1_ps(value)); }
+	inline VFLOAT VAdd(VFLOAT a, VFLOAT b) { return(_mm256_add_ps(a, b)); }
+	inline VFLOAT VSub(VFLOAT a, VFLOAT b) { return(_mm256_sub_ps(a, b)); }
+	inline VFLOAT VMul(VFLOAT a, VFLOAT b) { return(_mm256_mul_ps(a, b)); }
+	inline VFLOAT VDiv(VFLOAT a, VFLOAT b) { return(_mm256_div_ps(a, b)); }
+	inline VFLOAT VNegate(VFLOAT v) { return(_mm256_xor_ps(v, _mm256_set1_ps(-0.0f))); }
+	inline VINT VRoundToInt(VFLOAT v) { return(_mm256_cvtps_epi32(v)); }
+	inline VFLOAT VToFloat(VINT v) { return(_mm256_cvtepi32_ps(v)); }
+	inline VINT VAddInt(VINT v, int value) { return(_mm256_add_epi32(v, _mm256_set1_epi32(value))); }
+	// all bits set in the lanes where the bit of v is set
+	inline VFLOAT VBitMask(VINT v, int bit)
+	{
+		VINT bits = _mm256_set1_epi32(bit);
+		return(_mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(v, bits), bits)));
+	}
+	// a in the lanes of the mask, b in the others
+	inline VFLOAT VSelect(VFLOAT mask, VFLOAT a, VFLOAT b) { return(_mm256_blendv_ps(b, a, mask)); }
+#elif defined(TRANSFORM_SIMD_SSE2)
+	const int g_Lanes = 4;
+	typedef __m128 VFLOAT;
+	typedef __m128i VINT;
+
+	inline VFLOAT VLoad(const float* values) { return(_mm_loadu_ps(values)); }
+	inline void VStore(float* values, VFLOAT v) { _mm_storeu_ps(values, v); }
+	inline VFLOAT VSet(float value) { return(_mm_set1_ps(value)); }
+	inline VFLOAT VAdd(VFLOAT a, VFLOAT b) { return(_mm_add_ps(a, b)); }
+	inline VFLOAT VSub(VFLOAT a, VFLOAT b) { return(_mm_sub_ps(a, b)); }
+	inline VFLOAT VMul(VFLOAT a, VFLOAT b) { return(_mm_mul_ps(a, b)); }
+	inline VFLOAT VDiv(VFLOAT a, VFLOAT b) { return(_mm_div_ps(a, b)); }
+	inline VFLOAT VNegate(VFLOAT v) { return(_mm_xor_ps(v, _mm_set1_ps(-0.0f))); }
+	inline VINT VRoundToInt(VFLOAT v) { return(_mm_cvtps_epi32(v)); }
+	inline VFLOAT VToFloat(VINT v) { return(_mm_cvtepi32_ps(v)); }
+	inline VINT VAddInt(VINT v, int value) { return(_mm_add_epi32(v, _mm_set1_epi32(value))); }
+	inline VFLOAT VBitMask(VINT v, int bit)
+	{
+		VINT bits = _mm_set1_epi32(bit);
+		return(_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(v, bits), bits)));
+	}
+	inline VFLOAT VSelect(VFLOAT mask, VFLOAT a, VFLOAT b) { return(_mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b))); }
+#elif defined(TRANSFORM_SIMD_NEON)
+	const int g_Lanes = 4;
+	typedef float32x4_t VFLOAT;
+	typedef int32x4_t VINT;
+
+	inline VFLOAT VLoad(const float* values) { return(vld1q_f32(values)); }
+	inline void VStore(float* values, VFLOAT v) { vst1q_f32(values, v); }
+	inline VFLOAT VSet(float value) { return(vdupq_n_f32(value)); }
+	inline VFLOAT VAdd(VFLOAT a, VFLOAT b) { return(vaddq_f32(a, b)); }
+	inline VFLOAT VSub(VFLOAT a, VFLOAT b) { return(vsubq_f32(a, b)); }
+	inline VFLOAT VMul(VFLOAT a, VFLOAT b) { return(vmulq_f32(a, b)); }
+	inline VFLOAT VDiv(VFLOAT a, VFLOAT b) { return(vdivq_f32(a, b)); }
+	inline VFLOAT VNegate(VFLOAT v) { return(vnegq_f32(v)); }
+	inline VINT VRoundToInt(VFLOAT v) { return(vcvtnq_s32_f32(v)); }
+	inline VFLOAT VToFloat(VINT v) { return(vcvtq_f32_s32(v)); }
+	inline VINT VAddInt(VINT v, int value) { return(vaddq_s32(v, vdupq_n_s32(value))); }
+	inline VFLOAT VBitMask(VINT v, int bit) { return(vreinterpretq_f32_u32(vtstq_s32(v, vdupq_n_s32(bit)))); }
+	inline VFLOAT VSelect(VFLOAT mask, VFLOAT a, VFLOAT b) { return(vbslq_f32(vreinterpretq_u32_f32(mask), a, b)); }
+#endif
+
+#if defined(TRANSFORM_SIMD_AVX2) || defined(TRANSFORM_SIMD_SSE2) || defined(TRANSFORM_SIMD_NEON)
+#define TRANSFORM_SIMD
+	// the sine and cosine of every lane - the angle is reduced by
+	// whole quarter turns, and the quarter turn picks and signs
+	// the polynomial results
+	void SinCos(VFLOAT angle, VFLOAT& sine, VFLOAT& cosine)
+	{
+		VINT quadrant = VRoundToInt(VMul(angle, VSet(g_TwoOverPi)));
+		VFLOAT turns = VToFloat(quadrant);
+
+		VFLOAT r = VSub(angle, VMul(turns, VSet(g_HalfPiA)));
+		r = VSub(r, VMul(turns, VSet(g_HalfPiB)));
+		r = VSub(r, VMul(turns, VSet(g_HalfPiC)));
+		VFLOAT r2 = VMul(r, r);
+
+		VFLOAT sinR = VAdd(r, VMul(VMul(r, r2),
+			VAdd(VSet(g_Sin1), VMul(r2, VAdd(VSet(g_Sin2), VMul(r2, VSet(g_Sin3)))))));
+		VFLOAT cosR = VAdd(VSub(VSet(1.0f), VMul(VSet(0.5f), r2)), VMul(VMul(r2, r2),
+			VAdd(VSet(g_Cos1), VMul(r2, VAdd(VSet(g_Cos2), VMul(r2, VSet(g_Cos3)))))));
+
+		// odd quarter turns swap the sine and the cosine
+		VFLOAT swap = VBitMask(quadrant, 1);
+		VFLOAT sinV = VSelect(swap, cosR, sinR);
+		VFLOAT cosV = VSelect(swap, sinR, cosR);
+
+		sine = VSelect(VBitMask(quadrant, 2), VNegate(sinV), sinV);
+		cosine = VSelect(VBitMask(VAddInt(quadrant, 1), 2), VNegate(cosV), cosV);
+	}
+#endif
+
+	// the model matrix built from five matrices, the way
+	// SceneManager used to build it
+	glm::mat4 MultiplyModelMatrix(glm::vec3 scaleXYZ, glm::vec3 rotationDegrees, glm::vec3 positionXYZ)
+	{
+		glm::mat4 scale = glm::scale(scaleXYZ);
+		glm::mat4 rotationX = glm::rotate(glm::radians(rotationDegrees.x), glm::vec3(1.0f, 0.0f, 0.0f));
+		glm::mat4 rotationY = glm::rotate(glm::radians(rotationDegrees.y), glm::vec3(0.0f, 1.0f, 0.0f));
+		glm::mat4 rotationZ = glm::rotate(glm::radians(rotationDegrees.z), glm::vec3(0.0f, 0.0f, 1.0f));
+		glm::mat4 translation = glm::translate(positionXYZ);
+
+		return(translation * rotationZ * rotationY * rotationX * scale);
+	}
+
+	// the largest difference between two lists of matrices
+	float MaxDifference(const std::vector<glm::mat4>& a, const std::vector<glm::mat4>& b)
+	{
+		float difference = 0.0f;
+		for (size_t m = 0; m < a.size(); m++)
+		{
+			for (int c = 0; c < 4; c++)
+			{
+				for (int r = 0; r < 4; r++)
+				{
+					difference = std::max(difference, std::fabs(a[m][c][r] - b[m][c][r]));
+				}
+			}
+		}
+		return(difference);
+	}
+}
+
+/***********************************************************
+ *  GetInstructionSet()
+ *
+ *  This method is used for getting the name of the
+ *  instruction set the kernel was compiled for.
+ ***********************************************************/
+const char* TransformBatch::GetInstructionSet()
+{
+#if defined(TRANSFORM_SIMD_AVX2)
+	return("AVX2");
+#elif defined(TRANSFORM_SIMD_SSE2)
+	return("SSE2");
+#elif defined(TRANSFORM_SIMD_NEON)
+	return("NEON");
+#else
+	return("scalar");
+#endif
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing every object from the
+ *  batch.  The arrays keep their memory for the next batch.
+ ***********************************************************/
+void TransformBatch::Clear()
+{
+	m_scaleX.clear();
+	m_scaleY.clear();
+	m_scaleZ.clear();
+	m_rotationX.clear();
+	m_rotationY.clear();
+	m_rotationZ.clear();
+	m_positionX.clear();
+	m_positionY.clear();
+	m_positionZ.clear();
+}
+
+/***********************************************************
+ *  Add()
+ *
+ *  This method is used for appending the transformation
+ *  values of an object to the arrays of the batch.
+ ***********************************************************/
+void TransformBatch::Add(const glm::vec3& scaleXYZ, const glm::vec3& rotationDegrees, const glm::vec3& positionXYZ)
+{
+	m_scaleX.push_back(scaleXYZ.x);
+	m_scaleY.push_back(scaleXYZ.y);
+	m_scaleZ.push_back(scaleXYZ.z);
+	m_rotationX.push_back(rotationDegrees.x);
+	m_rotationY.push_back(rotationDegrees.y);
+	m_rotationZ.push_back(rotationDegrees.z);
+	m_positionX.push_back(positionXYZ.x);
+	m_positionY.push_back(positionXYZ.y);
+	m_positionZ.push_back(positionXYZ.z);
+}
+
+/***********************************************************
+ *  Compute()
+ *
+ *  This method is used for writing the matrices of a range
+ *  of objects in the batch.  Whole groups of lanes go
+ *  through the SIMD kernel and the remaining objects through
+ *  the scalar one.
+ *
+ *  With a = rotationX, b = rotationY and c = rotationZ, the
+ *  columns of Rz * Ry * Rx are
+ *    ( cos c cos b,  sin c cos b,  -sin b )
+ *    ( cos c sin b sin a - sin c cos a,
+ *      sin c sin b sin a + cos c cos a,  cos b sin a )
+ *    ( cos c sin b cos a + sin c sin a,
+ *      sin c sin b cos a - cos c sin a,  cos b cos a )
+ *  and the model matrix scales each of them.  The rotation
+ *  is orthonormal, so the normal matrix divides each column
+ *  by its scale instead.
+ ***********************************************************/
+void TransformBatch::Compute(int firstObject, int objectCount, glm::mat4* models, glm::mat3* normals) const
+{
+	int end = std::min(firstObject + objectCount, GetCount());
+	int first = std::max(firstObject, 0);
+
+#if defined(TRANSFORM_SIMD)
+	const VFLOAT toRadians = VSet(g_DegreesToRadians);
+	const VFLOAT one = VSet(1.0f);
+
+	for (; first + g_Lanes <= end; first += g_Lanes)
+	{
+		VFLOAT sinX, cosX, sinY, cosY, sinZ, cosZ;
+		SinCos(VMul(VLoad(&m_rotationX[first]), toRadians), sinX, cosX);
+		SinCos(VMul(VLoad(&m_rotationY[first]), toRadians), sinY, cosY);
+		SinCos(VMul(VLoad(&m_rotationZ[first]), toRadians), sinZ, cosZ);
+
+		VFLOAT cosZsinY = VMul(cosZ, sinY);
+		VFLOAT sinZsinY = VMul(sinZ, sinY);
+
+		VFLOAT rotation[9];
+		rotation[0] = VMul(cosZ, cosY);
+		rotation[1] = VMul(sinZ, cosY);
+		rotation[2] = VNegate(sinY);
+		rotation[3] = VSub(VMul(cosZsinY, sinX), VMul(sinZ, cosX));
+		rotation[4] = VAdd(VMul(sinZsinY, sinX), VMul(cosZ, cosX));
+		rotation[5] = VMul(cosY, sinX);
+		rotation[6] = VAdd(VMul(cosZsinY, cosX), VMul(sinZ, sinX));
+		rotation[7] = VSub(VMul(sinZsinY, cosX), VMul(cosZ, sinX));
+		rotation[8] = VMul(cosY, cosX);
+
+		VFLOAT scale[3];
+		scale[0] = VLoad(&m_scaleX[first]);
+		scale[1] = VLoad(&m_scaleY[first]);
+		scale[2] = VLoad(&m_scaleZ[first]);
+
+		// the nine values per lane, column by column
+		float columns[9][g_Lanes];
+		for (int v = 0; v < 9; v++)
+		{
+			VStore(columns[v], VMul(rotation[v], scale[v / 3]));
+		}
+
+		for (int lane = 0; lane < g_Lanes; lane++)
+		{
+			int i = first + lane;
+			glm::mat4& model = models[i];
+
+			model[0] = glm::vec4(columns[0][lane], columns[1][lane], columns[2][lane], 0.0f);
+			model[1] = glm::vec4(columns[3][lane], columns[4][lane], columns[5][lane], 0.0f);
+			model[2] = glm::vec4(columns[6][lane], columns[7][lane], columns[8][lane], 0.0f);
+			model[3] = glm::vec4(m_positionX[i], m_positionY[i], m_positionZ[i], 1.0f);
+		}
+
+		if (NULL == normals)
+		{
+			continue;
+		}
+
+		for (int v = 0; v < 9; v++)
+		{
+			VStore(columns[v], VMul(rotation[v], VDiv(one, scale[v / 3])));
+		}
+
+		for (int lane = 0; lane < g_Lanes; lane++)
+		{
+			glm::mat3& normal = normals[first + lane];
+
+			normal[0] = glm::vec3(columns[0][lane], columns[1][lane], columns[2][lane]);
+			normal[1] = glm::vec3(columns[3][lane], columns[4][lane], columns[5][lane]);
+			normal[2] = glm::vec3(columns[6][lane], columns[7][lane], columns[8][lane]);
+		}
+	}
+#endif
+
+	ComputeRange(first, end - first, models, normals);
+}
+
+/***********************************************************
+ *  Compute()
+ *
+ *  This method is used for writing the matrices of every
+ *  object in the batch.
+ ***********************************************************/
+void TransformBatch::Compute(glm::mat4* models, glm::mat3* normals) const
+{
+	Compute(0, GetCount(), models, normals);
+}
+
+/***********************************************************
+ *  ComputeScalar()
+ *
+ *  This method is used for writing the matrices of every
+ *  object without the SIMD kernel, for comparing the two.
+ ***********************************************************/
+void TransformBatch::ComputeScalar(glm::mat4* models, glm::mat3* normals) const
+{
+	ComputeRange(0, GetCount(), models, normals);
+}
+
+/***********************************************************
+ *  ComputeRange()
+ *
+ *  This method is used for writing the matrices of a range
+ *  of objects one at a time.
+ ***********************************************************/
+void TransformBatch::ComputeRange(int first, int count, glm::mat4* models, glm::mat3* normals) const
+{
+	for (int i = first; i < first + count; i++)
+	{
+		models[i] = ComposeMatrix(
+			glm::vec3(m_scaleX[i], m_scaleY[i], m_scaleZ[i]),
+			glm::vec3(m_rotationX[i], m_rotationY[i], m_rotationZ[i]),
+			glm::vec3(m_positionX[i], m_positionY[i], m_positionZ[i]),
+			(NULL != normals) ? &normals[i] : NULL);
+	}
+}
+
+/***********************************************************
+ *  ComposeMatrix()
+ *
+ *  This method is used for building the matrices of one
+ *  object with the same composed rotation as the SIMD
+ *  kernel.
+ ***********************************************************/
+glm::mat4 TransformBatch::ComposeMatrix(
+	const glm::vec3& scaleXYZ,
+	const glm::vec3& rotationDegrees,
+	const glm::vec3& positionXYZ,
+	glm::mat3* normal)
+{
+	float angleX = rotationDegrees.x * g_DegreesToRadians;
+	float angleY = rotationDegrees.y * g_DegreesToRadians;
+	float angleZ = rotationDegrees.z * g_DegreesToRadians;
+	float sinX = std::sin(angleX);
+	float cosX = std::cos(angleX);
+	float sinY = std::sin(angleY);
+	float cosY = std::cos(angleY);
+	float sinZ = std::sin(angleZ);
+	float cosZ = std::cos(angleZ);
+
+	glm::vec3 column0(cosZ * cosY, sinZ * cosY, -sinY);
+	glm::vec3 column1(
+		(cosZ * sinY * sinX) - (sinZ * cosX),
+		(sinZ * sinY * sinX) + (cosZ * cosX),
+		cosY * sinX);
+	glm::vec3 column2(
+		(cosZ * sinY * cosX) + (sinZ * sinX),
+		(sinZ * sinY * cosX) - (cosZ * sinX),
+		cosY * cosX);
+
+	glm::mat4 model;
+	model[0] = glm::vec4(column0 * scaleXYZ.x, 0.0f);
+	model[1] = glm::vec4(column1 * scaleXYZ.y, 0.0f);
+	model[2] = glm::vec4(column2 * scaleXYZ.z, 0.0f);
+	model[3] = glm::vec4(positionXYZ, 1.0f);
+
+	if (NULL != normal)
+	{
+		(*normal)[0] = column0 / scaleXYZ.x;
+		(*normal)[1] = column1 / scaleXYZ.y;
+		(*normal)[2] = column2 / scaleXYZ.z;
+	}
+
+	return(model);
+}
+
+/***********************************************************
+ *  RunBenchmark()
+ *
+ *  This method is used for timing the kernel, the scalar
+ *  composed path and the five matrix product on the same
+ *  pseudo random transformations, and for checking that all
+ *  of them build the same matrices.
+ ***********************************************************/
+bool TransformBatch::RunBenchmark(int objectCount, int iterations)
+{
+	typedef std::chrono::steady_clock CLOCK;
+
+	objectCount = std::max(objectCount, 1);
+	iterations = std::max(iterations, 1);
+
+	// a fixed linear congruential sequence, so every run times
+	// the same values
+	uint32_t seed = 12345u;
+	auto random = [&seed](float low, float high)
+	{
+		seed = (seed * 1664525u) + 1013904223u;
+		return(low + ((high - low) * (float)(seed >> 8) / 16777216.0f));
+	};
+
+	std::vector<glm::vec3> scales(objectCount);
+	std::vector<glm::vec3> rotations(objectCount);
+	std::vector<glm::vec3> positions(objectCount);
+	TransformBatch batch;
+	for (int i = 0; i < objectCount; i++)
+	{
+		scales[i] = glm::vec3(random(0.1f, 4.0f), random(0.1f, 4.0f), random(0.1f, 4.0f));
+		rotations[i] = glm::vec3(random(-360.0f, 360.0f), random(-360.0f, 360.0f), random(-360.0f, 360.0f));
+		positions[i] = glm::vec3(random(-50.0f, 50.0f), random(-10.0f, 10.0f), random(-50.0f, 50.0f));
+		batch.Add(scales[i], rotations[i], positions[i]);
+	}
+
+	std::vector<glm::mat4> reference(objectCount);
+	std::vector<glm::mat4> scalar(objectCount);
+	std::vector<glm::mat4> kernel(objectCount);
+	std::vector<glm::mat3> normals(objectCount);
+	// read back from every run, so no run is optimized away
+	float checksum = 0.0f;
+
+	CLOCK::time_point start = CLOCK::now();
+	for (int n = 0; n < iterations; n++)
+	{
+		for (int i = 0; i < objectCount; i++)
+		{
+			reference[i] = MultiplyModelMatrix(scales[i], rotations[i], positions[i]);
+		}
+		checksum += reference[n % objectCount][0][0];
+	}
+	CLOCK::time_point referenceEnd = CLOCK::now();
+	for (int n = 0; n < iterations; n++)
+	{
+		batch.ComputeScalar(scalar.data(), NULL);
+		checksum += scalar[n % objectCount][0][0];
+	}
+	CLOCK::time_point scalarEnd = CLOCK::now();
+	for (int n = 0; n < iterations; n++)
+	{
+		batch.Compute(kernel.data(), NULL);
+		checksum += kernel[n % objectCount][0][0];
+	}
+	CLOCK::time_point kernelEnd = CLOCK::now();
+	for (int n = 0; n < iterations; n++)
+	{
+		batch.Compute(kernel.data(), normals.data());
+		checksum += normals[n % objectCount][0][0];
+	}
+	CLOCK::time_point normalsEnd = CLOCK::now();
+
+	double perObject = 1.0e9 / ((double)objectCount * iterations);
+	double referenceTime = std::chrono::duration<double>(referenceEnd - start).count() * perObject;
+	double scalarTime = std::chrono::duration<double>(scalarEnd - referenceEnd).count() * perObject;
+	double kernelTime = std::chrono::duration<double>(kernelEnd - scalarEnd).count() * perObject;
+	double normalsTime = std::chrono::duration<double>(normalsEnd - kernelEnd).count() * perObject;
+
+	float scalarError = MaxDifference(reference, scalar);
+	float kernelError = MaxDifference(reference, kernel);
+
+	std::cout << "Transform benchmark, " << objectCount << " objects x " << iterations << " iterations" << std::endl;
+	std::cout << "  five matrix product:  " << referenceTime << " ns per object" << std::endl;
+	std::cout << "  composed scalar:      " << scalarTime << " ns per object, "
+		<< (referenceTime / scalarTime) << "x, max error " << scalarError << std::endl;
+	std::string kernelLabel = std::string("composed ") + GetInstructionSet() + ":";
+	kernelLabel.resize(22, ' ');
+	std::cout << "  " << kernelLabel << kernelTime << " ns per object, " << (referenceTime / kernelTime) << "x, max error " << kernelError << std::endl;
+	std::cout << "  with normal matrices: " << normalsTime << " ns per object" << std::endl;
+	std::cout << "  checksum " << checksum << std::endl;
+
+	// the matrices hold values up to the largest position, so
+	// the tolerance is relative to it
+	const float tolerance = 1.0e-4f * 50.0f;
+	if ((scalarError > tolerance) || (kernelError > tolerance))
+	{
+		std::cout << "The composed matrices do not match the five matrix product" << std::endl;
+		return(false);
+	}
+
+	return(true);
+}
@@ -0,0 +1,78 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformbatch.h
+// ============
+// compute the model matrices of many objects at once from their scale,
+// rotation and position
+//
+//  The matrix of an object is translation * rotationZ * rotationY *
+//  rotationX * scale, the order SceneManager has always used.  Instead of
+//  five matrices and four full 4x4 products, the nine values of the
+//  composed rotation are written out directly from the sines and cosines of
+//  the three angles and scaled per column.  The input is kept as separate
+//  arrays per value, so the kernel works on 8 objects at a time with AVX2 or
+//  4 at a time with SSE2 or NEON, and on one object at a time otherwise.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  TransformBatch
+ *
+ *  This class contains the structure-of-arrays transform
+ *  input of a batch of objects and the kernel that turns it
+ *  into model matrices.
+ ***********************************************************/
+class TransformBatch
+{
+public:
+	// the instruction set the kernel was compiled for
+	static const char* GetInstructionSet();
+
+	// the model matrix, and when normal is not NULL the normal
+	// matrix, of a single object
+	static glm::mat4 ComposeMatrix(
+		const glm::vec3& scaleXYZ,
+		const glm::vec3& rotationDegrees,
+		const glm::vec3& positionXYZ,
+		glm::mat3* normal);
+
+	// remove every object from the batch
+	void Clear();
+	// add the transformation values of an object to the batch
+	void Add(const glm::vec3& scaleXYZ, const glm::vec3& rotationDegrees, const glm::vec3& positionXYZ);
+	int GetCount() const { return((int)m_positionX.size()); }
+
+	// write the model matrix of every object, and when normals
+	// is not NULL, the normal matrix - the inverse transpose of
+	// the upper 3x3 - which needs scales that are not 0
+	void Compute(glm::mat4* models, glm::mat3* normals) const;
+	// the same for a range of the objects, so separate threads
+	// can compute separate ranges - the outputs are indexed by
+	// object, not by the start of the range
+	void Compute(int first, int count, glm::mat4* models, glm::mat3* normals) const;
+	// the same result, one object at a time without SIMD
+	void ComputeScalar(glm::mat4* models, glm::mat3* normals) const;
+
+	// time the kernel against building and multiplying the five
+	// matrices and print the results - returns false when the
+	// results do not match
+	static bool RunBenchmark(int objectCount, int iterations);
+
+private:
+	std::vector<float> m_scaleX;
+	std::vector<float> m_scaleY;
+	std::vector<float> m_scaleZ;
+	std::vector<float> m_rotationX;
+	std::vector<float> m_rotationY;
+	std::vector<float> m_rotationZ;
+	std::vector<float> m_positionX;
+	std::vector<float> m_positionY;
+	std::vector<float> m_positionZ;
+
+	// compute a range of objects without SIMD
+	void ComputeRange(int first, int count, glm::mat4* models, glm::mat3* normals) const;
+};
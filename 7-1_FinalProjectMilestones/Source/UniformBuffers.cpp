@@ -0,0 +1,245 @@
+///////////////////////////////////////////////////////////////////////////////
+// uniformbuffers.cpp
+// ============
+// std140 uniform buffer objects for the per-frame camera, the scene lights,
+// the scene materials and the streamed per-draw records
+///////////////////////////////////////////////////////////////////////////////
+
+#include "UniformBuffers.h"
+
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+
+// the std140 offsets of the blocks declared in the shaders
+static_assert(sizeof(UBO_DIRECTIONAL_LIGHT) == 64, "DirectionalLight std140 size");
+static_assert(sizeof(UBO_POINT_LIGHT) == 64, "PointLight std140 size");
+static_assert(sizeof(UBO_SPOT_LIGHT) == 96, "SpotLight std140 size");
+static_assert(offsetof(UBO_SPOT_LIGHT, ambient) == 48, "SpotLight std140 layout");
+static_assert(offsetof(UBO_LIGHT_BLOCK, pointLights) == 64, "LightBlock std140 layout");
+static_assert(offsetof(UBO_LIGHT_BLOCK, spotLight) == 384, "LightBlock std140 layout");
+static_assert(sizeof(UBO_CAMERA_BLOCK) == 160, "CameraBlock std140 size");
+static_assert(sizeof(UBO_MATERIAL) == 32, "MaterialData std140 size");
+static_assert(offsetof(UBO_MATERIAL, specularColor) == 16, "MaterialData std140 layout");
+static_assert(sizeof(UBO_DRAW_RECORD) == 96, "DrawRecord std140 size");
+
+namespace
+{
+	const char* g_CameraBlockName = "CameraBlock";
+	const char* g_LightBlockName = "LightBlock";
+	const char* g_MaterialBlockName = "MaterialBlock";
+	const char* g_DrawBlockName = "DrawBlock";
+}
+
+/***********************************************************
+ *  UniformBuffers()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+UniformBuffers::UniformBuffers()
+{
+	m_cameraBuffer = 0;
+	m_lightBuffer = 0;
+	m_materialBuffer = 0;
+	memset((void*)&m_camera, 0, sizeof(m_camera));
+	memset((void*)&m_lights, 0, sizeof(m_lights));
+	memset((void*)&m_materials, 0, sizeof(m_materials));
+	m_bCameraDirty = true;
+	m_uploadCount = 0;
+}
+
+/***********************************************************
+ *  ~UniformBuffers()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+UniformBuffers::~UniformBuffers()
+{
+	DestroyBuffers();
+}
+
+/***********************************************************
+ *  CreateBuffers()
+ *
+ *  This method is used for creating the buffer objects of
+ *  the camera, light and material blocks and attaching them
+ *  to their binding points.
+ ***********************************************************/
+void UniformBuffers::CreateBuffers()
+{
+	if (m_cameraBuffer == 0)
+	{
+		glGenBuffers(1, &m_cameraBuffer);
+		glBindBuffer(GL_UNIFORM_BUFFER, m_cameraBuffer);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(UBO_CAMERA_BLOCK), NULL, GL_DYNAMIC_DRAW);
+		glBindBufferBase(GL_UNIFORM_BUFFER, CAMERA_BLOCK_BINDING, m_cameraBuffer);
+	}
+
+	if (m_lightBuffer == 0)
+	{
+		glGenBuffers(1, &m_lightBuffer);
+		glBindBuffer(GL_UNIFORM_BUFFER, m_lightBuffer);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(UBO_LIGHT_BLOCK), &m_lights, GL_STATIC_DRAW);
+		glBindBufferBase(GL_UNIFORM_BUFFER, LIGHT_BLOCK_BINDING, m_lightBuffer);
+	}
+
+	if (m_materialBuffer == 0)
+	{
+		glGenBuffers(1, &m_materialBuffer);
+		glBindBuffer(GL_UNIFORM_BUFFER, m_materialBuffer);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(UBO_MATERIAL_BLOCK), &m_materials, GL_STATIC_DRAW);
+		glBindBufferBase(GL_UNIFORM_BUFFER, MATERIAL_BLOCK_BINDING, m_materialBuffer);
+	}
+
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	m_bCameraDirty = true;
+}
+
+/***********************************************************
+ *  BindToProgram()
+ *
+ *  This method is used for pointing the camera, light,
+ *  material and draw uniform blocks of a shader program at
+ *  the shared binding points.  A program can declare any of the
+ *  blocks or none of them.
+ ***********************************************************/
+void UniformBuffers::BindToProgram(GLuint programID) const
+{
+	GLuint blockIndex = GL_INVALID_INDEX;
+
+	if (programID == 0)
+	{
+		return;
+	}
+
+	blockIndex = glGetUniformBlockIndex(programID, g_CameraBlockName);
+	if (blockIndex != GL_INVALID_INDEX)
+	{
+		glUniformBlockBinding(programID, blockIndex, CAMERA_BLOCK_BINDING);
+	}
+
+	blockIndex = glGetUniformBlockIndex(programID, g_LightBlockName);
+	if (blockIndex != GL_INVALID_INDEX)
+	{
+		glUniformBlockBinding(programID, blockIndex, LIGHT_BLOCK_BINDING);
+	}
+
+	blockIndex = glGetUniformBlockIndex(programID, g_MaterialBlockName);
+	if (blockIndex != GL_INVALID_INDEX)
+	{
+		glUniformBlockBinding(programID, blockIndex, MATERIAL_BLOCK_BINDING);
+	}
+
+	blockIndex = glGetUniformBlockIndex(programID, g_DrawBlockName);
+	if (blockIndex != GL_INVALID_INDEX)
+	{
+		glUniformBlockBinding(programID, blockIndex, DRAW_BLOCK_BINDING);
+	}
+}
+
+/***********************************************************
+ *  DestroyBuffers()
+ *
+ *  This method is used for releasing the buffer objects.
+ ***********************************************************/
+void UniformBuffers::DestroyBuffers()
+{
+	if (m_cameraBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_cameraBuffer);
+		m_cameraBuffer = 0;
+	}
+	if (m_lightBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_lightBuffer);
+		m_lightBuffer = 0;
+	}
+	if (m_materialBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_materialBuffer);
+		m_materialBuffer = 0;
+	}
+}
+
+/***********************************************************
+ *  SetCamera()
+ *
+ *  This method is used for updating the camera block.  The
+ *  buffer is only written when the view, the projection,
+ *  the camera position or the jitter differ from the last
+ *  upload.
+ ***********************************************************/
+void UniformBuffers::SetCamera(
+	const glm::mat4& view,
+	const glm::mat4& projection,
+	const glm::vec3& viewPosition,
+	const glm::vec2& jitter)
+{
+	UBO_CAMERA_BLOCK camera;
+
+	memset((void*)&camera, 0, sizeof(camera));
+	camera.view = view;
+	camera.projection = projection;
+	camera.viewPosition = viewPosition;
+	camera.jitter = jitter;
+
+	if ((m_bCameraDirty == false) &&
+		(memcmp(&camera, &m_camera, sizeof(camera)) == 0))
+	{
+		return;
+	}
+
+	m_camera = camera;
+	m_bCameraDirty = false;
+
+	if (m_cameraBuffer == 0)
+	{
+		return;
+	}
+
+	glBindBuffer(GL_UNIFORM_BUFFER, m_cameraBuffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(UBO_CAMERA_BLOCK), &m_camera);
+	m_uploadCount++;
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+/***********************************************************
+ *  UploadLights()
+ *
+ *  This method is used for uploading the light block after
+ *  the lights returned by GetLights() have been changed.
+ ***********************************************************/
+void UniformBuffers::UploadLights()
+{
+	if (m_lightBuffer == 0)
+	{
+		std::cout << "Light buffer uploaded before it was created" << std::endl;
+		return;
+	}
+
+	glBindBuffer(GL_UNIFORM_BUFFER, m_lightBuffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(UBO_LIGHT_BLOCK), &m_lights);
+	m_uploadCount++;
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+/***********************************************************
+ *  UploadMaterials()
+ *
+ *  This method is used for uploading the material block
+ *  after the materials returned by GetMaterials() have been
+ *  changed.
+ ***********************************************************/
+void UniformBuffers::UploadMaterials()
+{
+	if (m_materialBuffer == 0)
+	{
+		std::cout << "Material buffer uploaded before it was created" << std::endl;
+		return;
+	}
+
+	glBindBuffer(GL_UNIFORM_BUFFER, m_materialBuffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(UBO_MATERIAL_BLOCK), &m_materials);
+	m_uploadCount++;
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
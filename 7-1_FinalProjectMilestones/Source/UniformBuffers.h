@@ -0,0 +1,192 @@
+///////////////////////////////////////////////////////////////////////////////
+// uniformbuffers.h
+// ============
+// std140 uniform buffer objects for the per-frame camera, the scene lights,
+// the scene materials and the streamed per-draw records
+//
+//  The camera and light blocks are shared by every shader program that
+//  declares them, so each block is uploaded with one buffer update instead
+//  of one glUniform call per field.  The C++ structures below mirror the
+//  std140 layout of the blocks declared in the GLSL shaders exactly.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+// the uniform buffer binding points used by every shader program
+#define CAMERA_BLOCK_BINDING 0
+#define LIGHT_BLOCK_BINDING 1
+#define MATERIAL_BLOCK_BINDING 2
+#define DRAW_BLOCK_BINDING 3
+
+// must match TOTAL_POINT_LIGHTS in the fragment shader
+#define TOTAL_POINT_LIGHTS 5
+// must match TOTAL_MATERIALS in the fragment shader
+#define TOTAL_MATERIALS 32
+// must match TOTAL_DRAW_RECORDS in the vertex shader - 128 records
+// stay below the 16KB uniform block size every context supports
+#define TOTAL_DRAW_RECORDS 128
+
+// std140 image of the DirectionalLight structure
+struct UBO_DIRECTIONAL_LIGHT
+{
+	glm::vec3 direction;
+	float padding0;
+	glm::vec3 ambient;
+	float padding1;
+	glm::vec3 diffuse;
+	float padding2;
+	glm::vec3 specular;
+	int bActive;
+};
+
+// std140 image of the PointLight structure
+struct UBO_POINT_LIGHT
+{
+	glm::vec3 position;
+	float padding0;
+	glm::vec3 ambient;
+	float padding1;
+	glm::vec3 diffuse;
+	float padding2;
+	glm::vec3 specular;
+	int bActive;
+};
+
+// std140 image of the SpotLight structure
+struct UBO_SPOT_LIGHT
+{
+	glm::vec3 position;
+	float padding0;
+	glm::vec3 direction;
+	float cutOff;
+	float outerCutOff;
+	float constant;
+	float linear;
+	float quadratic;
+	glm::vec3 ambient;
+	float padding1;
+	glm::vec3 diffuse;
+	float padding2;
+	glm::vec3 specular;
+	int bActive;
+};
+
+// std140 image of the CameraBlock uniform block
+struct UBO_CAMERA_BLOCK
+{
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::vec3 viewPosition;
+	float padding0;
+	// sub-pixel offset of the drawn frame in normalized device
+	// coordinates, only applied by the scene vertex shader so
+	// the projection stays the same for culling and caching
+	glm::vec2 jitter;
+	glm::vec2 padding1;
+};
+
+// std140 image of the LightBlock uniform block
+struct UBO_LIGHT_BLOCK
+{
+	UBO_DIRECTIONAL_LIGHT directionalLight;
+	UBO_POINT_LIGHT pointLights[TOTAL_POINT_LIGHTS];
+	UBO_SPOT_LIGHT spotLight;
+};
+
+// std140 image of the MaterialData structure
+struct UBO_MATERIAL
+{
+	glm::vec3 diffuseColor;
+	float shininess;
+	glm::vec3 specularColor;
+	float padding0;
+};
+
+// std140 image of the MaterialBlock uniform block
+struct UBO_MATERIAL_BLOCK
+{
+	UBO_MATERIAL materials[TOTAL_MATERIALS];
+};
+
+// std140 image of the DrawRecord structure
+struct UBO_DRAW_RECORD
+{
+	glm::mat4 model;
+	glm::vec4 color;
+	glm::vec2 UVscale;
+	float textureLayer;
+	// index of the object material in the material block
+	float materialIndex;
+};
+
+// std140 image of the DrawBlock uniform block
+struct UBO_DRAW_BLOCK
+{
+	UBO_DRAW_RECORD records[TOTAL_DRAW_RECORDS];
+};
+
+/***********************************************************
+ *  UniformBuffers
+ *
+ *  This class contains the uniform buffer objects for the
+ *  camera, light and material blocks.  The buffers are bound to fixed
+ *  binding points, and every program that uses the blocks
+ *  only needs its block indices pointed at those bindings.
+ *  The draw block is filled and bound by DrawRecordRing.
+ ***********************************************************/
+class UniformBuffers
+{
+public:
+	// constructor
+	UniformBuffers();
+	// destructor
+	~UniformBuffers();
+
+	// create the buffer objects - needs a current GL context
+	void CreateBuffers();
+	// connect the uniform blocks of a program to the bindings
+	void BindToProgram(GLuint programID) const;
+	// release the buffer objects
+	void DestroyBuffers();
+
+	// upload the camera block if any of its values changed
+	void SetCamera(
+		const glm::mat4& view,
+		const glm::mat4& projection,
+		const glm::vec3& viewPosition,
+		const glm::vec2& jitter);
+
+	// the last uploaded camera block
+	const UBO_CAMERA_BLOCK& GetCamera() const { return(m_camera); }
+
+	// the light block that is uploaded by UploadLights()
+	UBO_LIGHT_BLOCK& GetLights() { return(m_lights); }
+	// upload the whole light block
+	void UploadLights();
+
+	// the material block that is uploaded by UploadMaterials()
+	UBO_MATERIAL_BLOCK& GetMaterials() { return(m_materials); }
+	// upload the whole material block
+	void UploadMaterials();
+
+	// number of block uploads since the last reset
+	int GetUploadCount() const { return(m_uploadCount); }
+	void ResetUploadCount() { m_uploadCount = 0; }
+
+private:
+	// the buffer object of each block
+	GLuint m_cameraBuffer;
+	GLuint m_lightBuffer;
+	GLuint m_materialBuffer;
+	// the last uploaded contents of each block
+	UBO_CAMERA_BLOCK m_camera;
+	UBO_LIGHT_BLOCK m_lights;
+	UBO_MATERIAL_BLOCK m_materials;
+	// true until the camera block has been uploaded once
+	bool m_bCameraDirty;
+	// number of block uploads since the last reset
+	int m_uploadCount;
+};
@@ -0,0 +1,282 @@
+///////////////////////////////////////////////////////////////////////////////
+// uniformcache.cpp
+// ============
+// resolve the shader uniform locations once and set uniform values by handle
+///////////////////////////////////////////////////////////////////////////////
+
+#include "UniformCache.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+/***********************************************************
+ *  UniformCache()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+UniformCache::UniformCache()
+{
+	m_programID = 0;
+	m_activeProgramID = 0;
+	m_activeLocations = &m_locations;
+	m_uploadCount = 0;
+}
+
+/***********************************************************
+ *  ~UniformCache()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+UniformCache::~UniformCache()
+{
+	m_names.clear();
+	m_locations.clear();
+	m_variantLocations.clear();
+	m_handles.clear();
+}
+
+/***********************************************************
+ *  GetHandle()
+ *
+ *  This method is used for getting the handle of a uniform
+ *  by name.  Unknown names get a new handle whose location
+ *  is resolved against the loaded program, if any, and
+ *  against every added variant.
+ ***********************************************************/
+int UniformCache::GetHandle(const char* name)
+{
+	std::unordered_map<std::string, int>::const_iterator found = m_handles.find(name);
+	if (found != m_handles.end())
+	{
+		return(found->second);
+	}
+
+	GLint location = -1;
+	if (m_programID != 0)
+	{
+		location = glGetUniformLocation(m_programID, name);
+	}
+
+	m_names.push_back(name);
+	m_locations.push_back(location);
+	m_handles[name] = (int)m_names.size() - 1;
+
+	for (std::unordered_map<GLuint, std::vector<GLint>>::iterator variant = m_variantLocations.begin();
+		variant != m_variantLocations.end(); ++variant)
+	{
+		variant->second.push_back(glGetUniformLocation(variant->first, name));
+	}
+
+	return((int)m_names.size() - 1);
+}
+
+/***********************************************************
+ *  LoadUniforms()
+ *
+ *  This method is used for introspecting the active uniforms
+ *  of a linked program and caching their locations.  Array
+ *  uniforms are registered element by element, and every
+ *  previously requested handle is re-resolved so that it
+ *  keeps working with the new program.
+ ***********************************************************/
+void UniformCache::LoadUniforms(GLuint programID)
+{
+	GLint activeUniforms = 0;
+	GLint maxNameLength = 0;
+
+	m_programID = programID;
+	m_activeProgramID = programID;
+	m_activeLocations = &m_locations;
+
+	// names requested before this program was loaded may not
+	// be active in it - start from an unresolved state
+	for (size_t i = 0; i < m_locations.size(); i++)
+	{
+		m_locations[i] = -1;
+	}
+
+	if (m_programID == 0)
+	{
+		return;
+	}
+
+	glGetProgramiv(m_programID, GL_ACTIVE_UNIFORMS, &activeUniforms);
+	glGetProgramiv(m_programID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+	std::vector<GLchar> nameBuffer(maxNameLength + 1);
+
+	for (GLint index = 0; index < activeUniforms; index++)
+	{
+		GLsizei nameLength = 0;
+		GLint arraySize = 0;
+		GLenum type = 0;
+
+		glGetActiveUniform(m_programID, (GLuint)index, (GLsizei)nameBuffer.size(),
+			&nameLength, &arraySize, &type, nameBuffer.data());
+
+		std::string name(nameBuffer.data(), nameLength);
+
+		// uniforms inside a uniform block have no location
+		if (glGetUniformLocation(m_programID, name.c_str()) < 0)
+		{
+			continue;
+		}
+
+		// arrays of basic types are reported once as "name[0]"
+		std::string baseName = name;
+		if ((baseName.size() > 3) && (baseName.compare(baseName.size() - 3, 3, "[0]") == 0))
+		{
+			baseName.erase(baseName.size() - 3);
+			GetHandle(baseName.c_str());
+		}
+
+		for (GLint element = 0; element < arraySize; element++)
+		{
+			std::string elementName = name;
+			if (arraySize > 1)
+			{
+				elementName = baseName + "[" + std::to_string(element) + "]";
+			}
+			GetHandle(elementName.c_str());
+		}
+	}
+
+	// resolve every known handle against the new program
+	for (size_t i = 0; i < m_names.size(); i++)
+	{
+		m_locations[i] = glGetUniformLocation(m_programID, m_names[i].c_str());
+	}
+}
+
+/***********************************************************
+ *  AddProgram()
+ *
+ *  This method is used for resolving every known handle
+ *  against a variant of the loaded program.  A variant is
+ *  built from the same shader files, so it has no uniforms
+ *  of its own and needs no introspection.
+ ***********************************************************/
+void UniformCache::AddProgram(GLuint programID)
+{
+	if ((programID == 0) || (programID == m_programID))
+	{
+		return;
+	}
+
+	std::vector<GLint>& locations = m_variantLocations[programID];
+	locations.resize(m_names.size());
+	for (size_t i = 0; i < m_names.size(); i++)
+	{
+		locations[i] = glGetUniformLocation(programID, m_names[i].c_str());
+	}
+}
+
+/***********************************************************
+ *  RemoveProgram()
+ *
+ *  This method is used for forgetting the locations of a
+ *  variant before it is deleted.  The loaded program is made
+ *  current again if the variant was.
+ ***********************************************************/
+void UniformCache::RemoveProgram(GLuint programID)
+{
+	if ((programID == m_activeProgramID) && (programID != m_programID))
+	{
+		m_activeProgramID = m_programID;
+		m_activeLocations = &m_locations;
+		glUseProgram(m_programID);
+	}
+	m_variantLocations.erase(programID);
+}
+
+/***********************************************************
+ *  UseProgram()
+ *
+ *  This method is used for making the loaded program or one
+ *  of its variants current.  Programs that were not added
+ *  are ignored.
+ ***********************************************************/
+void UniformCache::UseProgram(GLuint programID)
+{
+	if (programID == m_programID)
+	{
+		m_activeLocations = &m_locations;
+	}
+	else
+	{
+		std::unordered_map<GLuint, std::vector<GLint>>::const_iterator found = m_variantLocations.find(programID);
+		if (found == m_variantLocations.end())
+		{
+			return;
+		}
+		m_activeLocations = &found->second;
+	}
+
+	m_activeProgramID = programID;
+	glUseProgram(programID);
+}
+
+/***********************************************************
+ *  GetLocation()
+ *
+ *  This method is used for getting the cached location of a
+ *  uniform handle.  Every Set method goes through here, so
+ *  this is where the set uniform values are counted.
+ ***********************************************************/
+GLint UniformCache::GetLocation(int handle) const
+{
+	m_uploadCount++;
+
+	if ((handle < 0) || (handle >= (int)m_activeLocations->size()))
+	{
+		return(-1);
+	}
+
+	return((*m_activeLocations)[handle]);
+}
+
+/***********************************************************
+ *  Set*()
+ *
+ *  These methods are used for setting uniform values into
+ *  the current program by handle.  Setting a uniform that is
+ *  not active in the program is silently ignored.
+ ***********************************************************/
+void UniformCache::SetBool(int handle, bool value) const
+{
+	glUniform1i(GetLocation(handle), (int)value);
+}
+
+void UniformCache::SetInt(int handle, int value) const
+{
+	glUniform1i(GetLocation(handle), value);
+}
+
+void UniformCache::SetFloat(int handle, float value) const
+{
+	glUniform1f(GetLocation(handle), value);
+}
+
+void UniformCache::SetSampler2D(int handle, int textureSlot) const
+{
+	glUniform1i(GetLocation(handle), textureSlot);
+}
+
+void UniformCache::SetVec2(int handle, const glm::vec2& value) const
+{
+	glUniform2fv(GetLocation(handle), 1, glm::value_ptr(value));
+}
+
+void UniformCache::SetVec3(int handle, const glm::vec3& value) const
+{
+	glUniform3fv(GetLocation(handle), 1, glm::value_ptr(value));
+}
+
+void UniformCache::SetVec4(int handle, const glm::vec4& value) const
+{
+	glUniform4fv(GetLocation(handle), 1, glm::value_ptr(value));
+}
+
+void UniformCache::SetMat4(int handle, const glm::mat4& value) const
+{
+	glUniformMatrix4fv(GetLocation(handle), 1, GL_FALSE, glm::value_ptr(value));
+}
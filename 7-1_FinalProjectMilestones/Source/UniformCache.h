@@ -0,0 +1,91 @@
+///////////////////////////////////////////////////////////////////////////////
+// uniformcache.h
+// ============
+// resolve the shader uniform locations once and set uniform values by handle
+//
+//  Every name lookup happens when a handle is requested or when a program is
+//  loaded, so setting a uniform on the hot path is a plain array index and a
+//  glUniform call, without a string copy or a glGetUniformLocation query.
+//  Variants of the loaded program can be added with their own locations, and
+//  the same handles then set the uniforms of whichever program is in use.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/***********************************************************
+ *  UniformCache
+ *
+ *  This class contains the active uniform locations of the
+ *  loaded shader program and of its added variants.  Handles
+ *  are stable for the life of the cache, so they stay valid
+ *  when a program is reloaded or replaced.
+ ***********************************************************/
+class UniformCache
+{
+public:
+	// constructor
+	UniformCache();
+	// destructor
+	~UniformCache();
+
+	// get the handle of a uniform by name - the same name always
+	// returns the same handle, even before a program is loaded
+	int GetHandle(const char* name);
+
+	// resolve the locations of every active uniform of a program
+	void LoadUniforms(GLuint programID);
+
+	// the program the cached locations belong to
+	GLuint GetProgramID() const { return(m_programID); }
+
+	// resolve the locations of a variant of the loaded program
+	void AddProgram(GLuint programID);
+	// forget the locations of a variant
+	void RemoveProgram(GLuint programID);
+	// make the loaded program or a variant current, and set the
+	// uniforms into it from now on
+	void UseProgram(GLuint programID);
+	// the program the uniforms are set into
+	GLuint GetActiveProgramID() const { return(m_activeProgramID); }
+
+	// number of uniform values set since the last reset
+	int GetUploadCount() const { return(m_uploadCount); }
+	void ResetUploadCount() { m_uploadCount = 0; }
+
+	// set uniform values into the current program by handle
+	void SetBool(int handle, bool value) const;
+	void SetInt(int handle, int value) const;
+	void SetFloat(int handle, float value) const;
+	void SetSampler2D(int handle, int textureSlot) const;
+	void SetVec2(int handle, const glm::vec2& value) const;
+	void SetVec3(int handle, const glm::vec3& value) const;
+	void SetVec4(int handle, const glm::vec4& value) const;
+	void SetMat4(int handle, const glm::mat4& value) const;
+
+private:
+	// the program the cached locations belong to
+	GLuint m_programID;
+	// uniform name of every handle
+	std::vector<std::string> m_names;
+	// uniform location of every handle, -1 when not active
+	std::vector<GLint> m_locations;
+	// the locations of every handle in each added variant
+	std::unordered_map<GLuint, std::vector<GLint>> m_variantLocations;
+	// the program in use and its locations
+	GLuint m_activeProgramID;
+	const std::vector<GLint>* m_activeLocations;
+	// handle of every known uniform name
+	std::unordered_map<std::string, int> m_handles;
+	// number of uniform values set since the last reset
+	mutable int m_uploadCount;
+
+	// get the location of a handle, -1 when invalid
+	GLint GetLocation(int handle) const;
+};
@@ -15,14 +15,14 @@
 #include <glm/gtx/transform.hpp>
 #include <glm/gtc/type_ptr.hpp>    
 
+#include <algorithm>
+
 // declaration of the global variables and defines
 namespace
 {
 	// Variables for window width and height
 	const int WINDOW_WIDTH = 1000;
 	const int WINDOW_HEIGHT = 800;
-	const char* g_ViewName = "view";
-	const char* g_ProjectionName = "projection";
 
 	// camera object used for viewing and interacting with
 	// the 3D scene
@@ -32,10 +32,31 @@ namespace
 	float gLastX = WINDOW_WIDTH / 2.0f;
 	float gLastY = WINDOW_HEIGHT / 2.0f;
 	bool gFirstMouse = true;
+	// false while the camera is driven by a script
+	bool gInputEnabled = true;
 
 	// time between current frame and last frame
 	float gDeltaTime = 0.0f; 
 	float gLastFrame = 0.0f;
+	// the longest time step of the keyboard movement, so the
+	// first frame after skipped frames does not jump the camera
+	const float gMaxDeltaTime = 0.1f;
+	// set by the input and window callbacks until the next view
+	// is prepared
+	bool gViewDirty = true;
+	// the size of the window framebuffer, which differs from the
+	// window size on high density displays, and whether it
+	// changed since the last view was prepared
+	int gFramebufferWidth = WINDOW_WIDTH;
+	int gFramebufferHeight = WINDOW_HEIGHT;
+	bool gFramebufferResized = false;
+
+	// the keys that move or close the camera view
+	const int gViewKeys[] =
+	{
+		GLFW_KEY_ESCAPE, GLFW_KEY_W, GLFW_KEY_S, GLFW_KEY_A, GLFW_KEY_D,
+		GLFW_KEY_Q, GLFW_KEY_E, GLFW_KEY_O, GLFW_KEY_P
+	};
 
 	// the following variable is false when orthographic projection
 	// is off and true when it is on
@@ -48,11 +69,16 @@ namespace
  *  The constructor for the class
  ***********************************************************/
 ViewManager::ViewManager(
-	ShaderManager *pShaderManager)
+	ShaderManager *pShaderManager,
+	UniformBuffers* pUniformBuffers)
 {
 	// initialize the member variables
 	m_pShaderManager = pShaderManager;
+	m_pUniformBuffers = pUniformBuffers;
 	m_pWindow = NULL;
+	m_viewportWidth = WINDOW_WIDTH;
+	m_viewportHeight = WINDOW_HEIGHT;
+	m_projectionJitter = glm::vec2(0.0f);
 	g_pCamera = new Camera();
 	// default camera view parameters
 	g_pCamera->Position = glm::vec3(0.0f, 12.0f, 25.0f);
@@ -71,6 +97,7 @@ ViewManager::~ViewManager()
 {
 	// free up allocated memory
 	m_pShaderManager = NULL;
+	m_pUniformBuffers = NULL;
 	m_pWindow = NULL;
 	if (NULL != g_pCamera)
 	{
@@ -111,6 +138,14 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
 	// Callback for recieving mouse scroll wheel inputs
 	glfwSetScrollCallback(window, &ViewManager::Mouse_Scroll_Callback);
 
+	// Callback for redrawing the window when its contents are damaged
+	glfwSetWindowRefreshCallback(window, &ViewManager::Window_Refresh_Callback);
+
+	// Callback for following the size of the window framebuffer
+	glfwSetFramebufferSizeCallback(window, &ViewManager::Framebuffer_Size_Callback);
+	glfwGetFramebufferSize(window, &gFramebufferWidth, &gFramebufferHeight);
+	SetViewportSize(gFramebufferWidth, gFramebufferHeight);
+
 	// enable blending for supporting tranparent rendering
 	glEnable(GL_BLEND);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -128,6 +163,11 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
  ***********************************************************/
 void ViewManager::Mouse_Position_Callback(GLFWwindow* window, double xMousePos, double yMousePos)
 {
+	if (gInputEnabled == false)
+	{
+		return;
+	}
+
 	// when the first mouse move event is received, this needs to be recorded so that
 	// all subsequent mouse moves can correctly calculate the X position offset and Y
 	// position offset for proper operation
@@ -148,16 +188,50 @@ void ViewManager::Mouse_Position_Callback(GLFWwindow* window, double xMousePos,
 
 	// move the 3D camera according to the calculated offsets
 	g_pCamera->ProcessMouseMovement(xOffset, yOffset);
+	gViewDirty = true;
 }
 
 // Mouse_Scroll_Callback called from GLFW when scrolling input is detected
 void ViewManager::Mouse_Scroll_Callback(GLFWwindow* window, double xoffset, double yoffset)
 {
+	if (gInputEnabled == false)
+	{
+		return;
+	}
+
 	// Scrolling UP increases the speed and scrolling DOWN decreases the speed of the camera
 	g_pCamera->MovementSpeed += yoffset * 2.0f;
 
 	if (g_pCamera->MovementSpeed < 1.0f)
 		g_pCamera->MovementSpeed = 1.0f;
+	gViewDirty = true;
+}
+
+/***********************************************************
+ *  Window_Refresh_Callback()
+ *
+ *  This method is automatically called from GLFW whenever
+ *  the contents of the window were damaged, for example by
+ *  another window moving over it, and need to be drawn.
+ ***********************************************************/
+void ViewManager::Window_Refresh_Callback(GLFWwindow* window)
+{
+	gViewDirty = true;
+}
+
+/***********************************************************
+ *  Framebuffer_Size_Callback()
+ *
+ *  This method is automatically called from GLFW whenever
+ *  the framebuffer of the window changes size.  The new
+ *  size is applied when the next view is prepared.
+ ***********************************************************/
+void ViewManager::Framebuffer_Size_Callback(GLFWwindow* window, int width, int height)
+{
+	gFramebufferWidth = width;
+	gFramebufferHeight = height;
+	gFramebufferResized = true;
+	gViewDirty = true;
 }
 
 /***********************************************************
@@ -243,12 +317,23 @@ void ViewManager::PrepareSceneView()
 
 	// per-frame timing
 	float currentFrame = glfwGetTime();
-	gDeltaTime = currentFrame - gLastFrame;
+	gDeltaTime = std::min(currentFrame - gLastFrame, gMaxDeltaTime);
 	gLastFrame = currentFrame;
+	gViewDirty = false;
+
+	// the projection follows the aspect ratio of a resized window
+	if (gFramebufferResized == true)
+	{
+		SetViewportSize(gFramebufferWidth, gFramebufferHeight);
+		gFramebufferResized = false;
+	}
 
 	// process any keyboard events that may be waiting in the 
 	// event queue
-	ProcessKeyboardEvents();
+	if (gInputEnabled == true)
+	{
+		ProcessKeyboardEvents();
+	}
 
 	// get the current view matrix from the camera
 	view = g_pCamera->GetViewMatrix();
@@ -258,20 +343,20 @@ void ViewManager::PrepareSceneView()
 	if (bOrthographicProjection == false)
 	{
 		// perspective projection
-		projection = glm::perspective(glm::radians(g_pCamera->Zoom), (GLfloat)WINDOW_WIDTH / (GLfloat)WINDOW_HEIGHT, 0.1f, 100.0f);
+		projection = glm::perspective(glm::radians(g_pCamera->Zoom), (GLfloat)m_viewportWidth / (GLfloat)m_viewportHeight, 0.1f, 100.0f);
 	}
 	else
 	{
 		// Front orthographic view with proper zooming
 		double scale = 0.0;
-		if (WINDOW_WIDTH > WINDOW_HEIGHT)
+		if (m_viewportWidth > m_viewportHeight)
 		{
-			scale = (double)WINDOW_HEIGHT / (double)WINDOW_WIDTH;
+			scale = (double)m_viewportHeight / (double)m_viewportWidth;
 			projection = glm::ortho(-20.0f, 20.0f, -20.0f * (float)scale, 20.0f * (float)scale, 0.1f, 100.0f);
 		}
-		else if (WINDOW_WIDTH < WINDOW_HEIGHT)
+		else if (m_viewportWidth < m_viewportHeight)
 		{
-			scale = (double)WINDOW_WIDTH / (double)WINDOW_HEIGHT;
+			scale = (double)m_viewportWidth / (double)m_viewportHeight;
 			projection = glm::ortho(-20.0f * (float)scale, 20.0f * (float)scale, -20.0f, 20.0f, 0.1f, 100.0f);
 		}
 		else
@@ -280,14 +365,114 @@ void ViewManager::PrepareSceneView()
 		}
 	}
 
-	// if the shader manager object is valid
-	if (NULL != m_pShaderManager)
+	// if the uniform buffers object is valid
+	if (NULL != m_pUniformBuffers)
 	{
-		// set the view matrix into the shader for proper rendering
-		m_pShaderManager->setMat4Value(g_ViewName, view);
-		// set the view matrix into the shader for proper rendering
-		m_pShaderManager->setMat4Value(g_ProjectionName, projection);
-		// set the view position of the camera into the shader for proper rendering
-		m_pShaderManager->setVec3Value("viewPosition", g_pCamera->Position);
+		// the view and projection matrices and the view position of
+		// the camera are shared by every shader program through the
+		// camera block, which is only written when they change -
+		// the jitter is kept apart from the projection, so culling
+		// and the cached views still see a still camera
+		m_pUniformBuffers->SetCamera(view, projection, g_pCamera->Position, m_projectionJitter);
 	}
+}
+
+/***********************************************************
+ *  SetInputEnabled()
+ *
+ *  This method is used for turning the keyboard and mouse
+ *  control of the camera on or off.
+ ***********************************************************/
+void ViewManager::SetInputEnabled(bool bEnabled)
+{
+	gInputEnabled = bEnabled;
+	gFirstMouse = true;
+}
+
+/***********************************************************
+ *  SetViewportSize()
+ *
+ *  This method is used for setting the size of the rendered
+ *  viewport, which sets the aspect ratio of the projection.
+ ***********************************************************/
+void ViewManager::SetViewportSize(int width, int height)
+{
+	if ((width <= 0) || (height <= 0))
+	{
+		return;
+	}
+
+	m_viewportWidth = width;
+	m_viewportHeight = height;
+	gViewDirty = true;
+}
+
+/***********************************************************
+ *  GetFramebufferSize()
+ *
+ *  This method is used for getting the size of the window
+ *  framebuffer in pixels, which is 0 while the window is
+ *  minimized.
+ ***********************************************************/
+void ViewManager::GetFramebufferSize(int& width, int& height) const
+{
+	width = gFramebufferWidth;
+	height = gFramebufferHeight;
+}
+
+/***********************************************************
+ *  SetProjectionJitter()
+ *
+ *  This method is used for shifting the projection of the
+ *  next views by a sub-pixel offset, for temporal anti-
+ *  aliasing.  An offset of 0 turns the jitter off.
+ ***********************************************************/
+void ViewManager::SetProjectionJitter(const glm::vec2& jitter)
+{
+	m_projectionJitter = jitter;
+}
+
+/***********************************************************
+ *  SetCameraPose()
+ *
+ *  This method is used for placing the camera at a position
+ *  looking along a direction, for scripted camera movement.
+ ***********************************************************/
+void ViewManager::SetCameraPose(const glm::vec3& position, const glm::vec3& front, float zoom)
+{
+	g_pCamera->Position = position;
+	g_pCamera->Front = front;
+	g_pCamera->Up = glm::vec3(0.0f, 1.0f, 0.0f);
+	g_pCamera->Zoom = zoom;
+	gViewDirty = true;
+}
+
+/***********************************************************
+ *  IsViewChanging()
+ *
+ *  This method is used for checking whether the view may
+ *  change in the next frame.  The mouse moves the camera
+ *  in its callback, but a held key only moves it while the
+ *  frames are drawn, so the keys are read here as well.
+ ***********************************************************/
+bool ViewManager::IsViewChanging() const
+{
+	if (gViewDirty == true)
+	{
+		return(true);
+	}
+	if ((gInputEnabled == false) || (NULL == m_pWindow))
+	{
+		return(false);
+	}
+
+	for (size_t i = 0; i < sizeof(gViewKeys) / sizeof(gViewKeys[0]); i++)
+	{
+		if (glfwGetKey(m_pWindow, gViewKeys[i]) == GLFW_PRESS)
+		{
+			return(true);
+		}
+	}
+
+	return(false);
 }
\ No newline at end of file
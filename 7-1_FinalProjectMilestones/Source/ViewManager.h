@@ -10,6 +10,7 @@
 #pragma once
 
 #include "ShaderManager.h"
+#include "UniformBuffers.h"
 #include "camera.h"
 
 // GLFW library
@@ -20,7 +21,8 @@ class ViewManager
 public:
 	// constructor
 	ViewManager(
-		ShaderManager* pShaderManager);
+		ShaderManager* pShaderManager,
+		UniformBuffers* pUniformBuffers);
 	// destructor
 	~ViewManager();
 
@@ -30,11 +32,25 @@ public:
 	// Scrolling callback for camera speed adjustment
 	static void Mouse_Scroll_Callback(GLFWwindow* window, double xOffset, double yOffset);
 
+	// window refresh callback for redrawing a damaged window
+	static void Window_Refresh_Callback(GLFWwindow* window);
+
+	// framebuffer size callback for following the window size
+	static void Framebuffer_Size_Callback(GLFWwindow* window, int width, int height);
+
 private:
 	// pointer to shader manager object
 	ShaderManager* m_pShaderManager;
+	// pointer to the shared camera and light uniform buffers
+	UniformBuffers* m_pUniformBuffers;
 	// active OpenGL display window
 	GLFWwindow* m_pWindow;
+	// size of the rendered viewport, used for the projection
+	int m_viewportWidth;
+	int m_viewportHeight;
+	// offset the scene vertex shader adds to the projected x and
+	// y, in normalized device coordinates
+	glm::vec2 m_projectionJitter;
 
 	// process keyboard events for interaction with the 3D scene
 	void ProcessKeyboardEvents();
@@ -45,4 +61,21 @@ public:
 
 	// prepare the conversion from 3D object display to 2D scene display
 	void PrepareSceneView();
+
+	// turn the keyboard and mouse control of the camera on or off
+	void SetInputEnabled(bool bEnabled);
+	// set the size of the rendered viewport
+	void SetViewportSize(int width, int height);
+	// the size of the window framebuffer, 0 while it is minimized
+	void GetFramebufferSize(int& width, int& height) const;
+	// shift the drawn scene by a sub-pixel offset, in normalized
+	// device coordinates - the projection itself is not changed
+	void SetProjectionJitter(const glm::vec2& jitter);
+	// place the camera, for scripted camera movement
+	void SetCameraPose(const glm::vec3& position, const glm::vec3& front, float zoom);
+
+	// true when the next PrepareSceneView() may change the view -
+	// after input events, while a camera key is held down and
+	// after the window needs to be redrawn
+	bool IsViewChanging() const;
 };
\ No newline at end of file
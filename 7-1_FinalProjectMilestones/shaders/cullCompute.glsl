@@ -0,0 +1,199 @@
+#version 430 core
+// must match GpuCulling::GROUP_SIZE
+layout (local_size_x = 64) in;
+
+// must match GpuCulling::GPU_OBJECT
+struct CullObject {
+    mat4 model;
+    vec4 color;
+    vec4 boundsMin;
+    vec4 boundsMax;
+    // UV scale in xy, texture layer in z, material index in w
+    vec4 params;
+    // first command of the draw group in x, OBJECT_FLAGS bits
+    // in y, number of detail levels in z
+    uvec4 drawGroup;
+};
+
+// must match GpuCulling::MAX_LOD_COUNT
+#define MAX_LOD_COUNT 4
+
+// must match GpuCulling::OBJECT_FLAGS
+#define OBJECT_OCCLUDER 1u
+
+// must match GpuCulling::DRAW_COMMAND
+struct DrawCommand {
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+};
+
+// must match InstancedMeshes::INSTANCE_DATA
+struct InstanceData {
+    mat4 model;
+    vec4 color;
+    vec2 UVscale;
+    float textureLayer;
+    float materialIndex;
+};
+
+layout (std430, binding = 0) readonly buffer ObjectBuffer
+{
+    CullObject objects[];
+};
+
+layout (std430, binding = 1) buffer CommandBuffer
+{
+    DrawCommand commands[];
+};
+
+layout (std430, binding = 2) writeonly buffer InstanceBuffer
+{
+    InstanceData instances[];
+};
+
+// the detail level of every object in the last frame
+layout (std430, binding = 3) buffer LodBuffer
+{
+    uint objectLods[];
+};
+
+// world space frustum planes with inward normals
+uniform vec4 frustumPlanes[6];
+uniform uint objectCount;
+uniform bool bUseFrustum = true;
+
+uniform mat4 viewProjection;
+
+// screen size based level of detail
+uniform bool bUseLod = false;
+uniform float lodScale;
+uniform float lodScreenSizes[MAX_LOD_COUNT - 1];
+uniform float lodHysteresis;
+
+// the farthest occluder depth pyramid from HiZBuffer - its textures can be
+// larger than the viewport, and hiZSize is the part that was built
+uniform bool bUseOcclusion = false;
+uniform sampler2D hiZBuffer;
+uniform ivec2 hiZSize;
+uniform int hiZLevels;
+
+// true when the whole box is behind the occluders - the nearest
+// depth of the box is compared with the farthest occluder depth
+// of the pyramid texels that cover the box on screen
+bool IsOccluded(vec3 boundsMin, vec3 boundsMax)
+{
+    vec3 ndcMin = vec3(1.0f);
+    vec3 ndcMax = vec3(-1.0f);
+
+    for(int c = 0; c < 8; c++)
+    {
+        vec3 corner = mix(boundsMin, boundsMax, vec3(ivec3(c, c >> 1, c >> 2) & 1));
+        vec4 clip = viewProjection * vec4(corner, 1.0f);
+        // boxes reaching behind the camera are never hidden
+        if(clip.w <= 0.0f)
+        {
+            return false;
+        }
+        vec3 ndc = clip.xyz / clip.w;
+        ndcMin = min(ndcMin, ndc);
+        ndcMax = max(ndcMax, ndc);
+    }
+
+    vec2 uvMin = clamp(ndcMin.xy * 0.5f + 0.5f, 0.0f, 1.0f);
+    vec2 uvMax = clamp(ndcMax.xy * 0.5f + 0.5f, 0.0f, 1.0f);
+    float nearestDepth = ndcMin.z * 0.5f + 0.5f;
+
+    // the level where the box covers at most 2x2 texels
+    vec2 screenSize = (uvMax - uvMin) * vec2(hiZSize);
+    int level = int(ceil(log2(max(max(screenSize.x, screenSize.y), 1.0f))));
+    level = clamp(level, 0, hiZLevels - 1);
+
+    ivec2 levelSize = max(hiZSize >> level, ivec2(1));
+    ivec2 texelMin = clamp(ivec2(uvMin * vec2(levelSize)), ivec2(0), levelSize - 1);
+    ivec2 texelMax = clamp(ivec2(uvMax * vec2(levelSize)), ivec2(0), levelSize - 1);
+
+    float farthest = texelFetch(hiZBuffer, texelMin, level).r;
+    farthest = max(farthest, texelFetch(hiZBuffer, ivec2(texelMax.x, texelMin.y), level).r);
+    farthest = max(farthest, texelFetch(hiZBuffer, ivec2(texelMin.x, texelMax.y), level).r);
+    farthest = max(farthest, texelFetch(hiZBuffer, texelMax, level).r);
+
+    return nearestDepth > farthest;
+}
+
+// the detail level for the fraction of the screen height the
+// bounds cover, moving from the last level only once the size is
+// past the switching size by the hysteresis fraction
+uint SelectLod(vec3 boundsMin, vec3 boundsMax, uint lastLod, uint lodCount)
+{
+    vec3 center = (boundsMin + boundsMax) * 0.5f;
+    float radius = length(boundsMax - boundsMin) * 0.5f;
+    float w = max((viewProjection * vec4(center, 1.0f)).w, 0.0001f);
+    float screenSize = radius * lodScale / w;
+
+    uint lod = min(lastLod, lodCount - 1u);
+    while((lod + 1u < lodCount) && (screenSize < lodScreenSizes[lod] * (1.0f - lodHysteresis)))
+    {
+        lod++;
+    }
+    while((lod > 0u) && (screenSize > lodScreenSizes[lod - 1u] * (1.0f + lodHysteresis)))
+    {
+        lod--;
+    }
+    return lod;
+}
+
+void main()
+{
+    uint objectIndex = gl_GlobalInvocationID.x;
+    if(objectIndex >= objectCount)
+    {
+        return;
+    }
+
+    CullObject object = objects[objectIndex];
+
+    if(bUseFrustum == true)
+    {
+        vec3 center = (object.boundsMin.xyz + object.boundsMax.xyz) * 0.5f;
+        vec3 extent = (object.boundsMax.xyz - object.boundsMin.xyz) * 0.5f;
+
+        for(int p = 0; p < 6; p++)
+        {
+            float distance = dot(frustumPlanes[p].xyz, center) + frustumPlanes[p].w;
+            float radius = dot(abs(frustumPlanes[p].xyz), extent);
+            if(distance + radius < 0.0f)
+            {
+                return;
+            }
+        }
+
+        // the occluders themselves are always drawn
+        if((bUseOcclusion == true) && ((object.drawGroup.y & OBJECT_OCCLUDER) == 0u) &&
+            (IsOccluded(object.boundsMin.xyz, object.boundsMax.xyz) == true))
+        {
+            return;
+        }
+    }
+
+    // the detail level picks the command of the draw group
+    uint lod = 0u;
+    if((bUseLod == true) && (object.drawGroup.z > 1u))
+    {
+        lod = SelectLod(object.boundsMin.xyz, object.boundsMax.xyz, objectLods[objectIndex], object.drawGroup.z);
+        objectLods[objectIndex] = lod;
+    }
+
+    // append the object to the instances of its draw command
+    uint group = object.drawGroup.x + lod;
+    uint slot = atomicAdd(commands[group].instanceCount, 1u);
+    uint target = commands[group].baseInstance + slot;
+
+    instances[target].model = object.model;
+    instances[target].color = object.color;
+    instances[target].UVscale = object.params.xy;
+    instances[target].textureLayer = object.params.z;
+    instances[target].materialIndex = object.params.w;
+}
@@ -4,6 +4,10 @@ out vec4 fragmentColor;
 in vec3 fragmentPosition;
 in vec3 fragmentVertexNormal;
 in vec2 fragmentTextureCoordinate;
+in vec4 fragmentObjectColor;
+in vec2 fragmentUVscale;
+flat in float fragmentTextureLayer;
+flat in float fragmentMaterialIndex;
 
 struct Material {
     vec3 diffuseColor;
@@ -48,30 +52,162 @@ struct SpotLight {
     bool bActive;
 };
 
+// std140 image of a material - must match UBO_MATERIAL in UniformBuffers.h
+struct MaterialData {
+    vec3 diffuseColor;
+    float shininess;
+    vec3 specularColor;
+};
+
+// must match TOTAL_POINT_LIGHTS in UniformBuffers.h
 #define TOTAL_POINT_LIGHTS 5
+// must match TOTAL_MATERIALS in UniformBuffers.h
+#define TOTAL_MATERIALS 32
+
+// per-frame camera data shared by every shader program
+layout (std140) uniform CameraBlock
+{
+    mat4 view;
+    mat4 projection;
+    vec3 viewPosition;
+    vec2 jitter;
+};
+
+// scene light sources shared by every shader program
+layout (std140) uniform LightBlock
+{
+    DirectionalLight directionalLight;
+    PointLight pointLights[TOTAL_POINT_LIGHTS];
+    SpotLight spotLight;
+};
+
+// scene materials, indexed per instance by GPU driven draws
+layout (std140) uniform MaterialBlock
+{
+    MaterialData materials[TOTAL_MATERIALS];
+};
 
 uniform bool bUseTexture=false;
 uniform bool bUseLighting=false;
-uniform vec4 objectColor = vec4(1.0f);
-uniform vec3 viewPosition;
-uniform DirectionalLight directionalLight;
-uniform PointLight pointLights[TOTAL_POINT_LIGHTS];
-uniform SpotLight spotLight;
 uniform Material material;
+// when set, the material comes from the material block
+uniform bool bUseMaterialIndex = false;
 uniform sampler2D objectTexture;
-uniform vec2 UVscale = vec2(1.0f, 1.0f);
+// when set, the object texture is a layer of the texture array
+uniform bool bUseTextureArray = false;
+uniform sampler2DArray objectTextureArray;
+
+// must match LightClusters::CLUSTER_COUNT_X, _Y, _Z and CLUSTER_STRIDE
+#define CLUSTER_COUNT_X 16
+#define CLUSTER_COUNT_Y 9
+#define CLUSTER_COUNT_Z 24
+#define CLUSTER_STRIDE 64
+// when set, the point lights with a radius are read from the clusters
+// that the light cluster pass binned them into
+uniform bool bUseLightClusters = false;
+// four texels per light - position and radius, ambient, diffuse, specular
+uniform samplerBuffer clusterLights;
+// the light count of every cluster followed by its light indices
+uniform usamplerBuffer clusterEntries;
+// the tiles per pixel in xy, and the scale and bias that turn the log
+// of the view depth into a slice in zw
+uniform vec4 clusterParameters;
+
+// must match ShadowMaps::CASCADE_COUNT and CUBE_FACES
+#define SHADOW_CASCADE_COUNT 3
+#define SHADOW_CUBE_FACES 6
+// when set, the directional light is shadowed by its cascades
+uniform bool bUseCascadeShadows = false;
+uniform sampler2DArrayShadow cascadeShadowMap;
+// the light view projection of every cascade, and the view depth where
+// every cascade ends in xyz
+uniform mat4 cascadeMatrices[SHADOW_CASCADE_COUNT];
+uniform vec4 cascadeSplits;
+// six layers per point light of the light block, in the face order of
+// OpenGL cube maps
+uniform sampler2DArrayShadow pointShadowMap;
+// the near and far plane of the cube faces
+uniform vec2 pointShadowParameters;
+// the point lights of the light block that have a shadow map
+uniform int pointShadowMask = 0;
+
+// the look and up directions of the cube faces - must match g_FaceDirections
+// and g_FaceUps in ShadowMaps.cpp
+const vec3 shadowFaceDirections[SHADOW_CUBE_FACES] = vec3[](
+    vec3(1.0, 0.0, 0.0), vec3(-1.0, 0.0, 0.0),
+    vec3(0.0, 1.0, 0.0), vec3(0.0, -1.0, 0.0),
+    vec3(0.0, 0.0, 1.0), vec3(0.0, 0.0, -1.0));
+const vec3 shadowFaceUps[SHADOW_CUBE_FACES] = vec3[](
+    vec3(0.0, -1.0, 0.0), vec3(0.0, -1.0, 0.0),
+    vec3(0.0, 0.0, 1.0), vec3(0.0, 0.0, -1.0),
+    vec3(0.0, -1.0, 0.0), vec3(0.0, -1.0, 0.0));
+
+// a variant of the program fixes the texture, lighting and active lights
+// as #define values - see ShaderVariants.h - so the compiler removes these
+// branches, otherwise they are read from the uniforms per fragment
+#ifdef SHADER_VARIANT
+#define USE_TEXTURE (VARIANT_TEXTURE != 0)
+#define USE_LIGHTING (VARIANT_LIGHTING != 0)
+#define DIRECTIONAL_LIGHT_ACTIVE (VARIANT_DIRECTIONAL_LIGHT != 0)
+#define POINT_LIGHT_ACTIVE(index) ((VARIANT_POINT_LIGHTS & (1 << (index))) != 0)
+#define SPOT_LIGHT_ACTIVE (VARIANT_SPOT_LIGHT != 0)
+#else
+#define USE_TEXTURE bUseTexture
+#define USE_LIGHTING bUseLighting
+#define DIRECTIONAL_LIGHT_ACTIVE directionalLight.bActive
+#define POINT_LIGHT_ACTIVE(index) pointLights[index].bActive
+#define SPOT_LIGHT_ACTIVE spotLight.bActive
+#endif
 
 // the scaled texture coordinate to use in calculations
-vec2 fragmentTextureCoordinateScaled = fragmentTextureCoordinate * UVscale;
+vec2 fragmentTextureCoordinateScaled;
+// the object texture color, sampled once per fragment
+vec4 objectTexel;
+// the texture or object color that the lights modulate
+vec3 surfaceColor;
+// the material of the fragment
+Material objectMaterial;
 
 // function prototypes
-vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir);
-vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
+vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir, float shadow);
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, float shadow);
 vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
+vec3 CalcClusteredLights(vec3 normal, vec3 fragPos, vec3 viewDir);
+float SampleShadowMap(sampler2DArrayShadow shadowMap, vec2 uv, float layer, float depth);
+float CalcCascadeShadow(vec3 fragPos);
+float CalcPointShadow(int index, vec3 fragPos);
 
 void main()
 {   
-    if(bUseLighting == true)
+    // the object color and UV scale come from the vertex shader so that
+    // instanced draws can supply them per instance
+    fragmentTextureCoordinateScaled = fragmentTextureCoordinate * fragmentUVscale;
+
+    objectMaterial = material;
+    if(bUseMaterialIndex == true)
+    {
+        MaterialData indexed = materials[int(fragmentMaterialIndex)];
+        objectMaterial.diffuseColor = indexed.diffuseColor;
+        objectMaterial.specularColor = indexed.specularColor;
+        objectMaterial.shininess = indexed.shininess;
+    }
+
+    objectTexel = vec4(1.0f);
+    if(USE_TEXTURE == true)
+    {
+        if(bUseTextureArray == true)
+        {
+            objectTexel = texture(objectTextureArray, vec3(fragmentTextureCoordinateScaled, fragmentTextureLayer));
+        }
+        else
+        {
+            objectTexel = texture(objectTexture, fragmentTextureCoordinateScaled);
+        }
+    }
+
+    surfaceColor = (USE_TEXTURE == true) ? vec3(objectTexel) : vec3(fragmentObjectColor);
+
+    if(USE_LIGHTING == true)
     {
         vec3 phongResult = vec3(0.0f);
         // properties
@@ -85,48 +221,55 @@ void main()
         // up for this fragment's final color.
         // == =====================================================
         // phase 1: directional lighting
-        if(directionalLight.bActive == true)
+        if(DIRECTIONAL_LIGHT_ACTIVE == true)
         {
-            phongResult += CalcDirectionalLight(directionalLight, norm, viewDir);
+            float shadow = (bUseCascadeShadows == true) ? CalcCascadeShadow(fragmentPosition) : 1.0;
+            phongResult += CalcDirectionalLight(directionalLight, norm, viewDir, shadow);
         }
         // phase 2: point lights
         for(int i = 0; i < TOTAL_POINT_LIGHTS; i++)
         {
-	    if(pointLights[i].bActive == true)
+	    if(POINT_LIGHT_ACTIVE(i) == true)
             {
-                phongResult += CalcPointLight(pointLights[i], norm, fragmentPosition, viewDir);   
+                float shadow = ((pointShadowMask & (1 << i)) != 0) ? CalcPointShadow(i, fragmentPosition) : 1.0;
+                phongResult += CalcPointLight(pointLights[i], norm, fragmentPosition, viewDir, shadow);   
             }
         } 
+        // the point lights of the fragment's cluster
+        if(bUseLightClusters == true)
+        {
+            phongResult += CalcClusteredLights(norm, fragmentPosition, viewDir);
+        }
         // phase 3: spot light
-        if(spotLight.bActive == true)
+        if(SPOT_LIGHT_ACTIVE == true)
         {
             phongResult += CalcSpotLight(spotLight, norm, fragmentPosition, viewDir);    
         }
     
-        if(bUseTexture == true)
+        if(USE_TEXTURE == true)
         {
-            fragmentColor = vec4(phongResult, (texture(objectTexture, fragmentTextureCoordinateScaled)).a);
+            fragmentColor = vec4(phongResult, objectTexel.a);
         }
         else
         {
-            fragmentColor = vec4(phongResult, objectColor.a);
+            fragmentColor = vec4(phongResult, fragmentObjectColor.a);
         }
     }
     else
     {
-        if(bUseTexture == true)
+        if(USE_TEXTURE == true)
         {
-            fragmentColor = texture(objectTexture, fragmentTextureCoordinateScaled);
+            fragmentColor = objectTexel;
         }
         else
         {
-            fragmentColor = objectColor;
+            fragmentColor = fragmentObjectColor;
         }
     }
 }
 
 // calculates the color when using a directional light.
-vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir)
+vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir, float shadow)
 {
     vec3 ambient = vec3(0.0f);
     vec3 diffuse = vec3(0.0f);
@@ -137,26 +280,18 @@ vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir)
     float diff = max(dot(normal, lightDirection), 0.0);
     // specular shading
     vec3 reflectDir = reflect(-lightDirection, normal);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), objectMaterial.shininess);
     // combine results
-    if(bUseTexture == true)
-    {
-        ambient = light.ambient * vec3(texture(objectTexture, fragmentTextureCoordinateScaled));
-        diffuse = light.diffuse * diff * material.diffuseColor * vec3(texture(objectTexture, fragmentTextureCoordinateScaled));
-        specular = light.specular * spec * material.specularColor * vec3(texture(objectTexture, fragmentTextureCoordinateScaled));
-    }
-    else
-    {
-        ambient = light.ambient * vec3(objectColor);
-        diffuse = light.diffuse * diff * material.diffuseColor * vec3(objectColor);
-        specular = light.specular * spec * material.specularColor * vec3(objectColor);
-    }
+    ambient = light.ambient * surfaceColor;
+    diffuse = light.diffuse * diff * objectMaterial.diffuseColor * surfaceColor;
+    specular = light.specular * spec * objectMaterial.specularColor * surfaceColor;
     
-    return (ambient + diffuse + specular);
+    // the shadow only hides the direct light
+    return (ambient + (diffuse + specular) * shadow);
 }
 
 // calculates the color when using a point light.
-vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, float shadow)
 {
     vec3 ambient = vec3(0.0f);
     vec3 diffuse = vec3(0.0f);
@@ -168,23 +303,14 @@ vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     // specular shading
     vec3 reflectDir = reflect(-lightDir, normal);
     // Calculate specular component
-    float specularComponent = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    float specularComponent = pow(max(dot(viewDir, reflectDir), 0.0), objectMaterial.shininess);
    
     // combine results
-    if(bUseTexture == true)
-    {
-        ambient = light.ambient * vec3(texture(objectTexture, fragmentTextureCoordinateScaled));
-        diffuse = light.diffuse * diff * material.diffuseColor * vec3(texture(objectTexture, fragmentTextureCoordinateScaled));
-        specular = light.specular * specularComponent * material.specularColor;
-    }
-    else
-    {
-        ambient = light.ambient * vec3(objectColor);
-        diffuse = light.diffuse * diff * material.diffuseColor * vec3(objectColor);
-        specular = light.specular * specularComponent * material.specularColor;
-    }
+    ambient = light.ambient * surfaceColor;
+    diffuse = light.diffuse * diff * objectMaterial.diffuseColor * surfaceColor;
+    specular = light.specular * specularComponent * objectMaterial.specularColor;
     
-    return (ambient + diffuse + specular);
+    return (ambient + (diffuse + specular) * shadow);
 }
 
 // calculates the color when using a spot light.
@@ -199,7 +325,7 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     float diff = max(dot(normal, lightDir), 0.0);
     // specular shading
     vec3 reflectDir = reflect(-lightDir, normal);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), objectMaterial.shininess);
     // attenuation
     float distance = length(light.position - fragPos);
     float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));    
@@ -208,21 +334,126 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     float epsilon = light.cutOff - light.outerCutOff;
     float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
     // combine results
-    if(bUseTexture == true)
-    {
-        ambient = light.ambient * vec3(texture(objectTexture, fragmentTextureCoordinateScaled));
-        diffuse = light.diffuse * diff * material.diffuseColor * vec3(texture(objectTexture, fragmentTextureCoordinateScaled));
-        specular = light.specular * spec * material.specularColor * vec3(texture(objectTexture, fragmentTextureCoordinateScaled));
-    }
-    else
-    {
-        ambient = light.ambient * vec3(objectColor);
-        diffuse = light.diffuse * diff * material.diffuseColor * vec3(objectColor);
-        specular = light.specular * spec * material.specularColor * vec3(objectColor);
-    }
+    ambient = light.ambient * surfaceColor;
+    diffuse = light.diffuse * diff * objectMaterial.diffuseColor * surfaceColor;
+    specular = light.specular * spec * objectMaterial.specularColor * surfaceColor;
     
     ambient *= attenuation * intensity;
     diffuse *= attenuation * intensity;
     specular *= attenuation * intensity;
     return (ambient + diffuse + specular);
 }
+
+// calculates the color of the clustered point lights that touch the
+// cluster of the fragment.
+vec3 CalcClusteredLights(vec3 normal, vec3 fragPos, vec3 viewDir)
+{
+    vec3 result = vec3(0.0f);
+
+    float viewDepth = -(view * vec4(fragPos, 1.0)).z;
+    ivec3 cluster = ivec3(
+        int(gl_FragCoord.x * clusterParameters.x),
+        int(gl_FragCoord.y * clusterParameters.y),
+        int(floor(log(max(viewDepth, 1.0e-4)) * clusterParameters.z + clusterParameters.w)));
+    cluster = clamp(cluster, ivec3(0), ivec3(CLUSTER_COUNT_X - 1, CLUSTER_COUNT_Y - 1, CLUSTER_COUNT_Z - 1));
+
+    int base = ((cluster.z * CLUSTER_COUNT_Y + cluster.y) * CLUSTER_COUNT_X + cluster.x) * CLUSTER_STRIDE;
+    int lightCount = int(texelFetch(clusterEntries, base).r);
+    for(int i = 0; i < lightCount; i++)
+    {
+        int texel = int(texelFetch(clusterEntries, base + 1 + i).r) * 4;
+        vec4 positionRadius = texelFetch(clusterLights, texel);
+
+        PointLight light;
+        light.position = positionRadius.xyz;
+        light.ambient = texelFetch(clusterLights, texel + 1).rgb;
+        light.diffuse = texelFetch(clusterLights, texel + 2).rgb;
+        light.specular = texelFetch(clusterLights, texel + 3).rgb;
+        light.bActive = true;
+
+        // the light fades out smoothly to nothing at its radius
+        float ratio = length(light.position - fragPos) / positionRadius.w;
+        float falloff = clamp(1.0 - ratio * ratio * ratio * ratio, 0.0, 1.0);
+        result += CalcPointLight(light, normal, fragPos, viewDir, 1.0) * falloff * falloff;
+    }
+
+    return (result);
+}
+
+// averages four depth comparisons half a texel around a point of a shadow
+// map, each of them bilinear filtered by the comparison sampler.
+float SampleShadowMap(sampler2DArrayShadow shadowMap, vec2 uv, float layer, float depth)
+{
+    vec2 texel = 0.5 / vec2(textureSize(shadowMap, 0).xy);
+    float lit = 0.0;
+    lit += texture(shadowMap, vec4(uv + vec2(-texel.x, -texel.y), layer, depth));
+    lit += texture(shadowMap, vec4(uv + vec2(texel.x, -texel.y), layer, depth));
+    lit += texture(shadowMap, vec4(uv + vec2(-texel.x, texel.y), layer, depth));
+    lit += texture(shadowMap, vec4(uv + vec2(texel.x, texel.y), layer, depth));
+
+    return (lit * 0.25);
+}
+
+// calculates how much of the directional light reaches the fragment, from
+// the cascade that covers its view depth.
+float CalcCascadeShadow(vec3 fragPos)
+{
+    float viewDepth = -(view * vec4(fragPos, 1.0)).z;
+    int cascade = 0;
+    while((cascade < SHADOW_CASCADE_COUNT) && (viewDepth > cascadeSplits[cascade]))
+    {
+        cascade++;
+    }
+    // beyond the last cascade nothing is shadowed
+    if(cascade >= SHADOW_CASCADE_COUNT)
+    {
+        return (1.0);
+    }
+
+    vec3 position = (cascadeMatrices[cascade] * vec4(fragPos, 1.0)).xyz * 0.5 + 0.5;
+    if(position.z > 1.0)
+    {
+        return (1.0);
+    }
+
+    return (SampleShadowMap(cascadeShadowMap, position.xy, float(cascade), position.z));
+}
+
+// calculates how much of a point light of the light block reaches the
+// fragment, from the cube face that looks along the major axis towards it.
+float CalcPointShadow(int index, vec3 fragPos)
+{
+    vec3 toFragment = fragPos - pointLights[index].position;
+    vec3 absolute = abs(toFragment);
+    int face = 0;
+    if((absolute.x >= absolute.y) && (absolute.x >= absolute.z))
+    {
+        face = (toFragment.x > 0.0) ? 0 : 1;
+    }
+    else if(absolute.y >= absolute.z)
+    {
+        face = (toFragment.y > 0.0) ? 2 : 3;
+    }
+    else
+    {
+        face = (toFragment.z > 0.0) ? 4 : 5;
+    }
+
+    // the same projection as the lookAt and 90 degree perspective of the face
+    vec3 direction = shadowFaceDirections[face];
+    vec3 side = normalize(cross(direction, shadowFaceUps[face]));
+    vec3 up = cross(side, direction);
+    float distance = dot(direction, toFragment);
+    float nearPlane = pointShadowParameters.x;
+    float farPlane = pointShadowParameters.y;
+    if(distance >= farPlane)
+    {
+        return (1.0);
+    }
+
+    vec2 uv = vec2(dot(side, toFragment), dot(up, toFragment)) / distance * 0.5 + 0.5;
+    float depth = ((farPlane + nearPlane) / (farPlane - nearPlane)
+        - 2.0 * farPlane * nearPlane / ((farPlane - nearPlane) * distance)) * 0.5 + 0.5;
+
+    return (SampleShadowMap(pointShadowMap, uv, float(index * SHADOW_CUBE_FACES + face), depth));
+}
@@ -0,0 +1,54 @@
+#version 430 core
+// must match HiZBuffer::GROUP_SIZE
+layout (local_size_x = 8, local_size_y = 8) in;
+
+// the occluder depth, read for the first level
+uniform sampler2D depthTexture;
+// the previous and the written pyramid level
+layout (r32f, binding = 0) readonly uniform image2D sourceLevel;
+layout (r32f, binding = 1) writeonly uniform image2D targetLevel;
+
+uniform bool bFromDepth = false;
+uniform ivec2 sourceSize;
+uniform ivec2 targetSize;
+
+void main()
+{
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    if(any(greaterThanEqual(texel, targetSize)))
+    {
+        return;
+    }
+
+    // the first level is a copy of the occluder depth
+    if(bFromDepth == true)
+    {
+        imageStore(targetLevel, texel, vec4(texelFetch(depthTexture, texel, 0).r));
+        return;
+    }
+
+    // the last texel of a level with an odd size also covers the
+    // extra row or column of the level before it
+    ivec2 blockSize = ivec2(2);
+    if((texel.x == targetSize.x - 1) && ((sourceSize.x & 1) != 0))
+    {
+        blockSize.x = 3;
+    }
+    if((texel.y == targetSize.y - 1) && ((sourceSize.y & 1) != 0))
+    {
+        blockSize.y = 3;
+    }
+
+    float farthest = 0.0f;
+    ivec2 base = texel * 2;
+    for(int y = 0; y < blockSize.y; y++)
+    {
+        for(int x = 0; x < blockSize.x; x++)
+        {
+            ivec2 source = min(base + ivec2(x, y), sourceSize - 1);
+            farthest = max(farthest, imageLoad(sourceLevel, source).r);
+        }
+    }
+
+    imageStore(targetLevel, texel, vec4(farthest));
+}
@@ -0,0 +1,121 @@
+#version 430 core
+// must match LightClusters::GROUP_SIZE
+layout (local_size_x = 128) in;
+
+// must match LightClusters::CLUSTER_COUNT_X, _Y, _Z and CLUSTER_STRIDE
+#define CLUSTER_COUNT_X 16u
+#define CLUSTER_COUNT_Y 9u
+#define CLUSTER_COUNT_Z 24u
+#define CLUSTER_STRIDE 64u
+#define GROUP_SIZE 128
+
+// must match LightClusters::CLUSTER_LIGHT
+struct ClusterLight {
+    // world space position in xyz, radius in w
+    vec4 positionRadius;
+    vec4 ambient;
+    vec4 diffuse;
+    vec4 specular;
+};
+
+layout (std430, binding = 0) readonly buffer LightBuffer
+{
+    ClusterLight lights[];
+};
+
+// the light count of every cluster followed by its light indices
+layout (std430, binding = 1) writeonly buffer ClusterBuffer
+{
+    uint clusterEntries[];
+};
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform mat4 inverseProjection;
+// the view depths where the first slice starts and the last one ends
+uniform float sliceNear;
+uniform float sliceFar;
+uniform int lightCount;
+
+// the view space position and radius of a batch of lights
+shared vec4 batchLights[GROUP_SIZE];
+
+// the normalized device depth of a view depth
+float ViewDepthToNdc(float depth)
+{
+    vec4 clip = projection * vec4(0.0, 0.0, -depth, 1.0);
+    return clip.z / clip.w;
+}
+
+// the view space position of a normalized device position
+vec3 Unproject(vec3 ndc)
+{
+    vec4 position = inverseProjection * vec4(ndc, 1.0);
+    return position.xyz / position.w;
+}
+
+void main()
+{
+    uint cluster = gl_GlobalInvocationID.x;
+    bool bValid = cluster < CLUSTER_COUNT_X * CLUSTER_COUNT_Y * CLUSTER_COUNT_Z;
+
+    uint x = cluster % CLUSTER_COUNT_X;
+    uint y = (cluster / CLUSTER_COUNT_X) % CLUSTER_COUNT_Y;
+    uint z = cluster / (CLUSTER_COUNT_X * CLUSTER_COUNT_Y);
+
+    // the slices split the depth range exponentially, so the
+    // clusters keep roughly the same shape at every distance
+    float depthRatio = sliceFar / sliceNear;
+    float ndcNear = ViewDepthToNdc(sliceNear * pow(depthRatio, float(z) / float(CLUSTER_COUNT_Z)));
+    float ndcFar = ViewDepthToNdc(sliceNear * pow(depthRatio, float(z + 1u) / float(CLUSTER_COUNT_Z)));
+    vec2 ndcMin = vec2(x, y) / vec2(CLUSTER_COUNT_X, CLUSTER_COUNT_Y) * 2.0 - 1.0;
+    vec2 ndcMax = vec2(x + 1u, y + 1u) / vec2(CLUSTER_COUNT_X, CLUSTER_COUNT_Y) * 2.0 - 1.0;
+
+    // the view space bounds of the eight cluster corners
+    vec3 boundsMin = vec3(3.0e38);
+    vec3 boundsMax = vec3(-3.0e38);
+    for(int corner = 0; corner < 8; corner++)
+    {
+        vec3 ndc = vec3(
+            ((corner & 1) != 0) ? ndcMax.x : ndcMin.x,
+            ((corner & 2) != 0) ? ndcMax.y : ndcMin.y,
+            ((corner & 4) != 0) ? ndcFar : ndcNear);
+        vec3 position = Unproject(ndc);
+        boundsMin = min(boundsMin, position);
+        boundsMax = max(boundsMax, position);
+    }
+
+    uint base = cluster * CLUSTER_STRIDE;
+    uint count = 0u;
+
+    // every thread loads one light of a batch, and every thread
+    // then tests its cluster against the whole batch
+    for(int first = 0; first < lightCount; first += GROUP_SIZE)
+    {
+        int index = first + int(gl_LocalInvocationID.x);
+        if(index < lightCount)
+        {
+            vec4 positionRadius = lights[index].positionRadius;
+            batchLights[gl_LocalInvocationID.x] = vec4((view * vec4(positionRadius.xyz, 1.0)).xyz, positionRadius.w);
+        }
+        barrier();
+
+        int batchSize = min(GROUP_SIZE, lightCount - first);
+        for(int i = 0; (i < batchSize) && (bValid == true); i++)
+        {
+            vec4 light = batchLights[i];
+            vec3 offset = clamp(light.xyz, boundsMin, boundsMax) - light.xyz;
+            if((dot(offset, offset) <= light.w * light.w) && (count < CLUSTER_STRIDE - 1u))
+            {
+                clusterEntries[base + 1u + count] = uint(first + i);
+                count++;
+            }
+        }
+        barrier();
+    }
+
+    if(bValid == true)
+    {
+        clusterEntries[base] = count;
+    }
+}
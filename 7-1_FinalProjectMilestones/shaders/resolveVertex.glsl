@@ -0,0 +1,12 @@
+#version 330 core
+// the window position of the fragment, 0 to 1
+out vec2 screenCoordinate;
+
+// a triangle that covers the window, generated from the vertex ids so no
+// vertex buffer is bound
+void main()
+{
+    vec2 position = vec2(float((gl_VertexID << 1) & 2), float(gl_VertexID & 2));
+    screenCoordinate = position;
+    gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,5 @@
+#version 330 core
+// the casters only write depth
+void main()
+{
+}
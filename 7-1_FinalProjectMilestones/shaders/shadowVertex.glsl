@@ -0,0 +1,12 @@
+#version 330 core
+// the casters are always drawn instanced, see ShadowMaps.h
+layout (location = 0) in vec3 inVertexPosition;
+layout (location = 3) in mat4 inInstanceModel;
+
+// the view projection of the cascade or cube face being drawn
+uniform mat4 lightViewProjection;
+
+void main()
+{
+    gl_Position = lightViewProjection * inInstanceModel * vec4(inVertexPosition, 1.0f);
+}
@@ -0,0 +1,70 @@
+#version 330 core
+out vec4 fragmentColor;
+
+in vec2 screenCoordinate;
+
+// the scene target of this frame, and the history the last frame wrote
+uniform sampler2D currentColor;
+uniform sampler2D currentDepth;
+uniform sampler2D historyColor;
+// the part of the scene target the frame was drawn to, and the size of one
+// of its texels, in texture coordinates
+uniform vec2 renderScale;
+uniform vec2 renderTexel;
+// the projection offset of the frame, in normalized device coordinates
+uniform vec2 jitter;
+// from the unjittered clip space of this frame to the one of the last frame
+uniform mat4 reprojection;
+// when not set, the frame is only upscaled
+uniform bool bUseHistory = false;
+
+// the weight of the history in the blend, the frame adds the rest
+const float historyWeight = 0.9;
+
+// the scene target coordinate of a window coordinate, kept inside the part
+// the frame was drawn to
+vec2 SceneCoordinate(vec2 coordinate)
+{
+    return (clamp(coordinate * renderScale, renderTexel * 0.5, renderScale - renderTexel * 0.5));
+}
+
+void main()
+{
+    // the frame was drawn shifted by the jitter, so the center of the
+    // pixel is read where it landed
+    vec2 sceneCoordinate = SceneCoordinate(screenCoordinate + jitter * 0.5);
+    vec3 current = texture(currentColor, sceneCoordinate).rgb;
+    if(bUseHistory == false)
+    {
+        fragmentColor = vec4(current, 1.0);
+        return;
+    }
+
+    // the range of the colors around the pixel, the history may not leave it
+    vec3 minColor = current;
+    vec3 maxColor = current;
+    for(int y = -1; y <= 1; y++)
+    {
+        for(int x = -1; x <= 1; x++)
+        {
+            vec2 neighbour = clamp(sceneCoordinate + vec2(x, y) * renderTexel,
+                renderTexel * 0.5, renderScale - renderTexel * 0.5);
+            vec3 color = texture(currentColor, neighbour).rgb;
+            minColor = min(minColor, color);
+            maxColor = max(maxColor, color);
+        }
+    }
+
+    // where the surface of the pixel was in the last frame
+    float depth = texture(currentDepth, sceneCoordinate).r;
+    vec4 previous = reprojection * vec4(screenCoordinate * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+    vec2 previousCoordinate = previous.xy / previous.w * 0.5 + 0.5;
+    if(any(lessThan(previousCoordinate, vec2(0.0))) || any(greaterThan(previousCoordinate, vec2(1.0))))
+    {
+        fragmentColor = vec4(current, 1.0);
+        return;
+    }
+
+    vec3 history = clamp(texture(historyColor, previousCoordinate).rgb, minColor, maxColor);
+    fragmentColor = vec4(mix(current, history, historyWeight), 1.0);
+}
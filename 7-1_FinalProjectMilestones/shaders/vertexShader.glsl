@@ -2,19 +2,94 @@
 layout (location = 0) in vec3 inVertexPosition;
 layout (location = 1) in vec3 inVertexNormal;
 layout (location = 2) in vec2 inTextureCoordinate;
+// per-instance values, only read when bUseInstancing is set
+layout (location = 3) in mat4 inInstanceModel;
+layout (location = 7) in vec4 inInstanceColor;
+layout (location = 8) in vec2 inInstanceUVscale;
+layout (location = 9) in float inInstanceTextureLayer;
+layout (location = 10) in float inInstanceMaterialIndex;
 
 out vec3 fragmentPosition;
 out vec3 fragmentVertexNormal;
 out vec2 fragmentTextureCoordinate;
+out vec4 fragmentObjectColor;
+out vec2 fragmentUVscale;
+flat out float fragmentTextureLayer;
+flat out float fragmentMaterialIndex;
+
+// the depth pre-pass and the shaded pass draw with different programs,
+// and the shaded pass only keeps fragments at the exact pre-pass depth
+invariant gl_Position;
+
+// per-frame camera data shared by every shader program
+layout (std140) uniform CameraBlock
+{
+   mat4 view;
+   mat4 projection;
+   vec3 viewPosition;
+   vec2 jitter;
+};
+
+// must match TOTAL_DRAW_RECORDS in UniformBuffers.h
+#define TOTAL_DRAW_RECORDS 128
+
+// per-draw values streamed by the CPU, only read when
+// bUseDrawRecords is set
+struct DrawRecord
+{
+   mat4 model;
+   vec4 color;
+   vec2 UVscale;
+   float textureLayer;
+   float materialIndex;
+};
+
+layout (std140) uniform DrawBlock
+{
+   DrawRecord draws[TOTAL_DRAW_RECORDS];
+};
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+uniform bool bUseInstancing = false;
+uniform bool bUseDrawRecords = false;
+uniform int drawIndex = 0;
+uniform vec4 objectColor = vec4(1.0f);
+uniform vec2 UVscale = vec2(1.0f, 1.0f);
+uniform float textureLayer = 0.0f;
 
 void main()
 {
-   fragmentPosition = vec3(model * vec4(inVertexPosition, 1.0));
-   gl_Position = projection * view * model * vec4(inVertexPosition, 1.0f);
+   mat4 objectModel = model;
+   fragmentObjectColor = objectColor;
+   fragmentUVscale = UVscale;
+   fragmentTextureLayer = textureLayer;
+   fragmentMaterialIndex = 0.0f;
+
+   // instanced draws take the per-object values from the instance buffer
+   if(bUseInstancing == true)
+   {
+      objectModel = inInstanceModel;
+      fragmentObjectColor = inInstanceColor;
+      fragmentUVscale = inInstanceUVscale;
+      fragmentTextureLayer = inInstanceTextureLayer;
+      fragmentMaterialIndex = inInstanceMaterialIndex;
+   }
+   // single draws take them from their record in the draw block
+   else if(bUseDrawRecords == true)
+   {
+      DrawRecord record = draws[drawIndex];
+      objectModel = record.model;
+      fragmentObjectColor = record.color;
+      fragmentUVscale = record.UVscale;
+      fragmentTextureLayer = record.textureLayer;
+      fragmentMaterialIndex = record.materialIndex;
+   }
+
+   fragmentPosition = vec3(objectModel * vec4(inVertexPosition, 1.0));
+   gl_Position = projection * view * objectModel * vec4(inVertexPosition, 1.0f);
+   // the sub-pixel offset is added in clip space, so it moves every
+   // vertex by the same amount in normalized device coordinates
+   gl_Position.xy += jitter * gl_Position.w;
    fragmentVertexNormal = inVertexNormal;
    fragmentTextureCoordinate = inTextureCoordinate;
 }
\ No newline at end of file